@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// NOTE: keep consistent with triple_bin_header_t in src/loader/triple_parser.hpp
+struct header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t id_sz;
+    uint32_t nfields;
+    uint32_t reserved;
+    uint64_t ntriples;
+};
+
+static bool convert(const string &src, const string &dst, uint32_t id_sz, uint32_t nfields) {
+    ifstream infile(src);
+    ofstream outfile(dst, ios::out | ios::trunc | ios::binary);
+    if (!infile || !outfile)
+        return false;
+
+    header_t h;
+    memcpy(h.magic, "WKTRIPLE", sizeof(h.magic));
+    h.version = 1;
+    h.id_sz = id_sz;
+    h.nfields = nfields;
+    h.reserved = 0;
+    h.ntriples = 0;
+    outfile.write(reinterpret_cast<char *>(&h), sizeof(h));  // rewritten at last
+
+    vector<char> rec(3 * id_sz + (nfields - 3) * sizeof(int64_t));
+    int64_t v[5];
+    while (infile >> v[0] >> v[1] >> v[2]) {
+        if (nfields == 5 && !(infile >> v[3] >> v[4]))
+            break;
+
+        for (int f = 0; f < 3; f++) {
+            if (id_sz == sizeof(uint32_t)) {
+                uint32_t id = v[f];
+                memcpy(&rec[f * id_sz], &id, id_sz);
+            } else {
+                uint64_t id = v[f];
+                memcpy(&rec[f * id_sz], &id, id_sz);
+            }
+        }
+        if (nfields == 5)
+            memcpy(&rec[3 * id_sz], &v[3], 2 * sizeof(int64_t));
+        outfile.write(rec.data(), rec.size());
+        h.ntriples++;
+    }
+
+    outfile.seekp(0);
+    outfile.write(reinterpret_cast<char *>(&h), sizeof(h));
+    return outfile.good();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("usage: ./convert_bin id_triples_directory_name [id_bytes (4 or 8)] [-t]\n");
+        printf("  -t: triples with timestamps (TRDF_MODE)\n");
+        return -1;
+    }
+
+    uint32_t id_sz = 4, nfields = 3;
+    for (int i = 2; i < argc; i++) {
+        if (string(argv[i]) == "-t")
+            nfields = 5;
+        else
+            id_sz = stoi(argv[i]);
+    }
+    if (id_sz != 4 && id_sz != 8) {
+        printf("id_bytes should be 4 (default) or 8 (built w/ USE_DTYPE_64BIT)\n");
+        return -1;
+    }
+
+    DIR *dir = opendir(argv[1]);
+    if (dir == NULL) {
+        cout << "failed to open directory" << argv[1];
+        return -1;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        string name(ent->d_name);
+        if (name.find("id_") != 0 || name.rfind(".bin") == name.length() - 4)
+            continue;
+
+        string fname = string(argv[1]) + "/" + name;
+        string dst = string(argv[1]) + "/" + name.substr(0, name.find_last_of('.')) + ".bin";
+        cout << "Processing: " << name << endl;
+        if (!convert(fname, dst, id_sz, nfields)) {
+            cout << "failed to convert " << name << endl;
+            return -1;
+        }
+        // the loader reads both text and binary files
+        remove(fname.c_str());
+    }
+    closedir(dir);
+
+    cout << "Finished!" << endl;
+}
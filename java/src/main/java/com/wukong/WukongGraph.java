@@ -9,6 +9,11 @@ public class WukongGraph
     // api
     public native void retrieveClusterInfo();
     public native String executeSparqlQuery(String query);
+    // prepare a query w/ placeholders (e.g., %ub:Course) once, and execute it w/ the constants
+    // (prepareSparqlQuery and releasePreparedQuery throw RuntimeException if failed)
+    public native int prepareSparqlQuery(String query);
+    public native String executePreparedQuery(int handle, String[] bindings);
+    public native void releasePreparedQuery(int handle);
 
     private native long connectToServer(String address, int port);
     private native void disconnectToServer(long native_client_handle);
@@ -19,3 +19,14 @@ def execute_query(qno):
 
 for i in range(6):
     execute_query(i+1)
+
+# run a light query w/ different constants (see sparql_query/lubm/emulator)
+f = open("../scripts/sparql_query/lubm/emulator/q2")
+(handle,) = graph.prepare_sparql_query(f.read(), 10000)
+for i in range(10):
+    prof = "<http://www.Department0.University0.edu/AssistantProfessor" + str(i) + ">"
+    begin_time = datetime.datetime.now()
+    _ = graph.execute_prepared_query(handle, [prof], 10000)
+    d_time = datetime.datetime.now() - begin_time
+    print("\tprepared latency: ", d_time.microseconds, " usec.")
+graph.release_prepared_query(handle, 10000)
@@ -1,4 +1,5 @@
 #include <string>
+#include <vector>
 
 #include "WukongGraph.h"
 #include "client/rpc_client.hpp"
@@ -16,6 +17,14 @@ inline jstring ConvertToJString(JNIEnv* env, std::string str) {
   return env->NewStringUTF(str.c_str());
 }
 
+// throw a RuntimeException w/ the message of the failed status
+inline bool CheckStatus(JNIEnv* env, Status status) {
+  if (status.ok()) return true;
+  jclass ex_class = env->FindClass("java/lang/RuntimeException");
+  env->ThrowNew(ex_class, status.get_msg().c_str());
+  return false;
+}
+
 JNIEXPORT
 jlong JNICALL Java_com_wukong_WukongGraph_connectToServer(JNIEnv *env, jobject obj, jstring address, jint port) {
     std::string addr_str = ConvertToString(env, address);
@@ -56,4 +65,49 @@ jstring JNICALL Java_com_wukong_WukongGraph_executeSparqlQuery(JNIEnv *env, jobj
     client_handle->execute_sparql_query(query_str, result_str);
 
     return ConvertToJString(env, result_str);
-}
\ No newline at end of file
+}
+
+JNIEXPORT
+jint JNICALL Java_com_wukong_WukongGraph_prepareSparqlQuery(JNIEnv *env, jobject obj, jstring query) {
+    // get handle
+    jclass wukong_class = env->GetObjectClass(obj);
+    jfieldID handleFieldId = env->GetFieldID(wukong_class, "native_client_handle", "J");
+    RPCClient* client_handle = (RPCClient*)(env->GetLongField(obj, handleFieldId));
+
+    std::string query_str = ConvertToString(env, query);
+    int handle = -1;
+
+    CheckStatus(env, client_handle->prepare_sparql_query(query_str, handle));
+
+    return handle;
+}
+
+JNIEXPORT
+jstring JNICALL Java_com_wukong_WukongGraph_executePreparedQuery(JNIEnv *env, jobject obj, jint handle, jobjectArray bindings) {
+    // get handle
+    jclass wukong_class = env->GetObjectClass(obj);
+    jfieldID handleFieldId = env->GetFieldID(wukong_class, "native_client_handle", "J");
+    RPCClient* client_handle = (RPCClient*)(env->GetLongField(obj, handleFieldId));
+
+    std::vector<std::string> binding_strs;
+    for (jsize i = 0; i < env->GetArrayLength(bindings); i++) {
+        jstring binding = (jstring)env->GetObjectArrayElement(bindings, i);
+        binding_strs.push_back(ConvertToString(env, binding));
+        env->DeleteLocalRef(binding);
+    }
+    std::string result_str;
+
+    client_handle->execute_prepared_query(handle, binding_strs, result_str);
+
+    return ConvertToJString(env, result_str);
+}
+
+JNIEXPORT
+void JNICALL Java_com_wukong_WukongGraph_releasePreparedQuery(JNIEnv *env, jobject obj, jint handle) {
+    // get handle
+    jclass wukong_class = env->GetObjectClass(obj);
+    jfieldID handleFieldId = env->GetFieldID(wukong_class, "native_client_handle", "J");
+    RPCClient* client_handle = (RPCClient*)(env->GetLongField(obj, handleFieldId));
+
+    CheckStatus(env, client_handle->release_prepared_query(handle));
+}
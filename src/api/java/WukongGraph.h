@@ -23,6 +23,30 @@ JNIEXPORT void JNICALL Java_com_wukong_WukongGraph_retrieveClusterInfo
 JNIEXPORT jstring JNICALL Java_com_wukong_WukongGraph_executeSparqlQuery
   (JNIEnv *, jobject, jstring);
 
+/*
+ * Class:     com_wukong_WukongGraph
+ * Method:    prepareSparqlQuery
+ * Signature: (Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_wukong_WukongGraph_prepareSparqlQuery
+  (JNIEnv *, jobject, jstring);
+
+/*
+ * Class:     com_wukong_WukongGraph
+ * Method:    executePreparedQuery
+ * Signature: (I[Ljava/lang/String;)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_com_wukong_WukongGraph_executePreparedQuery
+  (JNIEnv *, jobject, jint, jobjectArray);
+
+/*
+ * Class:     com_wukong_WukongGraph
+ * Method:    releasePreparedQuery
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_wukong_WukongGraph_releasePreparedQuery
+  (JNIEnv *, jobject, jint);
+
 /*
  * Class:     com_wukong_WukongGraph
  * Method:    connectToServer
@@ -28,9 +28,36 @@ py::tuple WukongGraph::ExecuteSPARQLQuery(std::string query_text, int timeout) {
 	return py::make_tuple(result_data);
 }
 
+py::tuple WukongGraph::PrepareSPARQLQuery(std::string query_text, int timeout) {
+    int handle = -1;
+
+    // Parse the query w/ placeholders once on the server
+    client.prepare_sparql_query(query_text, handle, timeout);
+
+    return py::make_tuple(handle);
+}
+
+py::tuple WukongGraph::ExecutePreparedQuery(int handle, std::vector<std::string> bindings, int timeout) {
+    std::string result_data;
+
+    // Execute the prepared query w/ the constants of placeholders
+    client.execute_prepared_query(handle, bindings, result_data, timeout);
+
+    return py::make_tuple(result_data);
+}
+
+py::tuple WukongGraph::ReleasePreparedQuery(int handle, int timeout) {
+    client.release_prepared_query(handle, timeout);
+
+    return py::make_tuple();
+}
+
 void init_wukong_graph(py::module &m) {
   py::class_<WukongGraph>(m, "WukongGraph")
     .def(py::init<std::string, int>())
     .def("retrieve_cluster_info", &WukongGraph::RetrieveClusterInfo, py::arg("timeout") = ConnectTimeoutMs)
-    .def("execute_sparql_query", &WukongGraph::ExecuteSPARQLQuery, py::arg("query_text"), py::arg("timeout") = ConnectTimeoutMs);
+    .def("execute_sparql_query", &WukongGraph::ExecuteSPARQLQuery, py::arg("query_text"), py::arg("timeout") = ConnectTimeoutMs)
+    .def("prepare_sparql_query", &WukongGraph::PrepareSPARQLQuery, py::arg("query_text"), py::arg("timeout") = ConnectTimeoutMs)
+    .def("execute_prepared_query", &WukongGraph::ExecutePreparedQuery, py::arg("handle"), py::arg("bindings"), py::arg("timeout") = ConnectTimeoutMs)
+    .def("release_prepared_query", &WukongGraph::ReleasePreparedQuery, py::arg("handle"), py::arg("timeout") = ConnectTimeoutMs);
 }
@@ -42,6 +42,12 @@ public:
 
   py::tuple ExecuteSPARQLQuery(std::string query_text, int timeout);
 
+  py::tuple PrepareSPARQLQuery(std::string query_text, int timeout);
+
+  py::tuple ExecutePreparedQuery(int handle, std::vector<std::string> bindings, int timeout);
+
+  py::tuple ReleasePreparedQuery(int handle, int timeout);
+
 private:
   RPCClient client;
 };
\ No newline at end of file
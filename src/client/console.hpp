@@ -38,6 +38,8 @@
 #include "core/common/errors.hpp"
 #include "core/common/monitor.hpp"
 
+#include "utils/time_tool.hpp"
+
 using namespace boost;
 using namespace boost::program_options;
 
@@ -105,6 +107,8 @@ options_description     sparql_desc("sparql <args>       run SPARQL queries in s
 options_description sparql_emu_desc("sparql-emu <args>   emulate clients to continuously send SPARQL queries");
 options_description       load_desc("load <args>         load RDF data into dynamic (in-memmory) graph store");
 options_description       gsck_desc("gsck <args>         check the integrity of (in-memmory) graph storage");
+options_description     gstore_desc("gstore snapshot <args>  dump (in-memory) graph storage to binary snapshots");
+options_description   snapshot_desc("snapshot <args>     materialize snapshots for FROM SNAPSHOT queries (TRDF_MODE)");
 options_description  load_stat_desc("load-stat           load statistics of SPARQL query optimizer");
 options_description store_stat_desc("store-stat          store statistics of SPARQL query optimizer");
 
@@ -181,6 +185,22 @@ void init_options_desc()
     ;
     all_desc.add(gsck_desc);
 
+    // e.g., wukong> gstore snapshot <args>
+    gstore_desc.add_options()
+    (",d", value<std::string>()->value_name("<dname>"), "dump snapshots to directory <dname> (default: global_snapshot_folder)")
+    ("help,h", "help message about gstore")
+    ;
+    all_desc.add(gstore_desc);
+
+    // e.g., wukong> snapshot create <time>
+    snapshot_desc.add_options()
+    ("create", value<std::string>()->value_name("<time>"), "materialize the snapshot at <time> (yyyy-MM-dd or yyyy-MM-ddTHH:mm:ss)")
+    ("drop", value<std::string>()->value_name("<time>"), "drop the snapshot at <time>")
+    ("list", "list the snapshots")
+    ("help,h", "help message about snapshot")
+    ;
+    all_desc.add(snapshot_desc);
+
     // e.g., wukong> load-stat
     load_stat_desc.add_options()
     (",f", value<std::string>()->value_name("<fname>"), "load statistics from <fname> located at data folder")
@@ -835,6 +855,123 @@ static void run_gsck(ConsoleProxy *proxy, int argc, char **argv)
     proxy->monitor.print_latency();
 }
 
+/**
+ * run the 'gstore' command
+ * usage:
+ * gstore snapshot [options]
+ *   -d <dname>   dump snapshots to directory <dname>
+ */
+static void run_gstore(ConsoleProxy *proxy, int argc, char **argv)
+{
+    // use the leader proxy thread on each server to dump its own graph store
+    if (!LEADER(proxy))
+        return;
+
+    if (argc < 2 || std::string(argv[1]) != "snapshot") {
+        if (MASTER(proxy)) fail_to_parse(proxy, argc, argv);  // invalid cmd
+        return;
+    }
+
+    // parse command (skip the keyword 'gstore')
+    variables_map gstore_vm;
+    try {
+        store(parse_command_line(argc - 1, argv + 1, gstore_desc), gstore_vm);
+    } catch (...) {
+        if (MASTER(proxy)) fail_to_parse(proxy, argc, argv);
+        return;
+    }
+    notify(gstore_vm);
+
+    // parse options
+    if (gstore_vm.count("help")) {
+        if (MASTER(proxy))
+            std::cout << gstore_desc;
+        return;
+    }
+
+    std::string dname;
+    if (gstore_vm.count("-d")) {
+        dname = gstore_vm["-d"].as<std::string>();
+    } else if (!Global::snapshot_folder.empty()) {
+        dname = Global::snapshot_folder;
+    } else {
+        if (MASTER(proxy))
+            logstream(LOG_ERROR) << "Please set the directory by -d or global_snapshot_folder." << LOG_endl;
+        return;
+    }
+    if (dname[dname.length() - 1] != '/')
+        dname = dname + "/"; // force a "/" at the end of dname.
+
+    /// do snapshot
+    if (!proxy->get_graph()->dump_snapshot(dname)) {
+        logstream(LOG_ERROR) << "Failed to dump graph store to directory " << dname << LOG_endl;
+        return;
+    }
+
+    // statistics are only cached on the master server
+    if (MASTER(proxy)) {
+        std::string fname = dname + "statfile";
+        std::remove(fname.c_str());  // replace the old one
+        proxy->get_stats()->store_stat_to_file(fname);
+    }
+}
+
+/**
+ * run the 'snapshot' command
+ * usage:
+ * snapshot create <time>   materialize the snapshot at <time> (i.e., FROM SNAPSHOT <time>)
+ * snapshot drop <time>     drop the snapshot at <time>
+ * snapshot list            list the snapshots
+ */
+static void run_snapshot(ConsoleProxy *proxy, int argc, char **argv)
+{
+    // use the leader proxy thread on each server to materialize its own snapshots
+    if (!LEADER(proxy))
+        return;
+
+    std::string op = (argc > 1) ? argv[1] : "";
+    if (op.compare(0, 2, "--") == 0)
+        op = op.substr(2);  // e.g., --create
+    if (op == "help" || op == "-h") {
+        if (MASTER(proxy))
+            std::cout << snapshot_desc;
+        return;
+    }
+
+#ifdef TRDF_MODE
+    DGraph *graph = proxy->get_graph();
+    if (op == "list" && argc == 2) {
+        for (auto const &view : graph->snapshot_views.list())
+            logstream(LOG_INFO) << PRINT_ID(proxy) << " snapshot [" << view->ts << ", " << view->te << "]: "
+                                << view->num_edges() << " edges of " << view->num_keys() << " keys ("
+                                << B2MiB(view->mem_usage()) << "MB)" << LOG_endl;
+        return;
+    }
+
+    // the same time interval as FROM SNAPSHOT <time>
+    int64_t ts, te;
+    std::string time = (argc == 3) ? argv[2] : "";
+    if (time.size() > 2 && time.front() == '<' && time.back() == '>')
+        time = time.substr(1, time.size() - 2);
+    if ((op != "create" && op != "drop") || !time_tool::snapshot2interval(time, ts, te)) {
+        if (MASTER(proxy)) fail_to_parse(proxy, argc, argv);
+        return;
+    }
+
+    /// do snapshot create/drop
+    if (op == "create") {
+        if (!graph->create_snapshot_view(ts, te))
+            logstream(LOG_ERROR) << PRINT_ID(proxy) << " Failed to materialize the snapshot at " << time
+                                 << " beyond global_snapshot_view_size_mb." << LOG_endl;
+    } else if (!graph->snapshot_views.drop(ts, te)) {
+        logstream(LOG_WARNING) << PRINT_ID(proxy) << " No snapshot at " << time << LOG_endl;
+    }
+#else
+    if (MASTER(proxy))
+        logstream(LOG_ERROR) << "Snapshots are only supported by temporal RDF (TRDF_MODE)." << LOG_endl;
+#endif
+}
+
 /**
  * run the 'load-stat' command
  * usage:
@@ -1008,6 +1145,10 @@ void run_console(ConsoleProxy *proxy)
                 run_load(proxy, argc, argv);
             } else if (cmd_type == "gsck") {
                 run_gsck(proxy, argc, argv);
+            } else if (cmd_type == "gstore") {
+                run_gstore(proxy, argc, argv);
+            } else if (cmd_type == "snapshot") {
+                run_snapshot(proxy, argc, argv);
             } else if (cmd_type == "load-stat") {
                 run_load_stat(proxy, argc, argv);
             } else if (cmd_type == "store-stat") {
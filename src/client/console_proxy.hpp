@@ -113,28 +113,38 @@ private:
         }
     }
 
+    DGraph* graph;
+
 public:
     Monitor monitor;
 
     ConsoleProxy(int sid, int tid, StringMapping* str_server, DGraph* graph,
                  Adaptor* adaptor, Stats* stats)
-        : Proxy(sid, tid, str_server, graph, adaptor, stats) {}
+        : Proxy(sid, tid, str_server, graph, adaptor, stats), graph(graph) {}
 
     Stats* get_stats() { return this->stats; }
 
+    DGraph* get_graph() { return this->graph; }
+
     // output result of current query
     void output_result(std::ostream& stream, SPARQLQuery& q, int sz) {
+        int ncols = q.result.col_num;
+        std::vector<std::pair<bool, std::string>> strs;
         for (int i = 0; i < sz; i++) {
+            // translate the IDs of the next rows by a batch
+            int off = i % PROXY_TRANS_ROWS;
+            if (off == 0)
+                strs = translate_rows(q.result, i, std::min(i + PROXY_TRANS_ROWS, sz), ncols);
+
             stream << i + 1 << ": ";
 
             // entity
-            for (int j = 0; j < q.result.col_num; j++) {
-                int id = q.result.get_row_col(i, j);
-                auto map_result = str_server->id2str(tid, id);
+            for (int j = 0; j < ncols; j++) {
+                auto& map_result = strs[off * ncols + j];
                 if (map_result.first)
                     stream << map_result.second << "\t";
                 else
-                    stream << id << "\t";
+                    stream << q.result.get_row_col(i, j) << "\t";
             }
 
             // attribute
@@ -435,6 +445,12 @@ public:
 
         monitor.finish();
 
+        if (Global::enable_planner) {
+            const PlanCache &cache = planner.get_plan_cache();
+            logstream(LOG_DEBUG) << "#" << tid << " plan cache: " << cache.num_hits() << " hits, "
+                                 << cache.num_misses() << " misses, " << cache.size() << " plans" << LOG_endl;
+        }
+
         return 0;  // success
     }              // end of run_query_emu
 
@@ -26,6 +26,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/unordered_map.hpp>
@@ -52,6 +53,9 @@
 #include "utils/timer.hpp"
 #include "utils/time_tool.hpp"
 
+// the #rows of results translated (id2str) by a batch
+#define PROXY_TRANS_ROWS 4096
+
 namespace wukong {
 
 class Proxy;
@@ -131,7 +135,7 @@ protected:
      *  Send given bundle to given server(@dst_sid).
      */
     inline bool send(Bundle& bundle, int dst_sid) {
-        std::string msg = bundle.to_str();
+        std::string msg = bundle.take_str();
         send(msg, dst_sid);
     }
 
@@ -221,6 +225,20 @@ protected:
 
         return success;
     }
+
+    /**
+     * Translate the first ncols ID columns of the result rows [start, end)
+     * by a batch, instead of one id2str per cell (row-major).
+     */
+    std::vector<std::pair<bool, std::string>> translate_rows(SPARQLQuery::Result& result,
+                                                             int start, int end, int ncols) {
+        std::vector<sid_t> ids;
+        ids.reserve((uint64_t)(end - start) * ncols);
+        for (int i = start; i < end; i++)
+            for (int j = 0; j < ncols; j++)
+                ids.push_back(result.get_row_col(i, j));
+        return str_server->id2str_batch(tid, ids);
+    }
 };
 
 }  // namespace wukong
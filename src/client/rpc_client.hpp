@@ -27,6 +27,8 @@
 #include <string>
 #include <vector>
 
+#include "nlohmann/json.hpp"
+
 #include "core/common/global.hpp"
 #include "core/common/errors.hpp"
 #include "core/common/status.hpp"
@@ -121,6 +123,67 @@ public:
         return Status(ret, err_msgs[ret]);
     }
 
+    /**
+     * @brief Prepare a query w/ placeholders (e.g., %ub:Course) for the constants,
+     *        which is parsed and kept by the server for execute_prepared_query.
+     *
+     * @param query The query to be prepared.
+     * @param handle The handle of the prepared query (-1 if failed).
+     *
+     * @return Status that indicates whether the query has been prepared.
+     */
+    Status prepare_sparql_query(std::string query, int& handle, int timeout = ConnectTimeoutMs) {
+        if (timeout <= 0) timeout = ConnectTimeoutMs;
+        std::string reply_msg;
+        int ret = cl->call(RPC_CODE::PREPARE_RPC, reply_msg, timeout, query);
+        ASSERT_GE(ret, 0);
+
+        handle = -1;
+        if (ret == SUCCESS) {
+            nlohmann::json reply = nlohmann::json::parse(reply_msg, nullptr, false);
+            if (reply.is_object() && reply["Handle"].is_number_integer())
+                handle = reply["Handle"].get<int>();
+        }
+        return Status(ret, err_msgs[ret]);
+    }
+
+    /**
+     * @brief Execute a prepared query.
+     *
+     * @param handle The handle of the prepared query.
+     * @param bindings The constants (e.g., <IRI>) of the placeholders in order.
+     * @param result The result of the query (the same as execute_sparql_query).
+     *
+     * @return Status that indicates whether the query has succeeded.
+     */
+    Status execute_prepared_query(int handle, const std::vector<std::string>& bindings,
+                                  std::string& result, int timeout = ConnectTimeoutMs) {
+        if (timeout <= 0) timeout = ConnectTimeoutMs;
+        nlohmann::json request;
+        request["Handle"] = handle;
+        request["Bindings"] = bindings;
+        int ret = cl->call(RPC_CODE::EXECUTE_RPC, result, timeout, request.dump());
+        ASSERT_GE(ret, 0);
+        return Status(ret, err_msgs[ret]);
+    }
+
+    /**
+     * @brief Release a prepared query, which is kept by the server until released.
+     *
+     * @param handle The handle of the prepared query.
+     *
+     * @return Status that indicates whether the query has been released.
+     */
+    Status release_prepared_query(int handle, int timeout = ConnectTimeoutMs) {
+        if (timeout <= 0) timeout = ConnectTimeoutMs;
+        nlohmann::json request;
+        request["Handle"] = handle;
+        std::string reply_msg;
+        int ret = cl->call(RPC_CODE::RELEASE_RPC, reply_msg, timeout, request.dump());
+        ASSERT_GE(ret, 0);
+        return Status(ret, err_msgs[ret]);
+    }
+
 };
 
 }  // namespace wukong
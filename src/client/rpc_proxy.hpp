@@ -22,9 +22,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <sstream> 
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -65,6 +67,9 @@ public:
         // register handlers
         srv->reg(RPC_CODE::INFO_RPC, this, &RPCProxy::retrieve_cluster_info);
         srv->reg(RPC_CODE::SPARQL_RPC, this, &RPCProxy::execute_sparql_task);
+        srv->reg(RPC_CODE::PREPARE_RPC, this, &RPCProxy::prepare_sparql_task);
+        srv->reg(RPC_CODE::EXECUTE_RPC, this, &RPCProxy::execute_prepared_task);
+        srv->reg(RPC_CODE::RELEASE_RPC, this, &RPCProxy::release_prepared_task);
         // start server
         srv->start();
     }
@@ -74,6 +79,19 @@ protected:
     uint32_t port;
     RPCS *srv;
 
+    // a prepared query, which is parsed and ID-resolved once, and planned
+    // by its first bindings (see execute_prepared_task). It is planned again
+    // once the statistics are reloaded (see Stats::version).
+    struct Statement {
+        SPARQLQuery_Template raw;  // as prepared (w/o plan)
+        SPARQLQuery_Template tpl;  // w/ the plan of the statistics of the version
+        bool planned = false;
+        uint64_t version = 0;
+    };
+
+    std::unordered_map<int, Statement> statements;  // handle -> prepared query (until RELEASE_RPC)
+    int next_handle = 0;
+
     void reply2json(SPARQLQuery& reply, json& json_result) {
         static const char* type_name[3] = {"INT_t", "DOUBLE_t", "FLOAT_t"};
 
@@ -95,15 +113,31 @@ protected:
         json_result["Size"]["Col"] = result.get_col_num() + result.get_attr_col_num();
         json_result["Size"]["Row"] = result.row_num;
 
+        // the names of (normal and attribute) columns, e.g., the results of aggregates
+        std::vector<std::string> names, attr_names;
+        for (int j = 0; j < result.required_vars_name.size(); j++) {
+            if (result.var_type(result.required_vars[j]) == SID_t)
+                names.push_back(result.required_vars_name[j]);
+            else
+                attr_names.push_back(result.required_vars_name[j]);
+        }
+
         // the result data
+        int ncols = result.get_col_num();
+        std::vector<std::pair<bool, std::string>> strs;
         for (int i = 0; i < display_rows; i++) {
             json row;
 
+            // translate the IDs of the next rows by a batch
+            int off = i % PROXY_TRANS_ROWS;
+            if (off == 0)
+                strs = translate_rows(result, i, std::min(i + PROXY_TRANS_ROWS, display_rows), ncols);
+
             // result vid
-            for (int j = 0; j < result.required_vars.size(); j++) {
-                std::string col_name = result.required_vars_name[j];
+            for (int j = 0; j < ncols; j++) {
+                std::string col_name = (j < names.size()) ? names[j] : "col" + std::to_string(j);
                 int id = result.get_row_col(i, j);
-                auto map_result = str_server->id2str(tid, id);
+                auto& map_result = strs[off * ncols + j];
 
                 json element = {{"type", "STRING_t"}};
                 if (map_result.first) element["value"] = map_result.second;
@@ -132,7 +166,7 @@ protected:
                 default:
                     assert(false);
                 }
-                row["attr" + std::to_string(c)] = element;
+                row[(c < attr_names.size()) ? attr_names[c] : "attr" + std::to_string(c)] = element;
             }
 
             // add row to json
@@ -186,6 +220,11 @@ protected:
         }
 
         // Execute the SPARQL query
+        run_request(request, reply);
+        return 0;
+    }  // end of run_single_query
+
+    void run_request(SPARQLQuery& request, SPARQLQuery& reply) {
         setpid(request);
         // only take back results of the last request if not silent
         request.result.blind = Global::silent;
@@ -196,11 +235,9 @@ protected:
         reply = recv_reply();
         end = timer::get_usec();
         logstream(LOG_INFO) << "latency: " << (end - start) << " usec" << LOG_endl;
-       
-        reply.result.required_vars_name = request.result.required_vars_name;
 
-        return 0;
-    }  // end of run_single_query
+        reply.result.required_vars_name = request.result.required_vars_name;
+    }
 
     int execute_sparql_task(std::string msg_in, std::string& msg_out) {
         // forward to engines
@@ -240,6 +277,146 @@ protected:
         return SUCCESS;
     }
 
+    /**
+     * @brief Prepare a SPARQL query w/ placeholders (e.g., %ub:Course) for
+     *        the constants, which are bound by EXECUTE_RPC in order
+     *
+     * @param msg_in the query text (like the templates of sparql-emu)
+     * @param msg_out {"StatusMsg": 0, "Handle": <handle>, "Bindings": <#placeholders>}
+     */
+    int prepare_sparql_task(std::string msg_in, std::string& msg_out) {
+        logstream(LOG_INFO) << "[RPCProxy] receive PREPARE_RPC request." << LOG_endl;
+
+        json json_res;
+        try {
+            Statement stmt;
+            std::istringstream query(msg_in);
+            int ret = parser.parse_template(query, stmt.raw);
+            if (ret != SUCCESS)
+                throw WukongException(ret);
+            stmt.tpl = stmt.raw;
+
+            int handle = next_handle++;
+            json_res["StatusMsg"] = SUCCESS;
+            json_res["Handle"] = handle;
+            json_res["Bindings"] = stmt.tpl.ptypes_pos.size();
+            statements[handle] = std::move(stmt);
+        } catch (WukongException &ex) {
+            logstream(LOG_ERROR) << "Prepare failed [ERRNO " << ex.code() << "]: "
+                                 << ERR_MSG(ex.code()) << LOG_endl;
+            return ex.code();
+        }
+
+        msg_out = json_res.dump();
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Execute a prepared query w/ the constants of its placeholders
+     *
+     * @param msg_in {"Handle": <handle>, "Bindings": ["<IRI>", ...]}
+     * @param msg_out the result (the same as SPARQL_RPC)
+     */
+    int execute_prepared_task(std::string msg_in, std::string& msg_out) {
+        logstream(LOG_DEBUG) << "[RPCProxy] receive EXECUTE_RPC request." << LOG_endl;
+
+        json json_res;
+        try {
+            json req = json::parse(msg_in, nullptr, false);
+            if (!req.is_object() || !req["Handle"].is_number_integer() || !req["Bindings"].is_array())
+                throw WukongException(SYNTAX_ERROR);
+
+            auto it = statements.find(req["Handle"].get<int>());
+            if (it == statements.end() || req["Bindings"].size() != it->second.tpl.ptypes_pos.size())
+                throw WukongException(UNKNOWN_PREPARED);
+            Statement &stmt = it->second;
+
+            std::vector<sid_t> consts;
+            for (auto &b : req["Bindings"]) {
+                if (!b.is_string())
+                    throw WukongException(SYNTAX_ERROR);
+                auto map_result = str_server->str2id(tid, b.get<std::string>());
+                if (!map_result.first) {
+                    logstream(LOG_ERROR) << "Unknown binding: " << b.get<std::string>() << LOG_endl;
+                    throw WukongException(VERTEX_INVALID);
+                }
+                consts.push_back(map_result.second);
+            }
+
+            // the plan is stale once the statistics are reloaded
+            bool replan = Global::enable_planner && (!stmt.planned || stmt.version != stats->version);
+            if (replan && stmt.planned) {
+                stmt.tpl = stmt.raw;
+                stmt.planned = false;
+            }
+
+            SPARQLQuery request = stmt.tpl.instantiate(consts);
+            request.result.required_vars_name = stmt.tpl.required_vars_name;
+
+            SPARQLQuery reply;
+            bool skip = false;
+            if (replan) {
+                // plan the bindings, and keep the plan in the template
+                SPARQLQuery::PatternGroup raw = request.pattern_group;
+                uint64_t version = stats->version;
+                if (planner.generate_plan(request)) {
+                    PlanCache::plan_t plan;
+                    if (PlanCache::get_plan(raw, request.pattern_group, plan)) {
+                        planner.set_plan(stmt.tpl.pattern_group, plan, stmt.tpl.ptypes_pos);
+                        stmt.planned = true;
+                        stmt.version = version;
+                    }
+                } else {
+                    // A shortcut for contradictory queries (e.g., empty result)
+                    logstream(LOG_INFO) << "Query has no bindings, no need to execute it." << LOG_endl;
+                    skip = true;
+                }
+            }
+            if (!skip)
+                run_request(request, reply);
+
+            json_res["StatusMsg"] = reply.result.status_code;
+            if (reply.result.status_code == SUCCESS) {
+                reply2json(reply, json_res["Result"]);
+            } else throw WukongException(reply.result.status_code);
+        } catch (WukongException &ex) {
+            logstream(LOG_ERROR) << "Query failed [ERRNO " << ex.code() << "]: "
+                                 << ERR_MSG(ex.code()) << LOG_endl;
+            return ex.code();
+        }
+
+        msg_out = json_res.dump();
+        return SUCCESS;
+    }
+
+    /**
+     * @brief Release a prepared query, whose handle is invalid afterwards
+     *
+     * @param msg_in {"Handle": <handle>}
+     * @param msg_out {"StatusMsg": 0}
+     */
+    int release_prepared_task(std::string msg_in, std::string& msg_out) {
+        logstream(LOG_INFO) << "[RPCProxy] receive RELEASE_RPC request." << LOG_endl;
+
+        json json_res;
+        try {
+            json req = json::parse(msg_in, nullptr, false);
+            if (!req.is_object() || !req["Handle"].is_number_integer())
+                throw WukongException(SYNTAX_ERROR);
+
+            if (statements.erase(req["Handle"].get<int>()) == 0)
+                throw WukongException(UNKNOWN_PREPARED);
+            json_res["StatusMsg"] = SUCCESS;
+        } catch (WukongException &ex) {
+            logstream(LOG_ERROR) << "Release failed [ERRNO " << ex.code() << "]: "
+                                 << ERR_MSG(ex.code()) << LOG_endl;
+            return ex.code();
+        }
+
+        msg_out = json_res.dump();
+        return SUCCESS;
+    }
+
     int retrieve_cluster_info(int cid, std::string& msg_out) {
         logstream(LOG_INFO) << "[RPCProxy] receive INFO_RPC request." << LOG_endl;
         msg_out = "\tnode num: " + std::to_string(Global::num_servers) + "\n";
@@ -24,11 +24,15 @@
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/serialization/string.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 
 #include "core/common/errors.hpp"
+#include "core/common/global.hpp"
 #include "core/common/type.hpp"
 
 #include "core/sparql/query.hpp"
+#include "core/sparql/query_wire.hpp"
 
 #include "stringserver/sscache_request.hpp"
 
@@ -41,6 +45,17 @@ namespace wukong {
 /**
  * Bundle to be sent by network, with data type labeled
  * Note this class does not use boost serialization
+ *
+ * The data may hold the whole message (i.e., type + payload), called framed,
+ * which is the case of received bundles and SPARQL queries in the flat wire
+ * format (see QueryWire). A framed bundle is passed to and from the adaptor
+ * without copying the payload.
+ *
+ * NOTE: the adaptor still copies the message once into its transport buffer
+ * (i.e., the ZeroMQ message, or the RDMA buffer or ring buffer), since it
+ * sends std::string. Encoding into the transport buffer directly (see
+ * QueryWire::encode(q, buf)) would need the adaptor to reserve the buffer
+ * by the size first.
  */
 class Bundle {
 private:
@@ -49,8 +64,18 @@ private:
     void serialize(Archive &ar, const unsigned int version) {
         ar & type;
         ar & data;
+        ar & offset;
     }
 
+    uint64_t offset = 0;    // the offset of payload in data (non-zero if framed)
+
+    const char *payload() const { return data.data() + offset; }
+
+    uint64_t payload_size() const { return data.size() - offset; }
+
+    // boost archive over the payload (in place)
+    typedef boost::iostreams::stream<boost::iostreams::array_source> payload_stream;
+
 public:
     req_type type;
     std::string data;
@@ -59,9 +84,19 @@ public:
 
     Bundle(const req_type &t, const std::string &d): type(t), data(d) { }
 
-    Bundle(const Bundle &b): type(b.type), data(b.data) { }
+    Bundle(const Bundle &b): offset(b.offset), type(b.type), data(b.data) { }
 
     Bundle(const SPARQLQuery &r): type(SPARQL_QUERY) {
+        if (Global::enable_flat_wire) {
+            // encode the header and the query into the message in one pass
+            // (copied into the transport buffer by the adaptor)
+            data.append((const char *)&type, sizeof(req_type));
+            offset = sizeof(req_type);
+            QueryWire::encode(r, data);
+            return;
+        }
+
+        // fallback: boost serialization
         std::stringstream ss;
         boost::archive::binary_oarchive oa(ss);
 
@@ -93,21 +128,28 @@ public:
         data = ss.str();
     }
 
-    Bundle(const std::string str) { init(str); }
+    Bundle(std::string str) { init(std::move(str)); }
 
-    void init(const std::string str) {
+    void init(std::string str) {
+        ASSERT(str.length() >= sizeof(req_type));
         memcpy(&type, str.c_str(), sizeof(req_type));
-        std::string d(str, sizeof(req_type), str.length() - sizeof(req_type));
-        data = d;
+        // keep the message as is and skip the type (no copy)
+        data = std::move(str);
+        offset = sizeof(req_type);
     }
 
     // SPARQLQuery command
     SPARQLQuery get_sparql_query() const {
         ASSERT(type == SPARQL_QUERY);
 
-        std::stringstream ss;
-        ss << data;
+        // decode the flat wire format in place
+        if (QueryWire::match(payload(), payload_size())) {
+            SPARQLQuery result;
+            QueryWire::decode(payload(), payload_size(), result);
+            return result;
+        }
 
+        payload_stream ss(payload(), payload_size());
         boost::archive::binary_iarchive ia(ss);
         SPARQLQuery result;
         ia >> result;
@@ -118,9 +160,7 @@ public:
     RDFLoad get_rdf_load() const {
         ASSERT(type == DYNAMIC_LOAD);
 
-        std::stringstream ss;
-        ss << data;
-
+        payload_stream ss(payload(), payload_size());
         boost::archive::binary_iarchive ia(ss);
         RDFLoad result;
         ia >> result;
@@ -131,9 +171,7 @@ public:
     GStoreCheck get_gstore_check() const {
         ASSERT(type == GSTORE_CHECK);
 
-        std::stringstream ss;
-        ss << data;
-
+        payload_stream ss(payload(), payload_size());
         boost::archive::binary_iarchive ia(ss);
         GStoreCheck result;
         ia >> result;
@@ -143,9 +181,7 @@ public:
     SSCacheRequest get_sscache_req() const {
         ASSERT(type == SSCACHE_REQ);
 
-        std::stringstream ss;
-        ss << data;
-
+        payload_stream ss(payload(), payload_size());
         boost::archive::binary_iarchive ia(ss);
         SSCacheRequest result;
         ia >> result;
@@ -153,17 +189,23 @@ public:
     }
 
     std::string to_str() const {
-#if 1 // FIXME
-        char *c_str = new char[sizeof(req_type) + data.length()];
-        memcpy(c_str, &type, sizeof(req_type));
-        memcpy(c_str + sizeof(req_type), data.c_str(), data.length());
-        std::string str(c_str, sizeof(req_type) + data.length());
-        delete []c_str;
+        if (offset == sizeof(req_type))
+            return data;    // framed
+
+        std::string str;
+        str.reserve(sizeof(req_type) + payload_size());
+        str.append((const char *)&type, sizeof(req_type));
+        str.append(payload(), payload_size());
         return str;
-#else
-        // FIXME: why not work? (Rong)
-        return std::string(std::to_string((uint64_t)type) + data);
-#endif
+    }
+
+    // move the message out of the bundle (no copy if framed)
+    std::string take_str() {
+        if (offset != sizeof(req_type))
+            return to_str();
+
+        offset = 0;
+        return std::move(data);
     }
 
 };
@@ -61,6 +61,23 @@ static bool set_immutable_config(std::string cfg_name, std::string value)
         // force a "/" at the end of Global::input_folder.
         if (Global::input_folder[Global::input_folder.length() - 1] != '/')
             Global::input_folder = Global::input_folder + "/";
+    } else if (cfg_name == "global_snapshot_folder") {
+        Global::snapshot_folder = value;
+
+        // force a "/" at the end of Global::snapshot_folder.
+        if (Global::snapshot_folder.length() > 0
+                && Global::snapshot_folder[Global::snapshot_folder.length() - 1] != '/')
+            Global::snapshot_folder = Global::snapshot_folder + "/";
+    } else if (cfg_name == "global_load_budget_mb") {
+        Global::load_budget_mb = atoi(value.c_str());
+        ASSERT(Global::load_budget_mb >= 0);
+    } else if (cfg_name == "global_load_spill_folder") {
+        Global::load_spill_folder = value;
+
+        // force a "/" at the end of Global::load_spill_folder.
+        if (Global::load_spill_folder.length() == 0
+                || Global::load_spill_folder[Global::load_spill_folder.length() - 1] != '/')
+            Global::load_spill_folder = Global::load_spill_folder + "/";
     } else if (cfg_name == "global_data_port_base") {
         Global::data_port_base = atoi(value.c_str());
         ASSERT(Global::data_port_base > 0);
@@ -83,6 +100,12 @@ static bool set_immutable_config(std::string cfg_name, std::string value)
     } else if (cfg_name == "global_est_load_factor") {
         Global::est_load_factor = atoi(value.c_str());
         ASSERT(Global::est_load_factor > 0 && Global::est_load_factor < 100);
+    } else if (cfg_name == "global_time_index_threshold") {
+        Global::time_index_threshold = atoi(value.c_str());
+        ASSERT(Global::time_index_threshold >= 0);
+    } else if (cfg_name == "global_snapshot_view_size_mb") {
+        Global::snapshot_view_size_mb = atoi(value.c_str());
+        ASSERT(Global::snapshot_view_size_mb >= 0);
     } else if (cfg_name == "global_rdma_buf_size_mb") {
         if (RDMA::get_rdma().has_rdma())
             Global::rdma_buf_size_mb = atoi(value.c_str());
@@ -140,18 +163,32 @@ static bool set_mutable_config(std::string cfg_name, std::string value)
     } else if (cfg_name == "global_mt_threshold") {
         Global::mt_threshold = atoi(value.c_str());
         ASSERT(Global::mt_threshold > 0);
+    } else if (cfg_name == "global_enable_columnar") {
+        Global::enable_columnar = atoi(value.c_str());
+    } else if (cfg_name == "global_enable_flat_wire") {
+        Global::enable_flat_wire = atoi(value.c_str());
+    } else if (cfg_name == "global_dedup_threshold") {
+        Global::dedup_threshold = atoi(value.c_str());
+        ASSERT(Global::dedup_threshold >= 0 && Global::dedup_threshold <= 100);
+    } else if (cfg_name == "global_morsel_size") {
+        Global::morsel_size = atoi(value.c_str());
+        ASSERT(Global::morsel_size >= 0);
     } else if (cfg_name == "global_enable_caching") {
         Global::enable_caching = atoi(value.c_str());
     } else if (cfg_name == "global_enable_workstealing") {
         Global::enable_workstealing = atoi(value.c_str());
     } else if (cfg_name == "global_stealing_pattern") {
         Global::stealing_pattern = atoi(value.c_str());
+        ASSERT(Global::stealing_pattern >= 0 && Global::stealing_pattern <= 2);
     } else if (cfg_name == "global_silent") {
         Global::silent = atoi(value.c_str());
     } else if (cfg_name == "global_enable_planner") {
         Global::enable_planner = atoi(value.c_str());
     } else if (cfg_name == "global_enable_budget") {
         Global::enable_budget = atoi(value.c_str());
+    } else if (cfg_name == "global_plan_cache_size") {
+        Global::plan_cache_size = atoi(value.c_str());
+        ASSERT(Global::plan_cache_size >= 0);
     } else if (cfg_name == "global_enable_vattr") {
         Global::enable_vattr = atoi(value.c_str());
     } else if (cfg_name == "global_gpu_enable_pipeline") {
@@ -262,8 +299,13 @@ void print_config(void)
     std::cout << "the number of proxies: "        << Global::num_proxies           << LOG_endl;
     std::cout << "the number of engines: "        << Global::num_engines           << LOG_endl;
     std::cout << "global_input_folder: "          << Global::input_folder          << LOG_endl;
+    std::cout << "global_snapshot_folder: "       << Global::snapshot_folder       << LOG_endl;
+    std::cout << "global_load_budget_mb: "        << Global::load_budget_mb        << LOG_endl;
+    std::cout << "global_load_spill_folder: "     << Global::load_spill_folder     << LOG_endl;
     std::cout << "global_memstore_size_gb: "      << Global::memstore_size_gb      << LOG_endl;
     std::cout << "global_est_load_factor: "       << Global::est_load_factor       << LOG_endl;
+    std::cout << "global_time_index_threshold: "  << Global::time_index_threshold  << LOG_endl;
+    std::cout << "global_snapshot_view_size_mb: " << Global::snapshot_view_size_mb << LOG_endl;
     std::cout << "global_data_port_base: "        << Global::data_port_base        << LOG_endl;
     std::cout << "global_ctrl_port_base: "        << Global::ctrl_port_base        << LOG_endl;
     std::cout << "global_server_port_base: "      << Global::server_port_base      << LOG_endl;
@@ -275,12 +317,17 @@ void print_config(void)
     std::cout << "global_stealing_pattern: "      << Global::stealing_pattern      << LOG_endl;
     std::cout << "global_rdma_threshold: "        << Global::rdma_threshold        << LOG_endl;
     std::cout << "global_mt_threshold: "          << Global::mt_threshold          << LOG_endl;
+    std::cout << "global_enable_columnar: "       << Global::enable_columnar       << LOG_endl;
+    std::cout << "global_enable_flat_wire: "      << Global::enable_flat_wire      << LOG_endl;
+    std::cout << "global_dedup_threshold: "       << Global::dedup_threshold       << LOG_endl;
+    std::cout << "global_morsel_size: "           << Global::morsel_size           << LOG_endl;
     std::cout << "global_enable_standalone_str_server: "   << Global::enable_standalone_str_server   << LOG_endl;
     std::cout << "global_standalone_str_server_addr: "     << Global::standalone_str_server_addr     << LOG_endl;
     std::cout << "global_silent: "                << Global::silent                << LOG_endl;
     std::cout << "global_enable_planner: "        << Global::enable_planner        << LOG_endl;
     std::cout << "global_generate_statistics: "   << Global::generate_statistics   << LOG_endl;
     std::cout << "global_enable_budget: "         << Global::enable_budget         << LOG_endl;
+    std::cout << "global_plan_cache_size: "       << Global::plan_cache_size       << LOG_endl;
     std::cout << "global_enable_vattr: "          << Global::enable_vattr          << LOG_endl;
     std::cout << "global_num_gpus: "              << Global::num_gpus              << LOG_endl;
     std::cout << "global_gpu_rdma_buf_size_mb: "  << Global::gpu_rdma_buf_size_mb  << LOG_endl;
@@ -43,6 +43,8 @@ enum {
     FIRST_PATTERN_ERROR,
     UNKNOWN_FILTER,
     FILE_NOT_FOUND,
+    UNSUPPORT_AGGREGATE,
+    UNKNOWN_PREPARED,
     ERROR_LAST
 };
 
@@ -61,7 +63,9 @@ static const char *err_msgs[ERROR_LAST] = {
     "You may change SETTING files to avoid this error. (e.g. global.hpp/config/...)",
     "Const_X_X or index_X_X must be the first pattern.",
     "Unsupported filter type.",
-    "Query file not found."};
+    "Query file not found.",
+    "Unsupported aggregate (e.g., on timestamps).",
+    "Unknown prepared query or mismatched bindings."};
 
 // An exception
 struct WukongException : public std::exception {
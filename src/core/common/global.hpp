@@ -38,6 +38,9 @@ public:
     static int num_engines __attribute__((weak));
 
     static std::string input_folder __attribute__((weak));
+    static std::string snapshot_folder __attribute__((weak));
+    static int load_budget_mb __attribute__((weak));
+    static std::string load_spill_folder __attribute__((weak));
 
     static int data_port_base __attribute__((weak));
     static int ctrl_port_base __attribute__((weak));
@@ -52,6 +55,11 @@ public:
 
     static int mt_threshold __attribute__((weak));
 
+    static bool enable_columnar __attribute__((weak));
+    static bool enable_flat_wire __attribute__((weak));
+    static int dedup_threshold __attribute__((weak));
+    static int morsel_size __attribute__((weak));
+
     static bool enable_caching __attribute__((weak));
     static bool enable_workstealing __attribute__((weak));
     static int stealing_pattern __attribute__((weak));
@@ -64,11 +72,14 @@ public:
     static bool enable_planner __attribute__((weak));
     static bool generate_statistics __attribute__((weak));
     static bool enable_budget __attribute__((weak));
+    static int plan_cache_size __attribute__((weak));
 
     static bool enable_vattr __attribute__((weak));
 
     static int memstore_size_gb __attribute__((weak));
     static int est_load_factor __attribute__((weak));
+    static int time_index_threshold __attribute__((weak));
+    static int snapshot_view_size_mb __attribute__((weak));
 
     static int num_gpus __attribute__((weak));
     static int gpu_kvcache_size_gb __attribute__((weak));
@@ -87,6 +98,11 @@ int Global::num_proxies = 1;    // the number of proxies
 int Global::num_engines = 1;    // the number of engines
 
 std::string Global::input_folder;
+std::string Global::snapshot_folder;  // restore gstore from binary snapshots if given (see 'gstore snapshot')
+// bounded-memory loading: buffer at most #MB of triples per server and spill sorted runs
+// to load_spill_folder (0: load all triples in memory)
+int Global::load_budget_mb = 0;
+std::string Global::load_spill_folder = "/tmp/";
 
 int Global::data_port_base = 5500;
 int Global::ctrl_port_base = 9576;
@@ -101,9 +117,14 @@ int Global::rdma_threshold = 300;
 
 int Global::mt_threshold = 16;
 
+bool Global::enable_columnar = true;  // late materialization of intermediate results
+bool Global::enable_flat_wire = true; // flat binary encoding of SPARQL queries (or boost serialization)
+int Global::dedup_threshold = 20;      // dedup KNOWN vertices globally if saving >= 20% lookups (0 = disable)
+int Global::morsel_size = 65536;       // #rows per morsel of intra-query parallelism (0 = disable)
+
 bool Global::enable_caching = true;
-bool Global::enable_workstealing = false;
-int Global::stealing_pattern = 0;  // 0 = pair stealing,  1 = ring stealing
+bool Global::enable_workstealing = true;
+int Global::stealing_pattern = 2;  // 0 = pair stealing,  1 = ring stealing, 2 = random stealing
 
 bool Global::enable_standalone_str_server = false;
 std::string Global::standalone_str_server_addr;
@@ -113,6 +134,7 @@ bool Global::silent = true;  // don't take back results by default
 bool Global::enable_planner = true;  // for planner
 bool Global::generate_statistics = true;  // for planner
 bool Global::enable_budget = true;  // for planner
+int Global::plan_cache_size = 4096;  // the max #plans cached by a planner, keyed by query shapes (0 = disable)
 
 bool Global::enable_vattr = false;  // for attr
 
@@ -125,6 +147,10 @@ int Global::memstore_size_gb = 20;
  * #buckets = (#keys * 100) / (ASSOCIATIVITY * global_est_load_factor)
  */
 int Global::est_load_factor = 55;
+// index the temporal value lists w/ at least #edges by time intervals (TRDF_MODE, 0 = disable)
+int Global::time_index_threshold = 64;
+// the memory budget of materialized snapshots per server (TRDF_MODE, see 'snapshot create')
+int Global::snapshot_view_size_mb = 1024;
 
 // GPU support
 int Global::num_gpus = 0;
@@ -39,7 +39,10 @@ enum RPC_CODE {
     INFO_RPC = 0x7001,
     SPARQL_RPC,
     STRING_RPC,
-    EXIT_RPC
+    EXIT_RPC,
+    PREPARE_RPC,
+    EXECUTE_RPC,
+    RELEASE_RPC
 };
 
 enum StatusCode {
@@ -57,6 +57,12 @@ enum req_type {
     SSCACHE_REQ = 4 
 };
 
+#ifdef TRDF_MODE
+#define TRIPLE_NFIELDS 5  // s p o ts te
+#else
+#define TRIPLE_NFIELDS 3  // s p o
+#endif
+
 struct triple_t {
     sid_t s; // subject
     sid_t p; // predicate
@@ -69,9 +75,16 @@ struct triple_t {
     triple_t(sid_t _s, sid_t _p, sid_t _o, int64_t _ts, int64_t _te): s(_s), p(_p), o(_o), ts(_ts), te(_te) { }
 #endif
 
+#ifdef TRDF_MODE
+    // the triples w/o timestamps are always valid
+    triple_t(): s(0), p(0), o(0), ts(TIMESTAMP_MIN), te(TIMESTAMP_MAX) { }
+
+    triple_t(sid_t _s, sid_t _p, sid_t _o): s(_s), p(_p), o(_o), ts(TIMESTAMP_MIN), te(TIMESTAMP_MAX) { }
+#else
     triple_t(): s(0), p(0), o(0) { }
 
     triple_t(sid_t _s, sid_t _p, sid_t _o): s(_s), p(_p), o(_o) { }
+#endif
 
     triple_t(const triple_t& triple) {
         s = triple.s;
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <string.h>
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "core/common/errors.hpp"
+#include "core/common/type.hpp"
+
+#include "core/sparql/query.hpp"
+
+#include "stringserver/string_mapping.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+
+namespace wukong {
+
+/**
+ * GROUP BY and aggregates (COUNT/SUM/AVG/MIN/MAX) of SELECT queries
+ *
+ * Engines aggregate the rows of a (sub-)query into the groups of its
+ * AggTable, so that sub-queries only reply their groups to the parent
+ * query (merged by RMap). The engine replying to the proxy turns the
+ * final groups into the result table (incl. ORDER BY, OFFSET and LIMIT).
+ */
+class Aggregator {
+private:
+    static double attr2double(const attr_t &attr) {
+        switch (attr.which()) {
+        case 0: return boost::get<int>(attr);
+        case 1: return boost::get<double>(attr);
+        case 2: return boost::get<float>(attr);
+        default: ASSERT(false);
+        }
+        return 0;
+    }
+
+    // the column of a variable in the result table (-1 if unbound)
+    static int key_col(SPARQLQuery::Result &res, ssid_t var) {
+        int col = res.var2col(var);
+        if (col == NO_RESULT) return -1;
+        ASSERT_ERROR_CODE(res.var_type(var) == SID_t, UNSUPPORT_AGGREGATE);
+        return col;
+    }
+
+    // the result of MIN/MAX is a term (ID) unless it aggregates attributes
+    static bool is_attr_result(SPARQLQuery::Result &res, const SPARQLQuery::Aggregate &a) {
+        if (a.func == AGG_COUNT || a.func == AGG_SUM || a.func == AGG_AVG)
+            return true;
+        return (a.var != 0) && (res.var2col(a.var) != NO_RESULT)
+               && (res.var_type(a.var) != SID_t);
+    }
+
+    // the strings of (bound) terms w/o typed values, translated by a batch
+    static std::vector<std::string> untyped_strs(const std::vector<sid_t> &ids,
+                                                 const std::vector<typed_value_t> &vals,
+                                                 StringMapping *str_mapping, int tid) {
+        std::vector<std::string> strs(ids.size());
+        boost::unordered_map<sid_t, std::string> str_of;
+        std::vector<sid_t> untyped;
+        for (int i = 0; i < ids.size(); i++)
+            if (ids[i] != BLANK_ID && vals[i].kind == LIT_NONE
+                    && str_of.emplace(ids[i], std::string()).second)
+                untyped.push_back(ids[i]);
+        if (untyped.empty()) return strs;
+
+        auto map_results = str_mapping->id2str_batch(tid, untyped);
+        for (int i = 0; i < untyped.size(); i++)
+            if (map_results[i].first)
+                str_of[untyped[i]] = std::move(map_results[i].second);
+        for (int i = 0; i < ids.size(); i++)
+            if (ids[i] != BLANK_ID && vals[i].kind == LIT_NONE)
+                strs[i] = str_of[ids[i]];
+        return strs;
+    }
+
+    // ORDER BY on the groups (the strings of keys or the values of aggregates)
+    static void sort_groups(SPARQLQuery &r, std::vector<uint32_t> &groups,
+                            StringMapping *str_mapping, int tid) {
+        AggTable &agg = r.result.agg_table;
+
+        struct order_t { int key; int agg; bool descending; };
+        std::vector<order_t> orders;
+        std::vector<boost::unordered_map<sid_t, std::string>> strs(agg.nkeys);
+        for (auto const &o : r.orders) {
+            int k = std::find(r.group_by.begin(), r.group_by.end(), o.id) - r.group_by.begin();
+            if (k < agg.nkeys) {
+                orders.push_back({k, -1, o.descending});
+
+                // translate the distinct keys by a batch
+                std::vector<sid_t> ids;
+                for (uint32_t g : groups)
+                    if (strs[k].emplace(agg.key(g, k), std::string()).second)
+                        ids.push_back(agg.key(g, k));
+                auto map_results = str_mapping->id2str_batch(tid, ids);
+                for (int i = 0; i < ids.size(); i++)
+                    strs[k][ids[i]] = std::move(map_results[i].second);
+                continue;
+            }
+
+            for (int a = 0; a < r.aggregates.size(); a++)
+                if (r.aggregates[a].alias == o.id)
+                    orders.push_back({-1, a, o.descending});
+        }
+
+        std::stable_sort(groups.begin(), groups.end(), [&](uint32_t ga, uint32_t gb) {
+            for (auto const &o : orders) {
+                int cmp;
+                if (o.key != -1) {
+                    cmp = strs[o.key][agg.key(ga, o.key)].compare(strs[o.key][agg.key(gb, o.key)]);
+                } else {
+                    cmp = agg.compare(ga, gb, o.agg);
+                }
+                if (cmp != 0)
+                    return o.descending ? (cmp > 0) : (cmp < 0);
+            }
+            return false;
+        });
+    }
+
+public:
+    /**
+     * @brief Aggregate the rows of the query into its groups, and drop them
+     *        (i.e., only the groups are replied to the parent query)
+     */
+    static void aggregate(SPARQLQuery &r, StringMapping *str_mapping, int tid) {
+        SPARQLQuery::Result &res = r.result;
+        AggTable &agg = res.agg_table;
+        if (!agg.enabled()) {
+            std::vector<int32_t> funcs;
+            for (auto const &a : r.aggregates)
+                funcs.push_back(a.func);
+            agg.init(r.group_by.size(), funcs);
+        }
+
+        res.materialize();
+        int nrows = res.get_row_num();
+        if (nrows == 0) return;
+
+        // the group of each row
+        std::vector<int> key_cols;
+        for (ssid_t var : r.group_by)
+            key_cols.push_back(key_col(res, var));
+
+        std::vector<uint32_t> groups(nrows);
+        std::vector<sid_t> key(key_cols.size());
+        for (int row = 0; row < nrows; row++) {
+            for (int k = 0; k < key_cols.size(); k++)
+                key[k] = (key_cols[k] == -1) ? BLANK_ID : res.get_row_col(row, key_cols[k]);
+            groups[row] = agg.group(key.data());
+        }
+
+        for (int a = 0; a < r.aggregates.size(); a++) {
+            const SPARQLQuery::Aggregate &ag = r.aggregates[a];
+            int col = (ag.var == 0) ? NO_RESULT : res.var2col(ag.var);
+            bool is_attr = (col != NO_RESULT) && (res.var_type(ag.var) != SID_t);
+
+            // the IDs and typed values of the column
+            // (and the strings of the other terms for MIN/MAX)
+            std::vector<sid_t> ids(nrows, (ag.var == 0) ? 0 : BLANK_ID);
+            std::vector<typed_value_t> vals;
+            std::vector<std::string> strs;
+            if (is_attr) {
+                ASSERT_ERROR_CODE(res.var_type(ag.var) != TIME_t, UNSUPPORT_AGGREGATE);
+                vals.resize(nrows);
+                for (int row = 0; row < nrows; row++) {
+                    ids[row] = 0;
+                    vals[row] = typed_value_t(attr2double(res.get_attr_row_col(row, col)), LIT_NUMERIC);
+                }
+            } else if (col != NO_RESULT) {
+                for (int row = 0; row < nrows; row++)
+                    ids[row] = res.get_row_col(row, col);
+                if (ag.func != AGG_COUNT)
+                    vals = str_mapping->typed_value_batch(tid, ids);
+                if (ag.func == AGG_MIN || ag.func == AGG_MAX)
+                    strs = untyped_strs(ids, vals, str_mapping, tid);
+            }
+            if (vals.empty()) vals.resize(nrows);
+            if (strs.empty()) strs.resize(nrows);
+
+            // DISTINCT by (group, term), or (group, value) for attributes
+            boost::unordered_set<std::pair<uint32_t, uint64_t>> seen;
+            for (int row = 0; row < nrows; row++) {
+                if (ag.distinct) {
+                    uint64_t v = ids[row];
+                    if (is_attr) memcpy(&v, &vals[row].val, sizeof(uint64_t));
+                    if (!seen.emplace(groups[row], v).second)
+                        continue;
+                }
+                agg.update(groups[row], a, ids[row], vals[row], strs[row]);
+            }
+        }
+
+        // drop the aggregated rows
+        res.result_table.clear();
+        res.attr_res_table.clear();
+    #ifdef TRDF_MODE
+        res.time_res_table.clear();
+    #endif
+        res.optional_matched_rows.clear();
+        res.update_nrows();
+    }
+
+    /**
+     * @brief Turn the groups into the result table of the requested variables
+     *        (i.e., grouped variables and the results of aggregates)
+     */
+    static void finalize(SPARQLQuery &r, StringMapping *str_mapping, int tid) {
+        SPARQLQuery::Result &res = r.result;
+        AggTable &agg = res.agg_table;
+        aggregate(r, str_mapping, tid);  // the rest of rows
+
+        // a single (empty) group w/o GROUP BY, e.g., COUNT(*) is 0
+        if (agg.nkeys == 0 && agg.size() == 0)
+            agg.group(nullptr);
+
+        std::vector<uint32_t> groups(agg.size());
+        std::iota(groups.begin(), groups.end(), 0);
+
+        // ORDER BY
+        if (r.orders.size() > 0)
+            sort_groups(r, groups, str_mapping, tid);
+
+        // OFFSET and LIMIT
+        uint64_t start = std::min<uint64_t>(r.offset, groups.size());
+        uint64_t end = groups.size();
+        if (r.limit >= 0)
+            end = std::min<uint64_t>(start + r.limit, end);
+
+        // the columns of requested variables (a key or an aggregate)
+        struct out_col_t { ssid_t var; int key; int agg; };
+        std::vector<out_col_t> normal_cols, attr_cols;
+        for (ssid_t var : res.required_vars) {
+            int k = std::find(r.group_by.begin(), r.group_by.end(), var) - r.group_by.begin();
+            if (k < agg.nkeys) {
+                normal_cols.push_back({var, k, -1});
+                continue;
+            }
+
+            int a = 0;
+            while (a < r.aggregates.size() && r.aggregates[a].alias != var) a++;
+            ASSERT_ERROR_CODE(a < r.aggregates.size(), NO_REQUIRED_VAR);
+            if (is_attr_result(res, r.aggregates[a]))
+                attr_cols.push_back({var, -1, a});
+            else
+                normal_cols.push_back({var, -1, a});
+        }
+
+        std::vector<sid_t> table;
+        std::vector<attr_t> attr_table;
+        table.reserve((end - start) * normal_cols.size());
+        attr_table.reserve((end - start) * attr_cols.size());
+        for (uint64_t i = start; i < end; i++) {
+            uint32_t g = groups[i];
+            for (auto const &c : normal_cols) {
+                if (c.key != -1)
+                    table.push_back(agg.key(g, c.key));
+                else  // MIN/MAX
+                    table.push_back(agg.count(g, c.agg) > 0 ? agg.id(g, c.agg) : BLANK_ID);
+            }
+            for (auto const &c : attr_cols) {
+                if (agg.funcs[c.agg] == AGG_COUNT)
+                    attr_table.push_back(attr_t((int)agg.count(g, c.agg)));
+                else
+                    attr_table.push_back(attr_t(agg.value(g, c.agg)));
+            }
+        }
+
+        // update metadata (the variables are mapped to the new columns)
+        std::vector<int> v2c_map(res.nvars, NO_RESULT);
+        res.v2c_map.swap(v2c_map);
+        for (int j = 0; j < normal_cols.size(); j++)
+            res.add_var2col(normal_cols[j].var, j);
+        for (int j = 0; j < attr_cols.size(); j++) {
+            int t = (agg.funcs[attr_cols[j].agg] == AGG_COUNT) ? INT_t : DOUBLE_t;
+            res.add_var2col(attr_cols[j].var, j, t);
+        }
+
+        res.result_table.swap(table);
+        res.attr_res_table.swap(attr_table);
+        res.set_col_num(normal_cols.size());
+        res.set_attr_col_num(attr_cols.size());
+    #ifdef TRDF_MODE
+        res.set_time_col_num(0);
+    #endif
+        res.row_num = end - start;  // also w/o normal columns (e.g., only COUNT)
+        agg.clear();
+    }
+};
+
+} // namespace wukong
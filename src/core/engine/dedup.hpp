@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "core/common/global.hpp"
+#include "core/common/type.hpp"
+
+#include "core/store/vertex.hpp"
+
+namespace wukong {
+
+/**
+ * @brief Deduplicate the KNOWN vertices (one per row) of a pattern step
+ *
+ * The same vertices share one lookup of their neighbors (see
+ * SPARQLEngine::get_triples_batch), i.e., consecutive ones, or all of them
+ * if need_global(). The neighbors are expanded back to rows after lookups.
+ */
+class KnownDedup {
+public:
+    static const uint64_t MIN_ROWS = 1024;  // too few rows to pay off sorting
+    static const uint64_t SAMPLE = 4096;    // the sample size to estimate #distinct
+
+    /// A simple cost model to decide whether to dedup KNOWN vertices globally
+    /// (by sorting) rather than only consecutive ones. It pays off if sorting
+    /// saves enough lookups (e.g., a fan-in-heavy column like ?Y of "?X ub:memberOf ?Y"),
+    /// especially when the lookups are remote reads.
+    static bool need_global(const std::vector<sid_t> &knowns) {
+        if (Global::dedup_threshold == 0 || knowns.size() < MIN_ROWS)
+            return false;
+
+        // the number of lookups w/ the consecutive dedup
+        uint64_t nconsec = 1;
+        for (uint64_t i = 1; i < knowns.size(); i++)
+            nconsec += (knowns[i] != knowns[i - 1]);
+
+        // the number of lookups w/ the global dedup, estimated from an evenly spaced
+        // sample (it overestimates #distinct, so the decision is conservative)
+        uint64_t step = std::max<uint64_t>(1, knowns.size() / SAMPLE);
+        std::vector<sid_t> sample;
+        sample.reserve(SAMPLE + 1);
+        for (uint64_t i = 0; i < knowns.size(); i += step)
+            sample.push_back(knowns[i]);
+        std::sort(sample.begin(), sample.end());
+        uint64_t ndistinct = std::unique(sample.begin(), sample.end()) - sample.begin();
+        uint64_t nglobal = std::min(nconsec, ndistinct * knowns.size() / sample.size());
+
+        return (nconsec - nglobal) * 100 >= nconsec * Global::dedup_threshold;
+    }
+
+    /// the vertices to look up (BLANK_ID is skipped), and the index of
+    /// the vertex of each row in vids (-1 for BLANK_ID)
+    static void dedup(const std::vector<sid_t> &knowns, std::vector<sid_t> &vids,
+                      std::vector<int64_t> &idxs) {
+        vids.clear();
+        idxs.resize(knowns.size());
+        if (need_global(knowns)) {
+            vids.reserve(knowns.size());
+            for (sid_t v : knowns)
+                if (v != BLANK_ID) vids.push_back(v);
+            std::sort(vids.begin(), vids.end());
+            vids.erase(std::unique(vids.begin(), vids.end()), vids.end());
+
+            for (uint64_t i = 0; i < knowns.size(); i++) {
+                if (knowns[i] == BLANK_ID) {
+                    idxs[i] = -1;
+                    continue;
+                }
+                idxs[i] = std::lower_bound(vids.begin(), vids.end(), knowns[i]) - vids.begin();
+            }
+        } else {
+            for (uint64_t i = 0; i < knowns.size(); i++) {
+                if (knowns[i] == BLANK_ID) {
+                    idxs[i] = -1;
+                    continue;
+                }
+                if (vids.empty() || knowns[i] != vids.back())
+                    vids.push_back(knowns[i]);
+                idxs[i] = vids.size() - 1;
+            }
+        }
+    }
+
+    /// the neighbors of each row (NULL and 0 for BLANK_ID) from those of vids
+    static void expand(const std::vector<int64_t> &idxs,
+                       const std::vector<edge_t *> &vid_edges, const std::vector<uint64_t> &vid_szs,
+                       std::vector<edge_t *> &edges, std::vector<uint64_t> &szs) {
+        edges.resize(idxs.size());
+        szs.resize(idxs.size());
+        for (uint64_t i = 0; i < idxs.size(); i++) {
+            edges[i] = (idxs[i] < 0) ? NULL : vid_edges[idxs[i]];
+            szs[i] = (idxs[i] < 0) ? 0 : vid_szs[idxs[i]];
+        }
+    }
+};
+
+} // namespace wukong
@@ -36,6 +36,7 @@
 #include "core/engine/sparql.hpp"
 #include "core/engine/rdf.hpp"
 #include "core/engine/msgr.hpp"
+#include "core/engine/work_deque.hpp"
 #ifdef TRDF_MODE
 #include "core/engine/tsparql.hpp"
 #endif
@@ -87,13 +88,39 @@ private:
                 return -1;
         } else if (Global::stealing_pattern == 1) { // ring stealing
             return ((own_id + offset) % Global::num_engines);
+        } else if (Global::stealing_pattern == 2) { // random stealing
+            int victim = rand_r(&seed) % (Global::num_engines - 1);
+            return (victim < own_id) ? victim : (victim + 1); // skip itself
         }
         return -1;
     }
 
-public:
-    const static uint64_t TIMEOUT_THRESHOLD = 10000; // 10 msec
+    /**
+     * @brief Steal a task from other engines
+     *
+     * Local sub-queries (e.g., fork-join, UNION and OPTIONAL) are preferred
+     * over new queries, since the parent query is waiting for them.
+     * Morsels of heavy queries are shared via morsel_pool instead.
+     */
+    bool steal(int own_id, SPARQLQuery &req) {
+        if (Global::num_engines < 2)
+            return false;
+
+        for (int offset = 1; offset < Global::num_engines; offset++) {
+            int victim = next_to_oblige(own_id, offset);
+            if (victim == -1)
+                break;
+            if (victim == own_id)
+                continue;
+
+            if (engines[victim]->sparql->prior_stage.steal(req)
+                    || engines[victim]->runqueue.steal(req))
+                return true;
+        }
+        return false;
+    }
 
+public:
     int sid;    // server id
     int tid;    // thread id
 
@@ -111,12 +138,13 @@ public:
     RDFEngine *rdf;
 
     bool at_work; // whether engine is at work or not
-    uint64_t last_time; // busy or not (work-oblige)
+    uint64_t last_time; // the last time of doing work (snooze)
+    unsigned int seed;  // random victim selection
 
-    tbb::concurrent_queue<SPARQLQuery> runqueue; // task queue for sparql queries
+    WorkDeque<SPARQLQuery> runqueue; // new SPARQL queries (stealable by other engines)
 
     Engine(int sid, int tid, StringMapping *str_mapping, DGraph *graph, Adaptor *adaptor)
-        : sid(sid), tid(tid), last_time(timer::get_usec()),
+        : sid(sid), tid(tid), last_time(timer::get_usec()), seed(tid),
           str_mapping(str_mapping), graph(graph), adaptor(adaptor) {
 
         coder = new Coder(sid, tid);
@@ -144,28 +172,39 @@ public:
         };
 
 
+        /// tasks are scheduled in the order of priority:
+        /// 1. local sub-queries (own prior_stage, LIFO)
+        /// 2. morsels of heavy queries (morsel_pool)
+        /// 3. replies of sub-queries and other requests (adaptor)
+        /// 4. new queries (own runqueue, FIFO)
+        /// 5. sub-queries and new queries of random victims (work-stealing)
         while (true) {
             at_work = false;
 
             // check and send pending messages first
             msgr->sweep_msgs();
 
-            // priority path: sparql stage (FIXME: only for SPARQL queries)
             SPARQLQuery req;
-            at_work = sparql->prior_stage.try_pop(req);
-            if (at_work) {
+            if (sparql->prior_stage.try_pop(req)) {
                 reset_snooze(at_work, last_time);
                 sparql->execute_sparql_query(req);
-                continue; // exhaust all queries
+                continue; // exhaust all sub-queries
             }
 
-            // normal path: own runqueue
+#ifndef TRDF_MODE
+            // help other engines to run morsels of heavy queries
+            if (sparql->run_morsel()) {
+                reset_snooze(at_work, last_time);
+                continue;
+            }
+#endif
+
             std::string msg;
             while (adaptor->tryrecv(msg)) {
                 Bundle bundle(msg);
                 if (bundle.type == SPARQL_QUERY) {
-                    // to be fair, engine will handle sub-queries priority,
-                    // instead of processing a new task.
+                    // to be fair, engine will handle sub-queries and replies
+                    // (priority != 0) first, instead of processing a new task.
                     SPARQLQuery req = bundle.get_sparql_query();
                     if (req.priority != 0) {
                         reset_snooze(at_work, last_time);
@@ -181,47 +220,25 @@ public:
                     break;
                 }
             }
+            if (at_work) continue;
 
-            if (!at_work) {
-                SPARQLQuery req;
-                if (runqueue.try_pop(req)) {
-                    // process a new SPARQL query
-                    reset_snooze(at_work, last_time);
-                    sparql->execute_sparql_query(req);
-                }
+            // NOTE: the owner also takes new queries from the top of runqueue,
+            // such that they are processed in FIFO order (tail latency)
+            if (runqueue.steal(req)) {
+                reset_snooze(at_work, last_time);
+                sparql->execute_sparql_query(req);
+                continue;
             }
 
-            /// do work-obliger
-            // FIXME: Currently, we only steal SPARQL queries from the neighboring runqueues,
-            //        If we could steal jobs from adaptor, it will significantly improve the effect
-            //        Howeverm, we could not know the type of jobs in advance, and our work-obliger
-            //        mechanism only works well with SPARQL queries.
-            if (Global::enable_workstealing) {
-                bool success;
-                int offset = 1;
-                int next_engine;
-                SPARQLQuery req;
-
-                do {
-                    success = false;
-                    next_engine = next_to_oblige(own_id, offset);
-                    if (next_engine == -1)
-                        break;
-
-                    if (engines[next_engine]->at_work
-                            && ((timer::get_usec() - engines[next_engine]->last_time) >= TIMEOUT_THRESHOLD)
-                            && (engines[next_engine]->runqueue.try_pop(req))) {
-                        reset_snooze(at_work, last_time);
-                        sparql->execute_sparql_query(req);
-                        success = true;
-                        offset++;
-                    }
-                } while (success);
+            // idle: steal work from other engines
+            // FIXME: only SPARQL queries can be stolen, other requests (e.g., GSTORE_CHECK)
+            //        are still processed by the engine receiving them.
+            if (Global::enable_workstealing && steal(own_id, req)) {
+                reset_snooze(at_work, last_time);
+                sparql->execute_sparql_query(req);
+                continue;
             }
 
-
-            if (at_work) continue; // keep calm (no snooze)
-
             // busy polling a little while (BUSY_POLLING_THRESHOLD) before snooze
             if ((timer::get_usec() - last_time) >= BUSY_POLLING_THRESHOLD) {
                 timer::cpu_relax(snooze_interval); // relax CPU (snooze)
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <tbb/concurrent_queue.h>
+
+#include "core/common/errors.hpp"
+
+#include "core/sparql/query.hpp"
+
+namespace wukong {
+
+/**
+ * @brief A pattern step whose input rows are split into morsels
+ *
+ * Morsels are claimed one by one by the owner engine and idle engines
+ * on the same server, and the results are stitched back by the owner
+ * in the order of morsels (w/o going through RMap).
+ */
+struct MorselTask {
+    std::vector<SPARQLQuery> morsels;
+
+    std::atomic<int> next;    // the next morsel to claim
+    std::atomic<int> ndone;   // the number of finished morsels
+    std::atomic<int> status;  // the error code of failed morsels
+
+    MorselTask() : next(0), ndone(0), status(SUCCESS) {}
+
+    // claim a morsel, return -1 if all morsels are claimed
+    int claim() {
+        int m = next.fetch_add(1);
+        return (m < static_cast<int>(morsels.size())) ? m : -1;
+    }
+
+    bool done() { return ndone.load() == static_cast<int>(morsels.size()); }
+};
+
+/**
+ * @brief Server-wide pool of morsel tasks shared by all engines
+ */
+class MorselPool {
+private:
+    tbb::concurrent_queue<std::shared_ptr<MorselTask>> tasks;
+
+public:
+    void publish(std::shared_ptr<MorselTask> task) { tasks.push(task); }
+
+    /**
+     * @brief Pick a morsel from published tasks
+     *
+     * @param m the claimed morsel (return value)
+     * @return std::shared_ptr<MorselTask> nullptr if no morsel is left
+     */
+    std::shared_ptr<MorselTask> pick(int &m) {
+        std::shared_ptr<MorselTask> task;
+        while (tasks.try_pop(task)) {
+            m = task->claim();
+            if (m < 0)
+                continue;  // all morsels are claimed, drop the task
+
+            // keep the task visible to others if more morsels are left
+            if (m + 1 < static_cast<int>(task->morsels.size()))
+                tasks.push(task);
+            return task;
+        }
+        return nullptr;
+    }
+};
+
+// the pool of all local engines
+MorselPool morsel_pool;
+
+}  // namespace wukong
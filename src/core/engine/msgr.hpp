@@ -68,7 +68,7 @@ public:
     }
 
     bool send_msg(Bundle &bundle, int dst_sid, int dst_tid) {
-        std::string msg = bundle.to_str();
+        std::string msg = bundle.take_str();
         if (adaptor->send(dst_sid, dst_tid, msg))
             return true;
 
@@ -82,7 +82,7 @@ public:
     bool tryrecv_msg(Bundle &bundle) {
         std::string msg;
         if (!adaptor->tryrecv(msg)) return false;
-        bundle.init(msg);
+        bundle.init(std::move(msg));
         return true;
     }
 
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "core/common/type.hpp"
+
+#include "core/sparql/query.hpp"
+
+#include "stringserver/string_mapping.hpp"
+
+namespace wukong {
+
+/**
+ * DISTINCT, ORDER BY, OFFSET and LIMIT of the final result
+ *
+ * The rows are sorted by their indexes (w/o copying them), and ORDER BY
+ * compares the ranks of IDs, which are translated and ranked once per
+ * distinct ID. With LIMIT, only the first OFFSET+LIMIT rows are sorted
+ * (top-K by partial sort). At last, the selected rows are gathered once
+ * (incl. the attribute and timestamp tables).
+ */
+class ResultSorter {
+private:
+    // the columns of requested (normal) variables
+    static std::vector<int> required_cols(SPARQLQuery::Result &res) {
+        std::vector<int> cols;
+        for (ssid_t var : res.required_vars) {
+            int col = res.var2col(var);
+            if (col != NO_RESULT && res.var_type(var) == SID_t)
+                cols.push_back(col);
+        }
+        return cols;
+    }
+
+    // keep the first row of the rows having the same requested variables
+    static void distinct(SPARQLQuery::Result &res, std::vector<uint32_t> &rows) {
+        std::vector<int> cols = required_cols(res);
+        const sid_t *table = res.result_table.data();
+        int col_num = res.get_col_num();
+
+        auto less = [&](uint32_t a, uint32_t b) {
+            for (int col : cols) {
+                sid_t va = table[(uint64_t)a * col_num + col];
+                sid_t vb = table[(uint64_t)b * col_num + col];
+                if (va != vb) return va < vb;
+            }
+            return a < b;
+        };
+        auto equal = [&](uint32_t a, uint32_t b) {
+            for (int col : cols)
+                if (table[(uint64_t)a * col_num + col] != table[(uint64_t)b * col_num + col])
+                    return false;
+            return true;
+        };
+
+        std::sort(rows.begin(), rows.end(), less);
+        rows.erase(std::unique(rows.begin(), rows.end(), equal), rows.end());
+    }
+
+    // rank the rows by (attribute or timestamp) values
+    template <typename GetValue>
+    static void rank_values(const std::vector<uint32_t> &rows, std::vector<uint32_t> &ranks,
+                            int norders, int i, GetValue value) {
+        std::vector<std::pair<double, uint32_t>> vals;
+        vals.reserve(rows.size());
+        for (uint32_t row : rows)
+            vals.emplace_back(value(row), row);
+        std::sort(vals.begin(), vals.end());
+
+        uint32_t rank = 0;
+        for (uint64_t j = 0; j < vals.size(); j++) {
+            if (j > 0 && vals[j].first != vals[j - 1].first)
+                rank++;
+            ranks[(uint64_t)vals[j].second * norders + i] = rank;
+        }
+    }
+
+    // sort the first #k rows by ORDER BY (the rest are dropped)
+    static void order(SPARQLQuery &r, std::vector<uint32_t> &rows, uint64_t k,
+                      StringMapping *str_mapping, int tid) {
+        SPARQLQuery::Result &res = r.result;
+        uint64_t nrows = res.get_row_num();
+        int col_num = res.get_col_num();
+        int norders = r.orders.size();
+
+        // the ranks of rows in each ORDER BY column (e.g., by the strings of IDs)
+        std::vector<uint32_t> ranks(nrows * norders, 0);
+        for (int i = 0; i < norders; i++) {
+            ssid_t var = r.orders[i].id;
+            int col = res.var2col(var);
+            if (col == NO_RESULT) continue;  // unbound
+
+            if (res.var_type(var) != SID_t) {
+                rank_values(rows, ranks, norders, i, [&res, var, col](uint32_t row) {
+            #ifdef TRDF_MODE
+                    if (res.var_type(var) == TIME_t)
+                        return (double)res.get_time_row_col(row, col);
+            #endif
+                    return boost::apply_visitor([](auto v) { return (double)v; },
+                                                res.get_attr_row_col(row, col));
+                });
+                continue;
+            }
+
+            // translate the distinct IDs by a batch, and rank them by strings
+            boost::unordered_map<sid_t, uint32_t> rank_of;
+            std::vector<sid_t> ids;
+            for (uint32_t row : rows) {
+                sid_t id = res.result_table[(uint64_t)row * col_num + col];
+                if (rank_of.emplace(id, 0).second)
+                    ids.push_back(id);
+            }
+            auto map_results = str_mapping->id2str_batch(tid, ids);
+
+            std::vector<uint32_t> idx(ids.size());
+            std::iota(idx.begin(), idx.end(), 0);
+            std::sort(idx.begin(), idx.end(), [&map_results](uint32_t a, uint32_t b) {
+                return map_results[a].second < map_results[b].second;
+            });
+            uint32_t rank = 0;
+            for (uint64_t j = 0; j < idx.size(); j++) {
+                if (j > 0 && map_results[idx[j]].second != map_results[idx[j - 1]].second)
+                    rank++;
+                rank_of[ids[idx[j]]] = rank;
+            }
+
+            for (uint32_t row : rows)
+                ranks[(uint64_t)row * norders + i] = rank_of[res.result_table[(uint64_t)row * col_num + col]];
+        }
+
+        // ties are broken by the rows (i.e., a stable sort)
+        auto less = [&](uint32_t a, uint32_t b) {
+            for (int i = 0; i < norders; i++) {
+                uint32_t ra = ranks[(uint64_t)a * norders + i], rb = ranks[(uint64_t)b * norders + i];
+                if (ra != rb)
+                    return r.orders[i].descending ? (ra > rb) : (ra < rb);
+            }
+            return a < b;
+        };
+
+        if (k < rows.size()) {
+            std::partial_sort(rows.begin(), rows.begin() + k, rows.end(), less);
+            rows.resize(k);
+        } else {
+            std::sort(rows.begin(), rows.end(), less);
+        }
+    }
+
+    // only keep the rows (in order)
+    static void gather(SPARQLQuery::Result &res, const std::vector<uint32_t> &rows) {
+        std::vector<sid_t> table;
+        table.reserve(rows.size() * res.get_col_num());
+        for (uint32_t row : rows)
+            res.append_row_to(row, table);
+        res.result_table.swap(table);
+
+        if (res.get_attr_col_num() > 0 && res.get_attr_row_num() > 0) {
+            std::vector<attr_t> attr_table;
+            attr_table.reserve(rows.size() * res.get_attr_col_num());
+            for (uint32_t row : rows)
+                res.append_attr_row_to(row, attr_table);
+            res.attr_res_table.swap(attr_table);
+        }
+
+    #ifdef TRDF_MODE
+        if (res.get_time_col_num() > 0 && res.time_res_table.size() > 0) {
+            std::vector<int64_t> time_table;
+            time_table.reserve(rows.size() * res.get_time_col_num());
+            for (uint32_t row : rows)
+                res.append_time_row_to(row, time_table);
+            res.time_res_table.swap(time_table);
+        }
+    #endif
+
+        if (res.optional_matched_rows.size() > 0) {
+            std::vector<bool> matched;
+            matched.reserve(rows.size());
+            for (uint32_t row : rows)
+                matched.push_back(res.optional_matched_rows[row]);
+            res.optional_matched_rows.swap(matched);
+        }
+
+        res.update_nrows();
+    }
+
+public:
+    /**
+     * @brief DISTINCT, ORDER BY, OFFSET and LIMIT on the rows of the query
+     *        (the result table should be materialized)
+     */
+    static void process(SPARQLQuery &r, StringMapping *str_mapping, int tid) {
+        SPARQLQuery::Result &res = r.result;
+        uint64_t nrows = res.get_row_num();
+        if (!r.distinct && r.orders.size() == 0 && r.offset == 0 && r.limit < 0)
+            return;
+
+        std::vector<uint32_t> rows(nrows);
+        std::iota(rows.begin(), rows.end(), 0);
+
+        if (r.distinct)
+            distinct(res, rows);
+
+        // the rows of [start, end) are returned
+        uint64_t start = std::min<uint64_t>(r.offset, rows.size());
+        uint64_t end = rows.size();
+        if (r.limit >= 0)
+            end = std::min<uint64_t>(start + r.limit, end);
+
+        if (r.orders.size() > 0)
+            order(r, rows, end, str_mapping, tid);  // top-K w/ LIMIT
+
+        rows.resize(end);
+        rows.erase(rows.begin(), rows.begin() + start);
+        gather(res, rows);
+    }
+};
+
+} // namespace wukong
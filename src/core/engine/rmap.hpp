@@ -69,6 +69,9 @@ public:
         else
             whole.append_result(part);
 
+        // combine the partial aggregates (groups) of sub-queries
+        whole.agg_table.merge(part.agg_table);
+
 
         // NOTE: all sub-jobs have the same pattern_step, optional_step, and union_done
         // update parent's pattern step (progress)
@@ -109,6 +112,7 @@ public:
         r.result.time_res_table.swap(reply.result.time_res_table);
     #endif
         r.result.attr_res_table.swap(reply.result.attr_res_table);
+        r.result.agg_table.merge(reply.result.agg_table);
 
         internal_map.erase(qid);
         logstream(LOG_DEBUG) << "erase parent-qid=" << qid << LOG_endl;
@@ -39,12 +39,23 @@
 #include "core/common/bind.hpp"
 
 #include "core/store/dgraph.hpp"
+#include "core/store/edge_search.hpp"
 
 #include "core/sparql/query.hpp"
+#include "core/sparql/regex_matcher.hpp"
+
+#include "stringserver/string_mapping.hpp"
+#include "stringserver/term_kind.hpp"
+#include "stringserver/typed_literal.hpp"
 
 // engine
+#include "core/engine/dedup.hpp"
+#include "core/engine/morsel.hpp"
+#include "core/engine/aggregator.hpp"
+#include "core/engine/result_sorter.hpp"
 #include "core/engine/rmap.hpp"
 #include "core/engine/msgr.hpp"
+#include "core/engine/work_deque.hpp"
 
 // utils
 #include "utils/assertion.hpp"
@@ -76,6 +87,7 @@ private:
     Messenger *msgr;
 
     RMap rmap; // a map of replies for pending (fork-join) queries
+    RegexCache regex_cache; // compiled patterns of REGEX filters
     pthread_spinlock_t rmap_lock;
 
 
@@ -287,6 +299,147 @@ private:
         req.pattern_step++;
     }
 
+    /// Retrieve the neighbors of KNOWN vertices (one per row) in a batch
+    /// to overlap the cache misses of lookups (see KVStore::get_values_batch).
+    /// Same vertices share one lookup (see KnownDedup), and BLANK_ID is skipped.
+    /// If use_index, types are looked up in the type-index (i.e., [0|type|IN]).
+    /// The edges of remote vertices point to remote_edges (owned by the caller).
+    void get_triples_batch(const std::vector<sid_t> &knowns, ssid_t pid, dir_t d,
+                           std::vector<edge_t *> &edges, std::vector<uint64_t> &szs,
+                           std::vector<edge_t> &remote_edges, bool use_index = false) {
+        std::vector<sid_t> vids;
+        std::vector<int64_t> idxs;  // row -> index of vids
+        KnownDedup::dedup(knowns, vids, idxs);
+
+        std::vector<edge_t *> vid_edges(vids.size());
+        std::vector<uint64_t> vid_szs(vids.size());
+        if (use_index && pid == TYPE_ID && d == IN) {
+            for (uint64_t j = 0; j < vids.size(); j++)
+                vid_edges[j] = graph->get_index(tid, vids[j], d, vid_szs[j]);
+        } else {
+            graph->get_triples_batch(tid, vids, pid, d, vid_edges, vid_szs, remote_edges);
+        }
+        KnownDedup::expand(idxs, vid_edges, vid_szs, edges, szs);
+    }
+
+    /// The KNOWN_TO_* patterns share the lookups and matching below, and
+    /// only the results are written to the row-based or columnar table.
+
+    /// the neighbors (vals) of KNOWN vertices, w/ the rows they belong to (parents)
+    void expand_known(const std::vector<sid_t> &knowns, ssid_t pid, dir_t d,
+                      std::vector<uint32_t> &parents, std::vector<sid_t> &vals) {
+        std::vector<edge_t *> edges;
+        std::vector<uint64_t> szs;
+        std::vector<edge_t> remote_edges;
+        get_triples_batch(knowns, pid, d, edges, szs, remote_edges, true);
+
+        parents.reserve(knowns.size());
+        vals.reserve(knowns.size());
+        for (uint32_t i = 0; i < knowns.size(); i++) {
+            for (uint64_t k = 0; k < szs[i]; k++) {
+                parents.push_back(i);
+                vals.push_back(edges[i][k].val);
+            }
+        }
+    }
+
+    /// the rows (ascending) whose KNOWN vertex (knowns) is a neighbor of
+    /// the start vertex (starts)
+    void match_known(const std::vector<sid_t> &starts, const std::vector<sid_t> &knowns,
+                     ssid_t pid, dir_t d, std::vector<uint32_t> &matched_rows) {
+        std::vector<edge_t *> edges;
+        std::vector<uint64_t> szs;
+        std::vector<edge_t> remote_edges;
+        get_triples_batch(starts, pid, d, edges, szs, remote_edges);
+
+        std::vector<std::pair<sid_t, uint32_t>> run;  // (known, row)
+        std::vector<sid_t> run_knowns;
+        std::vector<uint64_t> run_matched;
+        for (uint32_t i = 0; i < starts.size();) {
+            // a run of rows w/ the same vertex
+            uint32_t e = i + 1;
+            while (e < starts.size() && starts[e] == starts[i]) e++;
+
+            if (e - i < EDGE_SCAN_THRESHOLD || szs[i] < EDGE_SCAN_THRESHOLD) {
+                for (; i < e; i++)
+                    if (edge_contains(edges[i], szs[i], knowns[i]))
+                        matched_rows.push_back(i);
+                continue;
+            }
+
+            // both sides are lists: intersect the sorted knowns with the neighbors
+            run.clear();
+            for (uint32_t r = i; r < e; r++)
+                run.push_back(std::make_pair(knowns[r], r));
+            std::sort(run.begin(), run.end());
+            run_knowns.clear();
+            for (auto const &p : run)
+                run_knowns.push_back(p.first);
+            run_matched.clear();
+            edge_intersect(run_knowns.data(), run_knowns.size(), edges[i], szs[i], run_matched);
+
+            uint64_t nmatched = matched_rows.size();
+            for (uint64_t m : run_matched)
+                matched_rows.push_back(run[m].second);
+            std::sort(matched_rows.begin() + nmatched, matched_rows.end());
+            i = e;
+        }
+    }
+
+    /// the rows (ascending) whose start vertex (starts) has the constant as a neighbor
+    void match_const(const std::vector<sid_t> &starts, ssid_t pid, dir_t d, ssid_t end,
+                     std::vector<uint32_t> &matched_rows) {
+        std::vector<edge_t *> edges;
+        std::vector<uint64_t> szs;
+        std::vector<edge_t> remote_edges;
+        get_triples_batch(starts, pid, d, edges, szs, remote_edges);
+
+        sid_t cached = BLANK_ID; // simple dedup for consecutive same vertices
+        bool exist = false;
+        for (uint32_t i = 0; i < starts.size(); i++) {
+            if (starts[i] != cached) {  // a new vertex
+                cached = starts[i];
+                exist = edge_contains(edges[i], szs[i], end);
+            }
+
+            // the matching result can also be reused
+            if (exist)
+                matched_rows.push_back(i);
+        }
+    }
+
+    /// keep the matched rows (ascending) of the row-based result table,
+    /// or clear the OPTIONAL results of the unmatched rows
+    void select_rows(SPARQLQuery &req, const std::vector<uint32_t> &matched_rows) {
+        SPARQLQuery::Result &res = req.result;
+        if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
+            uint64_t m = 0;
+            for (int i = 0; i < res.get_row_num(); i++) {
+                bool matched = (m < matched_rows.size() && matched_rows[m] == (uint32_t)i);
+                if (matched) m++;
+                if (res.optional_matched_rows[i] && (!matched))
+                    req.correct_optional_result(i);
+                res.optional_matched_rows[i] = (matched && res.optional_matched_rows[i]);
+            }
+            return;
+        }
+
+        std::vector<sid_t> updated_result_table;
+        std::vector<attr_t> updated_attr_table;
+        for (uint32_t i : matched_rows) {
+            // append a matched intermediate result
+            res.append_row_to(i, updated_result_table);
+            if (Global::enable_vattr)
+                res.append_attr_row_to(i, updated_attr_table);
+        }
+
+        // update result and metadata
+        res.result_table.swap(updated_result_table);
+        if (Global::enable_vattr)
+            res.attr_res_table.swap(updated_attr_table);
+        res.update_nrows();
+    }
+
     /// ?X P ?Y . (?X: KNOWN, P: GIVEN, ?X: UNKNOWN)
     /// e.g., "?X rdf:type ub:GraduateStudent"
     ///       "?X ub:memberOf ?Y"
@@ -321,50 +474,43 @@ private:
             if (req.pg_type == SPARQLQuery::PGType::OPTIONAL)
                 updated_optional_matched_rows.reserve(res.optional_matched_rows.size());
 
-            sid_t cached = BLANK_ID; // simple dedup for consecutive same vertices
-            edge_t *vids = NULL;
-            uint64_t sz = 0;
             int nrows = res.get_row_num();
-            for (int i = 0; i < nrows; i++) {
-                sid_t cur = res.get_row_col(i, res.var2col(start));
-
-                // optional
-                if (req.pg_type == SPARQLQuery::PGType::OPTIONAL
-                        && (!res.optional_matched_rows[i] || cur == BLANK_ID)) {
-                    res.append_row_to(i, updated_result_table);
-                    updated_result_table.push_back(BLANK_ID);
-                    updated_optional_matched_rows.push_back(res.optional_matched_rows[i]);
-                    continue;
-                }
-
-                if (cur != cached) { // new KNOWN
-                    cached = cur;
-                    if (pid == TYPE_ID && d == IN)
-                        vids = graph->get_index(tid, cur, d, sz);
-                    else
-                        vids = graph->get_triples(tid, cur, pid, d, sz);
-                }
+            std::vector<sid_t> knowns(nrows);
+            for (int i = 0; i < nrows; i++)
+                knowns[i] = res.get_row_col(i, res.var2col(start));
 
+            std::vector<uint32_t> parents;
+            std::vector<sid_t> vals;
+            expand_known(knowns, pid, d, parents, vals);
+            if (req.pg_type != SPARQLQuery::PGType::OPTIONAL) {
                 // append a new intermediate result (row)
-                if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
-                    if (sz > 0) {
-                        for (uint64_t k = 0; k < sz; k++) {
-                            res.append_row_to(i, updated_result_table);
-                            updated_result_table.push_back(vids[k].val);
-                            updated_optional_matched_rows.push_back(true);
-                        }
-                    } else {
+                for (uint64_t k = 0; k < parents.size(); k++) {
+                    res.append_row_to(parents[k], updated_result_table);
+                    // update attribute table to map the result table
+                    if (Global::enable_vattr)
+                        res.append_attr_row_to(parents[k], updated_attr_table);
+                    updated_result_table.push_back(vals[k]);
+                }
+            } else {
+                uint64_t k = 0;
+                for (int i = 0; i < nrows; i++) {
+                    // the neighbors of the row are vals[k, e)
+                    uint64_t e = k;
+                    while (e < parents.size() && parents[e] == (uint32_t)i) e++;
+
+                    // optional
+                    if (!res.optional_matched_rows[i] || e == k) {
                         res.append_row_to(i, updated_result_table);
                         updated_result_table.push_back(BLANK_ID);
-                        updated_optional_matched_rows.push_back(true);
+                        updated_optional_matched_rows.push_back(res.optional_matched_rows[i]);
+                        k = e;
+                        continue;
                     }
-                } else {
-                    for (uint64_t k = 0; k < sz; k++) {
+
+                    for (; k < e; k++) {
                         res.append_row_to(i, updated_result_table);
-                        // update attribute table to map the result table
-                        if (Global::enable_vattr)
-                            res.append_attr_row_to(i, updated_attr_table);
-                        updated_result_table.push_back(vids[k].val);
+                        updated_result_table.push_back(vals[k]);
+                        updated_optional_matched_rows.push_back(true);
                     }
                 }
             }
@@ -426,54 +572,16 @@ private:
 
         SPARQLQuery::Result &res = req.result;
 
-        std::vector<sid_t> updated_result_table;
-        std::vector<attr_t> updated_attr_table;
-
-        // simple dedup for consecutive same vertices
-        sid_t cached = BLANK_ID;
-        edge_t *vids = NULL;
-        uint64_t sz = 0;
-
         int nrows = res.get_row_num();
+        std::vector<sid_t> starts(nrows), knowns(nrows);
         for (int i = 0; i < nrows; i++) {
-            sid_t cur = res.get_row_col(i, res.var2col(start));
-            if (cur != cached) {  // a new vertex
-                cached = cur;
-                vids = graph->get_triples(tid, cur, pid, d, sz);
-            }
-
-            sid_t known = res.get_row_col(i, res.var2col(end));
-            if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
-                bool matched = false;
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].val == known) {
-                        matched = true;
-                        break;
-                    }
-                }
-                if (res.optional_matched_rows[i] && (!matched))
-                    req.correct_optional_result(i);
-                res.optional_matched_rows[i] = (matched && res.optional_matched_rows[i]);
-            } else {
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].val == known) {
-                        // append a matched intermediate result
-                        res.append_row_to(i, updated_result_table);
-                        if (Global::enable_vattr)
-                            res.append_attr_row_to(i, updated_attr_table);
-                        break;
-                    }
-                }
-            }
+            starts[i] = res.get_row_col(i, res.var2col(start));
+            knowns[i] = res.get_row_col(i, res.var2col(end));
         }
 
-        if (req.pg_type != SPARQLQuery::PGType::OPTIONAL) {
-            // update result and metadata
-            res.result_table.swap(updated_result_table);
-            if (Global::enable_vattr)
-                res.attr_res_table.swap(updated_attr_table);
-            res.update_nrows();
-        }
+        std::vector<uint32_t> matched_rows;
+        match_known(starts, knowns, pid, d, matched_rows);
+        select_rows(req, matched_rows);
 
         req.pattern_step++;
     }
@@ -494,59 +602,116 @@ private:
 
         SPARQLQuery::Result &res = req.result;
 
-        std::vector<sid_t> updated_result_table;
-        std::vector<attr_t> updated_attr_table;
-
-        // simple dedup for consecutive same vertices
-        sid_t cached = BLANK_ID;
-        edge_t *vids = NULL;
-        uint64_t sz = 0;
-        bool exist = false;
         int nrows = res.get_row_num();
-        for (int i = 0; i < nrows; i++) {
-            sid_t cur = res.get_row_col(i, res.var2col(start));
-            if (cur != cached) {  // a new vertex
-                exist = false;
-                cached = cur;
-                vids = graph->get_triples(tid, cur, pid, d, sz);
+        std::vector<sid_t> starts(nrows);
+        for (int i = 0; i < nrows; i++)
+            starts[i] = res.get_row_col(i, res.var2col(start));
 
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].val == end) {
-                        // append a matched intermediate result
-                        exist = true;
-                        if (req.pg_type != SPARQLQuery::PGType::OPTIONAL) {
-                            res.append_row_to(i, updated_result_table);
-                            if (Global::enable_vattr)
-                                res.append_attr_row_to(i, updated_attr_table);
-                        }
-                        break;
-                    }
-                }
-                if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
-                    if (res.optional_matched_rows[i] && (!exist)) req.correct_optional_result(i);
-                    res.optional_matched_rows[i] = (exist && res.optional_matched_rows[i]);
-                }
-            } else {
-                // the matching result can also be reused
-                if (exist && req.pg_type != SPARQLQuery::PGType::OPTIONAL) {
-                    res.append_row_to(i, updated_result_table);
-                    if (Global::enable_vattr)
-                        res.append_attr_row_to(i, updated_attr_table);
-                } else if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
-                    if (res.optional_matched_rows[i] && (!exist)) req.correct_optional_result(i);
-                    res.optional_matched_rows[i] = (exist && res.optional_matched_rows[i]);
-                }
-            }
+        std::vector<uint32_t> matched_rows;
+        match_const(starts, pid, d, end, matched_rows);
+        select_rows(req, matched_rows);
 
-        }
+        req.pattern_step++;
+    }
 
-        if (req.pg_type != SPARQLQuery::PGType::OPTIONAL) {
-            // update result and metadata
-            res.result_table.swap(updated_result_table);
-            if (Global::enable_vattr)
-                res.attr_res_table.swap(updated_attr_table);
-            res.update_nrows();
-        }
+    /// Whether the current pattern is a KNOWN_TO_* pattern w/o OPTIONAL and
+    /// attribute, whose rows are independent (see columnar_pattern() and need_morsels())
+    bool known_to_pattern(SPARQLQuery &req) {
+        if (Global::enable_vattr)
+            return false;
+
+        if (req.pg_type == SPARQLQuery::PGType::OPTIONAL)
+            return false;
+
+        if (req.pattern_step == 0 && req.start_from_index())
+            return false;
+
+        SPARQLQuery::Pattern &pattern = req.get_pattern();
+        return (pattern.pred_type == (char)SID_t)
+               && (req.result.var_stat(pattern.predicate) == CONST_VAR)
+               && (req.result.var_stat(pattern.subject) == KNOWN_VAR);
+    }
+
+    /// Whether the current pattern can run on the columnar result table.
+    bool columnar_pattern(SPARQLQuery &req) {
+        return Global::enable_columnar && known_to_pattern(req);
+    }
+
+    /// columnar version of known_to_unknown
+    /// only the new column and the row-index mapping are written
+    void known_to_unknown_columnar(SPARQLQuery &req) {
+        SPARQLQuery::Pattern &pattern = req.get_pattern();
+        ssid_t start = pattern.subject;
+        ssid_t pid = pattern.predicate;
+        dir_t d = pattern.direction;
+        ssid_t end = pattern.object;
+
+        SPARQLQuery::Result &res = req.result;
+        res.begin_columnar();
+
+        std::vector<sid_t> knowns;
+        res.col_table.gather(res.var2col(start), knowns);
+
+        std::vector<uint32_t> parents;
+        std::vector<sid_t> updated_col;
+        expand_known(knowns, pid, d, parents, updated_col);
+
+        // update result and metadata
+        res.col_table.expand(parents, updated_col, res.get_col_num());
+        res.add_var2col(end, res.get_col_num(), SID_t);
+        res.set_col_num(res.get_col_num() + 1);
+        res.update_nrows();
+
+        req.pattern_step++;
+    }
+
+    /// columnar version of known_to_known
+    /// only the selection vector is updated
+    void known_to_known_columnar(SPARQLQuery &req) {
+        SPARQLQuery::Pattern &pattern = req.get_pattern();
+        ssid_t start = pattern.subject;
+        ssid_t pid = pattern.predicate;
+        dir_t d = pattern.direction;
+        ssid_t end = pattern.object;
+
+        SPARQLQuery::Result &res = req.result;
+        res.begin_columnar();
+
+        std::vector<sid_t> starts, knowns;
+        res.col_table.gather(res.var2col(start), starts);
+        res.col_table.gather(res.var2col(end), knowns);
+
+        std::vector<uint32_t> matched_rows;
+        match_known(starts, knowns, pid, d, matched_rows);
+
+        // update result and metadata
+        res.col_table.select(matched_rows);
+        res.update_nrows();
+
+        req.pattern_step++;
+    }
+
+    /// columnar version of known_to_const
+    /// only the selection vector is updated
+    void known_to_const_columnar(SPARQLQuery &req) {
+        SPARQLQuery::Pattern &pattern = req.get_pattern();
+        ssid_t start = pattern.subject;
+        ssid_t pid = pattern.predicate;
+        dir_t d = pattern.direction;
+        ssid_t end = pattern.object;
+
+        SPARQLQuery::Result &res = req.result;
+        res.begin_columnar();
+
+        std::vector<sid_t> starts;
+        res.col_table.gather(res.var2col(start), starts);
+
+        std::vector<uint32_t> matched_rows;
+        match_const(starts, pid, d, end, matched_rows);
+
+        // update result and metadata
+        res.col_table.select(matched_rows);
+        res.update_nrows();
 
         req.pattern_step++;
     }
@@ -672,12 +837,9 @@ private:
             for (uint64_t p = 0; p < npids; p++) {
                 uint64_t sz = 0;
                 edge_t *vids = graph->get_triples(tid, prev_id, tpids[p].val, d, sz);
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].val == end) {
-                        res.append_row_to(i, updated_result_table);
-                        updated_result_table.push_back(tpids[p].val);
-                        break;
-                    }
+                if (edge_contains(vids, sz, end)) {
+                    res.append_row_to(i, updated_result_table);
+                    updated_result_table.push_back(tpids[p].val);
                 }
             }
         }
@@ -721,12 +883,8 @@ private:
         for (uint64_t p = 0; p < npids; p++) {
             uint64_t sz = 0;
             edge_t *vids = graph->get_triples(tid, start, tpids[p].val, d, sz);
-            for (uint64_t k = 0; k < sz; k++) {
-                if (vids[k].val == end) {
-                    updated_result_table.push_back(tpids[p].val);
-                    break;
-                }
-            }
+            if (edge_contains(vids, sz, end))
+                updated_result_table.push_back(tpids[p].val);
         }
 
         // update result and metadata
@@ -742,6 +900,8 @@ private:
         SPARQLQuery::Pattern &pattern = req.get_pattern();
         ssid_t start = pattern.subject;
 
+        req.result.materialize();
+
         // generate sub requests for all servers
         std::vector<SPARQLQuery> sub_reqs(Global::num_servers);
         for (int i = 0; i < Global::num_servers; i++) {
@@ -754,6 +914,8 @@ private:
             sub_reqs[i].fetch_step = req.fetch_step;
             sub_reqs[i].local_var = start;
             sub_reqs[i].priority = req.priority + 1;
+            sub_reqs[i].aggregates = req.aggregates;
+            sub_reqs[i].group_by = req.group_by;
 
             // metadata
             sub_reqs[i].result.col_num = req.result.col_num;
@@ -879,6 +1041,7 @@ private:
             if (sub_req.done(SPARQLQuery::SQState::SQ_PATTERN))
                 break;
         }
+        sub_result.materialize();
         uint64_t t2 = timer::get_usec(); // time to run the sub-request
 
         uint64_t t3, t4;
@@ -941,6 +1104,11 @@ private:
         dir_t direction = pattern.direction;
         ssid_t end = pattern.object;
 
+        // late materialization: row-based patterns need a materialized table
+        bool columnar = columnar_pattern(req);
+        if (!columnar)
+            req.result.materialize();
+
         // the first triple pattern from index
         if (req.pattern_step == 0 && req.start_from_index()) {
             if (req.result.var2col(end) != NO_RESULT)
@@ -1026,13 +1194,16 @@ private:
 
             // start from KNOWN
             case const_pair(KNOWN_VAR, CONST_VAR):
-                known_to_const(req);
+                if (columnar) known_to_const_columnar(req);
+                else known_to_const(req);
                 break;
             case const_pair(KNOWN_VAR, KNOWN_VAR):
-                known_to_known(req);
+                if (columnar) known_to_known_columnar(req);
+                else known_to_known(req);
                 break;
             case const_pair(KNOWN_VAR, UNKNOWN_VAR):
-                known_to_unknown(req);
+                if (columnar) known_to_unknown_columnar(req);
+                else known_to_unknown(req);
                 break;
 
             // start from UNKNOWN (incorrect query plan)
@@ -1054,6 +1225,78 @@ private:
         return true;
     }
 
+    /// Whether to split the current pattern step into morsels (intra-query parallelism).
+    bool need_morsels(SPARQLQuery &req) {
+        if (Global::morsel_size == 0 || Global::num_engines == 1)
+            return false;
+
+        return known_to_pattern(req)
+               && (req.result.get_row_num() >= 2 * Global::morsel_size);
+    }
+
+    // execute a morsel of given task, and record the error (if any) for the owner
+    void run_morsel(MorselTask &task, int m) {
+        SPARQLQuery &morsel = task.morsels[m];
+        try {
+            execute_one_pattern(morsel);
+            morsel.result.materialize();
+        } catch (const char *msg) {
+            task.status = UNKNOWN_ERROR;
+        } catch (WukongException &ex) {
+            task.status = ex.code();
+        }
+        task.ndone++;
+    }
+
+    /// Execute the current pattern step by morsels (see need_morsels()).
+    /// The morsels are run by this engine and idle engines on the same server,
+    /// and then the results are stitched back in order.
+    void execute_morsels(SPARQLQuery &r) {
+        SPARQLQuery::Result &res = r.result;
+        res.materialize();
+
+        uint64_t nrows = res.get_row_num();
+        uint64_t ncols = res.get_col_num();
+        uint64_t nmorsels = (nrows + Global::morsel_size - 1) / Global::morsel_size;
+
+        // split rows into morsels (each morsel is a copy of the query w/o other rows)
+        std::vector<sid_t> table;
+        table.swap(res.result_table);
+        std::shared_ptr<MorselTask> task = std::make_shared<MorselTask>();
+        task->morsels.resize(nmorsels, r);
+        for (uint64_t m = 0; m < nmorsels; m++) {
+            uint64_t begin = m * Global::morsel_size;
+            uint64_t end = std::min(begin + Global::morsel_size, nrows);
+            SPARQLQuery::Result &mres = task->morsels[m].result;
+            mres.result_table.assign(table.begin() + begin * ncols, table.begin() + end * ncols);
+            mres.update_nrows();
+        }
+        std::vector<sid_t>().swap(table);
+
+        morsel_pool.publish(task);
+        int m;
+        while ((m = task->claim()) >= 0)
+            run_morsel(*task, m);
+
+        // help others while waiting for the morsels run by others
+        // (engines are busy polling anyway)
+        while (!task->done())
+            run_morsel();
+
+        if (task->status != SUCCESS)
+            throw WukongException(task->status.load());
+
+        // stitch results back
+        r.pattern_step = task->morsels[0].pattern_step;
+        res = std::move(task->morsels[0].result);
+        for (uint64_t m = 1; m < nmorsels; m++) {
+            std::vector<sid_t> &mtable = task->morsels[m].result.result_table;
+            res.result_table.insert(res.result_table.end(), mtable.begin(), mtable.end());
+            std::vector<sid_t>().swap(mtable);
+        }
+        res.update_nrows();
+    }
+
     // deal with pattern wich start from index
     bool dispatch(SPARQLQuery &r, bool is_start=true) {
         if (Global::num_servers * r.mt_factor == 1) return false;
@@ -1113,7 +1356,10 @@ private:
                              << LOG_endl;
         do {
             time = timer::get_usec();
-            execute_one_pattern(r);
+            if (need_morsels(r))
+                execute_morsels(r);
+            else
+                execute_one_pattern(r);
             logstream(LOG_DEBUG) << "[" << sid << "-" << tid << "]"
                                  << " step = " << r.pattern_step
                                  << " exec-time = " << (timer::get_usec() - time) << " usec"
@@ -1121,11 +1367,15 @@ private:
                                  << LOG_endl;
 
             // co-run optimization
-            if (r.corun_enabled && (r.pattern_step == r.corun_step))
+            if (r.corun_enabled && (r.pattern_step == r.corun_step)) {
+                r.result.materialize();
                 do_corun(r);
+            }
 
-            if (r.done(SPARQLQuery::SQState::SQ_PATTERN))
+            if (r.done(SPARQLQuery::SQState::SQ_PATTERN)) {
+                r.result.materialize();
                 return true;  // done
+            }
 
             if (dispatch(r, false)) {
                 return false;
@@ -1148,72 +1398,176 @@ private:
     }
 
 
+    // translate the IDs of a column (only satisfied rows) by a batch
+    std::vector<std::string> translate_col(SPARQLQuery::Result &result, int col,
+                                           const std::vector<bool> &is_satisfy) {
+        std::vector<sid_t> ids;
+        for (int row = 0; row < is_satisfy.size(); row ++)
+            if (is_satisfy[row])
+                ids.push_back(result.get_row_col(row, col));
+
+        auto map_results = str_mapping->id2str_batch(tid, ids);
+        std::vector<std::string> strs(is_satisfy.size());
+        for (int row = 0, i = 0; row < is_satisfy.size(); row ++)
+            if (is_satisfy[row])
+                strs[row] = std::move(map_results[i++].second);
+        return strs;
+    }
+
+    // the typed values of a FILTER argument (a column or a constant) of rows
+    bool get_typed_arg(SPARQLQuery::Filter &arg, int col, SPARQLQuery::Result &result,
+                       const std::vector<int> &rows, std::vector<typed_value_t> &vals) {
+        switch (arg.type) {
+        case SPARQLQuery::Filter::Type::Variable: {
+            std::vector<sid_t> ids(rows.size());
+            for (int i = 0; i < rows.size(); i ++)
+                ids[i] = result.get_row_col(rows[i], col);
+            vals = str_mapping->typed_value_batch(tid, ids);
+            return true;
+        }
+        case SPARQLQuery::Filter::Type::Literal: {
+            typed_value_t v;
+            if (!TypedLiteral::decode_constant(arg.value, arg.valueType, v))
+                return false;
+            vals.assign(rows.size(), v);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    static void compare_values(SPARQLQuery::Filter::Type type, const double *a, const double *b,
+                               uint8_t *keep, int n) {
+        switch (type) {
+        case SPARQLQuery::Filter::Type::Equal:
+            for (int i = 0; i < n; i ++) keep[i] = (a[i] == b[i]);
+            break;
+        case SPARQLQuery::Filter::Type::NotEqual:
+            for (int i = 0; i < n; i ++) keep[i] = (a[i] != b[i]);
+            break;
+        case SPARQLQuery::Filter::Type::Less:
+            for (int i = 0; i < n; i ++) keep[i] = (a[i] < b[i]);
+            break;
+        case SPARQLQuery::Filter::Type::LessOrEqual:
+            for (int i = 0; i < n; i ++) keep[i] = (a[i] <= b[i]);
+            break;
+        case SPARQLQuery::Filter::Type::Greater:
+            for (int i = 0; i < n; i ++) keep[i] = (a[i] > b[i]);
+            break;
+        case SPARQLQuery::Filter::Type::GreaterOrEqual:
+            for (int i = 0; i < n; i ++) keep[i] = (a[i] >= b[i]);
+            break;
+        default:
+            for (int i = 0; i < n; i ++) keep[i] = 1;
+        }
+    }
+
+    /**
+     * The fast path of relational filters on typed (numeric and dateTime)
+     * literals, whose values are decoded once at load time (see
+     * typed_literal.hpp). It compares the values of the whole column by a
+     * tight loop, w/o translating IDs to strings. The rows whose values are
+     * not comparable (e.g., plain literals, or numbers vs. dateTimes) are
+     * left in pending for the string comparison.
+     */
+    void typed_relational_filter(SPARQLQuery::Filter &filter, SPARQLQuery::Result &result,
+                                 int col1, int col2, std::vector<bool> &is_satisfy,
+                                 std::vector<bool> &pending) {
+        std::vector<int> rows;
+        for (int row = 0; row < is_satisfy.size(); row ++)
+            if (is_satisfy[row])
+                rows.push_back(row);
+
+        std::vector<typed_value_t> vals1, vals2;
+        if (!get_typed_arg(*filter.arg1, col1, result, rows, vals1)
+                || !get_typed_arg(*filter.arg2, col2, result, rows, vals2))
+            return;  // e.g., a string constant
+
+        // gather the comparable rows
+        std::vector<int> cmp_rows;
+        std::vector<double> a, b;
+        cmp_rows.reserve(rows.size());
+        a.reserve(rows.size());
+        b.reserve(rows.size());
+        for (int i = 0; i < rows.size(); i ++) {
+            if (vals1[i].kind != LIT_NONE && vals1[i].kind == vals2[i].kind) {
+                cmp_rows.push_back(rows[i]);
+                a.push_back(vals1[i].val);
+                b.push_back(vals2[i].val);
+            }
+        }
+
+        std::vector<uint8_t> keep(cmp_rows.size());
+        compare_values(filter.type, a.data(), b.data(), keep.data(), cmp_rows.size());
+        for (int i = 0; i < cmp_rows.size(); i ++) {
+            is_satisfy[cmp_rows[i]] = keep[i];
+            pending[cmp_rows[i]] = false;
+        }
+    }
+
     // relational operator: < <= > >= == !=
     void relational_filter(SPARQLQuery::Filter &filter,
                            SPARQLQuery::Result &result,
                            std::vector<bool> &is_satisfy) {
+        for (SPARQLQuery::Filter *arg : {filter.arg1, filter.arg2}) {
+            if (arg->type != SPARQLQuery::Filter::Type::Variable
+                    && arg->type != SPARQLQuery::Filter::Type::Literal) {
+                logstream(LOG_ERROR) << "Unsupported FILTER type" << LOG_endl;
+                ASSERT_ERROR_CODE(false, UNKNOWN_FILTER);
+            }
+        }
+
         int col1 = (filter.arg1->type == SPARQLQuery::Filter::Type::Variable)
                    ? result.var2col(filter.arg1->valueArg) : -1;
         int col2 = (filter.arg2->type == SPARQLQuery::Filter::Type::Variable)
                    ? result.var2col(filter.arg2->valueArg) : -1;
 
-        auto get_str = [&](SPARQLQuery::Filter & filter, int row, int col) -> std::string {
-            int id = 0;
-            switch (filter.type) {
-            case SPARQLQuery::Filter::Type::Variable:
-                id = result.get_row_col(row, col);
-                return str_mapping->id2str(tid, id).second;
-            case SPARQLQuery::Filter::Type::Literal:
-                return "\"" + filter.value + "\"";
-            default:
-                logstream(LOG_ERROR) << "Unsupported FILTER type" << LOG_endl;
-                ASSERT_ERROR_CODE(false, UNKNOWN_FILTER);
-            }
-            return "";
-        };
+        // compare typed literals by values first
+        std::vector<bool> pending = is_satisfy;
+        typed_relational_filter(filter, result, col1, col2, is_satisfy, pending);
+
+        // compare the rest by strings
+        std::vector<std::string> strs1, strs2;
+        std::string lit1, lit2;
+        if (col1 != -1) strs1 = translate_col(result, col1, pending);
+        else lit1 = "\"" + filter.arg1->value + "\"";
+        if (col2 != -1) strs2 = translate_col(result, col2, pending);
+        else lit2 = "\"" + filter.arg2->value + "\"";
+
+        auto get_str1 = [&](int row) -> const std::string & { return (col1 != -1) ? strs1[row] : lit1; };
+        auto get_str2 = [&](int row) -> const std::string & { return (col2 != -1) ? strs2[row] : lit2; };
 
         int nrows = result.get_row_num();
         switch (filter.type) {
         case SPARQLQuery::Filter::Type::Equal:
             for (int row = 0; row < nrows; row ++)
-                if (is_satisfy[row]
-                        && (get_str(*filter.arg1, row, col1)
-                            != get_str(*filter.arg2, row, col2)))
+                if (pending[row] && (get_str1(row) != get_str2(row)))
                     is_satisfy[row] = false;
             break;
         case SPARQLQuery::Filter::Type::NotEqual:
             for (int row = 0; row < nrows; row ++)
-                if (is_satisfy[row]
-                        && (get_str(*filter.arg1, row, col1)
-                            == get_str(*filter.arg2, row, col2)))
+                if (pending[row] && (get_str1(row) == get_str2(row)))
                     is_satisfy[row] = false;
             break;
         case SPARQLQuery::Filter::Type::Less:
             for (int row = 0; row < nrows; row ++)
-                if (is_satisfy[row]
-                        && (get_str(*filter.arg1, row, col1)
-                            >= get_str(*filter.arg2, row, col2)))
+                if (pending[row] && (get_str1(row) >= get_str2(row)))
                     is_satisfy[row] = false;
             break;
         case SPARQLQuery::Filter::Type::LessOrEqual:
             for (int row = 0; row < nrows; row ++)
-                if (is_satisfy[row]
-                        && (get_str(*filter.arg1, row, col1)
-                            > get_str(*filter.arg2, row, col2)))
+                if (pending[row] && (get_str1(row) > get_str2(row)))
                     is_satisfy[row] = false;
             break;
         case SPARQLQuery::Filter::Type::Greater:
             for (int row = 0; row < nrows; row ++)
-                if (is_satisfy[row]
-                        && (get_str(*filter.arg1, row, col1)
-                            <= get_str(*filter.arg2, row, col2)))
+                if (pending[row] && (get_str1(row) <= get_str2(row)))
                     is_satisfy[row] = false;
             break;
         case SPARQLQuery::Filter::Type::GreaterOrEqual:
             for (int row = 0; row < nrows; row ++)
-                if (is_satisfy[row]
-                        && get_str(*filter.arg1, row, col1)
-                        < get_str(*filter.arg2, row, col2))
+                if (pending[row] && (get_str1(row) < get_str2(row)))
                     is_satisfy[row] = false;
             break;
         }
@@ -1233,85 +1587,66 @@ private:
         }
     }
 
-    // IRI and URI are the same in SPARQL
-    void isIRI_filter(SPARQLQuery::Filter &filter,
-                      SPARQLQuery::Result &result,
-                      std::vector<bool> &is_satisfy) {
+    // the term kinds (see term_kind.hpp) of a column (only satisfied rows)
+    void term_kind_filter(SPARQLQuery::Filter &filter,
+                          SPARQLQuery::Result &result,
+                          std::vector<bool> &is_satisfy, uint8_t kind) {
         int col = result.var2col(filter.arg1->valueArg);
 
-        std::string IRI_REF = R"(<([^<>\\"{}|^`\\])*>)";
-        std::string prefixed_name = ".*:.*";
-        std::string IRIref_str = "(" + IRI_REF + "|" + prefixed_name + ")";
-
-        std::regex IRI_pattern(IRIref_str);
+        std::vector<int> rows;
+        std::vector<sid_t> ids;
         for (int row = 0; row < is_satisfy.size(); row ++) {
-            if (!is_satisfy[row])
-                continue;
-
-            int id = result.get_row_col(row, col);
-            std::string str = str_mapping->id2str(tid, id).second;
-            if (!regex_match(str, IRI_pattern))
-                is_satisfy[row] = false;
+            if (is_satisfy[row]) {
+                rows.push_back(row);
+                ids.push_back(result.get_row_col(row, col));
+            }
         }
-    }
-
-    void isliteral_filter(SPARQLQuery::Filter &filter,
-                          SPARQLQuery::Result &result,
-                          std::vector<bool> &is_satisfy) {
-        int col = result.var2col(filter.arg1->valueArg);
-
-        std::string langtag_pattern_str("@[a-zA-Z]+(-[a-zA-Z0-9]+)*");
-
-        std::string literal1_str = R"('([^\x27\x5C\x0A\x0D]|\\[tbnrf\"'])*')";
-        std::string literal2_str = R"("([^\x22\x5C\x0A\x0D]|\\[tbnrf\"'])*")";
-        std::string literal_long1_str = R"('''(('|'')?([^'\\]|\\[tbnrf\"']))*''')";
-        std::string literal_long2_str = R"("""(("|"")?([^"\\]|\\[tbnrf\"']))*""")";
-        std::string literal = "(" + literal1_str + "|" + literal2_str + "|"
-                         + literal_long1_str + "|" + literal_long2_str + ")";
-
-        std::string IRI_REF = R"(<([^<>\\"{}|^`\\])*>)";
-        std::string prefixed_name = ".*:.*";
-        std::string IRIref_str = "(" + IRI_REF + "|" + prefixed_name + ")";
 
-        std::regex RDFLiteral_pattern(literal + "(" + langtag_pattern_str + "|(\\^\\^" + IRIref_str +  "))?");
-
-        for (int row = 0; row < is_satisfy.size(); row ++) {
-            if (!is_satisfy[row])
-                continue;
+        std::vector<uint8_t> kinds = str_mapping->term_kind_batch(tid, ids);
+        for (int i = 0; i < rows.size(); i ++)
+            if (!(kinds[i] & kind))
+                is_satisfy[rows[i]] = false;
+    }
 
-            int id = result.get_row_col(row, col);
-            std::string str = str_mapping->id2str(tid, id).second;
-            if (!regex_match(str, RDFLiteral_pattern))
-                is_satisfy[row] = false;
-        }
+    // the lexical form of a literal (w/o quotes, language tag and datatype)
+    static std::string_view lexical_form(const std::string &str) {
+        if (TermKind::classify(str) != TERM_LITERAL)
+            return std::string_view();
+        uint64_t close = str.rfind(str.front());
+        return std::string_view(str.data() + 1, close - 1);
     }
 
     // regex flag only support "i" option now
     void regex_filter(SPARQLQuery::Filter &filter,
                       SPARQLQuery::Result &result,
                       std::vector<bool> &is_satisfy) {
-        std::regex pattern;
-        if (filter.arg3 != nullptr && filter.arg3->value == "i")
-            pattern = std::regex(filter.arg2->value, std::regex::icase);
-        else
-            pattern = std::regex(filter.arg2->value);
+        bool icase = (filter.arg3 != nullptr && filter.arg3->value == "i");
+        std::shared_ptr<const RegexMatcher> matcher = regex_cache.get(filter.arg2->value, icase);
 
+        // translate and match distinct IDs only (memoized)
         int col = result.var2col(filter.arg1->valueArg);
-        for (int row = 0; row < is_satisfy.size(); row ++) {
-            if (!is_satisfy[row])
-                continue;
-
-            int id = result.get_row_col(row, col);
-            std::string str = str_mapping->id2str(tid, id).second;
-            if (str.front() != '\"' || str.back() != '\"')
+        boost::unordered_map<sid_t, int> memo;  // ID to the index of distinct IDs
+        std::vector<sid_t> ids;
+        for (int row = 0; row < is_satisfy.size(); row ++)
+            if (is_satisfy[row] && memo.emplace(result.get_row_col(row, col), ids.size()).second)
+                ids.push_back(result.get_row_col(row, col));
+
+        auto strs = str_mapping->id2str_batch(tid, ids);
+        std::vector<uint8_t> matched(ids.size());
+        for (int i = 0; i < ids.size(); i ++) {
+            const std::string &str = strs[i].second;
+            std::string_view lex = lexical_form(str);
+            if (lex.data() == nullptr) {
                 logstream(LOG_ERROR) << "The first parameter of function regex must be string"
                                      << LOG_endl;
-            else
-                str = str.substr(1, str.length() - 2);
+                lex = str;
+            }
+            matched[i] = matcher->match(lex);
+        }
 
-            if (!regex_match(str, pattern))
+        for (int row = 0; row < is_satisfy.size(); row ++)
+            if (is_satisfy[row] && !matched[memo[result.get_row_col(row, col)]])
                 is_satisfy[row] = false;
-        }
     }
 
     void general_filter(SPARQLQuery::Filter &filter,
@@ -1337,9 +1672,12 @@ private:
         } else if (filter.type == SPARQLQuery::Filter::Type::Builtin_bound) {
             bound_filter(filter, result, is_satisfy);
         } else if (filter.type == SPARQLQuery::Filter::Type::Builtin_isiri) {
-            isIRI_filter(filter, result, is_satisfy);
+            // IRI and URI are the same in SPARQL
+            term_kind_filter(filter, result, is_satisfy, TERM_IRI);
         } else if (filter.type == SPARQLQuery::Filter::Type::Builtin_isliteral) {
-            isliteral_filter(filter, result, is_satisfy);
+            term_kind_filter(filter, result, is_satisfy, TERM_LITERAL);
+        } else if (filter.type == SPARQLQuery::Filter::Type::Builtin_isblank) {
+            term_kind_filter(filter, result, is_satisfy, TERM_BLANK);
         } else if (filter.type == SPARQLQuery::Filter::Type::Builtin_regex) {
             try {
                 regex_filter(filter, result, is_satisfy);
@@ -1375,129 +1713,18 @@ private:
         r.result.update_nrows();
     }
 
-    class Compare {
-    private:
-        int tid;
-        SPARQLQuery &query;
-        StringMapping *str_mapping;
-    public:
-        Compare(int tid, SPARQLQuery &query, StringMapping *str_mapping)
-            : tid(tid), query(query), str_mapping(str_mapping) { }
-
-        bool operator()(const int* a, const int* b) {
-            int cmp = 0;
-            for (int i = 0; i < query.orders.size(); i ++) {
-                int col = query.result.var2col(query.orders[i].id);
-                std::string str_a = str_mapping->id2str(tid, a[col]).second;
-                std::string str_b = str_mapping->id2str(tid, b[col]).second;
-                cmp = str_a.compare(str_b);
-                if (cmp != 0) {
-                    cmp = query.orders[i].descending ? -cmp : cmp;
-                    break;
-                }
-            }
-            return cmp < 0;
-        }
-    };
-
-    class ReduceCmp {
-    private:
-        int col_num;
-    public:
-        ReduceCmp(int col_num): col_num(col_num) { }
-
-        bool operator()(const int* a, const int* b) {
-            for (int i = 0; i < col_num; i ++) {
-                if (a[i] == b[i])
-                    continue;
-                return a[i] < b[i];
-            }
-            return 0;
-        }
-    };
-
     void final_process(SPARQLQuery &r) {
-        if (r.result.blind || r.result.result_table.size() == 0)
+        // GROUP BY and aggregates (incl. ORDER BY, OFFSET and LIMIT on groups)
+        if (r.has_aggregate() && !r.result.blind) {
+            Aggregator::finalize(r, str_mapping, tid);
             return;
-
-        // DISTINCT and ORDER BY
-        if (r.distinct || r.orders.size() > 0) {
-            // initialize table
-            int **table;
-            int size = r.result.get_row_num();
-            int new_size = size;
-
-            table = new int*[size];
-            for (int i = 0; i < size; i ++)
-                table[i] = new int[r.result.col_num];
-
-            for (int i = 0; i < size; i ++)
-                for (int j = 0; j < r.result.col_num; j ++)
-                    table[i][j] = r.result.get_row_col(i, j);
-
-            // DISTINCT
-            if (r.distinct) {
-                // sort and then compare
-                std::sort(table, table + size, ReduceCmp(r.result.col_num));
-                int p = 0, q = 1;
-                auto equal = [&r](int *a, int *b) -> bool{
-                    for (int i = 0; i < r.result.required_vars.size(); i ++) {
-                        int col = r.result.var2col(r.result.required_vars[i]);
-                        if (a[col] != b[col]) return false;
-                    }
-                    return true;
-                };
-
-                auto swap = [](int *&a, int *&b) {
-                    int *temp = a;
-                    a = b;
-                    b = temp;
-                };
-
-                while (q < size) {
-                    while (equal(table[p], table[q])) {
-                        q++;
-                        if (q >= size) goto out;
-                    }
-                    p ++;
-                    swap(table[p], table[q]);
-                    q ++;
-                }
-out:
-                new_size = p + 1;
-            }
-
-            // ORDER BY
-            if (r.orders.size() > 0)
-                std::sort(table, table + new_size, Compare(tid, r, str_mapping));
-
-            // write back data and delete **table
-            for (int i = 0; i < new_size; i ++)
-                for (int j = 0; j < r.result.col_num; j ++)
-                    r.result.result_table[r.result.col_num * i + j] = table[i][j];
-
-            if (new_size < size)
-                r.result.result_table.erase(r.result.result_table.begin() + new_size * r.result.col_num,
-                                            r.result.result_table.begin() + size * r.result.col_num);
-
-            for (int i = 0; i < size; i ++)
-                delete[] table[i];
-            delete[] table;
         }
 
-        // OFFSET
-        if (r.offset > 0)
-            r.result.result_table.erase(r.result.result_table.begin(),
-                                        std::min(r.result.result_table.begin()
-                                            + r.offset * r.result.col_num,
-                                            r.result.result_table.end()));
+        if (r.result.blind || r.result.result_table.size() == 0)
+            return;
 
-        // LIMIT
-        if (r.limit >= 0)
-            r.result.result_table.erase(std::min(r.result.result_table.begin()
-                                            + r.limit * r.result.col_num,
-                                            r.result.result_table.end()),
-                                        r.result.result_table.end());
+        // DISTINCT, ORDER BY (top-K w/ LIMIT), OFFSET and LIMIT
+        ResultSorter::process(r, str_mapping, tid);
 
         // remove unrequested variables
         // separate var to normal and attribute
@@ -1546,7 +1773,7 @@ out:
     }
 
 public:
-    tbb::concurrent_queue<SPARQLQuery> prior_stage;
+    WorkDeque<SPARQLQuery> prior_stage;  // local sub-queries (stealable by other engines)
 
     SPARQLEngine(int sid, int tid, StringMapping *str_mapping,
                  DGraph *graph, Coder *coder, Messenger *msgr)
@@ -1556,6 +1783,18 @@ public:
         pthread_spin_init(&rmap_lock, 0);
     }
 
+    /// Run a morsel of other engines (intra-query parallelism) if any.
+    /// @return false if no morsel is left
+    bool run_morsel() {
+        int m;
+        std::shared_ptr<MorselTask> task = morsel_pool.pick(m);
+        if (task == nullptr)
+            return false;
+
+        run_morsel(*task, m);
+        return true;
+    }
+
     void execute_sparql_query(SPARQLQuery &r) {
         try {
             // encode the lineage of the query (server & thread)
@@ -1649,6 +1888,9 @@ public:
             if (QUERY_FROM_PROXY(r)) {
                 r.state = SPARQLQuery::SQState::SQ_FINAL;
                 final_process(r);
+            } else if (r.can_aggregate_partially()) {
+                // only reply the groups (partial aggregates) to the parent query
+                Aggregator::aggregate(r, str_mapping, tid);
             }
 
         } catch (const char *msg) {
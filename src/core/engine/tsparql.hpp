@@ -25,6 +25,7 @@
 #include <tbb/concurrent_queue.h>
 
 #include <algorithm>  // sort
+#include <memory>
 #include <regex>
 #include <string>
 #include <utility>
@@ -40,12 +41,16 @@
 #include "core/common/bind.hpp"
 
 #include "core/store/dgraph.hpp"
+#include "core/store/edge_search.hpp"
 
 #include "core/sparql/query.hpp"
 
 // engine
 #include "core/engine/msgr.hpp"
+#include "core/engine/aggregator.hpp"
+#include "core/engine/result_sorter.hpp"
 #include "core/engine/rmap.hpp"
+#include "core/engine/work_deque.hpp"
 
 // utils
 #include "utils/assertion.hpp"
@@ -67,6 +72,9 @@ private:
     RMap rmap;  // a map of replies for pending (fork-join) queries
     pthread_spinlock_t rmap_lock;
 
+    // the materialized snapshot of the pattern being executed (see use_view)
+    std::shared_ptr<SnapshotView> view;
+
     enum time_vstat {
         UNDEFINED_UNDEFINED,
         CONST_CONST,
@@ -108,6 +116,52 @@ private:
         }
     }
 
+    /// whether the pattern needs the timestamps of edges (see edge_time_t)
+    bool need_times(SPARQLQuery& req) {
+        return req.ts != TIMESTAMP_MIN || req.te != TIMESTAMP_MAX
+               || get_time_vstat(req) != UNDEFINED_UNDEFINED;
+    }
+
+    /// the edges of a snapshot pattern can be read from the materialized
+    /// snapshot of the query (see SnapshotView), if any
+    bool use_view(SPARQLQuery& req) {
+        return view != nullptr && get_time_vstat(req) == UNDEFINED_UNDEFINED;
+    }
+
+    /// the neighbors of [vid|pid|d] w/ their timestamps, which are only read
+    /// for the temporal patterns (otherwise, times is nullptr)
+    edge_t* get_triples(SPARQLQuery& req, sid_t vid, sid_t pid, dir_t d, uint64_t& sz,
+                        edge_time_t*& times) {
+        times = nullptr;
+        if (!need_times(req))
+            return graph->get_triples(tid, vid, pid, d, sz);
+        // only local edges are materialized
+        if (use_view(req) && PARTITION(vid) == sid)
+            return view->get_values(ikey_t(vid, pid, d), sz);
+        return graph->get_timed_triples(tid, vid, pid, d, sz, times);
+    }
+
+    edge_t* get_index(SPARQLQuery& req, sid_t pid, dir_t d, uint64_t& sz, edge_time_t*& times) {
+        times = nullptr;
+        if (!need_times(req))
+            return graph->get_index(tid, pid, d, sz);
+        if (use_view(req))
+            return view->get_values(ikey_t(0, pid, d), sz);
+        return graph->get_timed_index(tid, pid, d, sz, times);
+    }
+
+    /// the timestamps of the k-th edge, which are always valid if they are
+    /// not read or not stored (i.e., non-temporal segments)
+    static const edge_time_t* time_at(const edge_time_t* times, uint64_t k) {
+        static const edge_time_t always(TIMESTAMP_MIN, TIMESTAMP_MAX);
+        return (times == nullptr) ? &always : &times[k];
+    }
+
+    /// all edges are valid if their timestamps are not read or not stored
+    static bool valid_at(const edge_time_t* times, uint64_t k, int64_t ts, int64_t te) {
+        return (times == nullptr) || times[k].valid(ts, te);
+    }
+
     /// add elements to result table
     void push_result(std::vector<sid_t>& updated_result_table, int num_id, sid_t id0 = 0, sid_t id1 = 0) {
         if (num_id >= 1) {
@@ -157,13 +211,13 @@ private:
                        SPARQLQuery::Pattern& pattern,
                        std::vector<sid_t>& updated_result_table,
                        std::vector<int64_t>& updated_time_res_table,
-                       edge_t& edge, int num_id,
+                       const edge_time_t* time, int num_id,
                        sid_t id0 = 0, sid_t id1 = 0) {
         // edge timestamp
         int64_t idxTS, idxTE;
         if (ts_vstat != UNDEFINED_UNDEFINED) {
-            idxTS = edge.ts;
-            idxTE = edge.te;
+            idxTS = time->ts;
+            idxTE = time->te;
         }
         if (ts_vstat == UNDEFINED_UNDEFINED) {
             res.append_row_to(row_idx, updated_result_table);
@@ -236,6 +290,19 @@ private:
         }
     }
 
+    // copy the predicates of the vertex (i.e., [vid|PREDICATE_ID|d]) valid in [ts, te]
+    std::vector<edge_t> valid_predicates(sid_t vid, dir_t d, const edge_t* pids, const edge_time_t* ptimes,
+                                         uint64_t npids, int64_t ts, int64_t te) {
+        std::vector<uint64_t> valid;
+        graph->get_valid_edges(ikey_t(vid, PREDICATE_ID, d), ptimes, npids, ts, te, valid);
+
+        std::vector<edge_t> tpids;
+        tpids.reserve(valid.size());
+        for (uint64_t p : valid)
+            tpids.push_back(pids[p]);
+        return tpids;
+    }
+
     /// A query whose parent's PGType is UNION may call this pattern
     void index_to_known(SPARQLQuery& req) {
         SPARQLQuery::Pattern& pattern = req.get_pattern();
@@ -259,17 +326,16 @@ private:
         std::vector<int64_t> updated_time_res_table;
 
         uint64_t sz = 0;
-        edge_t* edges = graph->get_index(tid, tpid, d, sz);
+        edge_time_t* times = nullptr;
+        edge_t* edges = get_index(req, tpid, d, sz, times);
+
+        std::vector<uint64_t> valid;
+        graph->get_valid_edges(ikey_t(0, tpid, d), times, sz, ts, te, valid);
 
         boost::unordered_set<sid_t> unique_set;
         // FIXME: multi-threading
-        std::vector<edge_t> edge_table;
-        // every thread takes a part of consecutive edges
-        for (uint64_t k = 0; k < sz; k++)
-            if (edges[k].valid(ts, te)) {
-                unique_set.insert(edges[k].val);
-                edge_table.push_back(edges[k]);
-            }
+        for (uint64_t k : valid)
+            unique_set.insert(edges[k].val);
 
         int nrows = res.get_row_num();
         for (int i = 0; i < nrows; i++) {
@@ -286,11 +352,11 @@ private:
             } else {
                 // timestamp-related logic
                 if (ts_vstat != UNDEFINED_UNDEFINED) {
-                    for (int k = 0; k < edge_table.size(); k++) {
-                        if (edge_table[k].val == cur) {
+                    for (uint64_t k : valid) {
+                        if (edges[k].val == cur) {
                             append_result(ts_vstat, i, res, pattern, 
                                           updated_result_table, updated_time_res_table, 
-                                          edge_table[k], 0);
+                                          time_at(times, k), 0);
                         }
                     }
                 } else if (unique_set.find(cur) != unique_set.end()) {  // matched
@@ -330,17 +396,15 @@ private:
         ASSERT_ERROR_CODE(col != NO_RESULT, VERTEX_INVALID);
 
         uint64_t sz = 0;
-        edge_t* vids = graph->get_triples(tid, start, pid, d, sz);
+        edge_time_t* times = nullptr;
+        edge_t* vids = get_triples(req, start, pid, d, sz, times);
 
-        boost::unordered_set<sid_t> unique_set;
+        std::vector<uint64_t> valid;
+        graph->get_valid_edges(ikey_t(start, pid, d), times, sz, ts, te, valid);
 
-        std::vector<edge_t> edges;
-        for (uint64_t k = 0; k < sz; k++) {
-            if (vids[k].valid(ts, te)) {
-                unique_set.insert(vids[k].val);
-                edges.push_back(vids[k]);
-            }
-        }
+        boost::unordered_set<sid_t> unique_set;
+        for (uint64_t k : valid)
+            unique_set.insert(vids[k].val);
 
         if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
             int nrows = res.get_row_num();
@@ -363,11 +427,11 @@ private:
                 sid_t cur = res.get_row_col(i, col);
                 // timestamp-related logic
                 if (ts_stat != UNDEFINED_UNDEFINED) {
-                    for (int k = 0; k < edges.size(); k++) {
-                        if (edges[k].val == cur) {
+                    for (uint64_t k : valid) {
+                        if (vids[k].val == cur) {
                             append_result(ts_stat, i, res, pattern, 
                                           updated_result_table, updated_time_res_table, 
-                                          edges[k], 0);
+                                          time_at(times, k), 0);
                         }
                     }
                 } else if (unique_set.find(cur) != unique_set.end()) {
@@ -412,7 +476,8 @@ private:
         std::vector<int64_t> updated_time_res_table;
 
         uint64_t sz = 0;
-        edge_t* edges = graph->get_index(tid, tpid, d, sz);
+        edge_time_t* times = nullptr;
+        edge_t* edges = get_index(req, tpid, d, sz, times);
         int start = req.mt_tid % req.mt_factor;
         int length = sz / req.mt_factor;
 
@@ -420,38 +485,25 @@ private:
         // Fix time_stat
         if (id01 == PREDICATE_ID) ts_vstat = UNDEFINED_UNDEFINED;
 
-        // every thread takes a part of consecutive edges
-        for (uint64_t k = start * length; k < (start + 1) * length; k++) {
-            if (edges[k].valid(ts, te)) {
-                for (int i = 0; i < std::max(nrows, 1); i++) {
-                    if (id01 == PREDICATE_ID) {
-                        res.append_row_to(i, updated_result_table);
-                        res.append_time_row_to(i, updated_time_res_table);
-                        updated_result_table.push_back(edges[k].val);
-                    } else {
-                        append_result(ts_vstat, i, res, pattern, 
-                                      updated_result_table, updated_time_res_table, 
-                                      edges[k], 1, edges[k].val);
-                    }
-                }
-            }
-        }
-
-        // fixup the last participant
-        if (start == req.mt_factor - 1) {
-            for (uint64_t k = (start + 1) * length; k < sz; k++) {
-                if (edges[k].valid(ts, te)) {
-                    for (int i = 0; i < std::max(nrows, 1); i++) {
-                        if (id01 == PREDICATE_ID) {
-                            res.append_row_to(i, updated_result_table);
-                            res.append_time_row_to(i, updated_time_res_table);
-                            updated_result_table.push_back(edges[k].val);
-                        } else {
-                            append_result(ts_vstat, i, res, pattern, 
-                                          updated_result_table, updated_time_res_table, 
-                                          edges[k], 1, edges[k].val);
-                        }
-                    }
+        std::vector<uint64_t> valid;
+        graph->get_valid_edges(ikey_t(0, tpid, d), times, sz, ts, te, valid);
+
+        // every thread takes a part of consecutive edges (the last participant takes the rest)
+        uint64_t lo = start * length;
+        uint64_t hi = (start == req.mt_factor - 1) ? sz : (start + 1) * length;
+        auto first = std::lower_bound(valid.begin(), valid.end(), lo);
+        auto last = std::lower_bound(first, valid.end(), hi);
+        for (auto it = first; it != last; it++) {
+            uint64_t k = *it;
+            for (int i = 0; i < std::max(nrows, 1); i++) {
+                if (id01 == PREDICATE_ID) {
+                    res.append_row_to(i, updated_result_table);
+                    res.append_time_row_to(i, updated_time_res_table);
+                    updated_result_table.push_back(edges[k].val);
+                } else {
+                    append_result(ts_vstat, i, res, pattern, 
+                                  updated_result_table, updated_time_res_table, 
+                                  time_at(times, k), 1, edges[k].val);
                 }
             }
         }
@@ -494,16 +546,18 @@ private:
             //                   FIRST_PATTERN_ERROR);  // MUST be the first triple pattern
 
             uint64_t sz = 0;
-            edge_t* vids = graph->get_triples(tid, start, pid, d, sz);
+            edge_time_t* times = nullptr;
+            edge_t* vids = get_triples(req, start, pid, d, sz, times);
+            std::vector<uint64_t> valid;
+            graph->get_valid_edges(ikey_t(start, pid, d), times, sz, ts, te, valid);
+
             std::vector<sid_t> updated_result_table;
             std::vector<int64_t> updated_time_res_table;
-            for (uint64_t k = 0; k < sz; k++) {
-                if (vids[k].valid(ts, te)) {
-                    for (int i = 0; i < std::max(nrows, 1); i++) {
-                        append_result(ts_vstat, i, res, pattern, 
-                                      updated_result_table, updated_time_res_table, 
-                                      vids[k], 1, vids[k].val);
-                    }
+            for (uint64_t k : valid) {
+                for (int i = 0; i < std::max(nrows, 1); i++) {
+                    append_result(ts_vstat, i, res, pattern, 
+                                  updated_result_table, updated_time_res_table, 
+                                  time_at(times, k), 1, vids[k].val);
                 }
             }
 
@@ -576,7 +630,9 @@ private:
 
             sid_t cached = BLANK_ID;  // simple dedup for consecutive same vertices
             edge_t* vids = NULL;
+            edge_time_t* times = NULL;
             uint64_t sz = 0;
+            std::vector<uint64_t> valid;  // the positions of valid edges in vids
             int nrows = res.get_row_num();
             for (int i = 0; i < nrows; i++) {
                 sid_t cur = res.get_row_col(i, res.var2col(start));
@@ -592,22 +648,23 @@ private:
 
                 if (cur != cached) {  // new KNOWN
                     cached = cur;
-                    if (pid == TYPE_ID && d == IN)
-                        vids = graph->get_index(tid, cur, d, sz);
-                    else
-                        vids = graph->get_triples(tid, cur, pid, d, sz);
+                    if (pid == TYPE_ID && d == IN) {
+                        vids = get_index(req, cur, d, sz, times);
+                        graph->get_valid_edges(ikey_t(0, cur, d), times, sz, ts, te, valid);
+                    } else {
+                        vids = get_triples(req, cur, pid, d, sz, times);
+                        graph->get_valid_edges(ikey_t(cur, pid, d), times, sz, ts, te, valid);
+                    }
                 }
 
                 // append a new intermediate result (row)
                 if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
                     if (sz > 0) {
-                        for (uint64_t k = 0; k < sz; k++) {
-                            if (vids[k].valid(ts, te)) {
-                                append_result(ts_vstat, i, res, pattern, 
-                                              updated_result_table, updated_time_res_table, 
-                                              vids[k], 1, vids[k].val);
-                                updated_optional_matched_rows.push_back(true);
-                            }
+                        for (uint64_t k : valid) {
+                            append_result(ts_vstat, i, res, pattern, 
+                                          updated_result_table, updated_time_res_table, 
+                                          time_at(times, k), 1, vids[k].val);
+                            updated_optional_matched_rows.push_back(true);
                         }
                     } else {
                         res.append_row_to(i, updated_result_table);
@@ -617,15 +674,13 @@ private:
                         updated_optional_matched_rows.push_back(true);
                     }
                 } else {
-                    for (uint64_t k = 0; k < sz; k++) {
-                        if (vids[k].valid(ts, te)) {
-                            append_result(ts_vstat, i, res, pattern, 
-                                          updated_result_table, updated_time_res_table, 
-                                          vids[k], 1, vids[k].val);
-                            // update attribute table to map the result table
-                            if (Global::enable_vattr)
-                                res.append_attr_row_to(i, updated_attr_table);
-                        }
+                    for (uint64_t k : valid) {
+                        append_result(ts_vstat, i, res, pattern, 
+                                      updated_result_table, updated_time_res_table, 
+                                      time_at(times, k), 1, vids[k].val);
+                        // update attribute table to map the result table
+                        if (Global::enable_vattr)
+                            res.append_attr_row_to(i, updated_attr_table);
                     }
                 }
             }
@@ -701,6 +756,7 @@ private:
         // simple dedup for consecutive same vertices
         sid_t cached = BLANK_ID;
         edge_t* vids = NULL;
+        edge_time_t* times = NULL;
         uint64_t sz = 0;
 
         int nrows = res.get_row_num();
@@ -708,14 +764,15 @@ private:
             sid_t cur = res.get_row_col(i, res.var2col(start));
             if (cur != cached) {  // a new vertex
                 cached = cur;
-                vids = graph->get_triples(tid, cur, pid, d, sz);
+                vids = get_triples(req, cur, pid, d, sz, times);
             }
 
             sid_t known = res.get_row_col(i, res.var2col(end));
             if (req.pg_type == SPARQLQuery::PGType::OPTIONAL) {
                 bool matched = false;
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].valid(ts, te) && vids[k].val == known) {
+                // the edges to the KNOWN vertex (the value list is sorted by val)
+                for (uint64_t k = edge_lower_bound(vids, 0, sz, known); k < sz && vids[k].val == known; k++) {
+                    if (valid_at(times, k, ts, te)) {
                         matched = true;
                         break;
                     }
@@ -724,12 +781,12 @@ private:
                     req.correct_optional_result(i);
                 res.optional_matched_rows[i] = (matched && res.optional_matched_rows[i]);
             } else {
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].valid(ts, te) && vids[k].val == known) {
+                for (uint64_t k = edge_lower_bound(vids, 0, sz, known); k < sz && vids[k].val == known; k++) {
+                    if (valid_at(times, k, ts, te)) {
                         // append a matched intermediate result
                         append_result(ts_vstat, i, res, pattern, 
                                       updated_result_table, updated_time_res_table, 
-                                      vids[k], 0);
+                                      time_at(times, k), 0);
                         if (Global::enable_vattr)
                             res.append_attr_row_to(i, updated_attr_table);
                         break;
@@ -777,21 +834,23 @@ private:
 
         // simple dedup for consecutive same vertices
         edge_t* vids = NULL;
+        edge_time_t* times = NULL;
         uint64_t sz = 0;
         int nrows = res.get_row_num();
         for (int i = 0; i < nrows; i++) {
             sid_t cur = res.get_row_col(i, res.var2col(start));
             bool exist = false;
-            vids = graph->get_triples(tid, cur, pid, d, sz);
+            vids = get_triples(req, cur, pid, d, sz, times);
 
-            for (uint64_t k = 0; k < sz; k++) {
-                if (vids[k].valid(ts, te) && vids[k].val == end) {
+            // the edges to the const (the value list is sorted by val)
+            for (uint64_t k = edge_lower_bound(vids, 0, sz, end); k < sz && vids[k].val == end; k++) {
+                if (valid_at(times, k, ts, te)) {
                     // append a matched intermediate result
                     exist = true;
                     if (req.pg_type != SPARQLQuery::PGType::OPTIONAL) {
                         append_result(ts_vstat, i, res, pattern, 
                                       updated_result_table, updated_time_res_table, 
-                                      vids[k], 0);
+                                      time_at(times, k), 0);
                         if (Global::enable_vattr)
                             res.append_attr_row_to(i, updated_attr_table);
                     }
@@ -837,28 +896,27 @@ private:
         SPARQLQuery::Result& res = req.result;
 
         uint64_t npids = 0;
-        edge_t* pids = graph->get_triples(tid, start, PREDICATE_ID, d, npids);
+        edge_time_t* ptimes = nullptr;
+        edge_t* pids = get_triples(req, start, PREDICATE_ID, d, npids, ptimes);
 
-        // use a local buffer to store "known" predicates
-        std::vector<edge_t> tpids(npids);
-        std::copy(pids, pids + npids, tpids.data());
+        // use a local buffer to store "known" (valid) predicates
+        std::vector<edge_t> tpids = valid_predicates(start, d, pids, ptimes, npids, ts, te);
 
         int nrows = res.get_row_num();
 
         std::vector<sid_t> updated_result_table;
         std::vector<int64_t> updated_time_res_table;
-        for (uint64_t p = 0; p < npids; p++) {
-            if (tpids[p].valid(ts, te)) {
-                uint64_t sz = 0;
-                edge_t* vids = graph->get_triples(tid, start, tpids[p].val, d, sz);
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].valid(ts, te)) {
-                        for (int i = 0; i < std::max(nrows, 1); i++) {
-                            append_result(ts_vstat, i, res, pattern, 
-                                          updated_result_table, updated_time_res_table, 
-                                          vids[k], 2, tpids[p].val, vids[k].val);
-                        }
-                    }
+        std::vector<uint64_t> valid;
+        for (uint64_t p = 0; p < tpids.size(); p++) {
+            uint64_t sz = 0;
+            edge_time_t* times = nullptr;
+            edge_t* vids = get_triples(req, start, tpids[p].val, d, sz, times);
+            graph->get_valid_edges(ikey_t(start, tpids[p].val, d), times, sz, ts, te, valid);
+            for (uint64_t k : valid) {
+                for (int i = 0; i < std::max(nrows, 1); i++) {
+                    append_result(ts_vstat, i, res, pattern, 
+                                  updated_result_table, updated_time_res_table, 
+                                  time_at(times, k), 2, tpids[p].val, vids[k].val);
                 }
             }
         }
@@ -893,27 +951,26 @@ private:
 
         std::vector<sid_t> updated_result_table;
         std::vector<int64_t> updated_time_res_table;
+        std::vector<uint64_t> valid;
         int nrows = res.get_row_num();
         for (int i = 0; i < nrows; i++) {
             sid_t cur = res.get_row_col(i, res.var2col(start));
             uint64_t npids = 0;
-            edge_t* pids = graph->get_triples(tid, cur, PREDICATE_ID, d, npids);
-
-            // use a local buffer to store "known" predicates
-            std::vector<edge_t> tpids(npids);
-            std::copy(pids, pids + npids, tpids.data());
-
-            for (uint64_t p = 0; p < npids; p++) {
-                if (tpids[p].valid(ts, te)) {
-                    uint64_t sz = 0;
-                    edge_t* vids = graph->get_triples(tid, cur, tpids[p].val, d, sz);
-                    for (uint64_t k = 0; k < sz; k++) {
-                        if (vids[k].valid(ts, te)) {
-                            append_result(ts_vstat, i, res, pattern, 
-                                          updated_result_table, updated_time_res_table, 
-                                          vids[k], 2, tpids[p].val, vids[k].val);
-                        }
-                    }
+            edge_time_t* ptimes = nullptr;
+            edge_t* pids = get_triples(req, cur, PREDICATE_ID, d, npids, ptimes);
+
+            // use a local buffer to store "known" (valid) predicates
+            std::vector<edge_t> tpids = valid_predicates(cur, d, pids, ptimes, npids, ts, te);
+
+            for (uint64_t p = 0; p < tpids.size(); p++) {
+                uint64_t sz = 0;
+                edge_time_t* times = nullptr;
+            edge_t* vids = get_triples(req, cur, tpids[p].val, d, sz, times);
+                graph->get_valid_edges(ikey_t(cur, tpids[p].val, d), times, sz, ts, te, valid);
+                for (uint64_t k : valid) {
+                    append_result(ts_vstat, i, res, pattern, 
+                                  updated_result_table, updated_time_res_table, 
+                                  time_at(times, k), 2, tpids[p].val, vids[k].val);
                 }
             }
         }
@@ -954,23 +1011,22 @@ private:
         for (int i = 0; i < nrows; i++) {
             sid_t prev_id = res.get_row_col(i, res.var2col(start));
             uint64_t npids = 0;
-            edge_t* pids = graph->get_triples(tid, prev_id, PREDICATE_ID, d, npids);
-
-            // use a local buffer to store "known" predicates
-            std::vector<edge_t> tpids(npids);
-            std::copy(pids, pids + npids, tpids.data());
-
-            for (uint64_t p = 0; p < npids; p++) {
-                if (tpids[p].valid(ts, te)) {
-                    uint64_t sz = 0;
-                    edge_t* vids = graph->get_triples(tid, prev_id, tpids[p].val, d, sz);
-                    for (uint64_t k = 0; k < sz; k++) {
-                        if (vids[k].valid(ts, te) && vids[k].val == end) {
-                            append_result(ts_vstat, i, res, pattern, 
-                                          updated_result_table, updated_time_res_table, 
-                                          vids[k], 1, tpids[p].val);
-                            break;
-                        }
+            edge_time_t* ptimes = nullptr;
+            edge_t* pids = get_triples(req, prev_id, PREDICATE_ID, d, npids, ptimes);
+
+            // use a local buffer to store "known" (valid) predicates
+            std::vector<edge_t> tpids = valid_predicates(prev_id, d, pids, ptimes, npids, ts, te);
+
+            for (uint64_t p = 0; p < tpids.size(); p++) {
+                uint64_t sz = 0;
+                edge_time_t* times = nullptr;
+            edge_t* vids = get_triples(req, prev_id, tpids[p].val, d, sz, times);
+                for (uint64_t k = edge_lower_bound(vids, 0, sz, end); k < sz && vids[k].val == end; k++) {
+                    if (valid_at(times, k, ts, te)) {
+                        append_result(ts_vstat, i, res, pattern, 
+                                      updated_result_table, updated_time_res_table, 
+                                      time_at(times, k), 1, tpids[p].val);
+                        break;
                     }
                 }
             }
@@ -1009,27 +1065,26 @@ private:
         // ASSERT_ERROR_CODE(res.get_col_num() == 0, FIRST_PATTERN_ERROR);
 
         uint64_t npids = 0;
-        edge_t* pids = graph->get_triples(tid, start, PREDICATE_ID, d, npids);
+        edge_time_t* ptimes = nullptr;
+        edge_t* pids = get_triples(req, start, PREDICATE_ID, d, npids, ptimes);
 
-        // use a local buffer to store "known" predicates
-        std::vector<edge_t> tpids(npids);
-        std::copy(pids, pids + npids, tpids.data());
+        // use a local buffer to store "known" (valid) predicates
+        std::vector<edge_t> tpids = valid_predicates(start, d, pids, ptimes, npids, ts, te);
 
         int nrows = res.get_row_num();
 
         std::vector<sid_t> updated_result_table;
         std::vector<int64_t> updated_time_res_table;
-        for (uint64_t p = 0; p < npids; p++) {
-            if (tpids[p].valid(ts, te)) {
-                uint64_t sz = 0;
-                edge_t* vids = graph->get_triples(tid, start, tpids[p].val, d, sz);
-                for (uint64_t k = 0; k < sz; k++) {
-                    if (vids[k].valid(ts, te) && vids[k].val == end) {
-                        for (int i = 0; i < std::max(nrows, 1); i++) {
-                            append_result(ts_vstat, i, res, pattern, 
-                                          updated_result_table, updated_time_res_table, 
-                                          vids[k], 1, tpids[p].val);
-                        }
+        for (uint64_t p = 0; p < tpids.size(); p++) {
+            uint64_t sz = 0;
+            edge_time_t* times = nullptr;
+            edge_t* vids = get_triples(req, start, tpids[p].val, d, sz, times);
+            for (uint64_t k = edge_lower_bound(vids, 0, sz, end); k < sz && vids[k].val == end; k++) {
+                if (valid_at(times, k, ts, te)) {
+                    for (int i = 0; i < std::max(nrows, 1); i++) {
+                        append_result(ts_vstat, i, res, pattern, 
+                                      updated_result_table, updated_time_res_table, 
+                                      time_at(times, k), 1, tpids[p].val);
                     }
                 }
             }
@@ -1059,6 +1114,8 @@ private:
             sub_reqs[i].fetch_step = req.fetch_step;
             sub_reqs[i].local_var = start;
             sub_reqs[i].priority = req.priority + 1;
+            sub_reqs[i].aggregates = req.aggregates;
+            sub_reqs[i].group_by = req.group_by;
 
             // metadata
             sub_reqs[i].result.col_num = req.result.col_num;
@@ -1419,7 +1476,11 @@ private:
                              << LOG_endl;
         do {
             time = timer::get_usec();
+            // FROM SNAPSHOT (or time interval) w/ a materialized snapshot
+            if (r.ts != TIMESTAMP_MIN || r.te != TIMESTAMP_MAX)
+                view = graph->snapshot_views.get(r.ts, r.te);
             execute_one_pattern(r);
+            view.reset();
             logstream(LOG_DEBUG) << "[" << sid << "-" << tid << "]"
                                  << " step = " << r.pattern_step
                                  << " exec-time = " << (timer::get_usec() - time) << " usec"
@@ -1675,137 +1736,18 @@ private:
         r.result.update_nrows();
     }
 
-    class Compare {
-    private:
-        SPARQLQuery& query;
-        StringServer* str_server;
-
-    public:
-        Compare(SPARQLQuery& query, StringServer* str_server)
-            : query(query), str_server(str_server) {}
-
-        bool operator()(const int* a, const int* b) {
-            int cmp = 0;
-            for (int i = 0; i < query.orders.size(); i++) {
-                int col = query.result.var2col(query.orders[i].id);
-                std::string str_a = str_server->exist(a[col]) ? str_server->id2str(a[col]) : "";
-                std::string str_b = str_server->exist(a[col]) ? str_server->id2str(b[col]) : "";
-                cmp = str_a.compare(str_b);
-                if (cmp != 0) {
-                    cmp = query.orders[i].descending ? -cmp : cmp;
-                    break;
-                }
-            }
-            return cmp < 0;
-        }
-    };
-
-    class ReduceCmp {
-    private:
-        int col_num;
-
-    public:
-        explicit ReduceCmp(int col_num) : col_num(col_num) {}
-
-        bool operator()(const int* a, const int* b) {
-            for (int i = 0; i < col_num; i++) {
-                if (a[i] == b[i])
-                    continue;
-                return a[i] < b[i];
-            }
-            return 0;
-        }
-    };
-
     void final_process(SPARQLQuery& r) {
-        if (r.result.blind || r.result.result_table.size() == 0)
+        // GROUP BY and aggregates (incl. ORDER BY, OFFSET and LIMIT on groups)
+        if (r.has_aggregate() && !r.result.blind) {
+            Aggregator::finalize(r, str_server, tid);
             return;
-
-        // DISTINCT and ORDER BY
-        // TODO: support them in t-sparql
-        if (r.distinct || r.orders.size() > 0) {
-            // initialize table
-            int** table;
-            int size = r.result.get_row_num();
-            int new_size = size;
-
-            table = new int*[size];
-            for (int i = 0; i < size; i++)
-                table[i] = new int[r.result.col_num];
-
-            for (int i = 0; i < size; i++)
-                for (int j = 0; j < r.result.col_num; j++)
-                    table[i][j] = r.result.get_row_col(i, j);
-
-            // DISTINCT
-            if (r.distinct) {
-                // sort and then compare
-                std::sort(table, table + size, ReduceCmp(r.result.col_num));
-                int p = 0, q = 1;
-                auto equal = [&r](int* a, int* b) -> bool {
-                    for (int i = 0; i < r.result.required_vars.size(); i++) {
-                        int col = r.result.var2col(r.result.required_vars[i]);
-                        if (a[col] != b[col]) return false;
-                    }
-                    return true;
-                };
-
-                auto swap = [](int*& a, int*& b) {
-                    int* temp = a;
-                    a = b;
-                    b = temp;
-                };
-
-                while (q < size) {
-                    while (equal(table[p], table[q])) {
-                        q++;
-                        if (q >= size) goto out;
-                    }
-                    p++;
-                    swap(table[p], table[q]);
-                    q++;
-                }
-            out:
-                new_size = p + 1;
-            }
-
-            // ORDER BY
-            if (r.orders.size() > 0)
-                std::sort(table, table + new_size, Compare(r, str_server));
-
-            // write back data and delete **table
-            for (int i = 0; i < new_size; i++)
-                for (int j = 0; j < r.result.col_num; j++)
-                    r.result.result_table[r.result.col_num * i + j] = table[i][j];
-
-            if (new_size < size)
-                r.result.result_table.erase(r.result.result_table.begin() + new_size * r.result.col_num,
-                                            r.result.result_table.begin() + size * r.result.col_num);
-
-            for (int i = 0; i < size; i++)
-                delete[] table[i];
-            delete[] table;
-        }
-
-        // OFFSET
-        if (r.offset > 0) {
-            r.result.result_table.erase(r.result.result_table.begin(),
-                                        std::min(r.result.result_table.begin() + r.offset * r.result.col_num,
-                                                 r.result.result_table.end()));
-
-            r.result.time_res_table.erase(r.result.time_res_table.begin(),
-                                        std::min(r.result.time_res_table.begin() + r.offset * r.result.time_col_num,
-                                                 r.result.time_res_table.end()));
         }
 
-        // LIMIT
-        if (r.limit >= 0) {
-            r.result.result_table.erase(std::min(r.result.result_table.begin() + r.limit * r.result.col_num,
-                                                 r.result.result_table.end()), r.result.result_table.end());
+        if (r.result.blind || r.result.result_table.size() == 0)
+            return;
 
-            r.result.time_res_table.erase(std::min(r.result.time_res_table.begin() + r.limit * r.result.time_col_num,
-                                                   r.result.time_res_table.end()), r.result.time_res_table.end());
-        }
+        // DISTINCT, ORDER BY (top-K w/ LIMIT), OFFSET and LIMIT
+        ResultSorter::process(r, str_server, tid);
 
         // remove unrequested variables
         // separate var to normal and attribute
@@ -1871,7 +1813,7 @@ private:
     }
 
 public:
-    tbb::concurrent_queue<SPARQLQuery> prior_stage;
+    WorkDeque<SPARQLQuery> prior_stage;  // local sub-queries (stealable by other engines)
 
     TSPARQLEngine(int sid, int tid, StringServer* str_server,
                   DGraph* graph, Coder* coder, Messenger* msgr)
@@ -1995,6 +1937,9 @@ public:
             if (QUERY_FROM_PROXY(r)) {
                 r.state = SPARQLQuery::SQState::SQ_FINAL;
                 final_process(r);
+            } else if (r.can_aggregate_partially()) {
+                // only reply the groups (partial aggregates) to the parent query
+                Aggregator::aggregate(r, str_server, tid);
             }
         } catch (const char* msg) {
             r.result.set_status_code(UNKNOWN_ERROR);
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace wukong {
+
+/**
+ * @brief Chase-Lev work-stealing deque
+ *
+ * Only the owner engine can push() and try_pop() at the bottom (LIFO),
+ * while any engine (incl. the owner) can steal() at the top (FIFO).
+ * The circular array grows on demand, and retired arrays are kept until
+ * the deque is destroyed since thieves may still read them.
+ *
+ * See "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP'13)
+ */
+template <typename T>
+class WorkDeque {
+private:
+    static const int64_t INIT_CAPACITY = 256;
+
+    struct Array {
+        int64_t capacity;  // power of 2
+        std::atomic<T *> *buf;
+
+        explicit Array(int64_t capacity)
+            : capacity(capacity), buf(new std::atomic<T *>[capacity]) {}
+
+        ~Array() { delete[] buf; }
+
+        T *get(int64_t i) { return buf[i & (capacity - 1)].load(std::memory_order_relaxed); }
+
+        void put(int64_t i, T *item) { buf[i & (capacity - 1)].store(item, std::memory_order_relaxed); }
+
+        Array *grow(int64_t bottom, int64_t top) {
+            Array *a = new Array(capacity * 2);
+            for (int64_t i = top; i < bottom; i++)
+                a->put(i, get(i));
+            return a;
+        }
+    };
+
+    // top and bottom are updated by different engines
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    std::atomic<Array *> array;
+
+    std::vector<Array *> retired;  // only accessed by the owner
+
+public:
+    WorkDeque() : top(0), bottom(0), array(new Array(INIT_CAPACITY)) {}
+
+    ~WorkDeque() {
+        T item;
+        while (try_pop(item)) continue;
+        delete array.load();
+        for (auto a : retired)
+            delete a;
+    }
+
+    WorkDeque(const WorkDeque &) = delete;
+    WorkDeque &operator=(const WorkDeque &) = delete;
+
+    // (owner only)
+    void push(T item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Array *a = array.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {  // full
+            retired.push_back(a);
+            a = a->grow(b, t);
+            array.store(a, std::memory_order_release);
+        }
+        a->put(b, new T(std::move(item)));
+        bottom.store(b + 1, std::memory_order_release);  // publish the item to thieves
+    }
+
+    // (owner only) pop the latest item
+    bool try_pop(T &item) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array *a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {  // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        T *p = a->get(b);
+        if (t == b) {
+            // the last item, race with thieves
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won) return false;
+        }
+        item = std::move(*p);
+        delete p;
+        return true;
+    }
+
+    // (any engine) steal the earliest item
+    bool steal(T &item) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;  // empty
+
+        Array *a = array.load(std::memory_order_acquire);
+        T *p = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+            return false;  // lost the race with the owner or other thieves
+        item = std::move(*p);
+        delete p;
+        return true;
+    }
+
+    // (approximate if called by thieves)
+    int64_t size() {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return (b > t) ? (b - t) : 0;
+    }
+
+    bool empty() { return size() == 0; }
+};
+
+}  // namespace wukong
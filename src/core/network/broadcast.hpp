@@ -69,7 +69,7 @@ public:
     bool tryrecv(Bundle &b) {
         std::string str;
         if (!tryrecv(str)) return false;
-        b.init(str);
+        b.init(std::move(str));
         return true;
     }
 };
@@ -115,7 +115,7 @@ public:
     bool tryrecv(Bundle &b) {
         std::string str;
         if (!tryrecv(str)) return false;
-        b.init(str);
+        b.init(std::move(str));
         return true;
     }
 };
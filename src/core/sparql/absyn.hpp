@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -193,6 +194,23 @@ public:
         bool descending;
     };
 
+    /// Aggregate functions (the same order as agg_func_t)
+    enum AggregateFunc {Aggregate_Count, Aggregate_Sum, Aggregate_Avg,
+                        Aggregate_Min, Aggregate_Max
+                       };
+
+    /// Aggregate, e.g., (COUNT(DISTINCT ?X) AS ?N)
+    struct Aggregate {
+        /// The function
+        AggregateFunc func;
+        /// Variable id (0 for COUNT(*))
+        int id;
+        /// Variable id of the result
+        int alias;
+        /// Only distinct values
+        bool distinct;
+    };
+
     struct PatternNode {
         PatternType type; 
         Pattern* pattern;
@@ -220,6 +238,12 @@ private:
     PatternGroup patterns;
     /// The sort order
     std::vector<Order> order;
+    /// The aggregates in the projection clause
+    std::vector<Aggregate> aggregates;
+    /// The group by clause
+    std::vector<int> groupBy;
+    /// The argument of the aggregate being parsed
+    Aggregate pendingAggregate = Aggregate();
     /// The result limit, -1 means no limit
     int limit;
     /// The result offset
@@ -275,6 +299,9 @@ public:
         namedVariables.clear();
         projection.clear();
         order.clear();
+        aggregates.clear();
+        groupBy.clear();
+        pendingAggregate = Aggregate();
         patterns.patterns.clear();
         patterns.filters.clear();
         patterns.unions.clear();
@@ -307,6 +334,15 @@ public:
     /// Iterator over the order by clause
     order_iterator orderEnd() const { return order.end(); }
 
+    /// Iterator over the aggregates
+    typedef std::vector<Aggregate>::const_iterator aggregate_iterator;
+    /// Iterator over the aggregates
+    aggregate_iterator aggregateBegin() const { return aggregates.begin(); }
+    /// Iterator over the aggregates
+    aggregate_iterator aggregateEnd() const { return aggregates.end(); }
+    /// The group by clause
+    const std::vector<int> &getGroupBy() const { return groupBy; }
+
     /// The projection modifier
     ProjectionModifier getProjectionModifier() const { return projectionModifier; }
     /// The size limit
@@ -331,13 +367,7 @@ public:
         #endif
         std::string iri(iri_);
         iri = iri.substr(1,iri.size()-2);
-        if(wukong::time_tool::is_date(iri)) {
-            ts = wukong::time_tool::str2int(iri);
-            te = ts + 24 * 60 * 60;
-        } else if(wukong::time_tool::is_time(iri)) {
-            ts = wukong::time_tool::str2int(iri);
-            te = ts;
-        } else {
+        if(!wukong::time_tool::snapshot2interval(iri, ts, te)) {
             throw ParserException("snapshot format must be <yyyy-MM-dd> or <yyyy-MM-ddTHH:mm:ss>");
         }
     }
@@ -419,6 +449,49 @@ public:
 		projection.push_back(nameVariable(variable));
 	}
 
+    // Register the argument of an aggregate (NULL for *)
+    void setAggregateArg(char* variable){
+        if (!variable) {
+            pendingAggregate.id = 0;
+            return;
+        }
+        std::string name;
+        for (variable = variable + 1; isalnum(*variable); variable++)
+            name.push_back(*variable);
+        pendingAggregate.id = nameVariable(name);
+    }
+
+    // Register the modifier of an aggregate (only DISTINCT)
+    void setAggregateDistinct(char* modifier){
+        if (!isKeyword(modifier, "distinct"))
+            throw ParserException("unexpected '" + std::string(modifier) + "' in aggregate");
+        pendingAggregate.distinct = true;
+    }
+
+    // Register the aggregate w/ the registered argument
+    void addAggregate(int func){
+        pendingAggregate.func = static_cast<AggregateFunc>(func);
+        if (pendingAggregate.id == 0 && func != Aggregate_Count)
+            throw ParserException("only COUNT supports * in aggregate");
+        aggregates.push_back(pendingAggregate);
+        pendingAggregate = Aggregate();
+    }
+
+    // Register the result variable of the last aggregate (AS ?alias)
+    void addAggregateAlias(char* variable){
+        variable = variable + 1;
+        if (namedVariables.count(variable))
+            throw ParserException("variable '" + std::string(variable) + "' is already in use");
+        aggregates.back().alias = nameVariable(variable);
+        projection.push_back(aggregates.back().alias);
+    }
+
+    // Register the variable of group by clause
+    void addGroupBy(char* variable){
+        variable = variable + 1;
+        groupBy.push_back(nameVariable(variable));
+    }
+
     // Register PatternGroup in where clause
     void registerPatternGroup(PatternGroup* patternGroup){
         if(patternGroup){
@@ -697,6 +770,7 @@ public:
             }   
         }
         result->value = std::string(stringValue); 
+        result->subType = Element::None;
         if(customLanguage){
             result->subType = Element::CustomLanguage;
             result->subTypeValue = std::string(customLanguage);
@@ -957,6 +1031,21 @@ public:
 
     // post parsing operations
     void postParsing(){
+        // Check projections w/ aggregates or group by (only aggregates and grouped variables)
+        if (aggregates.size() || groupBy.size()) {
+            if (!projection.size())
+                throw ParserException("SELECT * is not allowed with aggregates or GROUP BY");
+
+            for (int var : projection) {
+                bool valid = std::find(groupBy.begin(), groupBy.end(), var) != groupBy.end();
+                for (const Aggregate &a : aggregates)
+                    valid = valid || (a.alias == var);
+                if (!valid)
+                    throw ParserException("variable '" + getVariableName(var)
+                                          + "' should be grouped or aggregated");
+            }
+        }
+
         // Fixup empty projections (i.e. *)
         if (!projection.size()) {
             for (std::map<std::string, ssid_t>::const_iterator iter = namedVariables.begin(), limit = namedVariables.end();
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "core/common/type.hpp"
+
+#include "stringserver/typed_literal.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+
+namespace wukong {
+
+// aggregate functions (the same order as SPARQLParser::AggregateFunc)
+enum agg_func_t : int32_t { AGG_COUNT = 0, AGG_SUM, AGG_AVG, AGG_MIN, AGG_MAX };
+
+/**
+ * @brief (Partial) aggregates of a query, one row per group
+ *
+ * Each group has #nkeys key IDs (the GROUP BY variables) and a state per
+ * aggregate function, i.e., a count, a value and an ID:
+ *   COUNT:   count (#bound rows)
+ *   SUM/AVG: count and sum of numeric values
+ *   MIN/MAX: count, the min/max term, i.e., its typed value or its string
+ *            (for the other terms, e.g., IRIs), and its ID
+ *
+ * MIN/MAX order the typed (numeric and dateTime) values before the other
+ * terms, which are ordered by their strings as ORDER BY does (see ResultSorter).
+ *
+ * The states are mergeable, so engines aggregate their own rows and ship
+ * the groups (instead of the rows), which are merged by the parent query.
+ */
+class AggTable {
+private:
+    friend class boost::serialization::access;
+    template <typename Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+        ar & nkeys;
+        ar & funcs;
+        ar & keys;
+        ar & cnts;
+        ar & vals;
+        ar & ids;
+        ar & strs;
+    }
+
+    // the hash index of groups (not serialized, rebuilt on demand)
+    std::vector<uint32_t> slots;  // group index + 1 (0 means empty)
+
+    uint64_t hash(const sid_t *key) const {
+        uint64_t h = 0x9e3779b97f4a7c15ULL;
+        for (int i = 0; i < nkeys; i++) {
+            h ^= key[i] + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            h *= 0xff51afd7ed558ccdULL;
+        }
+        return h ^ (h >> 33);
+    }
+
+    bool equal(uint32_t g, const sid_t *key) const {
+        for (int i = 0; i < nkeys; i++)
+            if (keys[(uint64_t)g * nkeys + i] != key[i]) return false;
+        return true;
+    }
+
+    void rehash(uint64_t nslots) {
+        slots.assign(nslots, 0);
+        for (uint32_t g = 0; g < size(); g++) {
+            uint64_t s = hash(keys.data() + (uint64_t)g * nkeys) & (nslots - 1);
+            while (slots[s] != 0) s = (s + 1) & (nslots - 1);
+            slots[s] = g + 1;
+        }
+    }
+
+    // compare two MIN/MAX terms (an empty string means a typed value)
+    static int compare_term(double va, const std::string &sa, double vb, const std::string &sb) {
+        if (sa.empty() != sb.empty())
+            return sa.empty() ? -1 : 1;
+        if (!sa.empty())
+            return sa.compare(sb);
+        return (va < vb) ? -1 : ((va > vb) ? 1 : 0);
+    }
+
+    void combine(uint64_t i, int32_t func, uint64_t cnt, double val, sid_t id,
+                 const std::string &str) {
+        if (cnt == 0) return;
+        switch (func) {
+        case AGG_COUNT:
+            break;
+        case AGG_SUM:
+        case AGG_AVG:
+            vals[i] += val;
+            break;
+        case AGG_MIN:
+        case AGG_MAX: {
+            // ties are broken by IDs, so that the result is deterministic
+            int cmp = compare_term(val, str, vals[i], strs[i]);
+            bool better = (func == AGG_MIN) ? (cmp < 0 || (cmp == 0 && id < ids[i]))
+                                            : (cmp > 0 || (cmp == 0 && id < ids[i]));
+            if (cnts[i] == 0 || better) {
+                vals[i] = val;
+                ids[i] = id;
+                strs[i] = str;
+            }
+            break;
+        }
+        default:
+            ASSERT(false);
+        }
+        cnts[i] += cnt;
+    }
+
+public:
+    int nkeys = 0;
+    std::vector<int32_t> funcs;  // agg_func_t of each aggregate
+
+    // nkeys keys and naggs() states per group
+    std::vector<sid_t> keys;
+    std::vector<uint64_t> cnts;
+    std::vector<double> vals;
+    std::vector<sid_t> ids;
+    std::vector<std::string> strs;  // only the MIN/MAX of the terms w/o typed values
+
+    void init(int nkeys, const std::vector<int32_t> &funcs) {
+        clear();
+        this->nkeys = nkeys;
+        this->funcs = funcs;
+    }
+
+    void clear() {
+        nkeys = 0;
+        funcs.clear();
+        keys.clear();
+        cnts.clear();
+        vals.clear();
+        ids.clear();
+        strs.clear();
+        slots.clear();
+    }
+
+    // initialized by a query w/ aggregates or GROUP BY
+    bool enabled() const { return nkeys > 0 || funcs.size() > 0; }
+
+    int naggs() const { return funcs.size(); }
+
+    // the number of groups
+    uint64_t size() const { return (naggs() > 0) ? cnts.size() / naggs() : keys.size() / nkeys; }
+
+    // find or insert the group of the key (#nkeys IDs)
+    uint32_t group(const sid_t *key) {
+        ASSERT(enabled());
+        if (nkeys == 0 && size() > 0)
+            return 0;  // a single group w/o GROUP BY
+
+        if (slots.size() < 2 * (size() + 1))
+            rehash(std::max<uint64_t>(64, slots.size() * 2));
+
+        uint64_t s = hash(key) & (slots.size() - 1);
+        while (slots[s] != 0) {
+            if (equal(slots[s] - 1, key))
+                return slots[s] - 1;
+            s = (s + 1) & (slots.size() - 1);
+        }
+
+        uint32_t g = size();
+        slots[s] = g + 1;
+        keys.insert(keys.end(), key, key + nkeys);
+        cnts.resize(cnts.size() + naggs(), 0);
+        vals.resize(vals.size() + naggs(), 0);
+        ids.resize(ids.size() + naggs(), BLANK_ID);
+        strs.resize(strs.size() + naggs());
+        return g;
+    }
+
+    /**
+     * @brief Aggregate a value of a row into the group
+     *
+     * @param id the ID of the term (any but BLANK_ID for COUNT(*))
+     * @param v the typed value of the term (only numeric values are summed)
+     * @param str the string of the term w/o typed value (only for MIN/MAX)
+     */
+    void update(uint32_t g, int a, sid_t id, const typed_value_t &v,
+                const std::string &str = std::string()) {
+        int32_t func = funcs[a];
+        if (func == AGG_COUNT && id == BLANK_ID) return;  // unbound (e.g., OPTIONAL)
+        if ((func == AGG_SUM || func == AGG_AVG) && v.kind != LIT_NUMERIC) return;
+        if ((func == AGG_MIN || func == AGG_MAX) && v.kind == LIT_NONE && str.empty()) return;
+        combine((uint64_t)g * naggs() + a, func, 1, v.val, id,
+                (v.kind == LIT_NONE) ? str : std::string());
+    }
+
+    // merge (partial) aggregates of the same query
+    void merge(const AggTable &o) {
+        if (!o.enabled()) return;
+        if (!enabled()) {
+            *this = o;
+            slots.clear();
+            return;
+        }
+
+        ASSERT(nkeys == o.nkeys && funcs == o.funcs);
+        for (uint32_t og = 0; og < o.size(); og++) {
+            uint32_t g = group(o.keys.data() + (uint64_t)og * nkeys);
+            for (int a = 0; a < naggs(); a++) {
+                uint64_t oi = (uint64_t)og * naggs() + a;
+                combine((uint64_t)g * naggs() + a, funcs[a], o.cnts[oi], o.vals[oi], o.ids[oi],
+                        o.strs[oi]);
+            }
+        }
+    }
+
+    sid_t key(uint32_t g, int k) const { return keys[(uint64_t)g * nkeys + k]; }
+
+    uint64_t count(uint32_t g, int a) const { return cnts[(uint64_t)g * naggs() + a]; }
+
+    sid_t id(uint32_t g, int a) const { return ids[(uint64_t)g * naggs() + a]; }
+
+    // compare the aggregates of two groups (unbound MIN/MAX, e.g., of empty groups, goes first)
+    int compare(uint32_t ga, uint32_t gb, int a) const {
+        uint64_t ia = (uint64_t)ga * naggs() + a, ib = (uint64_t)gb * naggs() + a;
+        if (funcs[a] == AGG_MIN || funcs[a] == AGG_MAX) {
+            if ((cnts[ia] == 0) != (cnts[ib] == 0))
+                return (cnts[ia] == 0) ? -1 : 1;
+            return compare_term(vals[ia], strs[ia], vals[ib], strs[ib]);
+        }
+        double va = value(ga, a), vb = value(gb, a);
+        return (va < vb) ? -1 : ((va > vb) ? 1 : 0);
+    }
+
+    // the final value of the aggregate (e.g., AVG = SUM / COUNT)
+    double value(uint32_t g, int a) const {
+        uint64_t i = (uint64_t)g * naggs() + a;
+        switch (funcs[a]) {
+        case AGG_COUNT: return cnts[i];
+        case AGG_AVG: return (cnts[i] > 0) ? vals[i] / cnts[i] : 0;
+        default: return vals[i];
+        }
+    }
+};
+
+} // namespace wukong
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "core/common/type.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+
+namespace wukong {
+
+/**
+ * @brief Columnar (late-materialized) intermediate result table
+ *
+ * The table is a stack of levels.
+ * Level 0 is the row-major base table (i.e., the original result_table).
+ * Each expansion step (e.g., known_to_unknown) pushes a new level, which
+ * only stores the new column and the index of each new row's parent row
+ * in the previous level. Each filtering step (e.g., known_to_known) only
+ * updates the selection vector of the top level.
+ *
+ * Rows are materialized back to the row-major layout only when they are
+ * consumed by row-based operators (e.g., fork-join, filter, and final).
+ */
+class ColumnTable {
+private:
+    struct Level {
+        std::vector<uint32_t> parents;  // index of the parent row in the previous level
+        std::vector<sid_t> vals;        // values of the new column
+    };
+
+    bool active = false;
+
+    // level 0: row-major base table
+    std::vector<sid_t> base;
+    int base_cols = 0;
+
+    // level 1..N: one column per level
+    std::vector<Level> levels;
+
+    // the level of each column (index: col, value: level)
+    std::vector<int> col_level;
+
+    // selection vector on the top level (all rows if has_sel is false)
+    std::vector<uint32_t> sel;
+    bool has_sel = false;
+
+    uint64_t top_rows() const {
+        if (levels.empty())
+            return (base_cols == 0) ? 0 : base.size() / base_cols;
+        return levels.back().parents.size();
+    }
+
+    // translate active rows to the physical rows on the top level
+    void top_index(std::vector<uint32_t> &idx) const {
+        if (has_sel) {
+            idx.assign(sel.begin(), sel.end());
+        } else {
+            idx.resize(top_rows());
+            for (uint32_t i = 0; i < idx.size(); i++)
+                idx[i] = i;
+        }
+    }
+
+    // walk down the indexes of rows from the level 'from' to the level 'to'
+    void walk_down(std::vector<uint32_t> &idx, int from, int to) const {
+        for (int l = from; l > to; l--) {
+            const std::vector<uint32_t> &parents = levels[l - 1].parents;
+            for (uint32_t i = 0; i < idx.size(); i++)
+                idx[i] = parents[idx[i]];
+        }
+    }
+
+    sid_t value(int col, int lvl, uint32_t row) const {
+        if (lvl == 0)
+            return base[(uint64_t)row * base_cols + col];
+        return levels[lvl - 1].vals[row];
+    }
+
+public:
+    bool enabled() const { return active; }
+
+    /**
+     * @brief Start columnar execution on a row-major table
+     *
+     * @param table row-major table (moved into the base level)
+     * @param ncols the number of columns of the table
+     */
+    void init(std::vector<sid_t> &table, int ncols) {
+        ASSERT(!active);
+        base.swap(table);
+        table.clear();
+        base_cols = ncols;
+        levels.clear();
+        col_level.assign(ncols, 0);
+        sel.clear();
+        has_sel = false;
+        active = true;
+    }
+
+    // the number of active rows
+    uint64_t size() const { return has_sel ? sel.size() : top_rows(); }
+
+    // get the value at (row, col), where row is the index of active rows
+    sid_t get(uint32_t row, int col) const {
+        ASSERT(col < (int)col_level.size());
+        int lvl = levels.size();
+        uint32_t r = has_sel ? sel[row] : row;
+        for (; lvl > col_level[col]; lvl--)
+            r = levels[lvl - 1].parents[r];
+        return value(col, lvl, r);
+    }
+
+    /**
+     * @brief Gather a column of all active rows
+     *
+     * @param col column id
+     * @param out values of the column (for return)
+     */
+    void gather(int col, std::vector<sid_t> &out) const {
+        ASSERT(col < (int)col_level.size());
+        std::vector<uint32_t> idx;
+        top_index(idx);
+        walk_down(idx, levels.size(), col_level[col]);
+
+        out.resize(idx.size());
+        for (uint32_t i = 0; i < idx.size(); i++)
+            out[i] = value(col, col_level[col], idx[i]);
+    }
+
+    /**
+     * @brief Keep a subset of active rows (filtering step)
+     *
+     * @param rows the (ascending) indexes of active rows to keep
+     */
+    void select(const std::vector<uint32_t> &rows) {
+        if (has_sel) {
+            for (uint32_t i = 0; i < rows.size(); i++)
+                sel[i] = sel[rows[i]];
+            sel.resize(rows.size());
+        } else {
+            sel.assign(rows.begin(), rows.end());
+            has_sel = true;
+        }
+    }
+
+    /**
+     * @brief Append a new column (expansion step)
+     *
+     * The i-th new row copies the active row parents[i] and appends vals[i].
+     *
+     * @param parents the indexes of active rows (moved)
+     * @param vals values of the new column (moved)
+     * @param col column id of the new column
+     */
+    void expand(std::vector<uint32_t> &parents, std::vector<sid_t> &vals, int col) {
+        ASSERT(parents.size() == vals.size());
+        ASSERT(col == (int)col_level.size());
+
+        // the parents are always the physical rows of the previous level
+        if (has_sel) {
+            for (uint32_t i = 0; i < parents.size(); i++)
+                parents[i] = sel[parents[i]];
+            sel.clear();
+            has_sel = false;
+        }
+
+        levels.push_back(Level());
+        levels.back().parents.swap(parents);
+        levels.back().vals.swap(vals);
+        col_level.push_back(levels.size());
+    }
+
+    /**
+     * @brief Materialize active rows into a row-major table
+     *
+     * @param table row-major table (for return)
+     * @param ncols the number of columns
+     */
+    void materialize(std::vector<sid_t> &table, int ncols) const {
+        ASSERT(ncols == (int)col_level.size());
+        uint64_t nrows = size();
+
+        // the row indexes on every level
+        std::vector<std::vector<uint32_t>> idx(levels.size() + 1);
+        top_index(idx[levels.size()]);
+        for (int l = levels.size(); l > 0; l--) {
+            idx[l - 1] = idx[l];
+            walk_down(idx[l - 1], l, l - 1);
+        }
+
+        table.resize(nrows * ncols);
+        for (int c = 0; c < ncols; c++) {
+            int lvl = col_level[c];
+            const std::vector<uint32_t> &rows = idx[lvl];
+            for (uint64_t r = 0; r < nrows; r++)
+                table[r * ncols + c] = value(c, lvl, rows[r]);
+        }
+    }
+
+    // materialize active rows and quit columnar execution
+    void flush(std::vector<sid_t> &table, int ncols) {
+        ASSERT(active);
+        materialize(table, ncols);
+        clear();
+    }
+
+    void clear() {
+        active = false;
+        std::vector<sid_t>().swap(base);
+        base_cols = 0;
+        std::vector<Level>().swap(levels);
+        col_level.clear();
+        std::vector<uint32_t>().swap(sel);
+        has_sel = false;
+    }
+};
+
+} // namespace wukong
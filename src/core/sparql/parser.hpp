@@ -50,6 +50,7 @@
 
 #include "core/sparql/query.hpp"
 #include "core/sparql/absyn.hpp"
+#include "core/sparql/regex_matcher.hpp"
 
 #include "stringserver/string_mapping.hpp"
 
@@ -106,6 +107,9 @@ private:
 
     int tid;
 
+    // compiled patterns of REGEX filters (validated at parse time)
+    RegexCache regex_cache;
+
     /// SPARQLParser::Element to ssid
     ssid_t transfer_element(const SPARQLParser::Element &e) {
         switch (e.type) {
@@ -157,6 +161,10 @@ private:
         dst.type = (SPARQLQuery::Filter::Type)src.type;
         dst.value = src.value;
         dst.valueArg = src.valueArg;
+        // the datatype of typed literals (e.g., numbers), not the language tag
+        if (src.type == SPARQLParser::Filter::Literal
+                && src.valueArg == SPARQLParser::Element::CustomType)
+            dst.valueType = src.valueType;
         if (src.arg1 != NULL) {
             dst.arg1 = new SPARQLQuery::Filter();
             transfer_filter(*src.arg1, *dst.arg1);
@@ -169,6 +177,16 @@ private:
             dst.arg3 = new SPARQLQuery::Filter();
             transfer_filter(*src.arg3, *dst.arg3);
         }
+
+        // compile the pattern once, so that invalid patterns fail early as syntax errors
+        if (dst.type == SPARQLQuery::Filter::Type::Builtin_regex && dst.arg2 != NULL) {
+            try {
+                regex_cache.get(dst.arg2->value, dst.arg3 != NULL && dst.arg3->value == "i");
+            } catch (std::regex_error &err) {
+                logstream(LOG_ERROR) << "invalid pattern of regex: " << dst.arg2->value << LOG_endl;
+                throw WukongException(SYNTAX_ERROR);
+            }
+        }
     }
 
     /// SPARQLParser::PatternGroup to SPARQLQuery::PatternGroup
@@ -259,6 +277,17 @@ private:
                     iter ++)
                 sq.orders.push_back(SPARQLQuery::Order((*iter).id, (*iter).descending));
 
+        // aggregates and group by
+        if (sq.q_type == SPARQLQuery::SELECT) {
+            for (SPARQLParser::aggregate_iterator iter = sp.aggregateBegin();
+                    iter != sp.aggregateEnd();
+                    iter ++)
+                sq.aggregates.push_back(SPARQLQuery::Aggregate((*iter).func, (*iter).id,
+                                                               (*iter).alias, (*iter).distinct));
+            for (int var : sp.getGroupBy())
+                sq.group_by.push_back(var);
+        }
+
         // limit and offset
         sq.limit = sp.getLimit();
         sq.offset = sp.getOffset();
@@ -286,8 +315,10 @@ private:
         // required varaibles of SELECT clause
         for (SPARQLParser::projection_iterator iter = sp.projectionBegin();
                 iter != sp.projectionEnd();
-                iter ++)
+                iter ++) {
             sqt.required_vars.push_back(*iter);
+            sqt.required_vars_name.push_back(sp.getVariableName(*iter));
+        }
 
         // pattern group (patterns)
         // FIXME: union, filter, optional (unsupported now)
@@ -41,6 +41,9 @@
 
 #include "core/store/vertex.hpp"
 
+#include "core/sparql/agg_table.hpp"
+#include "core/sparql/column_table.hpp"
+
 // utils
 #include "utils/assertion.hpp"
 #include "utils/logger2.hpp"
@@ -179,6 +182,7 @@ public:
             ar & arg2;
             ar & arg3;
             ar & value;
+            ar & valueType;
             ar & valueArg;
         }
 
@@ -194,6 +198,7 @@ public:
         Type type;
         Filter *arg1, *arg2, *arg3; /// Input arguments
         std::string value; /// The value (for constants param)
+        std::string valueType; /// The datatype IRI of literals (empty if untyped)
         int valueArg; /// variable ids
 
         /// Constructor
@@ -202,7 +207,7 @@ public:
         /// Copy-Constructor
         Filter(const Filter &other)
             : type(other.type), arg1(0), arg2(0), arg3(0),
-              value(other.value), valueArg(other.valueArg) {
+              value(other.value), valueType(other.valueType), valueArg(other.valueArg) {
             if (other.arg1)
                 arg1 = new Filter(*other.arg1);
             if (other.arg2)
@@ -302,6 +307,29 @@ public:
             : id(_id), descending(_descending) { }
     };
 
+    class Aggregate {
+    private:
+        friend class boost::serialization::access;
+        template <typename Archive>
+        void serialize(Archive &ar, const unsigned int version) {
+            ar & func;
+            ar & var;
+            ar & alias;
+            ar & distinct;
+        }
+
+    public:
+        int32_t func;   /// agg_func_t
+        ssid_t var;     /// variable id (0 for COUNT(*))
+        ssid_t alias;   /// variable id of the result (AS ?alias)
+        bool distinct;  /// e.g., COUNT(DISTINCT ?X)
+
+        Aggregate() { }
+
+        Aggregate(int32_t _func, ssid_t _var, ssid_t _alias, bool _distinct)
+            : func(_func), var(_var), alias(_alias), distinct(_distinct) { }
+    };
+
     class Result {
     private:
         friend class boost::serialization::access;
@@ -393,11 +421,18 @@ public:
         std::vector<sid_t> result_table; // result table for string IDs
         std::vector<attr_t> attr_res_table; // result table for others
 
+        // columnar view of result_table during pattern matching (not serialized)
+        ColumnTable col_table;
+
+        // (partial) aggregates of the rows aggregated so far
+        AggTable agg_table;
+
 #ifdef USE_GPU
         GPUResult gpu;
 #endif
 
         void clear() {
+            col_table.clear();
             result_table.clear();
             attr_res_table.clear();
             required_vars.clear();
@@ -489,13 +524,14 @@ public:
         int get_col_num() const { return col_num; }
 
         int get_row_num() const {
+            if (col_table.enabled())
+                return col_table.size();
             return (col_num == 0) ?
                    0 : (result_table.size() / col_num);
         }
 
         void update_nrows() {
-            row_num = (col_num == 0) ?
-                      0 : (result_table.size() / col_num);
+            row_num = get_row_num();
         }
 
         sid_t get_row_col(int r, int c) {
@@ -512,6 +548,24 @@ public:
             result_table.assign(update.begin(), update.end());
         }
 
+        // COLUMNAR result (i.e., late materialization)
+        // NOTE: row-based accessors (e.g., get_row_col) require a materialized table
+        bool is_columnar() const { return col_table.enabled(); }
+
+        // move result_table into a columnar table
+        void begin_columnar() {
+            if (!col_table.enabled())
+                col_table.init(result_table, col_num);
+        }
+
+        // write back the columnar table to result_table (no-op if not columnar)
+        void materialize() {
+            if (col_table.enabled()) {
+                col_table.flush(result_table, col_num);
+                update_nrows();
+            }
+        }
+
     #ifdef TRDF_MODE
         // TIMT_T result (i.e., timestamp)
         void set_time_col_num(int n) {
@@ -603,6 +657,9 @@ public:
 
         // For UNION queries, merge two result table into one
         void merge_result(SPARQLQuery::Result &r) {
+            r.materialize();
+            materialize();
+
             /// update metadata (i.e., v2c_map, ncols, and nrows)
             nvars = r.nvars;
             v2c_map.resize(r.nvars, NO_RESULT);
@@ -674,6 +731,9 @@ public:
         }
 
         void append_result(SPARQLQuery::Result &r) {
+            r.materialize();
+            materialize();
+
             /// update metadata (i.e., v2c_map, ncols, attr_ncols, and nrows)
             // NOTE: all sub-jobs have the same v2c_map, ncols, and attr_ncols
             v2c_map = r.v2c_map;
@@ -747,6 +807,8 @@ public:
     // PatternGroup
     PatternGroup pattern_group;
     std::vector<Order> orders;
+    std::vector<Aggregate> aggregates;
+    std::vector<ssid_t> group_by;
     Result result;
 
     SPARQLQuery() { }
@@ -779,6 +841,8 @@ public:
         pattern_group.unions.clear();
 
         orders.clear();
+        aggregates.clear();
+        group_by.clear();
 
         // discard results if does not care
         if (result.blind)
@@ -793,6 +857,22 @@ public:
 
     bool has_filter() { return pattern_group.filters.size() > 0; }
 
+    bool has_aggregate() const { return aggregates.size() > 0 || group_by.size() > 0; }
+
+    /**
+     * The rows of a sub-query can be aggregated before replying (only the
+     * groups are sent back) if the parent query only filters and finalizes
+     * them, and no aggregate needs DISTINCT (which is not mergeable).
+     */
+    bool can_aggregate_partially() const {
+        if (!has_aggregate() || result.blind || pg_type != BASIC
+                || pattern_group.unions.size() > 0 || pattern_group.optional.size() > 0)
+            return false;
+        for (auto const &a : aggregates)
+            if (a.distinct) return false;
+        return true;
+    }
+
     bool done(SQState state) {
         switch (state) {
         case SQ_PATTERN:
@@ -991,30 +1071,39 @@ public:
 
     int nvars;  // the number of variable in triple patterns
     std::vector<ssid_t> required_vars; // variables selected to return
+    std::vector<std::string> required_vars_name; // the name of variables selected to return
 
     std::vector<std::string> ptypes_str; // the Types of random-constants
     std::vector<int> ptypes_pos; // the locations of random-constants
 
     std::vector<std::vector<sid_t>> ptypes_grp; // the candidates for random-constants
 
-    SPARQLQuery instantiate(int seed) {
-        for (int i = 0; i < ptypes_pos.size(); i++) {
-            int pos = ptypes_pos[i];
-            switch (pos % 4) {
-            case 0:
-                pattern_group.patterns[pos / 4].subject =
-                    ptypes_grp[i][seed % ptypes_grp[i].size()];
-                break;
-            case 1:
-                pattern_group.patterns[pos / 4].predicate =
-                    ptypes_grp[i][seed % ptypes_grp[i].size()];
-                break;
-            case 3:
-                pattern_group.patterns[pos / 4].object =
-                    ptypes_grp[i][seed % ptypes_grp[i].size()];
-                break;
-            }
+    void set_ptype(int pos, sid_t id) {
+        switch (pos % 4) {
+        case 0:
+            pattern_group.patterns[pos / 4].subject = id;
+            break;
+        case 1:
+            pattern_group.patterns[pos / 4].predicate = id;
+            break;
+        case 3:
+            pattern_group.patterns[pos / 4].object = id;
+            break;
         }
+    }
+
+    SPARQLQuery instantiate(int seed) {
+        for (int i = 0; i < ptypes_pos.size(); i++)
+            set_ptype(ptypes_pos[i], ptypes_grp[i][seed % ptypes_grp[i].size()]);
+
+        return SPARQLQuery(pattern_group, nvars, required_vars);
+    }
+
+    // fill random-constants w/ given constants in order (e.g., the bindings of a prepared query)
+    SPARQLQuery instantiate(const std::vector<sid_t> &consts) {
+        ASSERT(consts.size() == ptypes_pos.size());
+        for (int i = 0; i < ptypes_pos.size(); i++)
+            set_ptype(ptypes_pos[i], consts[i]);
 
         return SPARQLQuery(pattern_group, nvars, required_vars);
     }
@@ -1165,7 +1254,14 @@ void save(Archive &ar, const wukong::SPARQLQuery::Result &t, unsigned int versio
     ar << t.optional_matched_rows;
     if (t.row_num > 0) {
         ar << occupied;
-        ar << t.result_table;
+        if (t.col_table.enabled()) {
+            // late materialization before sending
+            std::vector<wukong::sid_t> table;
+            t.col_table.materialize(table, t.col_num);
+            ar << table;
+        } else {
+            ar << t.result_table;
+        }
         ar << t.attr_res_table;
     } else {
         ar << empty;
@@ -1177,6 +1273,12 @@ void save(Archive &ar, const wukong::SPARQLQuery::Result &t, unsigned int versio
     ar << t.time_col_num;
     ar << t.time_res_table;
 #endif
+    if (t.agg_table.enabled()) {
+        ar << occupied;
+        ar << t.agg_table;
+    } else {
+        ar << empty;
+    }
 }
 
 template<class Archive>
@@ -1203,6 +1305,8 @@ void load(Archive & ar, wukong::SPARQLQuery::Result &t, unsigned int version) {
     ar >> t.time_col_num;
     ar >> t.time_res_table;
 #endif
+    ar >> temp;
+    if (temp == occupied) ar >> t.agg_table;
 }
 
 template<class Archive>
@@ -1238,6 +1342,13 @@ void save(Archive & ar, const wukong::SPARQLQuery &t, unsigned int version) {
     } else {
         ar << empty;
     }
+    if (t.has_aggregate()) {
+        ar << occupied;
+        ar << t.aggregates;
+        ar << t.group_by;
+    } else {
+        ar << empty;
+    }
     ar << t.result;
 }
 
@@ -1271,6 +1382,12 @@ void load(Archive & ar, wukong::SPARQLQuery &t, unsigned int version) {
 #endif
     ar >> temp;
     if (temp == occupied) ar >> t.orders;
+    temp = 2;
+    ar >> temp;
+    if (temp == occupied) {
+        ar >> t.aggregates;
+        ar >> t.group_by;
+    }
     ar >> t.result;
 }
 
@@ -1289,6 +1406,8 @@ BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery::Pattern, boost::serialization::o
 BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery::PatternGroup, boost::serialization::object_serializable);
 BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery::Filter, boost::serialization::object_serializable);
 BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery::Order, boost::serialization::object_serializable);
+BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery::Aggregate, boost::serialization::object_serializable);
+BOOST_CLASS_IMPLEMENTATION(wukong::AggTable, boost::serialization::object_serializable);
 BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery::Result, boost::serialization::object_serializable);
 BOOST_CLASS_IMPLEMENTATION(wukong::SPARQLQuery, boost::serialization::object_serializable);
 
@@ -1303,6 +1422,8 @@ BOOST_CLASS_TRACKING(wukong::SPARQLQuery::Pattern, boost::serialization::track_n
 BOOST_CLASS_TRACKING(wukong::SPARQLQuery::Filter, boost::serialization::track_never);
 BOOST_CLASS_TRACKING(wukong::SPARQLQuery::PatternGroup, boost::serialization::track_never);
 BOOST_CLASS_TRACKING(wukong::SPARQLQuery::Order, boost::serialization::track_never);
+BOOST_CLASS_TRACKING(wukong::SPARQLQuery::Aggregate, boost::serialization::track_never);
+BOOST_CLASS_TRACKING(wukong::AggTable, boost::serialization::track_never);
 BOOST_CLASS_TRACKING(wukong::SPARQLQuery::Result, boost::serialization::track_never);
 BOOST_CLASS_TRACKING(wukong::SPARQLQuery, boost::serialization::track_never);
 
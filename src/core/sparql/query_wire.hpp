@@ -0,0 +1,542 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "core/common/type.hpp"
+
+#include "core/sparql/query.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+
+namespace wukong {
+
+/**
+ * @brief Writer of the flat binary wire format
+ *
+ * If buf is NULL, the writer only counts the size of the message,
+ * which is used to allocate the send buffer once before encoding.
+ */
+class WireWriter {
+private:
+    char *buf;
+    uint64_t off = 0;
+
+public:
+    explicit WireWriter(char *buf = nullptr) : buf(buf) { }
+
+    uint64_t size() const { return off; }
+
+    // only count the size
+    bool dry() const { return buf == nullptr; }
+
+    void put_bytes(const void *p, uint64_t sz) {
+        if (buf != nullptr && sz > 0)
+            memcpy(buf + off, p, sz);
+        off += sz;
+    }
+
+    template <typename T>
+    void put(const T &v) { put_bytes(&v, sizeof(T)); }
+
+    // only for vectors of POD types
+    template <typename T>
+    void put_vec(const std::vector<T> &v) {
+        put<uint64_t>(v.size());
+        put_bytes(v.data(), sizeof(T) * v.size());
+    }
+
+    void put_str(const std::string &s) {
+        put<uint64_t>(s.size());
+        put_bytes(s.data(), s.size());
+    }
+
+    // used by serialize() of nested classes (e.g., GPUResult)
+    template <typename T>
+    WireWriter &operator&(const T &v) { put(v); return *this; }
+};
+
+/**
+ * @brief Reader of the flat binary wire format
+ *
+ * The reader decodes the message in place (e.g., the receive buffer),
+ * and PODs are copied into the destination objects by a single memcpy.
+ */
+class WireReader {
+private:
+    const char *buf;
+    uint64_t sz;
+    uint64_t off = 0;
+
+public:
+    WireReader(const char *buf, uint64_t sz) : buf(buf), sz(sz) { }
+
+    uint64_t remain() const { return sz - off; }
+
+    void get_bytes(void *p, uint64_t n) {
+        ASSERT(off + n <= sz);
+        if (n > 0) memcpy(p, buf + off, n);
+        off += n;
+    }
+
+    template <typename T>
+    void get(T &v) { get_bytes(&v, sizeof(T)); }
+
+    template <typename T>
+    T get() { T v; get(v); return v; }
+
+    template <typename T>
+    void get_vec(std::vector<T> &v) {
+        uint64_t n = get<uint64_t>();
+        ASSERT(n * sizeof(T) <= remain());
+        v.resize(n);
+        get_bytes(v.data(), sizeof(T) * n);
+    }
+
+    void get_str(std::string &s) {
+        uint64_t n = get<uint64_t>();
+        ASSERT(n <= remain());
+        s.assign(buf + off, n);
+        off += n;
+    }
+
+    template <typename T>
+    WireReader &operator&(T &v) { get(v); return *this; }
+};
+
+/**
+ * @brief Flat and versioned binary encoding of SPARQLQuery
+ *
+ * The message is encoded in one pass into a pre-sized buffer (no stringstream),
+ * and decoded in place from the receive buffer. The header carries a magic
+ * number, the layout version, and the build flags that change the layout,
+ * so that a message from an incompatible build will be rejected.
+ *
+ * NOTE: update VERSION once the layout (i.e., write/read below) is changed.
+ */
+class QueryWire {
+private:
+    static const uint32_t MAGIC = 0x5157574b;  // "KWWQ"
+    static const uint16_t VERSION = 3;
+
+    enum { FLAG_TRDF = 1, FLAG_GPU = 2, FLAG_DTYPE64 = 4 };
+
+    struct header_t {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t flags;
+    };
+
+    static uint16_t build_flags() {
+        uint16_t flags = 0;
+#ifdef TRDF_MODE
+        flags |= FLAG_TRDF;
+#endif
+#ifdef USE_GPU
+        flags |= FLAG_GPU;
+#endif
+        if (sizeof(sid_t) == sizeof(uint64_t))
+            flags |= FLAG_DTYPE64;
+        return flags;
+    }
+
+    /// encoding
+
+    static void write(WireWriter &w, const SPARQLQuery::Pattern &p) {
+        w.put<int64_t>(p.subject);
+        w.put<int64_t>(p.predicate);
+        w.put<int64_t>(p.object);
+        w.put<int32_t>(p.direction);
+        w.put<char>(p.pred_type);
+#ifdef TRDF_MODE
+        w.put(p.time_interval.ts_value);
+        w.put(p.time_interval.te_value);
+        w.put<int64_t>(p.time_interval.ts_var);
+        w.put<int64_t>(p.time_interval.te_var);
+        w.put<int32_t>(p.time_interval.type);
+#endif
+    }
+
+    static void write(WireWriter &w, const SPARQLQuery::Filter &f) {
+        w.put<int32_t>(f.type);
+        w.put_str(f.value);
+        w.put_str(f.valueType);
+        w.put<int32_t>(f.valueArg);
+
+        // the filter is a tree (arg == NULL is encoded as 0)
+        const SPARQLQuery::Filter *args[3] = {f.arg1, f.arg2, f.arg3};
+        for (int i = 0; i < 3; i++) {
+            w.put<char>(args[i] != nullptr);
+            if (args[i] != nullptr)
+                write(w, *args[i]);
+        }
+    }
+
+    static void write(WireWriter &w, const SPARQLQuery::PatternGroup &g) {
+        w.put<uint64_t>(g.patterns.size());
+        for (auto const &p : g.patterns)
+            write(w, p);
+
+        w.put<uint64_t>(g.optional_new_vars.size());
+        for (auto const &v : g.optional_new_vars)
+            w.put<int64_t>(v);
+
+        w.put<uint64_t>(g.filters.size());
+        for (auto const &f : g.filters)
+            write(w, f);
+
+        w.put<uint64_t>(g.optional.size());
+        for (auto const &o : g.optional)
+            write(w, o);
+
+        w.put<uint64_t>(g.unions.size());
+        for (auto const &u : g.unions)
+            write(w, u);
+    }
+
+    static void write(WireWriter &w, const AggTable &t) {
+        w.put<int32_t>(t.nkeys);
+        w.put_vec(t.funcs);
+        w.put_vec(t.keys);
+        w.put_vec(t.cnts);
+        w.put_vec(t.vals);
+        w.put_vec(t.ids);
+        w.put<uint64_t>(t.strs.size());
+        for (auto const &s : t.strs)
+            w.put_str(s);
+    }
+
+    static void write(WireWriter &w, const SPARQLQuery::Result &r) {
+        w.put<int32_t>(r.col_num);
+        w.put<int32_t>(r.row_num);
+        w.put<int32_t>(r.attr_col_num);
+        w.put<int32_t>(r.status_code);
+        w.put<char>(r.blind);
+        w.put<int32_t>(r.nvars);
+        w.put_vec(r.required_vars);
+        w.put_vec(r.v2c_map);
+
+        w.put<uint64_t>(r.optional_matched_rows.size());
+        for (bool b : r.optional_matched_rows)
+            w.put<char>(b);
+
+        if (r.row_num > 0) {
+            if (r.col_table.enabled() && w.dry()) {
+                w.put<uint64_t>(r.col_table.size() * r.col_num);
+                w.put_bytes(nullptr, sizeof(sid_t) * r.col_table.size() * r.col_num);
+            } else if (r.col_table.enabled()) {
+                // late materialization before sending
+                std::vector<sid_t> table;
+                r.col_table.materialize(table, r.col_num);
+                w.put_vec(table);
+            } else {
+                w.put_vec(r.result_table);
+            }
+
+            w.put<uint64_t>(r.attr_res_table.size());
+            for (auto const &a : r.attr_res_table) {
+                int type = boost::apply_visitor(variant_type(), a);
+                w.put<char>(type);
+                switch (type) {
+                case INT_t: w.put(boost::get<int>(a)); break;
+                case FLOAT_t: w.put(boost::get<float>(a)); break;
+                case DOUBLE_t: w.put(boost::get<double>(a)); break;
+                default: ASSERT(false);
+                }
+            }
+        } else {
+            w.put<uint64_t>(0);
+            w.put<uint64_t>(0);
+        }
+#ifdef USE_GPU
+        const_cast<SPARQLQuery::Result &>(r).gpu.serialize(w, 0);
+#endif
+#ifdef TRDF_MODE
+        w.put<int32_t>(r.time_col_num);
+        w.put_vec(r.time_res_table);
+#endif
+        write(w, r.agg_table);
+    }
+
+    static void write(WireWriter &w, const SPARQLQuery &q) {
+        w.put<int32_t>(q.q_type);
+        w.put<int32_t>(q.qid);
+        w.put<int32_t>(q.pqid);
+        w.put<int32_t>(q.pg_type);
+        w.put<int32_t>(q.state);
+        w.put<int32_t>(q.dev_type);
+        w.put<int32_t>(q.job_type);
+        w.put<int32_t>(q.priority);
+        w.put<int32_t>(q.mt_factor);
+        w.put<int32_t>(q.mt_tid);
+        w.put<int32_t>(q.pattern_step);
+        w.put<int64_t>(q.local_var);
+        w.put<char>(q.corun_enabled);
+        w.put<int32_t>(q.corun_step);
+        w.put<int32_t>(q.fetch_step);
+        w.put<char>(q.union_done);
+        w.put<int32_t>(q.optional_step);
+        w.put<int32_t>(q.limit);
+        w.put<uint32_t>(q.offset);
+        w.put<char>(q.distinct);
+        write(w, q.pattern_group);
+#ifdef TRDF_MODE
+        w.put(q.ts);
+        w.put(q.te);
+#endif
+        w.put<uint64_t>(q.orders.size());
+        for (auto const &o : q.orders) {
+            w.put<int64_t>(o.id);
+            w.put<char>(o.descending);
+        }
+        w.put<uint64_t>(q.aggregates.size());
+        for (auto const &a : q.aggregates) {
+            w.put<int32_t>(a.func);
+            w.put<int64_t>(a.var);
+            w.put<int64_t>(a.alias);
+            w.put<char>(a.distinct);
+        }
+        w.put<uint64_t>(q.group_by.size());
+        for (auto const &v : q.group_by)
+            w.put<int64_t>(v);
+        write(w, q.result);
+    }
+
+    /// decoding
+
+    static void read(WireReader &r, SPARQLQuery::Pattern &p) {
+        p.subject = r.get<int64_t>();
+        p.predicate = r.get<int64_t>();
+        p.object = r.get<int64_t>();
+        p.direction = (dir_t)r.get<int32_t>();
+        p.pred_type = r.get<char>();
+#ifdef TRDF_MODE
+        r.get(p.time_interval.ts_value);
+        r.get(p.time_interval.te_value);
+        p.time_interval.ts_var = r.get<int64_t>();
+        p.time_interval.te_var = r.get<int64_t>();
+        p.time_interval.type = (SPARQLQuery::TimeIntervalType)r.get<int32_t>();
+#endif
+    }
+
+    static void read(WireReader &r, SPARQLQuery::Filter &f) {
+        f.type = (SPARQLQuery::Filter::Type)r.get<int32_t>();
+        r.get_str(f.value);
+        r.get_str(f.valueType);
+        f.valueArg = r.get<int32_t>();
+
+        SPARQLQuery::Filter **args[3] = {&f.arg1, &f.arg2, &f.arg3};
+        for (int i = 0; i < 3; i++) {
+            if (r.get<char>()) {
+                *args[i] = new SPARQLQuery::Filter();
+                read(r, **args[i]);
+            }
+        }
+    }
+
+    static void read(WireReader &r, SPARQLQuery::PatternGroup &g) {
+        g.patterns.resize(r.get<uint64_t>());
+        for (auto &p : g.patterns)
+            read(r, p);
+
+        uint64_t n = r.get<uint64_t>();
+        for (uint64_t i = 0; i < n; i++)
+            g.optional_new_vars.insert(r.get<int64_t>());
+
+        g.filters.resize(r.get<uint64_t>());
+        for (auto &f : g.filters)
+            read(r, f);
+
+        g.optional.resize(r.get<uint64_t>());
+        for (auto &o : g.optional)
+            read(r, o);
+
+        g.unions.resize(r.get<uint64_t>());
+        for (auto &u : g.unions)
+            read(r, u);
+    }
+
+    static void read(WireReader &r, AggTable &t) {
+        t.nkeys = r.get<int32_t>();
+        r.get_vec(t.funcs);
+        r.get_vec(t.keys);
+        r.get_vec(t.cnts);
+        r.get_vec(t.vals);
+        r.get_vec(t.ids);
+        t.strs.resize(r.get<uint64_t>());
+        for (auto &s : t.strs)
+            r.get_str(s);
+    }
+
+    static void read(WireReader &r, SPARQLQuery::Result &res) {
+        res.col_num = r.get<int32_t>();
+        res.row_num = r.get<int32_t>();
+        res.attr_col_num = r.get<int32_t>();
+        res.status_code = r.get<int32_t>();
+        res.blind = r.get<char>();
+        res.nvars = r.get<int32_t>();
+        r.get_vec(res.required_vars);
+        r.get_vec(res.v2c_map);
+
+        res.optional_matched_rows.resize(r.get<uint64_t>());
+        for (uint64_t i = 0; i < res.optional_matched_rows.size(); i++)
+            res.optional_matched_rows[i] = r.get<char>();
+
+        r.get_vec(res.result_table);
+
+        res.attr_res_table.resize(r.get<uint64_t>());
+        for (auto &a : res.attr_res_table) {
+            switch (r.get<char>()) {
+            case INT_t: a = r.get<int>(); break;
+            case FLOAT_t: a = r.get<float>(); break;
+            case DOUBLE_t: a = r.get<double>(); break;
+            default: ASSERT(false);
+            }
+        }
+#ifdef USE_GPU
+        res.gpu.serialize(r, 0);
+#endif
+#ifdef TRDF_MODE
+        res.time_col_num = r.get<int32_t>();
+        r.get_vec(res.time_res_table);
+#endif
+        read(r, res.agg_table);
+    }
+
+    static void read(WireReader &r, SPARQLQuery &q) {
+        q.q_type = (SPARQLQuery::QueryType)r.get<int32_t>();
+        q.qid = r.get<int32_t>();
+        q.pqid = r.get<int32_t>();
+        q.pg_type = (SPARQLQuery::PGType)r.get<int32_t>();
+        q.state = (SPARQLQuery::SQState)r.get<int32_t>();
+        q.dev_type = (SPARQLQuery::DeviceType)r.get<int32_t>();
+        q.job_type = (SPARQLQuery::SubJobType)r.get<int32_t>();
+        q.priority = r.get<int32_t>();
+        q.mt_factor = r.get<int32_t>();
+        q.mt_tid = r.get<int32_t>();
+        q.pattern_step = r.get<int32_t>();
+        q.local_var = r.get<int64_t>();
+        q.corun_enabled = r.get<char>();
+        q.corun_step = r.get<int32_t>();
+        q.fetch_step = r.get<int32_t>();
+        q.union_done = r.get<char>();
+        q.optional_step = r.get<int32_t>();
+        q.limit = r.get<int32_t>();
+        q.offset = r.get<uint32_t>();
+        q.distinct = r.get<char>();
+        read(r, q.pattern_group);
+#ifdef TRDF_MODE
+        r.get(q.ts);
+        r.get(q.te);
+#endif
+        q.orders.resize(r.get<uint64_t>());
+        for (auto &o : q.orders) {
+            o.id = r.get<int64_t>();
+            o.descending = r.get<char>();
+        }
+        q.aggregates.resize(r.get<uint64_t>());
+        for (auto &a : q.aggregates) {
+            a.func = r.get<int32_t>();
+            a.var = r.get<int64_t>();
+            a.alias = r.get<int64_t>();
+            a.distinct = r.get<char>();
+        }
+        q.group_by.resize(r.get<uint64_t>());
+        for (auto &v : q.group_by)
+            v = r.get<int64_t>();
+        read(r, q.result);
+    }
+
+public:
+    // the size of encoded query (including the header)
+    static uint64_t size(const SPARQLQuery &q) {
+        WireWriter w;
+        w.put(header_t());
+        write(w, q);
+        return w.size();
+    }
+
+    /**
+     * @brief Encode a query into the buffer
+     *
+     * @param q the query
+     * @param buf the buffer with at least size(q) bytes
+     * @return the number of bytes written
+     */
+    static uint64_t encode(const SPARQLQuery &q, char *buf) {
+        WireWriter w(buf);
+        header_t hdr;
+        hdr.magic = MAGIC;
+        hdr.version = VERSION;
+        hdr.flags = build_flags();
+        w.put(hdr);
+        write(w, q);
+        return w.size();
+    }
+
+    // encode a query and append it to the string
+    static void encode(const SPARQLQuery &q, std::string &str) {
+        uint64_t off = str.size();
+        str.resize(off + size(q));
+        encode(q, &str[off]);
+    }
+
+    // check whether the buffer holds a message in the flat wire format
+    static bool match(const char *buf, uint64_t sz) {
+        if (sz < sizeof(header_t)) return false;
+        header_t hdr;
+        memcpy(&hdr, buf, sizeof(header_t));
+        return (hdr.magic == MAGIC);
+    }
+
+    /**
+     * @brief Decode a query in place
+     *
+     * @param buf the buffer of the message (e.g., the receive buffer)
+     * @param sz the size of the message
+     * @param q the query (for return)
+     */
+    static void decode(const char *buf, uint64_t sz, SPARQLQuery &q) {
+        WireReader r(buf, sz);
+        header_t hdr;
+        r.get(hdr);
+        ASSERT(hdr.magic == MAGIC);
+        if (hdr.version != VERSION || hdr.flags != build_flags()) {
+            logstream(LOG_ERROR) << "mismatched wire format (version: " << hdr.version
+                                 << ", flags: " << hdr.flags << "), expected (version: "
+                                 << VERSION << ", flags: " << build_flags() << ")"
+                                 << LOG_endl;
+            ASSERT(false);
+        }
+        read(r, q);
+        ASSERT(r.remain() == 0);
+    }
+};
+
+} // namespace wukong
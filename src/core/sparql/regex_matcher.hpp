@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <ctype.h>
+#include <string.h>
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+
+#include <boost/unordered_map.hpp>
+
+namespace wukong {
+
+/**
+ * A compiled pattern of the REGEX FILTER (matching the whole string)
+ *
+ * The common shapes of patterns are matched w/o std::regex:
+ *   abc (EXACT), abc.* (PREFIX), .*abc (SUFFIX), .*abc.* (CONTAINS), .* (ANY)
+ * where abc has no metacharacters (w/ optional ^ and $ anchors), and the
+ * rest falls back to std::regex. Note that '.' does not match line
+ * terminators (the same as std::regex).
+ */
+class RegexMatcher {
+private:
+    enum Shape { EXACT, PREFIX, SUFFIX, CONTAINS, ANY, REGEX };
+
+    Shape shape = REGEX;
+    std::string lit;  // the literal part (lower-case w/ icase)
+    bool icase;
+    std::regex re;
+
+    static bool is_plain(const std::string& s) {
+        return s.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+    }
+
+    static bool has_newline(std::string_view s) {
+        return s.find_first_of("\n\r") != std::string_view::npos;
+    }
+
+    static bool ends_with(const std::string& s, const std::string& suffix) {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool equal(const char* s, uint64_t len) const {
+        if (len != lit.size()) return false;
+        if (!icase) return memcmp(s, lit.data(), len) == 0;
+        for (uint64_t i = 0; i < len; i++)
+            if (tolower(static_cast<unsigned char>(s[i])) != lit[i]) return false;
+        return true;
+    }
+
+    uint64_t find(std::string_view s) const {
+        if (!icase) return s.find(lit);
+        for (uint64_t i = 0; i + lit.size() <= s.size(); i++)
+            if (equal(s.data() + i, lit.size())) return i;
+        return std::string_view::npos;
+    }
+
+public:
+    /**
+     * @param pattern the pattern of REGEX
+     * @param icase case-insensitive (the "i" flag)
+     * @throw std::regex_error if the pattern is invalid
+     */
+    RegexMatcher(const std::string& pattern, bool icase) : icase(icase) {
+        std::string p = pattern;
+        if (!p.empty() && p.front() == '^') p = p.substr(1);
+        if (!p.empty() && p.back() == '$' && (p.size() < 2 || p[p.size() - 2] != '\\'))
+            p.pop_back();
+
+        bool any_front = (p.compare(0, 2, ".*") == 0);
+        if (any_front) p = p.substr(2);
+        bool any_back = ends_with(p, ".*") && (p.size() < 3 || p[p.size() - 3] != '\\');
+        if (any_back) p = p.substr(0, p.size() - 2);
+
+        if (is_plain(p)) {
+            lit = p;
+            if (icase)
+                for (auto& c : lit) c = tolower(static_cast<unsigned char>(c));
+            if (lit.empty() && (any_front || any_back)) shape = ANY;
+            else if (any_front && any_back) shape = CONTAINS;
+            else if (any_front) shape = SUFFIX;
+            else if (any_back) shape = PREFIX;
+            else shape = EXACT;
+        } else {
+            shape = REGEX;
+            re = icase ? std::regex(pattern, std::regex::icase) : std::regex(pattern);
+        }
+    }
+
+    bool is_regex() const { return shape == REGEX; }
+
+    bool match(std::string_view s) const {
+        switch (shape) {
+        case EXACT:
+            return equal(s.data(), s.size());
+        case PREFIX:
+            return s.size() >= lit.size() && equal(s.data(), lit.size())
+                   && !has_newline(s.substr(lit.size()));
+        case SUFFIX:
+            return s.size() >= lit.size() && equal(s.data() + s.size() - lit.size(), lit.size())
+                   && !has_newline(s.substr(0, s.size() - lit.size()));
+        case CONTAINS: {
+            uint64_t first = s.find_first_of("\n\r");
+            if (first == std::string_view::npos)
+                return find(s) != std::string_view::npos;
+
+            // the literal should cover all line terminators
+            uint64_t last = s.find_last_of("\n\r");
+            for (uint64_t i = 0; i <= first && i + lit.size() <= s.size(); i++)
+                if (i + lit.size() > last && equal(s.data() + i, lit.size()))
+                    return true;
+            return false;
+        }
+        case ANY:
+            return !has_newline(s);
+        default:
+            return std::regex_match(s.begin(), s.end(), re);
+        }
+    }
+};
+
+/**
+ * The cache of compiled patterns, keyed by the pattern text and flags,
+ * which is owned by a thread (e.g., an engine or a parser) w/o locking.
+ */
+class RegexCache {
+private:
+    boost::unordered_map<std::string, std::shared_ptr<const RegexMatcher>> cache;
+    uint64_t capacity;
+
+public:
+    explicit RegexCache(uint64_t capacity = 1024) : capacity(capacity) {}
+
+    // @throw std::regex_error if the pattern is invalid
+    std::shared_ptr<const RegexMatcher> get(const std::string& pattern, bool icase) {
+        std::string key = (icase ? "i/" : "/") + pattern;
+        auto it = cache.find(key);
+        if (it != cache.end())
+            return it->second;
+
+        auto matcher = std::make_shared<const RegexMatcher>(pattern, icase);
+        if (cache.size() >= capacity)
+            cache.clear();  // patterns are usually few
+        cache[key] = matcher;
+        return matcher;
+    }
+
+    uint64_t size() const { return cache.size(); }
+};
+
+}  // namespace wukong
@@ -47,8 +47,9 @@ void yyerror(std::string error)
   at type not_ or_ and_ plus_ minus_ mul_ div_
   integer decimal double_ percent predicate time_interval
   optional_ filter order_by limit offset asc desc truee_ falsee_ bound from snapshot/* newly defined symbol */
+  group_by as_ sum_ avg_ min_ max_
 
-%type<choice> PATTERN_SUFFIX ORDER_CHOICE RELATIONAL_CHOICE ADDITIVE_CHOICE MULTIPLICATIVE_CHOICE UNARY_CHOICE 
+%type<choice> PATTERN_SUFFIX ORDER_CHOICE AGGREGATE_CHOICE RELATIONAL_CHOICE ADDITIVE_CHOICE MULTIPLICATIVE_CHOICE UNARY_CHOICE 
 %type<str> identifier iri string_ variable time_interval
 %type<str> integer decimal double_ /* will be converted to real number in the parser */
 %type<element> PATTERN_ELEMENT
@@ -84,7 +85,7 @@ PREFIX_NODE: prefix identifier colon iri {
 MAIN_CLAUSE: SELECT_WHERE
            | ASK_WHERE
 
-SELECT_WHERE: select_ PROJECTION_MODIFIER PROJECTION_GROUP FROM_CLAUSE WHERE_CLAUSE ORDER_CLAUSE LIMIT_NODE OFFSET_NODE {
+SELECT_WHERE: select_ PROJECTION_MODIFIER PROJECTION_GROUP FROM_CLAUSE WHERE_CLAUSE GROUP_CLAUSE ORDER_CLAUSE LIMIT_NODE OFFSET_NODE {
     parser->registerQueryType(SPARQLParser::Type_Select);
 }
 ;
@@ -103,8 +104,26 @@ PROJECTION_GROUP: PROJECTION_NODE
                 | mul_ {}
 
 PROJECTION_NODE: variable {parser->addProjection($1);}
+               | lparen AGGREGATE AGGREGATE_ALIAS rparen {}
 ;
 
+/*(COUNT(DISTINCT ?X) AS ?N)*/
+AGGREGATE: AGGREGATE_CHOICE lparen AGGREGATE_ARG rparen {parser->addAggregate($1);}
+
+AGGREGATE_CHOICE: count {$$ = SPARQLParser::Aggregate_Count;}
+                | sum_ {$$ = SPARQLParser::Aggregate_Sum;}
+                | avg_ {$$ = SPARQLParser::Aggregate_Avg;}
+                | min_ {$$ = SPARQLParser::Aggregate_Min;}
+                | max_ {$$ = SPARQLParser::Aggregate_Max;}
+
+AGGREGATE_ARG: mul_ {parser->setAggregateArg(NULL);}
+             | variable {parser->setAggregateArg($1);}
+             | AGGREGATE_MODIFIER variable {parser->setAggregateArg($2);}
+
+AGGREGATE_MODIFIER: identifier {parser->setAggregateDistinct($1);}
+
+AGGREGATE_ALIAS: as_ variable {parser->addAggregateAlias($2);}
+
 FROM_CLAUSE: from snapshot iri {parser->parseFromSnapshot($3);}
            | from time_interval {parser->parseFromTime($2);}
            |
@@ -252,6 +271,15 @@ BOOL_LITERAL: truee_ {$$ = parser->parseBoolLiteral(true);}
             | falsee_ {$$ = parser->parseBoolLiteral(false);}
 
 
+/*GROUP BY ?X ?Y*/
+GROUP_CLAUSE: group_by GROUP_LIST
+            | 
+
+GROUP_LIST: GROUP_NODE
+          | GROUP_NODE GROUP_LIST
+
+GROUP_NODE: variable {parser->addGroupBy($1);}
+
 /*ORDER BY ASC(?X) DESC(?Y1)*/
 ORDER_CLAUSE: order_by ORDER_LIST
             | 
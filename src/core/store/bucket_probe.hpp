@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(USE_AVX512) || defined(USE_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace wukong {
+
+/**
+ * @brief Probe a bucket of 8 slots (16 bytes per slot: 64-bit key | 64-bit pointer)
+ *
+ * Find the first slot among the first 7 slots (the last one is the pointer to
+ * the indirect header) whose key is equal to the given key or empty (zero).
+ * The slot layout is unchanged, so the same code probes RDMA-read buckets.
+ *
+ * The implementation is selected at build time:
+ *   USE_AVX512: 2 x 512-bit compares (4 slots each)
+ *   USE_AVX2:   4 x 256-bit compares (2 slots each)
+ *   otherwise:  scalar comparisons
+ *
+ * A bucket spans two cache lines, so the second half (slot 4-6) is probed
+ * only if the first half has no match, as the scalar loop does.
+ *
+ * @param bucket the address of the bucket
+ * @param key the packed 64-bit key
+ * @return int the index of slot in [0, 7), or 7 if not found
+ */
+static inline int probe_bucket(const void *bucket, uint64_t key) {
+    static const int NSLOTS = 7;    // usable slots of a bucket
+    static const int SLOT_SZ = 16;  // bytes per slot
+    const char *base = reinterpret_cast<const char *>(bucket);
+#if defined(USE_AVX512)
+    const __m512i vkey = _mm512_set1_epi64(key);
+    const __m512i vzero = _mm512_setzero_si512();
+    for (int i = 0; i < 2; i++) {
+        __m512i v = _mm512_loadu_si512(base + i * 4 * SLOT_SZ);
+        // only the even lanes (keys) are compared, and the last slot is skipped
+        __mmask8 lanes = (i == 0) ? 0x55 : 0x15;
+        uint32_t m = _mm512_mask_cmpeq_epi64_mask(lanes, v, vkey)
+                     | _mm512_mask_cmpeq_epi64_mask(lanes, v, vzero);
+        if (m)
+            return i * 4 + (__builtin_ctz(m) >> 1);
+    }
+    return NSLOTS;
+#elif defined(USE_AVX2)
+    const __m256i vkey = _mm256_set1_epi64x(key);
+    const __m256i vzero = _mm256_setzero_si256();
+    for (int h = 0; h < 2; h++) {
+        uint32_t mask = 0;
+        for (int i = 0; i < 2; i++) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base + (h * 4 + i * 2) * SLOT_SZ));
+            __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi64(v, vkey),
+                                          _mm256_cmpeq_epi64(v, vzero));
+            // lane 0 and 2 are keys
+            uint32_t m = _mm256_movemask_pd(_mm256_castsi256_pd(hit));
+            mask |= ((m & 1) | ((m >> 1) & 2)) << (i * 2);
+        }
+        if (h == 1)
+            mask &= 0x7;  // skip the last slot
+        if (mask)
+            return h * 4 + __builtin_ctz(mask);
+    }
+    return NSLOTS;
+#else
+    for (int i = 0; i < NSLOTS; i++) {
+        uint64_t k;
+        memcpy(&k, base + i * SLOT_SZ, sizeof(uint64_t));
+        if (k == key || k == 0)
+            return i;
+    }
+    return NSLOTS;
+#endif
+}
+
+} // namespace wukong
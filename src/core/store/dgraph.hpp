@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <sys/resource.h>
+
 #include <map>
 #include <memory>
 #include <set>
@@ -37,6 +39,8 @@
 #include "core/store/gchecker.hpp"
 #include "core/store/static_kvstore.hpp"
 #include "core/store/dynamic_kvstore.hpp"
+#include "core/store/snapshot_view.hpp"
+#include "core/store/time_index.hpp"
 
 namespace wukong {
 
@@ -91,7 +95,11 @@ using RDFStore = KVStore<ikey_t, iptr_t, edge_t>;
 class DGraph {
 protected:
     using tbb_unordered_set = tbb::concurrent_unordered_set<sid_t>;
+#ifdef TRDF_MODE
+    using tbb_edge_hash_map = tbb::concurrent_hash_map<sid_t, std::vector<time_edge_t>>;
+#else
     using tbb_edge_hash_map = tbb::concurrent_hash_map<sid_t, std::vector<edge_t>>;
+#endif
     using tbb_triple_hash_map = tbb::concurrent_hash_map<ikey_t, std::vector<triple_t>, ikey_Hasher>;
     using tbb_triple_attr_hash_map = tbb::concurrent_hash_map<ikey_t, std::vector<triple_attr_t>, ikey_Hasher>;
 
@@ -133,13 +141,94 @@ protected:
                              std::vector<std::vector<triple_t>>& triple_pos,
                              std::vector<std::vector<triple_attr_t>>& triple_sav) = 0;
 
+    // initiate gstore with sorted runs on disk (see BaseLoader::load w/ a memory budget),
+    // which reads all runs back to memory by default (i.e., the budget is not honored).
+    // return false if any run fails to be read
+    virtual bool init_gstore_from_runs(std::vector<TripleRuns>& runs_pso,
+                                       std::vector<TripleRuns>& runs_pos,
+                                       std::vector<std::vector<triple_attr_t>>& triple_sav) {
+        logstream(LOG_WARNING) << "[RDFGraph] #" << sid << ": the load budget ("
+                               << Global::load_budget_mb << "MB) is ignored, "
+                               << "since the graph reads all sorted runs back to memory" << LOG_endl;
+        std::vector<std::vector<triple_t>> triple_pso(Global::num_engines);
+        std::vector<std::vector<triple_t>> triple_pos(Global::num_engines);
+        uint64_t nfailed = 0;
+        #pragma omp parallel for num_threads(Global::num_engines) reduction(+ : nfailed)
+        for (int tid = 0; tid < Global::num_engines; tid++) {
+            // all triples in a chunk
+            TripleRunMerger merger_pso(runs_pso[tid], MiB2B(1));
+            merger_pso.next_chunk(triple_pso[tid], UINT64_MAX);
+            TripleRunMerger merger_pos(runs_pos[tid], MiB2B(1));
+            merger_pos.next_chunk(triple_pos[tid], UINT64_MAX);
+            nfailed += !merger_pso.good() + !merger_pos.good();
+            runs_pso[tid].clear();
+            runs_pos[tid].clear();
+        }
+        if (nfailed > 0)
+            return false;
+        init_gstore(triple_pso, triple_pos, triple_sav);
+        return true;
+    }
+
+    // lookup the neighbors of local vertices in a batch, and remote ones one by one
+    // (copied to remote_edges, since each remote read reuses the RDMA buffer of the thread)
+    void get_local_triples_batch(int tid, const std::vector<sid_t>& vids, sid_t pid, dir_t d,
+                                 std::vector<edge_t*>& edges, std::vector<uint64_t>& szs,
+                                 std::vector<edge_t>& remote_edges, rdf_seg_meta_t* seg) {
+        edges.resize(vids.size());
+        szs.resize(vids.size());
+        remote_edges.clear();
+
+        std::vector<ikey_t> keys;
+        std::vector<uint64_t> idxs;  // the index of local keys in vids
+        std::vector<std::pair<uint64_t, uint64_t>> remotes;  // (index in vids, offset in remote_edges)
+        keys.reserve(vids.size());
+        idxs.reserve(vids.size());
+        for (uint64_t i = 0; i < vids.size(); i++) {
+            if (PARTITION(vids[i]) == this->sid) {
+                keys.push_back(ikey_t(vids[i], pid, d));
+                idxs.push_back(i);
+            } else {
+                edge_t* res = get_triples(tid, vids[i], pid, d, szs[i]);
+                remotes.push_back(std::make_pair(i, remote_edges.size()));
+                remote_edges.insert(remote_edges.end(), res, res + szs[i]);
+            }
+        }
+        // remote_edges is not reallocated anymore
+        for (auto const& r : remotes)
+            edges[r.first] = remote_edges.data() + r.second;
+
+        if (idxs.size() == vids.size()) {  // all local (the common case)
+            gstore->get_values_batch(tid, keys.data(), keys.size(), edges.data(), szs.data(), seg);
+            return;
+        }
+        if (idxs.empty())
+            return;
+
+        std::vector<edge_t*> local_edges(keys.size());
+        std::vector<uint64_t> local_szs(keys.size());
+        gstore->get_values_batch(tid, keys.data(), keys.size(), local_edges.data(), local_szs.data(), seg);
+        for (uint64_t j = 0; j < idxs.size(); j++) {
+            edges[idxs[j]] = local_edges[j];
+            szs[idxs[j]] = local_szs[j];
+        }
+    }
+
 public:
     std::shared_ptr<RDFStore> gstore;
 
+#ifdef TRDF_MODE
+    // the time-interval index of (local) temporal value lists
+    TimeIndex time_index;
+    // the materialized snapshots of (local) temporal value lists
+    SnapshotViews snapshot_views;
+#endif
+
     DGraph(int sid, KVMem kv_mem)
         : sid(sid), kv_mem(kv_mem){}
 
-    void load(std::string dname) {
+    // return false if triples fail to be loaded (see BaseLoader::load w/ a memory budget)
+    bool load(std::string dname) {
         uint64_t start, end;
 
         // load from hdfs or posix file
@@ -157,8 +246,19 @@ public:
         std::vector<std::vector<triple_t>> triple_pso;
         std::vector<std::vector<triple_t>> triple_pos;
         std::vector<std::vector<triple_attr_t>> triple_sav;
+        // sorted runs spilled to disk (bounded-memory loading)
+        std::vector<TripleRuns> runs_pso;
+        std::vector<TripleRuns> runs_pos;
         start = timer::get_usec();
-        loader->load(dname, triple_pso, triple_pos, triple_sav);
+        if (Global::load_budget_mb > 0) {
+            if (!loader->load(dname, Global::load_budget_mb, runs_pso, runs_pos, triple_sav)) {
+                logstream(LOG_ERROR) << "[RDFGraph] #" << sid << ": loading RDFGraph failed "
+                                     << "(load budget: " << Global::load_budget_mb << "MB)" << LOG_endl;
+                return false;
+            }
+        } else {
+            loader->load(dname, triple_pso, triple_pos, triple_sav);
+        }
         end = timer::get_usec();
         logstream(LOG_INFO) << "[Loader] #" << sid << ": " << (end - start) / 1000 << "ms "
                             << "for loading triples from disk to memory." << LOG_endl;
@@ -191,18 +291,43 @@ public:
 
         /* initialize gstore with triples */
         start = timer::get_usec();
-        init_gstore(triple_pso, triple_pos, triple_sav);
+        if (Global::load_budget_mb > 0) {
+            if (!init_gstore_from_runs(runs_pso, runs_pos, triple_sav)) {
+                logstream(LOG_ERROR) << "[RDFGraph] #" << sid << ": initializing gstore failed "
+                                     << "(failed to read sorted runs)" << LOG_endl;
+                return false;
+            }
+        } else {
+            init_gstore(triple_pso, triple_pos, triple_sav);
+        }
         end = timer::get_usec();
         logstream(LOG_INFO) << "[RDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
                             << "for initializing gstore." << LOG_endl;
+        logstream(LOG_INFO) << "[RDFGraph] #" << sid << ": peak RSS " << B2MiB(KiB2B(get_peak_rss_kb())) << "MB "
+                            << "after loading (load budget: " << Global::load_budget_mb << "MB)" << LOG_endl;
 
         logstream(LOG_INFO) << "[RDFGraph] #" << sid << ": loading RDFGraph is finished" << LOG_endl;
 
         print_graph_stat();
+        return true;
     }
 
     virtual ~DGraph() {}
 
+    // peak resident set size (KB) of the process
+    static uint64_t get_peak_rss_kb() {
+        // VmHWM can be reset by writing 5 to /proc/self/clear_refs
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+            if (line.compare(0, 6, "VmHWM:") == 0)
+                return std::stoull(line.substr(6));
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
     // return total num of preds, including normal and attr
     inline int get_num_normal_preds() const { return this->predicates.size() - 1; }
     inline int get_num_normal_preds_without_TYPEID() const { return this->predicates.size() - 2; }
@@ -222,10 +347,106 @@ public:
         return checker.gstore_check(index_check, normal_check);
     }
 
+#ifdef TRDF_MODE
+    // (re)build the time-interval index after loading gstore
+    void build_time_index() {
+        uint64_t start = timer::get_usec();
+        time_index.build(*gstore, Global::time_index_threshold,
+                         [this](ikey_t key, uint64_t off) { return get_local_times(key, off); });
+        uint64_t end = timer::get_usec();
+        logstream(LOG_INFO) << "[RDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for indexing " << time_index.num_edges() << " edges of "
+                            << time_index.num_keys() << " keys by time intervals ("
+                            << B2MiB(time_index.mem_usage()) << "MB)" << LOG_endl;
+    }
+
+    /**
+     * @brief Materialize the snapshot of [ts, te] of the local gstore (see SnapshotView),
+     *        which replaces the old one and may evict others
+     *
+     * @return false if the view exceeds the budget (global_snapshot_view_size_mb)
+     */
+    bool create_snapshot_view(int64_t ts, int64_t te) {
+        uint64_t start = timer::get_usec();
+        std::shared_ptr<SnapshotView> view = std::make_shared<SnapshotView>(ts, te);
+        view->build(*gstore, time_index,
+                    [this](ikey_t key, uint64_t off) { return get_local_times(key, off); });
+        uint64_t end = timer::get_usec();
+        logstream(LOG_INFO) << "[RDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for materializing " << view->num_edges() << " edges of "
+                            << view->num_keys() << " keys valid in [" << ts << ", " << te << "] ("
+                            << B2MiB(view->mem_usage()) << "MB)" << LOG_endl;
+
+        return snapshot_views.add(view, MiB2B((uint64_t)Global::snapshot_view_size_mb));
+    }
+
+    /**
+     * @brief the positions of edges valid in [ts, te] (ascending) in the value list
+     *        of the key, which is got by get_timed_triples or get_timed_index
+     *
+     * @param times the timestamps of the value list (nullptr: not fetched, i.e., all
+     *              edges are valid, e.g., non-temporal patterns or snapshot views)
+     */
+    void get_valid_edges(ikey_t key, const edge_time_t* times, uint64_t sz, int64_t ts, int64_t te,
+                         std::vector<uint64_t>& pos) const {
+        time_index.valid_edges(key, times, sz, ts, te, pos);
+    }
+
+    /**
+     * @brief the timestamps of the local value list of the key at off
+     *        (nullptr if the values have no timestamps)
+     */
+    virtual edge_time_t* get_local_times(ikey_t key, uint64_t off) {
+        return gstore->get_times(off);
+    }
+
+    /**
+     * @brief Retrieve the neighbors of a vertex w/ their timestamps
+     *
+     * The neighbors and timestamps of a remote vertex share the RDMA buffer
+     * of the thread, so they must be used (or copied, e.g., valid_predicates
+     * in TSPARQLEngine) before the next remote read, like get_triples.
+     *
+     * @param times the timestamps of neighbors (return value)
+     */
+    virtual edge_t* get_timed_triples(int tid, sid_t vid, sid_t pid, dir_t d, uint64_t& sz,
+                                      edge_time_t*& times) {
+        return gstore->get_timed_values(tid, PARTITION(vid), ikey_t(vid, pid, d), sz, times);
+    }
+
+    virtual edge_t* get_timed_index(int tid, sid_t pid, dir_t d, uint64_t& sz, edge_time_t*& times) {
+        // index vertex should be 0 and always local
+        return gstore->get_timed_values(tid, this->sid, ikey_t(0, pid, d), sz, times);
+    }
+#endif
+
+    // the neighbors of a remote vertex are only valid until the next remote read
+    // of the thread (see KVStore::rdma_get_values)
     virtual edge_t* get_triples(int tid, sid_t vid, sid_t pid, dir_t d, uint64_t& sz) {
         return gstore->get_values(tid, PARTITION(vid), ikey_t(vid, pid, d), sz);
     }
 
+    /**
+     * @brief Retrieve the neighbors of a batch of vertices (w/ the same predicate and direction)
+     *
+     * Local vertices are looked up in a batch (see KVStore::get_values_batch),
+     * and remote vertices are looked up one by one.
+     *
+     * @param tid caller thread id
+     * @param vids given vertices
+     * @param pid predicate
+     * @param d direction
+     * @param edges neighbors of each vertex (return value)
+     * @param szs the number of neighbors of each vertex (return value)
+     * @param remote_edges the neighbors of remote vertices (return value), which
+     *        the edges of remote vertices point to (i.e., owned by the caller)
+     */
+    virtual void get_triples_batch(int tid, const std::vector<sid_t>& vids, sid_t pid, dir_t d,
+                                   std::vector<edge_t*>& edges, std::vector<uint64_t>& szs,
+                                   std::vector<edge_t>& remote_edges) {
+        get_local_triples_batch(tid, vids, pid, d, edges, szs, remote_edges, nullptr);
+    }
+
     virtual edge_t* get_index(int tid, sid_t pid, dir_t d, uint64_t& sz) {
         // index vertex should be 0 and always local
         return gstore->get_values(tid, this->sid, ikey_t(0, pid, d), sz);
@@ -266,6 +487,38 @@ public:
 
     virtual int dynamic_load_data(std::string dname, bool check_dup) {}
 
+    /**
+     * @brief Dump the local gstore to a binary snapshot (see core/store/snapshot.hpp)
+     *
+     * @param dname the directory of snapshot files
+     * @return true if succeed
+     */
+    virtual bool dump_snapshot(std::string dname) {
+        logstream(LOG_ERROR) << "Snapshot is only supported by the static graph store." << LOG_endl;
+        return false;
+    }
+
+    /**
+     * @brief Read a binary snapshot into the local gstore and verify it (the header
+     *        and the checksums of all sections), which is not in use until committed
+     *
+     * Servers restore their gstores only if all of them read snapshots successfully,
+     * so the caller agrees on the results before commit_snapshot() or abort_snapshot().
+     *
+     * @param dname the directory of snapshot files
+     * @return false if the snapshot is missing, corrupted or mismatched (gstore is left empty)
+     */
+    virtual bool read_snapshot(std::string dname) {
+        logstream(LOG_ERROR) << "Snapshot is only supported by the static graph store." << LOG_endl;
+        return false;
+    }
+
+    /// restore the local gstore from the snapshot read by read_snapshot()
+    virtual void commit_snapshot() {}
+
+    /// drop the snapshot read by read_snapshot() and leave an empty gstore to load triples
+    virtual void abort_snapshot() {}
+
     virtual void print_graph_stat() {
         gstore->print_mem_usage();
 
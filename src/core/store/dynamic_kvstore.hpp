@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <queue>
 
 #include "core/store/kvstore.hpp"
@@ -52,6 +53,7 @@ protected:
     };
 
     using slot_t = typename KVStore<KeyType, PtrType, ValueType>::slot_t;
+    using InsertValueType = typename KVStore<KeyType, PtrType, ValueType>::InsertValueType;
 
     // manage the memory of value
     MAInterface* value_allocator;
@@ -120,14 +122,31 @@ protected:
         pthread_spin_unlock(&free_queue_lock);
     }
 
-    bool is_dup(slot_t* slot, ValueType value) {
+    bool is_dup(slot_t* slot, InsertValueType value) {
         int size = slot->ptr.size;
-        for (int i = 0; i < size; i++)
+        for (int i = 0; i < size; i++) {
+        #ifdef TRDF_MODE
+            if (this->values[slot->ptr.off + i] == value.val
+                    && this->times[slot->ptr.off + i] == value.time())
+                return true;
+        #else
             if (this->values[slot->ptr.off + i] == value)
                 return true;
+        #endif
+        }
         return false;
     }
 
+    // write the value (and its timestamps in TRDF_MODE) at the offset
+    inline void set_value(uint64_t off, InsertValueType value) {
+    #ifdef TRDF_MODE
+        this->values[off] = value.edge();
+        this->times[off] = value.time();
+    #else
+        this->values[off] = value;
+    #endif
+    }
+
     // Allocate space in given segment.
     // NOTICE! This function is not thread-safe.
     uint64_t alloc_entries(uint64_t num_values, int tid = 0) override {
@@ -167,34 +186,62 @@ public:
 
     ~DynamicKVStore() {}
 
-    bool insert_key_value(KeyType key, ValueType value, bool& dedup_or_isdup, int tid) override {
+    bool insert_key_value(KeyType key, InsertValueType value, bool& dedup_or_isdup, int tid) override {
         uint64_t bucket_id = this->bucket_local(key);
         uint64_t lock_id = bucket_id % this->NUM_LOCKS;
-        uint64_t slot_id = this->search_key(key);
+        // search and update the slot under the same lock,
+        // otherwise two writers may claim the same empty slot
+        this->lock_bucket(lock_id);
+        uint64_t slot_id = this->locate_key(key, bucket_id);
         slot_t* slot = &this->slots[slot_id];
-        pthread_spin_lock(&this->bucket_locks[lock_id]);
         if (slot->ptr.size == 0) {
             uint64_t off = this->alloc_entries(1, tid);
-            this->values[off] = value;
+            set_value(off, value);
             this->slots[slot_id].ptr = PtrType(1, off);
-            pthread_spin_unlock(&this->bucket_locks[lock_id]);
+            this->slots[slot_id].key = key;
+            this->unlock_bucket(lock_id);
             dedup_or_isdup = false;
             return true;
         } else {
             if (dedup_or_isdup && is_dup(slot, value)) {
-                pthread_spin_unlock(&this->bucket_locks[lock_id]);
+                this->unlock_bucket(lock_id);
                 return false;
             }
             dedup_or_isdup = false;
             uint64_t need_size = slot->ptr.size + 1;
 
-            // a new block is needed
-            if (blksz(slot->ptr.size + 1) - 1 < need_size) {
+            // keep the values of normal keys sorted (see sort_normal_triples),
+            // while the values of index keys (vid == 0) are unordered
+            uint64_t pos = slot->ptr.size;
+            if (key.vid != 0) {
+                ValueType* vals = &this->values[slot->ptr.off];
+            #ifdef TRDF_MODE
+                // the values of a vertex are ordered by val and then by timestamps,
+                // which edge_contains, edge_gallop and edge_intersect rely on
+                pos = std::upper_bound(vals, vals + slot->ptr.size, value.edge()) - vals;
+                edge_time_t* times = &this->times[slot->ptr.off];
+                while (pos > 0 && vals[pos - 1].val == value.val && value.time() < times[pos - 1])
+                    pos--;
+            #else
+                pos = std::upper_bound(vals, vals + slot->ptr.size, value) - vals;
+            #endif
+            }
+
+            // a new block is needed, or the value is not the last one
+            // (copy-on-write, since the values are read without lock)
+            if (blksz(slot->ptr.size + 1) - 1 < need_size || pos < slot->ptr.size) {
                 PtrType old_ptr = slot->ptr;
 
                 uint64_t off = this->alloc_entries(need_size, tid);
-                memcpy(&this->values[off], &this->values[old_ptr.off], e2b(old_ptr.size));
-                this->values[off + old_ptr.size] = value;
+                memcpy(&this->values[off], &this->values[old_ptr.off], e2b(pos));
+                memcpy(&this->values[off + pos + 1], &this->values[old_ptr.off + pos],
+                       e2b(old_ptr.size - pos));
+            #ifdef TRDF_MODE
+                memcpy(&this->times[off], &this->times[old_ptr.off], pos * sizeof(edge_time_t));
+                memcpy(&this->times[off + pos + 1], &this->times[old_ptr.off + pos],
+                       (old_ptr.size - pos) * sizeof(edge_time_t));
+            #endif
+                set_value(off + pos, value);
                 // invalidate the old block
                 insert_sz(INVALID_EDGES, old_ptr.size, old_ptr.off);
                 slot->ptr = PtrType(need_size, off);
@@ -209,11 +256,11 @@ public:
             } else {
                 // update size flag
                 insert_sz(need_size, need_size, slot->ptr.off);
-                this->values[slot->ptr.off + slot->ptr.size] = value;
+                set_value(slot->ptr.off + slot->ptr.size, value);
                 slot->ptr.size = need_size;
             }
 
-            pthread_spin_unlock(&this->bucket_locks[lock_id]);
+            this->unlock_bucket(lock_id);
             return false;
         }
     }
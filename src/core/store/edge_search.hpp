@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(USE_AVX512) || defined(USE_AVX2)
+#include <immintrin.h>
+#endif
+
+#include "core/common/type.hpp"
+
+#include "core/store/vertex.hpp"
+
+namespace wukong {
+
+/**
+ * Search in the value list of a normal key (i.e., [vid|pid|IN/OUT]), which is
+ * sorted by val (see sort_normal_triples and DynamicKVStore::insert_key_value).
+ *
+ * NOTE: the value lists of index keys (i.e., [0|pid|IN/OUT]) are NOT sorted.
+ */
+
+// value lists shorter than this are scanned linearly
+static const uint64_t EDGE_SCAN_THRESHOLD = 16;
+
+/**
+ * @brief the first position in [lo, sz) whose val is not less than v (binary search)
+ */
+static inline uint64_t edge_lower_bound(const edge_t *edges, uint64_t lo, uint64_t sz, sid_t v) {
+    uint64_t hi = sz;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if ((sid_t)edges[mid].val < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief the first position in [lo, sz) whose val is not less than v (galloping search)
+ *
+ * It is cheaper than edge_lower_bound() when v is close to edges[lo],
+ * e.g., searching increasing values one by one.
+ */
+static inline uint64_t edge_gallop(const edge_t *edges, uint64_t lo, uint64_t sz, sid_t v) {
+    uint64_t step = 1, hi = lo;
+    while (hi < sz && (sid_t)edges[hi].val < v) {
+        lo = hi + 1;
+        hi += step;
+        step <<= 1;
+    }
+    return edge_lower_bound(edges, lo, std::min(hi, sz), v);
+}
+
+/**
+ * @brief whether the (sorted) value list contains v
+ */
+static inline bool edge_contains(const edge_t *edges, uint64_t sz, sid_t v) {
+    if (sz < EDGE_SCAN_THRESHOLD) {
+        for (uint64_t k = 0; k < sz; k++)
+            if ((sid_t)edges[k].val == v)
+                return true;
+        return false;
+    }
+
+    uint64_t k = edge_lower_bound(edges, 0, sz, v);
+    return (k < sz) && ((sid_t)edges[k].val == v);
+}
+
+/**
+ * @brief intersect sorted values with a (sorted) value list
+ *
+ * @param vals values in ascending order (may be duplicate)
+ * @param n the number of values
+ * @param edges the value list
+ * @param sz the size of value list
+ * @param matched the positions of matched values in vals (return value, ascending)
+ */
+static inline void edge_intersect(const sid_t *vals, uint64_t n,
+                                  const edge_t *edges, uint64_t sz,
+                                  std::vector<uint64_t> &matched) {
+    uint64_t i = 0, j = 0;
+
+    // skewed: search each value by galloping
+    if (n * EDGE_SCAN_THRESHOLD < sz) {
+        for (; i < n; i++) {
+            j = edge_gallop(edges, j, sz, vals[i]);
+            if (j == sz)
+                break;
+            if ((sid_t)edges[j].val == vals[i])
+                matched.push_back(i);
+        }
+        return;
+    }
+
+#if defined(USE_AVX512) || defined(USE_AVX2)
+    // merge 8 x 8 values at a time (32-bit IDs w/o timestamps)
+    if (sizeof(sid_t) == sizeof(int) && sizeof(edge_t) == sizeof(int)) {
+        uint64_t start = matched.size();
+        const __m256i rotate = _mm256_set_epi32(0, 7, 6, 5, 4, 3, 2, 1);
+        while (i + 8 <= n && j + 8 <= sz) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vals + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(edges + j));
+            // compare each value in va with all values in vb
+            __m256i hit = _mm256_cmpeq_epi32(va, vb);
+            for (int r = 1; r < 8; r++) {
+                vb = _mm256_permutevar8x32_epi32(vb, rotate);
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(va, vb));
+            }
+
+            uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+            while (mask) {
+                matched.push_back(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+
+            // the values in vals may be duplicate, so keep the block of edges
+            // until the block of vals is passed
+            if (vals[i + 7] <= (sid_t)edges[j + 7].val)
+                i += 8;
+            else
+                j += 8;
+        }
+        // the block of vals may be matched by several blocks of edges
+        std::sort(matched.begin() + start, matched.end());
+    }
+#endif
+
+    // merge the rest one by one
+    while (i < n && j < sz) {
+        if (vals[i] < (sid_t)edges[j].val) {
+            i++;
+        } else if (vals[i] > (sid_t)edges[j].val) {
+            j++;
+        } else {
+            matched.push_back(i);
+            i++;
+        }
+    }
+}
+
+}  // namespace wukong
@@ -353,7 +353,24 @@ class GChecker {
         wukong::atomic::add_and_fetch(&nvertex_num, 1);
     }
 
+    // the value part of normal key/value pairs should be sorted (see edge_search.hpp)
+    void check_sorted(ikey_t key) {
+        uint64_t vsz = 0;
+        edge_t* vres = gstore->get_values_local(0, key, vsz);
+        for (uint64_t i = 1; i < vsz; i++) {
+            if (vres[i] < vres[i - 1]) {
+                logstream(LOG_ERROR) << "The value part of normal key/value pair "
+                                     << "[ " << key.vid << " | " << key.pid << " | " << key.dir << " ] "
+                                     << "is NOT sorted" << LOG_endl;
+                break;
+            }
+        }
+    }
+
     void check(ikey_t key, bool index, bool normal) {
+        if (normal && is_vid(key.vid))
+            check_sorted(key);
+
         if (key.vid == 0 && is_tpid(key.pid) && key.dir == IN) {  // (2) and (1)
             if (index) check_idx_in(key);
         } else if (key.vid == 0 && is_tpid(key.pid) && key.dir == OUT) {  // (1)
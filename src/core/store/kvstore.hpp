@@ -24,7 +24,9 @@
 
 #include <pthread.h>
 #include <stdint.h>  // uint64_t
+#include <algorithm>
 #include <atomic>
+#include <immintrin.h>
 #include <iostream>
 #include <limits>
 #include <queue>
@@ -41,6 +43,7 @@
 #include "core/common/rdma.hpp"
 #include "core/common/type.hpp"
 
+#include "core/store/bucket_probe.hpp"
 #include "core/store/rdma_cache.hpp"
 #include "core/store/segment_meta.hpp"
 #include "core/store/vertex.hpp"
@@ -75,6 +78,8 @@ class KVStore {
     friend class GChecker;
     friend class RDFGraph;
     friend class SegmentRDFGraph;
+    friend class TimeIndex;
+    friend class SnapshotView;
 
 public:
     // the number of locks to protect buckets
@@ -82,6 +87,13 @@ public:
     // the associativity of slots in each bucket
     static const int ASSOCIATIVITY = 8;
 
+#ifdef TRDF_MODE
+    // the value w/ its timestamps for inserting
+    using InsertValueType = time_edge_t;
+#else
+    using InsertValueType = ValueType;
+#endif
+
     /** 
      * Memory Usage (estimation):
      *   header region: |vertex| = 128-bit; 
@@ -112,6 +124,11 @@ protected:
 
     slot_t* slots;
     ValueType* values;
+#ifdef TRDF_MODE
+    // the timestamps of values in a time region parallel to the entry region,
+    // addressed by the same offsets (see reserve_times); otherwise nullptr
+    edge_time_t* times = nullptr;
+#endif
 
     uint64_t num_slots;        // 1 bucket = ASSOCIATIVITY * slots
     uint64_t num_buckets;      // main-header region (static)
@@ -122,6 +139,15 @@ protected:
     pthread_spinlock_t bucket_locks[NUM_LOCKS];
     pthread_spinlock_t bucket_ext_lock;
 
+    // seqlock-style versions of buckets (one per lock)
+    // writers hold the lock and make the version odd during the update,
+    // while readers never take the lock and retry if the version changes.
+    struct bucket_version_t {
+        std::atomic<uint64_t> ver;
+    } __attribute__((aligned(64)));
+
+    bucket_version_t bucket_versions[NUM_LOCKS];
+
     uint64_t num_entries;  // value region
 
     /**
@@ -154,7 +180,7 @@ protected:
         uint64_t lock_id = bucket_id % NUM_LOCKS;
 
         bool found = false;
-        pthread_spin_lock(&bucket_locks[lock_id]);
+        lock_bucket(lock_id);
         while (slot_id < num_slots) {
             // the last slot of each bucket is always reserved for pointer to indirect header
             /// TODO: add type info to slot and reuse the last slot to store key
@@ -196,26 +222,131 @@ protected:
             goto done;
         }
     done:
-        pthread_spin_unlock(&bucket_locks[lock_id]);
+        unlock_bucket(lock_id);
         ASSERT(slot_id < num_slots);
         return slot_id;
     }
 
     /**
-     * @brief search slot id for given key
-     * 
-     * if not found, return the new slot id to insert
-     * 
+     * @brief lock the buckets protected by lock_id for update
+     *
+     * The version becomes odd until unlock_bucket(), which invalidates
+     * concurrent optimistic reads.
+     *
+     * @param lock_id the id of bucket lock
+     */
+    void lock_bucket(uint64_t lock_id) {
+        pthread_spin_lock(&bucket_locks[lock_id]);
+        uint64_t ver = bucket_versions[lock_id].ver.load(std::memory_order_relaxed);
+        bucket_versions[lock_id].ver.store(ver + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void unlock_bucket(uint64_t lock_id) {
+        uint64_t ver = bucket_versions[lock_id].ver.load(std::memory_order_relaxed);
+        bucket_versions[lock_id].ver.store(ver + 1, std::memory_order_release);
+        pthread_spin_unlock(&bucket_locks[lock_id]);
+    }
+
+    // begin an optimistic read (wait for the in-flight writer)
+    uint64_t read_begin(uint64_t lock_id) const {
+        uint64_t ver;
+        while ((ver = bucket_versions[lock_id].ver.load(std::memory_order_acquire)) & 1)
+            _mm_pause();
+        return ver;
+    }
+
+    // end an optimistic read, return true if the read should be retried
+    bool read_retry(uint64_t lock_id, uint64_t ver) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return bucket_versions[lock_id].ver.load(std::memory_order_relaxed) != ver;
+    }
+
+    /**
+     * @brief find the first slot of a bucket whose key is given key or empty
+     *
+     * @param bucket the first slot of the bucket
      * @param key given key
-     * @return uint64_t slot id
+     * @return int the index of slot, or ASSOCIATIVITY - 1 if not found
      */
-    uint64_t search_key(KeyType key) {
-        uint64_t bucket_id = bucket_local(key);
+    static int probe_slots(const slot_t* bucket, KeyType key) {
+        static_assert(ASSOCIATIVITY == 8, "probe_bucket() assumes 8-way buckets");
+        if constexpr (sizeof(KeyType) == sizeof(uint64_t) && sizeof(slot_t) == 16) {
+            // packed 64-bit key (e.g., ikey_t), empty key is zero
+            uint64_t k;
+            memcpy(&k, &key, sizeof(uint64_t));
+            return probe_bucket(bucket, k);
+        } else {
+            for (int i = 0; i < ASSOCIATIVITY - 1; i++) {
+                KeyType k = bucket[i].key;
+                if (k == key || k.is_empty())
+                    return i;
+            }
+            return ASSOCIATIVITY - 1;
+        }
+    }
+
+    /**
+     * @brief walk the chain of buckets for given key without lock
+     *
+     * The result is meaningful only if the read is validated by read_retry().
+     *
+     * @param key given key
+     * @param bucket_id the first bucket of the chain
+     * @param slot a copy of the slot (for return)
+     * @return uint64_t the slot id of the key or the first empty slot,
+     *         or num_slots if the chain is full
+     */
+    uint64_t probe_chain(KeyType key, uint64_t bucket_id, slot_t& slot) const {
         uint64_t slot_id = bucket_id * ASSOCIATIVITY;
+        while (slot_id < num_slots) {
+            int i = probe_slots(&this->slots[slot_id], key);
+            if (i < ASSOCIATIVITY - 1) {
+                slot = this->slots[slot_id + i];
+                return slot_id + i;
+            }
+
+            // whether the bucket_ext (indirect-header region) is used
+            KeyType next = this->slots[slot_id + ASSOCIATIVITY - 1].key;
+            if (next.is_empty())
+                break;
+            slot_id = next.vid * ASSOCIATIVITY;
+        }
+
+        // the chain is full (or a torn read of the chain)
+        slot = slot_t();
+        return num_slots;
+    }
+
+    /**
+     * @brief lookup the slot of given key without lock (seqlock-style)
+     *
+     * @param key given key
+     * @param bucket_id the first bucket of the chain
+     * @param slot a consistent copy of the slot (for return)
+     * @return uint64_t see probe_chain()
+     */
+    uint64_t lookup_slot(KeyType key, uint64_t bucket_id, slot_t& slot) const {
         uint64_t lock_id = bucket_id % NUM_LOCKS;
+        uint64_t ver, slot_id;
+        do {
+            ver = read_begin(lock_id);
+            slot_id = probe_chain(key, bucket_id, slot);
+        } while (read_retry(lock_id, ver));
+        return slot_id;
+    }
 
-        bool found = false;
-        pthread_spin_lock(&bucket_locks[lock_id]);
+    /**
+     * @brief locate slot id for given key (the bucket lock must be held)
+     *
+     * if not found, return the new slot id to insert
+     *
+     * @param key given key
+     * @param bucket_id the first bucket of the chain
+     * @return uint64_t slot id
+     */
+    uint64_t locate_key(KeyType key, uint64_t bucket_id) {
+        uint64_t slot_id = bucket_id * ASSOCIATIVITY;
         while (slot_id < num_slots) {
             // the last slot of each bucket is always reserved for pointer to indirect header
             /// TODO: add type info to slot and reuse the last slot to store key
@@ -245,7 +376,6 @@ protected:
             goto done;
         }
     done:
-        pthread_spin_unlock(&bucket_locks[lock_id]);
         ASSERT(slot_id < num_slots);
         return slot_id;
     }
@@ -291,26 +421,11 @@ protected:
      */
     slot_t get_slot_local(int tid, KeyType key, rdf_seg_meta_t* seg = nullptr) {
         uint64_t bucket_id = bucket_local(key, seg);
-        while (true) {
-            for (int i = 0; i < ASSOCIATIVITY; i++) {
-                uint64_t slot_id = bucket_id * ASSOCIATIVITY + i;
-                if (i < ASSOCIATIVITY - 1) {
-                    if (this->slots[slot_id].key == key) {
-                        // we found it
-                        return this->slots[slot_id];
-                    }
-                } else {
-                    if (this->slots[slot_id].key.is_empty())
-                        // not found, return empty slot
-                        return slot_t();
-
-                    // move to next bucket
-                    bucket_id = this->slots[slot_id].key.vid;
-                    // break for-loop
-                    break;
-                }
-            }
-        }
+        slot_t slot;
+        lookup_slot(key, bucket_id, slot);
+        if (slot.key == key)
+            return slot;  // we found it
+        return slot_t();  // not found, return empty slot
     }
 
     /**
@@ -347,26 +462,26 @@ protected:
             RDMA& rdma = RDMA::get_rdma();
             rdma.dev->RdmaRead(tid, dst_sid, buf, sz, off);
             slot_t* slots = reinterpret_cast<slot_t*>(buf);
-            for (int i = 0; i < ASSOCIATIVITY; i++) {
-                if (i < ASSOCIATIVITY - 1) {
-                    if (slots[i].key == key) {
-                        rdma_cache.insert(slots[i]);
-                        return slots[i];  // found
-                    }
-                } else {
-                    if (slots[i].key.is_empty())
-                        return slot_t();  // not found
+            int i = probe_slots(slots, key);
+            if (i < ASSOCIATIVITY - 1) {
+                if (slots[i].key.is_empty())
+                    return slot_t();  // not found
 
-                    // move to next bucket
-                    bucket_id = slots[i].key.vid;
-                    // break for-loop
-                    break;
-                }
+                rdma_cache.insert(slots[i]);
+                return slots[i];  // found
             }
+
+            if (slots[ASSOCIATIVITY - 1].key.is_empty())
+                return slot_t();  // not found
+
+            // move to next bucket
+            bucket_id = slots[ASSOCIATIVITY - 1].key.vid;
         }
     }
 
     // Get values of given key from dst_sid by RDMA read.
+    // NOTE: the values are in the RDMA buffer of the thread, which is reused by
+    //       the next remote read (copy them to keep, see DGraph::get_triples_batch)
     ValueType* rdma_get_values(int tid, int dst_sid, slot_t& slot) {
         ASSERT(Global::use_rdma);
 
@@ -382,6 +497,47 @@ protected:
         return reinterpret_cast<ValueType*>(buf);
     }
 
+#ifdef TRDF_MODE
+    // the offset of the time region parallel to the entry region (see reserve_times)
+    uint64_t times_region_off() {
+        return num_slots * sizeof(slot_t) + num_entries * sizeof(ValueType);
+    }
+
+    // the offset of the timestamps of the value at off in the store (the same
+    // memory layout on all servers), which are either in the parallel time region
+    // (w/o segment) or in the entries of the segment behind its values
+    uint64_t times_off(uint64_t off, const rdf_seg_meta_t* seg) {
+        if (seg == nullptr)
+            return times_region_off() + off * sizeof(edge_time_t);
+        return num_slots * sizeof(slot_t) + seg->time_start * sizeof(ValueType)
+               + (off - seg->edge_start) * sizeof(edge_time_t);
+    }
+
+    // whether the values (in the segment) have timestamps
+    bool has_times(const rdf_seg_meta_t* seg) {
+        return (seg == nullptr) ? (times != nullptr) : seg->temporal;
+    }
+
+    // Get the timestamps of values of given key from dst_sid by RDMA read,
+    // which are placed behind the values in the buffer, and so are only valid
+    // until the next remote read of the thread, like the values (see rdma_get_values).
+    edge_time_t* rdma_get_times(int tid, int dst_sid, slot_t& slot, const rdf_seg_meta_t* seg) {
+        ASSERT(Global::use_rdma);
+        if (!has_times(seg))
+            return nullptr;
+
+        uint64_t buf_off = (get_value_sz(slot) + sizeof(edge_time_t) - 1) / sizeof(edge_time_t) * sizeof(edge_time_t);
+        char* buf = kv_mem.rrbuf + kv_mem.rrbuf_sz * tid + buf_off;
+        uint64_t r_off = times_off(slot.ptr.off, seg);
+        uint64_t r_sz = slot.ptr.size * sizeof(edge_time_t);
+        ASSERT(buf_off + r_sz < kv_mem.rrbuf_sz);  // enough space to host the values and timestamps
+
+        RDMA& rdma = RDMA::get_rdma();
+        rdma.dev->RdmaRead(tid, dst_sid, buf, r_sz, r_off);
+        return reinterpret_cast<edge_time_t*>(buf);
+    }
+#endif
+
     /**
      * @brief Get local values according to given key
      * 
@@ -483,6 +639,7 @@ public:
         pthread_spin_init(&this->bucket_ext_lock, 0);
         for (int i = 0; i < NUM_LOCKS; i++) {
             pthread_spin_init(&this->bucket_locks[i], 0);
+            this->bucket_versions[i].ver = 0;
         }
 
         // clean kv store
@@ -512,8 +669,43 @@ public:
     }
 
 
+#ifdef TRDF_MODE
+    /**
+     * @brief Reserve a time region parallel to the entry region
+     *
+     * Only for the store w/o segments, whose values may be anywhere in the
+     * entry region. It shrinks the entry region, and so must be called
+     * before any entry is allocated (i.e., before refresh()).
+     * (the segments reserve timestamps in their own entries, see rdf_seg_meta_t)
+     */
+    void reserve_times() {
+        uint64_t entry_region = kv_mem.kvs_sz - kv_mem.kvs_sz * HD_RATIO / 100;
+        // an even number of entries keeps the time region aligned
+        this->num_entries = entry_region / (sizeof(ValueType) + sizeof(edge_time_t)) / 2 * 2;
+        this->times = reinterpret_cast<edge_time_t*>(kv_mem.kvs + times_region_off());
+        logstream(LOG_INFO) << "  entry region: " << this->num_entries << " entries"
+                            << " (w/ timestamps)" << LOG_endl;
+    }
+
+    /**
+     * @brief Get the timestamps of the local value at off
+     *
+     * @param off value offset
+     * @param seg the segment of the value (nullptr w/o segments)
+     * @return edge_time_t* nullptr if the values have no timestamps
+     */
+    inline edge_time_t* get_times(uint64_t off, const rdf_seg_meta_t* seg = nullptr) {
+        if (!has_times(seg))
+            return nullptr;
+        return reinterpret_cast<edge_time_t*>(kv_mem.kvs + times_off(off, seg));
+    }
+#endif
+
     inline void* get_slot_addr() { return reinterpret_cast<void*>(this->slots); }
     inline void* get_value_addr() { return reinterpret_cast<void*>(this->values); }
+#ifdef TRDF_MODE
+    inline void* get_time_addr() { return reinterpret_cast<void*>(this->times); }
+#endif
 
     /**
      * @brief Get the values for given key
@@ -532,56 +724,125 @@ public:
             return get_values_remote(tid, dst_sid, key, sz, seg);
     }
 
+#ifdef TRDF_MODE
     /**
-     * @brief Check if the given key exists
-     * 
-     * @param key 
-     * @return true the key exist
+     * @brief Get the values and their timestamps for given key
+     *
+     * @param tid caller thread id
+     * @param dst_sid target server id
+     * @param key given key
+     * @param sz value size(return value)
+     * @param times the timestamps of values (return value)
+     * @param seg for segment-based
+     * @return ValueType* value address
      */
-    bool check_key_exist(KeyType key) {
-        uint64_t bucket_id = bucket_local(key);
-        uint64_t slot_id = bucket_id * ASSOCIATIVITY;
-        uint64_t lock_id = bucket_id % NUM_LOCKS;
+    ValueType* get_timed_values(int tid, int dst_sid, KeyType key, uint64_t& sz,
+                                edge_time_t*& times, rdf_seg_meta_t* seg = nullptr) {
+        if (dst_sid == this->sid) {
+            slot_t slot = get_slot_local(tid, key, seg);
+            sz = slot.ptr.size;
+            if (slot.key.is_empty()) {
+                sz = 0;
+                times = nullptr;
+                return nullptr;  // not found
+            }
+            times = get_times(slot.ptr.off, seg);
+            return &(this->values[slot.ptr.off]);
+        }
 
-        pthread_spin_lock(&bucket_locks[lock_id]);
-        while (slot_id < num_slots) {
-            // the last slot of each bucket is always reserved for pointer to indirect header
-            /// TODO: add type info to slot and reuse the last slot to store key
-            /// TODO: key.vid is reused to store the bucket_id of indirect header rather than ptr.off,
-            ///       since the is_empty() is not robust.
-            for (int i = 0; i < ASSOCIATIVITY - 1; i++, slot_id++) {
-                if (this->slots[slot_id].key == key) {
-                    pthread_spin_unlock(&bucket_locks[lock_id]);
-                    return true;
-                }
+        slot_t slot = get_slot_remote(tid, dst_sid, key, seg);
+        if (slot.key.is_empty()) {
+            sz = 0;
+            times = nullptr;
+            return nullptr;  // not found
+        }
 
-                // insert to an empty slot
-                if (this->slots[slot_id].key.is_empty()) {
-                    pthread_spin_unlock(&bucket_locks[lock_id]);
-                    return false;
-                }
+        ValueType* value_ptr = rdma_get_values(tid, dst_sid, slot);
+        while (!value_is_valid(slot, value_ptr)) {
+            rdma_cache.invalidate(key);
+            slot = get_slot_remote(tid, dst_sid, key, seg);
+            value_ptr = rdma_get_values(tid, dst_sid, slot);
+        }
+        // the block of values is freed lazily (see DynamicKVStore::add_pending_free)
+        times = rdma_get_times(tid, dst_sid, slot, seg);
+
+        sz = slot.ptr.size;
+        return value_ptr;
+    }
+#endif
+
+    /// the number of in-flight lookups in get_values_batch()
+    static const int BATCH_GROUP = 16;
+
+    /**
+     * @brief Get local values for a batch of keys
+     *
+     * The lookups are interleaved group by group (AMAC-style): the buckets of
+     * a group are prefetched first, then the slots are probed and the values
+     * are prefetched. Thus the cache misses of different keys are overlapped
+     * instead of being serialized.
+     *
+     * @param tid caller thread id
+     * @param keys given keys (all should be local)
+     * @param n the number of keys
+     * @param vals value addresses (return value, nullptr if not found)
+     * @param szs value sizes (return value)
+     * @param seg for segment-based search
+     */
+    void get_values_batch(int tid, const KeyType* keys, uint64_t n,
+                          ValueType** vals, uint64_t* szs, rdf_seg_meta_t* seg = nullptr) {
+        uint64_t bucket_ids[BATCH_GROUP];
+        for (uint64_t base = 0; base < n; base += BATCH_GROUP) {
+            int ng = std::min<uint64_t>(BATCH_GROUP, n - base);
+
+            // stage 1: prefetch the buckets (a bucket spans two cache lines)
+            for (int j = 0; j < ng; j++) {
+                bucket_ids[j] = bucket_local(keys[base + j], seg);
+                const char* bucket = reinterpret_cast<const char*>(&slots[bucket_ids[j] * ASSOCIATIVITY]);
+                __builtin_prefetch(bucket);
+                __builtin_prefetch(bucket + 64);
             }
-            // whether the bucket_ext (indirect-header region) is used
-            if (!this->slots[slot_id].key.is_empty()) {
-                slot_id = this->slots[slot_id].key.vid * ASSOCIATIVITY;
-                continue;  // continue and jump to next bucket
+
+            // stage 2: probe the slots and prefetch the values
+            for (int j = 0; j < ng; j++) {
+                uint64_t i = base + j;
+                slot_t slot;
+                lookup_slot(keys[i], bucket_ids[j], slot);
+                if (slot.key == keys[i]) {
+                    vals[i] = &(this->values[slot.ptr.off]);
+                    szs[i] = slot.ptr.size;
+                    __builtin_prefetch(vals[i]);
+                } else {
+                    vals[i] = nullptr;  // not found
+                    szs[i] = 0;
+                }
             }
-            pthread_spin_unlock(&bucket_locks[lock_id]);
-            return false;
         }
     }
 
+    /**
+     * @brief Check if the given key exists
+     * 
+     * @param key 
+     * @return true the key exist
+     */
+    bool check_key_exist(KeyType key) {
+        slot_t slot;
+        lookup_slot(key, bucket_local(key), slot);
+        return (slot.key == key);
+    }
+
     /**
      * @brief insert a new key-value pair (dynamically)
      * 
      * @param key 
-     * @param value 
+     * @param value (w/ timestamps in TRDF_MODE)
      * @param dedup_or_isdup param:if dedup; return value:is duplicate 
      * @param tid caller
      * @return true insert succeed
      * @return false insert failed
      */
-    virtual bool insert_key_value(KeyType key, ValueType value, bool& dedup_or_isdup, int tid) = 0;
+    virtual bool insert_key_value(KeyType key, InsertValueType value, bool& dedup_or_isdup, int tid) = 0;
 
     /**
      * @brief print the memory usage of KV
@@ -628,6 +889,10 @@ public:
                             << " MB (" << num_entries << " entries)" << LOG_endl;
         logstream(LOG_INFO) << "\tused entries: " << B2MiB(used_entries * sizeof(ValueType))
                             << " MB (" << used_entries << " entries)" << LOG_endl;
+#ifdef TRDF_MODE
+        logstream(LOG_INFO) << "[KV] time: " << B2MiB(this->num_entries * sizeof(edge_time_t))
+                            << " MB (used: " << B2MiB(used_entries * sizeof(edge_time_t)) << " MB)" << LOG_endl;
+#endif
     }
 };
 
@@ -54,7 +54,7 @@ class RDFGraph : public DGraph {
                 tbb_edge_hash_map::accessor a;
                 pidx_out_map.insert(a, pid);
             #if TRDF_MODE
-                a->second.push_back(edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
+                a->second.push_back(time_edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
             #else
                 a->second.push_back(edge_t(vid));
             #endif
@@ -71,7 +71,7 @@ class RDFGraph : public DGraph {
                     tbb_edge_hash_map::accessor a;
                     tidx_map.insert(a, this->gstore->values[off + e].val);
                 #if TRDF_MODE
-                    a->second.push_back(edge_t(vid, this->gstore->values[off + e].ts, this->gstore->values[off + e].te));
+                    a->second.push_back(time_edge_t(vid, this->gstore->times[off + e].ts, this->gstore->times[off + e].te));
                 #else
                     a->second.push_back(edge_t(vid));
                 #endif
@@ -83,7 +83,7 @@ class RDFGraph : public DGraph {
                 tbb_edge_hash_map::accessor a;
                 pidx_in_map.insert(a, pid);
             #if TRDF_MODE
-                a->second.push_back(edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
+                a->second.push_back(time_edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
             #else
                 a->second.push_back(edge_t(vid));
             #endif
@@ -130,10 +130,9 @@ class RDFGraph : public DGraph {
             // insert objects
             for (uint64_t i = s; i < e; i++) {
             #if TRDF_MODE
-                this->gstore->values[off++] = edge_t(pso[i].o, pso[i].ts, pso[i].te);
-            #else
-                this->gstore->values[off++] = edge_t(pso[i].o);
+                this->gstore->times[off] = edge_time_t(pso[i].ts, pso[i].te);
             #endif
+                this->gstore->values[off++] = edge_t(pso[i].o);
             }
 
             collect_idx_info(this->gstore->slots[slot_id]);
@@ -160,10 +159,9 @@ class RDFGraph : public DGraph {
                 // insert predicates
                 for (auto const& p : predicates) {
                 #if TRDF_MODE
-                    this->gstore->values[off++] = edge_t(p, TIMESTAMP_MIN, TIMESTAMP_MAX);
-                #else
-                    this->gstore->values[off++] = edge_t(p);
+                    this->gstore->times[off] = edge_time_t(TIMESTAMP_MIN, TIMESTAMP_MAX);
                 #endif
+                    this->gstore->values[off++] = edge_t(p);
                     p_set.insert(p);  // collect all local predicates
                 }
 
@@ -193,10 +191,9 @@ class RDFGraph : public DGraph {
             // insert values
             for (uint64_t i = s; i < e; i++) {
             #if TRDF_MODE
-                this->gstore->values[off++] = edge_t(pos[i].s, pos[i].ts, pos[i].te);
-            #else
-                this->gstore->values[off++] = edge_t(pos[i].s);
+                this->gstore->times[off] = edge_time_t(pos[i].ts, pos[i].te);
             #endif
+                this->gstore->values[off++] = edge_t(pos[i].s);
             }
 
             collect_idx_info(this->gstore->slots[slot_id]);
@@ -222,10 +219,9 @@ class RDFGraph : public DGraph {
                 // insert predicate
                 for (auto const& p : predicates) {
                 #if TRDF_MODE
-                    this->gstore->values[off++] = edge_t(p, TIMESTAMP_MIN, TIMESTAMP_MAX);
-                #else
-                    this->gstore->values[off++] = edge_t(p);
+                    this->gstore->times[off] = edge_time_t(TIMESTAMP_MIN, TIMESTAMP_MAX);
                 #endif
+                    this->gstore->values[off++] = edge_t(p);
                     p_set.insert(p);  // collect all local predicates
                 }
 
@@ -318,8 +314,14 @@ class RDFGraph : public DGraph {
                 iptr_t(sz, off));
 
             // insert subjects/objects
-            for (auto const& edge : e.second)
+            for (auto const& edge : e.second) {
+            #if TRDF_MODE
+                this->gstore->times[off] = edge.time();
+                this->gstore->values[off++] = edge.edge();
+            #else
                 this->gstore->values[off++] = edge;
+            #endif
+            }
         }
     }
 
@@ -338,11 +340,9 @@ class RDFGraph : public DGraph {
         // insert index value
         for (auto const& e : set) {
         #if TRDF_MODE
-            edge_t edge(e, TIMESTAMP_MIN, TIMESTAMP_MAX);
-        #else
-            edge_t edge(e);
+            this->gstore->times[off] = edge_time_t(TIMESTAMP_MIN, TIMESTAMP_MAX);
         #endif
-            this->gstore->values[off++] = edge;
+            this->gstore->values[off++] = edge_t(e);
         }
     }
 #endif  // VERSATILE
@@ -355,6 +355,10 @@ public:
             this->gstore = std::make_shared<StaticKVStore<ikey_t, iptr_t, edge_t>>(sid, kv_mem);
         else  // dynamic
             this->gstore = std::make_shared<DynamicKVStore<ikey_t, iptr_t, edge_t>>(sid, kv_mem);
+    #if TRDF_MODE
+        // the values of any key may be anywhere in the entry region (w/o segments)
+        this->gstore->reserve_times();
+    #endif
     }
 
     ~RDFGraph() {}
@@ -382,6 +386,64 @@ public:
         logstream(LOG_INFO) << sid << ": " << (end - start) / 1000 << "ms "
                             << "for inserting normal data into gstore" << LOG_endl;
 
+        insert_attr_and_idx(triple_sav);
+    }
+
+    /**
+     * @brief initialize gstore with sorted runs on disk (bounded-memory loading)
+     *
+     * The runs of each engine are merged and inserted by chunks of complete keys
+     * (see TripleRunMerger), since entries are allocated key by key. The run files
+     * are removed after inserted, and false is returned if any run fails to be read.
+     */
+    bool init_gstore_from_runs(std::vector<TripleRuns>& runs_pso,
+                               std::vector<TripleRuns>& runs_pos,
+                               std::vector<std::vector<triple_attr_t>>& triple_sav) override {
+        // a chunk and the read buffers of a merger per engine
+        uint64_t buf_sz = std::max(MiB2B(Global::load_budget_mb) / (2 * Global::num_engines), MiB2B(1));
+        uint64_t chunk_sz = buf_sz / sizeof(triple_t);
+
+        uint64_t start, end;
+        start = timer::get_usec();
+        uint64_t nfailed = 0;
+        #pragma omp parallel for num_threads(Global::num_engines) reduction(+ : nfailed)
+        for (int t = 0; t < Global::num_engines; t++) {
+            std::vector<triple_t> chunk, empty;
+            {
+                TripleRunMerger merger(runs_pso[t], buf_sz);
+                while (merger.next_chunk(chunk, chunk_sz))
+                    insert_normal(t, chunk, empty);
+                nfailed += !merger.good();
+            }
+            {
+                // TYPE triples lead the runs (see insert_normal), and so each chunk
+                TripleRunMerger merger(runs_pos[t], buf_sz);
+                while (merger.next_chunk(chunk, chunk_sz))
+                    insert_normal(t, empty, chunk);
+                nfailed += !merger.good();
+            }
+            // release disk space
+            runs_pso[t].clear();
+            runs_pos[t].clear();
+        }
+        if (nfailed > 0)
+            return false;
+        end = timer::get_usec();
+        if (this->dynamic)
+            logstream(LOG_INFO) << "[DynamicRDFGraph] #";
+        else
+            logstream(LOG_INFO) << "[StaticRDFGraph] #";
+        logstream(LOG_INFO) << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for inserting normal data (by chunks) into gstore" << LOG_endl;
+
+        insert_attr_and_idx(triple_sav);
+        return true;
+    }
+
+    // insert attr and index triples, and finalize the initialization of gstore
+    void insert_attr_and_idx(std::vector<std::vector<triple_attr_t>>& triple_sav) {
+        uint64_t start, end;
+
         /* insert attributes into gstore */
         start = timer::get_usec();
         #pragma omp parallel for num_threads(Global::num_engines)
@@ -485,6 +547,12 @@ public:
         // step 4: load attribute triples
         // TODO
 
+    #ifdef TRDF_MODE
+        // value lists may be moved or resized
+        build_time_index();
+        // the snapshots miss new triples
+        snapshot_views.clear();
+    #endif
         return 0;
     }
 
@@ -499,7 +567,7 @@ public:
             dedup_or_isdup = true;
             ikey_t key = ikey_t(triple.s, triple.p, OUT);
 #ifdef TRDF_MODE
-            edge_t value = edge_t(triple.o, triple.ts, triple.te);
+            time_edge_t value = time_edge_t(triple.o, triple.ts, triple.te);
 #else
             edge_t value = edge_t(triple.o);
 #endif
@@ -508,7 +576,7 @@ public:
 #ifdef VERSATILE
                 key = ikey_t(triple.s, PREDICATE_ID, OUT);
 #if TRDF_MODE
-                value = edge_t(triple.p, triple.ts, triple.te);
+                value = time_edge_t(triple.p, triple.ts, triple.te);
 #else
                 value = edge_t(triple.p);
 #endif
@@ -519,7 +587,7 @@ public:
                 if (this->gstore->insert_key_value(key, value, nodup, tid) && !this->gstore->check_key_exist(buddy_key)) {
                     key = ikey_t(0, TYPE_ID, IN);
 #if TRDF_MODE
-                    value = edge_t(triple.s, triple.ts, triple.te);
+                    value = time_edge_t(triple.s, triple.ts, triple.te);
 #else
                     value = edge_t(triple.s);
 #endif
@@ -531,7 +599,7 @@ public:
             if (!dedup_or_isdup) {
                 key = ikey_t(0, triple.o, IN);
 #ifdef TRDF_MODE
-                value = edge_t(triple.s, triple.ts, triple.te);
+                value = time_edge_t(triple.s, triple.ts, triple.te);
 #else
                 value = edge_t(triple.s);
 #endif
@@ -540,7 +608,7 @@ public:
 #ifdef VERSATILE
                     key = ikey_t(0, TYPE_ID, OUT);
 #if TRDF_MODE
-                    value = edge_t(triple.o, triple.ts, triple.te);
+                    value = time_edge_t(triple.o, triple.ts, triple.te);
 #else
                     value = edge_t(triple.o);
 #endif
@@ -552,7 +620,7 @@ public:
         } else {
             ikey_t key = ikey_t(triple.s, triple.p, OUT);
 #ifdef TRDF_MODE
-            edge_t value = edge_t(triple.o, triple.ts, triple.te);
+            time_edge_t value = time_edge_t(triple.o, triple.ts, triple.te);
 #else
             edge_t value = edge_t(triple.o);
 #endif
@@ -560,7 +628,7 @@ public:
             if (this->gstore->insert_key_value(key, value, dedup_or_isdup, tid)) {
                 key = ikey_t(0, triple.p, IN);
 #ifdef TRDF_MODE
-                value = edge_t(triple.s, triple.ts, triple.te);
+                value = time_edge_t(triple.s, triple.ts, triple.te);
 #else
                 value = edge_t(triple.s);
 #endif
@@ -572,7 +640,7 @@ public:
 #ifdef VERSATILE
                     key = ikey_t(0, PREDICATE_ID, OUT);
 #if TRDF_MODE
-                    value = edge_t(triple.p, triple.ts, triple.te);
+                    value = time_edge_t(triple.p, triple.ts, triple.te);
 #else
                     value = edge_t(triple.p);
 #endif
@@ -583,7 +651,7 @@ public:
 #ifdef VERSATILE
                 key = ikey_t(triple.s, PREDICATE_ID, OUT);
 #if TRDF_MODE
-                value = edge_t(triple.p, triple.ts, triple.te);
+                value = time_edge_t(triple.p, triple.ts, triple.te);
 #else
                 value = edge_t(triple.p);
 #endif
@@ -594,7 +662,7 @@ public:
                 if (this->gstore->insert_key_value(key, value, nodup, tid) && !this->gstore->check_key_exist(buddy_key)) {
                     key = ikey_t(0, TYPE_ID, IN);
 #if TRDF_MODE
-                    value = edge_t(triple.s, triple.ts, triple.te);
+                    value = time_edge_t(triple.s, triple.ts, triple.te);
 #else
                     value = edge_t(triple.s);
 #endif
@@ -615,7 +683,7 @@ public:
         if (triple.p == TYPE_ID) return;
         ikey_t key = ikey_t(triple.o, triple.p, IN);
 #ifdef TRDF_MODE
-        edge_t value = edge_t(triple.s, triple.ts, triple.te);
+        time_edge_t value = time_edge_t(triple.s, triple.ts, triple.te);
 #else
         edge_t value = edge_t(triple.s);
 #endif
@@ -624,7 +692,7 @@ public:
             // key doesn't exist before
             key = ikey_t(0, triple.p, OUT);
 #ifdef TRDF_MODE
-            value = edge_t(triple.o, triple.ts, triple.te);
+            value = time_edge_t(triple.o, triple.ts, triple.te);
 #else
             value = edge_t(triple.o);
 #endif
@@ -636,7 +704,7 @@ public:
 #ifdef VERSATILE
                 key = ikey_t(0, PREDICATE_ID, OUT);
 #if TRDF_MODE
-                value = edge_t(triple.p, triple.ts, triple.te);
+                value = time_edge_t(triple.p, triple.ts, triple.te);
 #else
                 value = edge_t(triple.p);
 #endif
@@ -647,7 +715,7 @@ public:
 #ifdef VERSATILE
             key = ikey_t(triple.o, PREDICATE_ID, IN);
 #if TRDF_MODE
-            value = edge_t(triple.p, triple.ts, triple.te);
+            value = time_edge_t(triple.p, triple.ts, triple.te);
 #else
             value = edge_t(triple.p);
 #endif
@@ -658,7 +726,7 @@ public:
             if (this->gstore->insert_key_value(key, value, nodup, tid) && !this->gstore->check_key_exist(buddy_key)) {
                 key = ikey_t(0, TYPE_ID, IN);
 #ifdef TRDF_MODE
-                value = edge_t(triple.o, triple.ts, triple.te);
+                value = time_edge_t(triple.o, triple.ts, triple.te);
 #else
                 value = edge_t(triple.o);
 #endif
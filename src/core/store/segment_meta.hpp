@@ -91,6 +91,12 @@ struct rdf_seg_meta_t {
     uint64_t num_edges = 0;     // #edges of the segment
     uint64_t edge_start = 0;    // start offset in the entry region of gstore
     uint64_t edge_off = 0;      // current available offset in the entry region, only used by static gstore
+#ifdef TRDF_MODE
+    // only the segments of temporal predicates reserve the timestamps of their values,
+    // in the entries behind the values (i.e., time_start; see KVStore::get_times)
+    bool temporal = false;
+    uint64_t time_start = 0;  // start offset of the timestamps in the entry region of gstore
+#endif
 
     int num_key_blks = 0;    // #key-blocks needed in gcache
     int num_value_blks = 0;  // #value-blocks needed in gcache
@@ -149,6 +155,10 @@ struct rdf_seg_meta_t {
 #endif
         ar & num_edges;
         ar & edge_start;
+#ifdef TRDF_MODE
+        ar & temporal;
+        ar & time_start;
+#endif
         // clang-format on
     }
 };
@@ -30,7 +30,14 @@
 #include <utility>
 #include <vector>
 
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
+
 #include "core/store/dgraph.hpp"
+#include "core/store/snapshot.hpp"
+
+// utils
+#include "utils/triple_sort.hpp"
 
 namespace wukong {
 
@@ -63,14 +70,25 @@ protected:
         cnt_t() {
             in = 0ul;
             out = 0ul;
+#if TRDF_MODE
+            timed = false;
+#endif
         }
 
         cnt_t(const cnt_t& cnt) {
             in = cnt.in.load();
             out = cnt.out.load();
+#if TRDF_MODE
+            timed = cnt.timed.load();
+#endif
         }
 
         std::atomic<uint64_t> in, out;
+#if TRDF_MODE
+        // whether any triple of the predicate has a valid time other than
+        // [TIMESTAMP_MIN, TIMESTAMP_MAX] (i.e., a temporal predicate)
+        std::atomic<bool> timed;
+#endif
     };
 
     // Index arrays which stores start offset of each predicate(attr)'s data.
@@ -169,13 +187,26 @@ protected:
      * @param total_num_values total number of the values in this segment
      */
     void alloc_entries_to_seg(rdf_seg_meta_t& seg) {
+#if TRDF_MODE
+        // the timestamps follow the values in the entries of a temporal segment
+        if (seg.temporal) {
+            uint64_t align = sizeof(edge_time_t) / sizeof(edge_t);
+            uint64_t time_sz = seg.num_edges * align;
+            seg.edge_start = this->gstore->alloc_entries(seg.num_edges + (align - 1) + time_sz);
+            seg.time_start = (seg.edge_start + seg.num_edges + align - 1) / align * align;
+            seg.edge_off = seg.edge_start;
+            return;
+        }
+#endif
         seg.edge_start = this->gstore->alloc_entries(seg.num_edges);
+        seg.edge_off = seg.edge_start;
     }
 
     /**
      * @brief Allocate value space in given segment.
      * 
-     * NOTICE: This function is not thread-safe.
+     * NOTICE: This function is thread-safe (e.g., inserting sorted runs
+     *         of all engines to the same segment concurrently).
      * 
      * @param num_values number of values
      * @param tid caller thread id
@@ -184,15 +215,20 @@ protected:
      */
     uint64_t alloc_entries_in_seg(uint64_t num_values, int tid = 0, rdf_seg_meta_t* seg = nullptr) {
         ASSERT(seg != nullptr);
-        // Init offset if first visited.
-        if (seg->edge_off == 0)
-            seg->edge_off = seg->edge_start;
-        uint64_t orig = seg->edge_off;
-        seg->edge_off += num_values;
-        ASSERT(seg->edge_off <= seg->edge_start + seg->num_edges);
+        uint64_t orig = __sync_fetch_and_add(&seg->edge_off, num_values);
+        ASSERT(orig + num_values <= seg->edge_start + seg->num_edges);
         return orig;
     }
 
+#if TRDF_MODE
+    // set the timestamps of the value at off, only if the segment reserves timestamps
+    inline void set_time(const rdf_seg_meta_t& seg, uint64_t off, const edge_time_t& time) {
+        edge_time_t* times = this->gstore->get_times(off, &seg);
+        if (times != nullptr)
+            *times = time;
+    }
+#endif
+
     /**
      * @brief insert key to a slot in segment
      * 
@@ -207,7 +243,7 @@ protected:
         uint64_t seg_ext_lock_id = segid_t(key).hash() % RDFStore::NUM_LOCKS;
 
         bool found = false;
-        pthread_spin_lock(&this->gstore->bucket_locks[lock_id]);
+        this->gstore->lock_bucket(lock_id);
         while (slot_id < this->gstore->num_slots) {
             // the last slot of each bucket is always reserved for pointer to indirect header
             /// TODO: add type info to slot and reuse the last slot to store key
@@ -265,7 +301,7 @@ protected:
             goto done;
         }
     done:
-        pthread_spin_unlock(&this->gstore->bucket_locks[lock_id]);
+        this->gstore->unlock_bucket(lock_id);
         ASSERT_LT(slot_id, this->gstore->num_slots);
         return slot_id;
     }
@@ -307,8 +343,14 @@ protected:
                 ikey_t(0, pid, d),
                 iptr_t(sz, off));
 
-            for (auto const& edge : ca->second)
+            for (auto const& edge : ca->second) {
+            #if TRDF_MODE
+                set_time(segment, off, edge.time());
+                this->gstore->values[off++] = edge.edge();
+            #else
                 this->gstore->values[off++] = edge;
+            #endif
+            }
 
             ASSERT(off <= segment.edge_start + segment.num_edges);
         }
@@ -324,8 +366,14 @@ protected:
                     ikey_t(0, pid, IN),
                     iptr_t(sz, off));
 
-                for (auto const& edge : e.second)
+                for (auto const& edge : e.second) {
+                #if TRDF_MODE
+                    set_time(segment, off, edge.time());
+                    this->gstore->values[off++] = edge.edge();
+                #else
                     this->gstore->values[off++] = edge;
+                #endif
+                }
 
                 ASSERT(off <= segment.edge_start + segment.num_edges);
             }
@@ -398,10 +446,9 @@ protected:
                 // insert predicates
                 for (auto const& p : preds) {
                 #if TRDF_MODE
-                    this->gstore->values[off++] = edge_t(p, TIMESTAMP_MIN, TIMESTAMP_MAX);
-                #else
-                    this->gstore->values[off++] = edge_t(p);
+                    set_time(out_seg, off, edge_time_t(TIMESTAMP_MIN, TIMESTAMP_MAX));
                 #endif
+                    this->gstore->values[off++] = edge_t(p);
                 }
 
                 preds.clear();
@@ -441,10 +488,9 @@ protected:
                 // insert predicates
                 for (auto const& p : preds) {
                 #if TRDF_MODE
-                    this->gstore->values[off++] = edge_t(p, TIMESTAMP_MIN, TIMESTAMP_MAX);
-                #else
-                    this->gstore->values[off++] = edge_t(p);
+                    set_time(in_seg, off, edge_time_t(TIMESTAMP_MIN, TIMESTAMP_MAX));
                 #endif
+                    this->gstore->values[off++] = edge_t(p);
                 }
 
                 preds.clear();
@@ -532,14 +578,16 @@ protected:
             iptr_t(e - s, off));
 
         // insert values
+    #if TRDF_MODE
+        edge_time_t* times = this->gstore->get_times(off, &seg);
+    #endif
         for (uint32_t i = s; i < e; i++) {
         #if TRDF_MODE
-            this->gstore->values[off++] = (dir == OUT) ? edge_t(triples[i].o, triples[i].ts, triples[i].te)
-                                                       : edge_t(triples[i].s, triples[i].ts, triples[i].te);
-        #else
+            if (times != nullptr)
+                times[i - s] = edge_time_t(triples[i].ts, triples[i].te);
+        #endif
             this->gstore->values[off++] = (dir == OUT) ? edge_t(triples[i].o)
                                                        : edge_t(triples[i].s);
-        #endif
         }
 
         collect_idx_info(this->gstore->slots[slot_id]);
@@ -589,6 +637,28 @@ protected:
         }
     }
     
+    /**
+     * @brief Insert a chunk of triples (of any predicates) to their segments
+     * 
+     * Notes: This function can be called by engines concurrently, and the triples
+     *        of the same key should be in the same chunk.
+     * 
+     * @param tid caller thread id
+     * @param triples normal triple data (pso/pos, or spo/ops w/ VERSATILE)
+     * @param dir direction
+     */
+    void insert_chunk(int tid, const std::vector<triple_t>& triples, dir_t dir) {
+        size_t s = 0;
+        while (s < triples.size()) {
+            // pos triples skip type triples
+            if (dir == IN && is_tpid(triples[s].o)) {
+                s++;
+                continue;
+            }
+            s = insert_normal_triples(tid, triples, rdf_seg_meta_map[segid_t(0, triples[s].p, dir)], s, dir);
+        }
+    }
+
     /**
      * @brief Insert attr triples beloging to the segment identified by segid to store
      * 
@@ -646,30 +716,24 @@ protected:
     }
 
     /**
-     * @brief init metadata for each segment
+     * @brief init the counters of segments
      * 
-     * @param triple_pso pso triple data
-     * @param triple_pos pos triple data
-     * @param triple_sav attribute triple data
+     * @param normal_cnt_map #edges and #keys of normal segments
+     * @param index_cnt_map #edges of index segments
      */
-    void init_seg_metas(const std::vector<std::vector<triple_t>>& triple_pso,
-                        const std::vector<std::vector<triple_t>>& triple_pos,
-                        const std::vector<std::vector<triple_attr_t>>& triple_sav) {
+    void init_seg_counters(std::map<sid_t, cnt_t>& normal_cnt_map,
+                           std::map<sid_t, cnt_t>& index_cnt_map) {
         /**
-         * count(|pred| means number of local predicates):
+         * normal_cnt_map, count(|pred| means number of local predicates):
          * 1. normal vertices [vid|pid|IN/OUT], key: pid, cnt_t: in&out, #item: |pred|
          * 2. vid's all types [vid|TYPE_ID(1)|OUT], key: TYPE_ID(1), cnt_t: out, #item: contained above
          * 3*. vid's all predicates [vid|PREDICATE_ID(0)|IN/OUT], key: PREDICATE_ID(0), cnt_t: in&out, #item: 1
          * 4^. attr triples [vid|pid|out], key: pid, cnt_t: out, #item: |attrpred|
-         */
-        std::map<sid_t, cnt_t> normal_cnt_map;
-
-        /**
-         * count(|pred| means number of local predicates):
+         *
+         * index_cnt_map, count(|pred| means number of local predicates):
          * 1. predicate index [0|pid|IN/OUT], key: pid, cnt_t: in&out, #item: |pred|
          * 2. type index [0|typeid|IN], key: typeid, cnt_t: in, #item: |type|
          */
-        std::map<sid_t, cnt_t> index_cnt_map;
 
         // initialization
         for (sid_t pred : this->predicates) {
@@ -689,107 +753,140 @@ protected:
         // init index segment
         rdf_seg_meta_map.insert(std::make_pair(segid_t(1, PREDICATE_ID, IN), rdf_seg_meta_t()));
         rdf_seg_meta_map.insert(std::make_pair(segid_t(1, PREDICATE_ID, OUT), rdf_seg_meta_t()));
+    }
 
-        #pragma omp parallel for num_threads(Global::num_engines)
-        for (int tid = 0; tid < Global::num_engines; tid++) {
-            const std::vector<triple_t>& pso = triple_pso[tid];
-            const std::vector<triple_t>& pos = triple_pos[tid];
-            const std::vector<triple_attr_t>& sav = triple_sav[tid];
-
-            uint64_t s = 0;
-            while (s < pso.size()) {
-                uint64_t e = s + 1;
+    /**
+     * @brief count the triples of an engine (or a chunk of them)
+     * 
+     * NOTICE: triples of the same key should not be split across calls.
+     * 
+     * @param pso pso triple data (or spo w/ VERSATILE)
+     * @param pos pos triple data (or ops w/ VERSATILE)
+     * @param sav attribute triple data
+     */
+    void count_triples(const std::vector<triple_t>& pso,
+                       const std::vector<triple_t>& pos,
+                       const std::vector<triple_attr_t>& sav,
+                       std::map<sid_t, cnt_t>& normal_cnt_map,
+                       std::map<sid_t, cnt_t>& index_cnt_map) {
+        uint64_t s = 0;
+        while (s < pso.size()) {
+            uint64_t e = s + 1;
 
-                while ((e < pso.size()) && (pso[s].s == pso[e].s) && (pso[s].p == pso[e].p)) {
-                    // count #edge of type-idx (IN)
-                    if (pso[e].p == TYPE_ID && is_tpid(pso[e].o)) {
+            while ((e < pso.size()) && (pso[s].s == pso[e].s) && (pso[s].p == pso[e].p)) {
+                // count #edge of type-idx (IN)
+                if (pso[e].p == TYPE_ID && is_tpid(pso[e].o)) {
 #ifdef VERSATILE
-                        t_set.insert(pso[e].o);
+                    t_set.insert(pso[e].o);
 #endif
-                        index_cnt_map[pso[e].o].in++;
-                    }
-                    e++;
+                    index_cnt_map[pso[e].o].in++;
                 }
+                e++;
+            }
 
 #ifdef VERSATILE
-                v_set.insert(pso[s].s);
-                p_set.insert(pso[s].p);
-
-                // vid's preds count
-                tbb::concurrent_hash_map<sid_t, uint64_t>::accessor oa;
-                if (vp_meta[OUT].insert(oa, pso[s].s))
-                    oa->second = 1;
-                else
-                    oa->second += 1;
-                oa.release();
-                // count vid's all predicates OUT (number of value in the segment)
-                normal_cnt_map[PREDICATE_ID].out++;
+            v_set.insert(pso[s].s);
+            p_set.insert(pso[s].p);
+
+            // vid's preds count
+            tbb::concurrent_hash_map<sid_t, uint64_t>::accessor oa;
+            if (vp_meta[OUT].insert(oa, pso[s].s))
+                oa->second = 1;
+            else
+                oa->second += 1;
+            oa.release();
+            // count vid's all predicates OUT (number of value in the segment)
+            normal_cnt_map[PREDICATE_ID].out++;
 #endif
 
-                // count #edge of predicate
-                normal_cnt_map[pso[s].p].out += (e - s);
+            // count #edge of predicate
+            normal_cnt_map[pso[s].p].out += (e - s);
+#if TRDF_MODE
+            mark_timed(pso, s, e, normal_cnt_map[pso[s].p]);
+#endif
 
-                // count #edge of predicate-idx
-                index_cnt_map[pso[s].p].in++;
+            // count #edge of predicate-idx
+            index_cnt_map[pso[s].p].in++;
 
-                // count #edge of type-idx
-                if (pso[s].p == TYPE_ID && is_tpid(pso[s].o)) {
+            // count #edge of type-idx
+            if (pso[s].p == TYPE_ID && is_tpid(pso[s].o)) {
 #ifdef VERSATILE
-                    t_set.insert(pso[s].o);
+                t_set.insert(pso[s].o);
 #endif
-                    index_cnt_map[pso[s].o].in++;
-                }
-                s = e;
+                index_cnt_map[pso[s].o].in++;
             }
+            s = e;
+        }
 
-            // skip type triples
-            uint64_t type_triples = 0;
-            triple_t tp;
-            while (type_triples < pos.size() && is_tpid(pos[type_triples].o)) {
-                type_triples++;
-            }
+        // skip type triples
+        uint64_t type_triples = 0;
+        triple_t tp;
+        while (type_triples < pos.size() && is_tpid(pos[type_triples].o)) {
+            type_triples++;
+        }
 
-            s = type_triples;
-            while (s < pos.size()) {
-                // predicate-based key (object + predicate)
-                uint64_t e = s + 1;
-                while ((e < pos.size()) && (pos[s].o == pos[e].o) && (pos[s].p == pos[e].p)) {
-                    e++;
-                }
+        s = type_triples;
+        while (s < pos.size()) {
+            // predicate-based key (object + predicate)
+            uint64_t e = s + 1;
+            while ((e < pos.size()) && (pos[s].o == pos[e].o) && (pos[s].p == pos[e].p)) {
+                e++;
+            }
 #ifdef VERSATILE
-                v_set.insert(pos[s].o);
-                p_set.insert(pos[s].p);
-                tbb::concurrent_hash_map<sid_t, uint64_t>::accessor ia;
-                if (vp_meta[IN].insert(ia, pos[s].o))
-                    ia->second = 1;
-                else
-                    ia->second += 1;
-                ia.release();
-                // count vid's all predicates IN (number of value in the segment)
-                normal_cnt_map[PREDICATE_ID].in++;
+            v_set.insert(pos[s].o);
+            p_set.insert(pos[s].p);
+            tbb::concurrent_hash_map<sid_t, uint64_t>::accessor ia;
+            if (vp_meta[IN].insert(ia, pos[s].o))
+                ia->second = 1;
+            else
+                ia->second += 1;
+            ia.release();
+            // count vid's all predicates IN (number of value in the segment)
+            normal_cnt_map[PREDICATE_ID].in++;
 #endif
 
-                // count #edge of predicate
-                normal_cnt_map[pos[s].p].in += (e - s);
-                index_cnt_map[pos[s].p].out++;
-                s = e;
-            }
+            // count #edge of predicate
+            normal_cnt_map[pos[s].p].in += (e - s);
+#if TRDF_MODE
+            mark_timed(pos, s, e, normal_cnt_map[pos[s].p]);
+#endif
+            index_cnt_map[pos[s].p].out++;
+            s = e;
+        }
 
-            s = 0;
-            while (s < sav.size()) {
-                uint64_t e = s + 1;
+        s = 0;
+        while (s < sav.size()) {
+            uint64_t e = s + 1;
 
-                while ((e < sav.size()) && (sav[s].s == sav[e].s) && (sav[s].a == sav[e].a)) {
-                    e++;
-                }
+            while ((e < sav.size()) && (sav[s].s == sav[e].s) && (sav[s].a == sav[e].a)) {
+                e++;
+            }
 
-                // count #edge of predicate
-                normal_cnt_map[sav[s].a].out += (e - s);
+            // count #edge of predicate
+            normal_cnt_map[sav[s].a].out += (e - s);
 
-                s = e;
+            s = e;
+        }
+    }
+
+#if TRDF_MODE
+    // mark the predicate of triples[s, e) temporal if any of them has a valid time
+    void mark_timed(const std::vector<triple_t>& triples, uint64_t s, uint64_t e, cnt_t& cnt) {
+        if (cnt.timed.load()) return;
+        for (uint64_t i = s; i < e; i++) {
+            if (triples[i].ts != TIMESTAMP_MIN || triples[i].te != TIMESTAMP_MAX) {
+                cnt.timed = true;
+                return;
             }
         }
+    }
+#endif
 
+    /**
+     * @brief allocate buckets and entries to segments by the counters
+     */
+    void alloc_segs(std::map<sid_t, cnt_t>& normal_cnt_map,
+                    std::map<sid_t, cnt_t>& index_cnt_map) {
         // count the total number of keys
         uint64_t total_num_keys = 0;
 #ifdef VERSATILE
@@ -883,6 +980,15 @@ protected:
             out_seg.num_keys = (out_seg.num_edges == 0) ? 0 : normal_nkeys[OUT];
             in_seg.num_keys = (in_seg.num_edges == 0) ? 0 : normal_nkeys[IN];
 
+#if TRDF_MODE
+            // the index segments have no timestamps, except the type index (IN),
+            // which copies those of the type triples (see collect_idx_info)
+            out_seg.temporal = normal_cnt_map[pred].timed && out_seg.num_edges > 0;
+            in_seg.temporal = normal_cnt_map[pred].timed && in_seg.num_edges > 0;
+            if (pred == TYPE_ID && out_seg.temporal)
+                idx_in_seg.temporal = true;
+#endif
+
             // allocate space for edges in entry-region
             alloc_entries_to_seg(out_seg);
             alloc_entries_to_seg(in_seg);
@@ -943,6 +1049,26 @@ protected:
                idx_in_seg.num_keys, idx_in_seg.num_buckets, idx_in_seg.num_edges, main_hdr_off);
     }
 
+    /**
+     * @brief init metadata for each segment
+     * 
+     * @param triple_pso pso triple data
+     * @param triple_pos pos triple data
+     * @param triple_sav attribute triple data
+     */
+    void init_seg_metas(const std::vector<std::vector<triple_t>>& triple_pso,
+                        const std::vector<std::vector<triple_t>>& triple_pos,
+                        const std::vector<std::vector<triple_attr_t>>& triple_sav) {
+        std::map<sid_t, cnt_t> normal_cnt_map, index_cnt_map;
+        init_seg_counters(normal_cnt_map, index_cnt_map);
+
+        #pragma omp parallel for num_threads(Global::num_engines)
+        for (int tid = 0; tid < Global::num_engines; tid++)
+            count_triples(triple_pso[tid], triple_pos[tid], triple_sav[tid], normal_cnt_map, index_cnt_map);
+
+        alloc_segs(normal_cnt_map, index_cnt_map);
+    }
+
     /**
      * @brief collect index data for a slot
      * 
@@ -963,7 +1089,7 @@ protected:
                 tbb_edge_hash_map::accessor a;
                 pidx_out_map.insert(a, pid);
             #if TRDF_MODE
-                a->second.push_back(edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
+                a->second.push_back(time_edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
             #else
                 a->second.push_back(edge_t(vid));
             #endif
@@ -971,12 +1097,18 @@ protected:
         } else {
             if (pid == PREDICATE_ID) {
             } else if (pid == TYPE_ID) {
+            #if TRDF_MODE
+                const edge_time_t* times = this->gstore->get_times(off, &rdf_seg_meta_map[segid_t(0, TYPE_ID, OUT)]);
+            #endif
                 // type-index (IN) -> vid_list
                 for (uint64_t e = 0; e < sz; e++) {
                     tbb_edge_hash_map::accessor a;
                     tidx_map.insert(a, this->gstore->values[off + e].val);
                 #if TRDF_MODE
-                    a->second.push_back(edge_t(vid, this->gstore->values[off + e].ts, this->gstore->values[off + e].te));
+                    if (times != nullptr)
+                        a->second.push_back(time_edge_t(vid, times[e].ts, times[e].te));
+                    else
+                        a->second.push_back(time_edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
                 #else
                     a->second.push_back(edge_t(vid));
                 #endif
@@ -985,7 +1117,7 @@ protected:
                 tbb_edge_hash_map::accessor a;
                 pidx_in_map.insert(a, pid);
             #if TRDF_MODE
-                a->second.push_back(edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
+                a->second.push_back(time_edge_t(vid, TIMESTAMP_MIN, TIMESTAMP_MAX));
             #else
                 a->second.push_back(edge_t(vid));
             #endif
@@ -1009,13 +1141,14 @@ protected:
             ikey_t(0, pid, d),
             iptr_t(sz, off));
 
+    #if TRDF_MODE
+        const rdf_seg_meta_t& segment = rdf_seg_meta_map[segid_t(1, PREDICATE_ID, d)];
+    #endif
         for (auto const& value : set) {
         #if TRDF_MODE
-            edge_t edge(value, TIMESTAMP_MIN, TIMESTAMP_MAX);
-        #else
-            edge_t edge(value);
+            set_time(segment, off, edge_time_t(TIMESTAMP_MIN, TIMESTAMP_MAX));
         #endif
-            this->gstore->values[off++] = edge;
+            this->gstore->values[off++] = edge_t(value);
         }
     }
 #endif  // VERSATILE
@@ -1071,6 +1204,64 @@ protected:
         }
     }
 
+    /**
+     * @brief serialize predicate lists and (all fields of) segment metadata for snapshot
+     */
+    std::string dump_snapshot_meta() {
+        std::stringstream ss;
+        boost::archive::binary_oarchive oa(ss);
+        oa << this->predicates << this->attributes
+           << this->edge_predicates << this->type_predicates
+           << this->attr_type_dim_map << this->num_segments;
+
+        uint64_t num_metas = rdf_seg_meta_map.size();
+        oa << num_metas;
+        for (auto const& e : rdf_seg_meta_map) {
+            const segid_t& segid = e.first;
+            const rdf_seg_meta_t& seg = e.second;
+            int dir = segid.dir;
+            oa << segid.index << segid.pid << dir;
+            oa << seg.num_keys << seg.num_buckets << seg.bucket_start
+               << seg.num_edges << seg.edge_start << seg.edge_off
+               << seg.num_key_blks << seg.num_value_blks << seg.ext_bucket_list;
+#ifdef USE_GPU
+            oa << seg.ext_bucket_list_sz;
+#endif
+#ifdef TRDF_MODE
+            oa << seg.temporal << seg.time_start;
+#endif
+        }
+        return ss.str();
+    }
+
+    void load_snapshot_meta(const std::string& meta) {
+        std::stringstream ss(meta);
+        boost::archive::binary_iarchive ia(ss);
+        ia >> this->predicates >> this->attributes
+           >> this->edge_predicates >> this->type_predicates
+           >> this->attr_type_dim_map >> this->num_segments;
+
+        uint64_t num_metas;
+        ia >> num_metas;
+        for (uint64_t i = 0; i < num_metas; i++) {
+            segid_t segid;
+            rdf_seg_meta_t seg;
+            int dir;
+            ia >> segid.index >> segid.pid >> dir;
+            segid.dir = (dir_t) dir;
+            ia >> seg.num_keys >> seg.num_buckets >> seg.bucket_start
+               >> seg.num_edges >> seg.edge_start >> seg.edge_off
+               >> seg.num_key_blks >> seg.num_value_blks >> seg.ext_bucket_list;
+#ifdef USE_GPU
+            ia >> seg.ext_bucket_list_sz;
+#endif
+#ifdef TRDF_MODE
+            ia >> seg.temporal >> seg.time_start;
+#endif
+            rdf_seg_meta_map[segid] = seg;
+        }
+    }
+
     /**
      * @brief re-adjust attributes of segments (for GPU)
      */
@@ -1122,12 +1313,48 @@ public:
         return gstore->get_values(tid, dst_sid, ikey_t(vid, pid, d), sz, seg);
     }
 
+    void get_triples_batch(int tid, const std::vector<sid_t>& vids, sid_t pid, dir_t d,
+                           std::vector<edge_t*>& edges, std::vector<uint64_t>& szs,
+                           std::vector<edge_t>& remote_edges) override {
+        // all local vertices share the same segment
+        rdf_seg_meta_t* seg = &rdf_seg_meta_map[segid_t(0, pid, d)];
+        get_local_triples_batch(tid, vids, pid, d, edges, szs, remote_edges, seg);
+    }
+
     edge_t* get_index(int tid, sid_t pid, dir_t d, uint64_t& sz) override {
         // index vertex should be 0 and always local
         rdf_seg_meta_t* seg = &rdf_seg_meta_map[segid_t(ikey_t(0, pid, d))];
         return gstore->get_values(tid, this->sid, ikey_t(0, pid, d), sz, seg);
     }
 
+#ifdef TRDF_MODE
+    edge_t* get_timed_triples(int tid, sid_t vid, sid_t pid, dir_t d, uint64_t& sz,
+                              edge_time_t*& times) override {
+        rdf_seg_meta_t* seg;
+        int dst_sid = PARTITION(vid);
+        if (dst_sid == sid) {
+            seg = &rdf_seg_meta_map[segid_t(ikey_t(vid, pid, d))];
+        } else {
+            seg = &shared_rdf_seg_meta_map[dst_sid][segid_t(ikey_t(vid, pid, d))];
+        }
+        return gstore->get_timed_values(tid, dst_sid, ikey_t(vid, pid, d), sz, times, seg);
+    }
+
+    edge_t* get_timed_index(int tid, sid_t pid, dir_t d, uint64_t& sz, edge_time_t*& times) override {
+        // index vertex should be 0 and always local
+        rdf_seg_meta_t* seg = &rdf_seg_meta_map[segid_t(ikey_t(0, pid, d))];
+        return gstore->get_timed_values(tid, this->sid, ikey_t(0, pid, d), sz, times, seg);
+    }
+
+    // only temporal segments reserve timestamps (see rdf_seg_meta_t)
+    edge_time_t* get_local_times(ikey_t key, uint64_t off) override {
+        auto it = rdf_seg_meta_map.find(segid_t(key));
+        if (it == rdf_seg_meta_map.end())
+            return nullptr;
+        return gstore->get_times(off, &it->second);
+    }
+#endif
+
     // return attribute value (has_value == true)
     attr_t get_attr(int tid, sid_t vid, sid_t pid, dir_t d, bool& has_value) override {
         uint64_t sz = 0;
@@ -1179,6 +1406,157 @@ public:
         recv_seg_meta(con_adaptor);
     }
 
+    bool dump_snapshot(std::string dname) override {
+        std::string fname = snapshot_fname(dname, sid);
+        auto kvstore = std::dynamic_pointer_cast<StaticKVStore<ikey_t, iptr_t, edge_t>>(gstore);
+        ASSERT(kvstore != nullptr);
+
+        uint64_t start = timer::get_usec();
+        snapshot_header_t hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        strncpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+        hdr.version = SNAPSHOT_VERSION;
+        hdr.flags = snapshot_flags();
+        hdr.sid = sid;
+        hdr.num_servers = Global::num_servers;
+        hdr.slot_sz = sizeof(RDFStore::slot_t);
+        hdr.value_sz = sizeof(edge_t);
+        hdr.kvs_sz = kv_mem.kvs_sz;
+        hdr.last_ext = gstore->last_ext;
+        hdr.last_entry = kvstore->last_entry;
+
+        std::string meta = dump_snapshot_meta();
+        hdr.meta_off = snapshot_align(sizeof(hdr));
+        hdr.meta_sz = meta.size();
+        hdr.slots_off = snapshot_align(hdr.meta_off + hdr.meta_sz);
+        hdr.slots_sz = (gstore->num_buckets + gstore->last_ext) * RDFStore::ASSOCIATIVITY * sizeof(RDFStore::slot_t);
+        hdr.values_off = snapshot_align(hdr.slots_off + hdr.slots_sz);
+        hdr.values_sz = kvstore->last_entry * sizeof(edge_t);
+
+        // write a temporary file and rename it, which never leaves a partial snapshot
+        std::string tmp_fname = fname + ".tmp";
+        int fd = open(tmp_fname.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+        if (fd < 0) {
+            logstream(LOG_ERROR) << "[Snapshot] #" << sid << ": failed to create " << tmp_fname << LOG_endl;
+            return false;
+        }
+
+        uint64_t hdr_checksum;
+        bool ok = snapshot_pwrite(fd, meta.data(), hdr.meta_sz, hdr.meta_off, hdr.meta_checksum)
+                  && snapshot_pwrite(fd, reinterpret_cast<char*>(gstore->slots), hdr.slots_sz,
+                                     hdr.slots_off, hdr.slots_checksum)
+                  && snapshot_pwrite(fd, reinterpret_cast<char*>(gstore->values), hdr.values_sz,
+                                     hdr.values_off, hdr.values_checksum)
+                  // the header (w/ checksums) is written at last
+                  && snapshot_pwrite(fd, reinterpret_cast<char*>(&hdr), sizeof(hdr), 0, hdr_checksum)
+                  && (fsync(fd) == 0);
+        close(fd);
+        if (!ok || rename(tmp_fname.c_str(), fname.c_str()) != 0) {
+            logstream(LOG_ERROR) << "[Snapshot] #" << sid << ": failed to write " << fname << LOG_endl;
+            unlink(tmp_fname.c_str());
+            return false;
+        }
+
+        uint64_t end = timer::get_usec();
+        uint64_t total_sz = hdr.values_off + hdr.values_sz;
+        logstream(LOG_INFO) << "[Snapshot] #" << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for dumping " << B2MiB(total_sz) << "MB gstore to " << fname
+                            << " (" << total_sz / std::max(1UL, end - start) << "MB/s)" << LOG_endl;
+        return true;
+    }
+
+    bool read_snapshot(std::string dname) override {
+        std::string fname = snapshot_fname(dname, sid);
+        auto kvstore = std::dynamic_pointer_cast<StaticKVStore<ikey_t, iptr_t, edge_t>>(gstore);
+        ASSERT(kvstore != nullptr);
+
+        uint64_t start = timer::get_usec();
+        int fd = open(fname.c_str(), O_RDONLY);
+        if (fd < 0) {
+            logstream(LOG_WARNING) << "[Snapshot] #" << sid << ": " << fname << " does not exist." << LOG_endl;
+            return false;
+        }
+
+        // check the layout version and the configuration
+        snapshot_header_t hdr;
+        std::string err;
+        if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)
+                || strncmp(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic)) != 0)
+            err = "not a snapshot";
+        else if (hdr.version != SNAPSHOT_VERSION || hdr.flags != snapshot_flags()
+                 || hdr.slot_sz != sizeof(RDFStore::slot_t) || hdr.value_sz != sizeof(edge_t))
+            err = "mismatched layout version";
+        else if (hdr.sid != sid || hdr.num_servers != Global::num_servers)
+            err = "mismatched number of servers";
+        else if (hdr.kvs_sz != kv_mem.kvs_sz)
+            err = "mismatched global_memstore_size_gb";
+        else if (hdr.last_ext > gstore->num_buckets_ext || hdr.last_entry > kvstore->num_entries
+                 || hdr.slots_sz != (gstore->num_buckets + hdr.last_ext) * RDFStore::ASSOCIATIVITY * sizeof(RDFStore::slot_t)
+                 || hdr.values_sz != hdr.last_entry * sizeof(edge_t)
+                 || hdr.meta_off + hdr.meta_sz > hdr.slots_off
+                 || hdr.slots_off + hdr.slots_sz > hdr.values_off)
+            err = "invalid header";
+
+        // bulk-read sections into the KV region
+        std::string meta;
+        uint64_t checksum;
+        if (err.empty()) meta.resize(hdr.meta_sz);
+        if (err.empty() && !(snapshot_pread(fd, &meta[0], hdr.meta_sz, hdr.meta_off, checksum)
+                             && checksum == hdr.meta_checksum))
+            err = "corrupted metadata";
+        if (err.empty() && !(snapshot_pread(fd, reinterpret_cast<char*>(gstore->slots), hdr.slots_sz,
+                                            hdr.slots_off, checksum)
+                             && checksum == hdr.slots_checksum))
+            err = "corrupted slots";
+        if (err.empty() && !(snapshot_pread(fd, reinterpret_cast<char*>(gstore->values), hdr.values_sz,
+                                            hdr.values_off, checksum)
+                             && checksum == hdr.values_checksum))
+            err = "corrupted values";
+        close(fd);
+
+        if (err.empty()) {
+            try {
+                load_snapshot_meta(meta);
+            } catch (boost::archive::archive_exception& e) {
+                err = "corrupted metadata";
+            }
+        }
+
+        if (!err.empty()) {
+            logstream(LOG_WARNING) << "[Snapshot] #" << sid << ": failed to restore gstore from "
+                                   << fname << " (" << err << ")" << LOG_endl;
+            abort_snapshot();
+            return false;
+        }
+
+        gstore->last_ext = hdr.last_ext;
+        kvstore->last_entry = hdr.last_entry;
+
+        uint64_t end = timer::get_usec();
+        uint64_t total_sz = hdr.values_off + hdr.values_sz;
+        logstream(LOG_INFO) << "[Snapshot] #" << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for reading " << B2MiB(total_sz) << "MB gstore from " << fname
+                            << " (" << total_sz / std::max(1UL, end - start) << "MB/s)" << LOG_endl;
+        return true;
+    }
+
+    void commit_snapshot() override {
+        // synchronize segment metadata among servers
+        sync_metadata();
+
+        print_graph_stat();
+    }
+
+    void abort_snapshot() override {
+        gstore->refresh();
+        this->predicates.clear();
+        this->attributes.clear();
+        this->edge_predicates.clear();
+        this->type_predicates.clear();
+        this->attr_type_dim_map.clear();
+        rdf_seg_meta_map.clear();
+    }
+
     void init_gstore(std::vector<std::vector<triple_t>>& triple_pso,
                      std::vector<std::vector<triple_t>>& triple_pos,
                      std::vector<std::vector<triple_attr_t>>& triple_sav) override {
@@ -1197,8 +1575,10 @@ public:
         for (int tid = 0; tid < Global::num_engines; tid++) {
             insert_vp(tid, triple_pso[tid], triple_pos[tid]);
             // Re-sort triples array by pso to accelarate normal triples insert.
-            std::sort(triple_pso[tid].begin(), triple_pso[tid].end(), triple_sort_by_pso());
-            std::sort(triple_pos[tid].begin(), triple_pos[tid].end(), triple_sort_by_pos());
+            // (spo/ops -> pso/pos only requires a stable sort on p)
+            std::vector<triple_t> tmp;
+            resort_triples_by_p(triple_pso[tid], tmp);
+            resort_triples_by_p(triple_pos[tid], tmp);
         }
         end = timer::get_usec();
         logstream(LOG_INFO) << "[SegmentRDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
@@ -1229,6 +1609,97 @@ public:
         logstream(LOG_INFO) << "[SegmentRDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
                             << "for inserting normal triples as segments into gstore" << LOG_endl;
 
+        insert_attr_and_idx(triple_sav);
+    }
+
+    /**
+     * @brief initialize gstore with sorted runs on disk (bounded-memory loading)
+     * 
+     * The runs of each engine are merged twice by chunks: the first pass counts
+     * triples to allocate segments, and the second pass inserts triples into
+     * segments. The run files are removed after inserted. If any run fails to be
+     * read, no more triples are inserted and false is returned, while segment
+     * metadata is still synchronized among servers (see insert_attr_and_idx).
+     */
+    bool init_gstore_from_runs(std::vector<TripleRuns>& runs_pso,
+                               std::vector<TripleRuns>& runs_pos,
+                               std::vector<std::vector<triple_attr_t>>& triple_sav) override {
+        this->num_segments = get_num_normal_preds() * PREDICATE_NSEGS + INDEX_NSEGS + this->get_num_attr_preds();
+
+        // a chunk and the read buffers of a merger per engine
+        uint64_t buf_sz = std::max(MiB2B(Global::load_budget_mb) / (2 * Global::num_engines), MiB2B(1));
+        uint64_t chunk_sz = buf_sz / sizeof(triple_t);
+
+        uint64_t start, end;
+        start = timer::get_usec();
+        std::map<sid_t, cnt_t> normal_cnt_map, index_cnt_map;
+        init_seg_counters(normal_cnt_map, index_cnt_map);
+
+        uint64_t nfailed = 0;
+        #pragma omp parallel for num_threads(Global::num_engines) reduction(+ : nfailed)
+        for (int tid = 0; tid < Global::num_engines; tid++) {
+            std::vector<triple_t> chunk, empty;
+            std::vector<triple_attr_t> empty_sav;
+            {
+                TripleRunMerger merger(runs_pso[tid], buf_sz);
+                while (merger.next_chunk(chunk, chunk_sz))
+                    count_triples(chunk, empty, empty_sav, normal_cnt_map, index_cnt_map);
+                nfailed += !merger.good();
+            }
+            {
+                TripleRunMerger merger(runs_pos[tid], buf_sz);
+                while (merger.next_chunk(chunk, chunk_sz))
+                    count_triples(empty, chunk, empty_sav, normal_cnt_map, index_cnt_map);
+                nfailed += !merger.good();
+            }
+            count_triples(empty, empty, triple_sav[tid], normal_cnt_map, index_cnt_map);
+        }
+        bool counted = (nfailed == 0);
+
+        alloc_segs(normal_cnt_map, index_cnt_map);
+        end = timer::get_usec();
+        logstream(LOG_INFO) << "[SegmentRDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for initializing predicate segment statistics." << LOG_endl;
+
+        start = timer::get_usec();
+        #pragma omp parallel for num_threads(Global::num_engines) reduction(+ : nfailed)
+        for (int tid = 0; tid < Global::num_engines; tid++) {
+            std::vector<triple_t> chunk, empty;
+            if (counted) {
+                TripleRunMerger merger(runs_pso[tid], buf_sz);
+                while (merger.next_chunk(chunk, chunk_sz)) {
+#ifdef VERSATILE
+                    insert_vp(tid, chunk, empty);
+#endif
+                    insert_chunk(tid, chunk, OUT);
+                }
+                nfailed += !merger.good();
+            }
+            if (counted) {
+                TripleRunMerger merger(runs_pos[tid], buf_sz);
+                while (merger.next_chunk(chunk, chunk_sz)) {
+#ifdef VERSATILE
+                    insert_vp(tid, empty, chunk);
+#endif
+                    insert_chunk(tid, chunk, IN);
+                }
+                nfailed += !merger.good();
+            }
+            // release disk space
+            runs_pso[tid].clear();
+            runs_pos[tid].clear();
+        }
+        end = timer::get_usec();
+        logstream(LOG_INFO) << "[SegmentRDFGraph] #" << sid << ": " << (end - start) / 1000 << "ms "
+                            << "for inserting normal triples as segments into gstore" << LOG_endl;
+
+        insert_attr_and_idx(triple_sav);
+        return nfailed == 0;
+    }
+
+    // insert attr and index triples, and finalize the initialization of gstore
+    void insert_attr_and_idx(std::vector<std::vector<triple_attr_t>>& triple_sav) {
+        uint64_t start, end;
         start = timer::get_usec();
         auto attr_map = init_triple_map(triple_sav);
         #pragma omp parallel for num_threads(Global::num_engines)
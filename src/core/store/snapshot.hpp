@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "core/common/global.hpp"
+
+// utils
+#include "utils/math.hpp"
+
+namespace wukong {
+
+/**
+ * Binary snapshot of the (static) gstore on a server
+ *
+ * file: <dname>/gstore.<sid>.snap
+ *
+ * layout (each section starts at a page boundary):
+ *  | header | metadata (boost archive) | slots | values |
+ *
+ * slots: the main-header region and allocated indirect-header buckets
+ * values: the allocated entries of the entry region
+ *         (w/ the timestamps of temporal segments in TRDF_MODE, see rdf_seg_meta_t)
+ */
+
+// bump it when the layout of the snapshot or the gstore changes
+#define SNAPSHOT_VERSION 2
+
+#define SNAPSHOT_MAGIC "WKGSNAP"
+#define SNAPSHOT_ALIGN 4096
+#define SNAPSHOT_CHUNK (64UL << 20)  // 64MB per I/O or checksum task
+
+// compile options changing the layout of gstore
+enum {
+    SNAPSHOT_VERSATILE = 1 << 0,
+    SNAPSHOT_GPU = 1 << 1,
+    SNAPSHOT_TRDF = 1 << 2,
+};
+
+struct snapshot_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int32_t sid;
+    int32_t num_servers;  // vertices are partitioned by #servers
+    uint32_t slot_sz;     // sizeof(slot_t)
+    uint32_t value_sz;    // sizeof(edge_t)
+    uint64_t kvs_sz;      // the size of KV region decides #buckets
+
+    uint64_t last_ext;    // allocated buckets in the indirect-header region
+    uint64_t last_entry;  // allocated entries in the entry region
+
+    uint64_t meta_off, meta_sz, meta_checksum;
+    uint64_t slots_off, slots_sz, slots_checksum;
+    uint64_t values_off, values_sz, values_checksum;
+};
+
+static inline uint32_t snapshot_flags() {
+    uint32_t flags = 0;
+#ifdef VERSATILE
+    flags |= SNAPSHOT_VERSATILE;
+#endif
+#ifdef USE_GPU
+    flags |= SNAPSHOT_GPU;
+#endif
+#ifdef TRDF_MODE
+    flags |= SNAPSHOT_TRDF;
+#endif
+    return flags;
+}
+
+static inline std::string snapshot_fname(std::string dname, int sid) {
+    if (dname[dname.length() - 1] != '/')
+        dname = dname + "/";
+    return dname + "gstore." + std::to_string(sid) + ".snap";
+}
+
+static inline uint64_t snapshot_align(uint64_t off) {
+    return (off + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+// 64-bit checksum of a chunk (4 independent lanes)
+static inline uint64_t checksum_chunk(const char *buf, uint64_t sz) {
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+    uint64_t h[4] = {PRIME, PRIME + 1, PRIME + 2, PRIME + 3};
+    auto mix = [PRIME](uint64_t &x, uint64_t w) {
+        x = (x ^ w) * PRIME;
+        x ^= x >> 29;
+    };
+
+    uint64_t off = 0;
+    for (; off + 4 * sizeof(uint64_t) <= sz; off += 4 * sizeof(uint64_t)) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t w;
+            memcpy(&w, buf + off + l * sizeof(uint64_t), sizeof(uint64_t));
+            mix(h[l], w);
+        }
+    }
+    for (; off < sz; off += sizeof(uint64_t)) {  // the rest (zero-padded)
+        uint64_t w = 0;
+        memcpy(&w, buf + off, std::min<uint64_t>(sizeof(uint64_t), sz - off));
+        mix(h[0], w);
+    }
+
+    uint64_t r = sz;
+    for (int l = 0; l < 4; l++)
+        r = wukong::math::hash_u64(r ^ h[l]);
+    return r;
+}
+
+static inline uint64_t combine_checksums(uint64_t sz, const std::vector<uint64_t> &sums) {
+    uint64_t r = sz;
+    for (auto s : sums)
+        r = wukong::math::hash_u64(r ^ s);
+    return r;
+}
+
+/**
+ * @brief Checksum of a section, whose chunks are hashed in parallel
+ */
+static inline uint64_t snapshot_checksum(const char *buf, uint64_t sz) {
+    std::vector<uint64_t> sums((sz + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK);
+    #pragma omp parallel for num_threads(Global::num_engines)
+    for (uint64_t i = 0; i < sums.size(); i++)
+        sums[i] = checksum_chunk(buf + i * SNAPSHOT_CHUNK, std::min(SNAPSHOT_CHUNK, sz - i * SNAPSHOT_CHUNK));
+    return combine_checksums(sz, sums);
+}
+
+/**
+ * @brief Write a section to the file at the offset (chunks are written and hashed in parallel)
+ *
+ * @param checksum the checksum of the section (return value)
+ * @return false if failed to write
+ */
+static inline bool snapshot_pwrite(int fd, const char *buf, uint64_t sz, uint64_t off, uint64_t &checksum) {
+    std::vector<uint64_t> sums((sz + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK);
+    std::atomic<bool> ok(true);
+    #pragma omp parallel for num_threads(Global::num_engines)
+    for (uint64_t i = 0; i < sums.size(); i++) {
+        uint64_t start = i * SNAPSHOT_CHUNK, len = std::min(SNAPSHOT_CHUNK, sz - start);
+        sums[i] = checksum_chunk(buf + start, len);
+        for (uint64_t done = 0; done < len;) {
+            ssize_t n = pwrite(fd, buf + start + done, len - done, off + start + done);
+            if (n <= 0) {
+                ok = false;
+                break;
+            }
+            done += n;
+        }
+    }
+    checksum = combine_checksums(sz, sums);
+    return ok;
+}
+
+/**
+ * @brief Read a section from the file at the offset (chunks are read and hashed in parallel)
+ *
+ * @param checksum the checksum of the section (return value)
+ * @return false if failed to read
+ */
+static inline bool snapshot_pread(int fd, char *buf, uint64_t sz, uint64_t off, uint64_t &checksum) {
+    std::vector<uint64_t> sums((sz + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK);
+    std::atomic<bool> ok(true);
+    #pragma omp parallel for num_threads(Global::num_engines)
+    for (uint64_t i = 0; i < sums.size(); i++) {
+        uint64_t start = i * SNAPSHOT_CHUNK, len = std::min(SNAPSHOT_CHUNK, sz - start);
+        for (uint64_t done = 0; done < len;) {
+            ssize_t n = pread(fd, buf + start + done, len - done, off + start + done);
+            if (n <= 0) {
+                ok = false;
+                break;
+            }
+            done += n;
+        }
+        sums[i] = checksum_chunk(buf + start, len);
+    }
+    checksum = combine_checksums(sz, sums);
+    return ok;
+}
+
+}  // namespace wukong
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#ifdef TRDF_MODE
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "core/common/type.hpp"
+
+#include "core/store/segment_meta.hpp"
+#include "core/store/time_index.hpp"
+#include "core/store/vertex.hpp"
+
+namespace wukong {
+
+/**
+ * A materialized snapshot of the local temporal value lists (TRDF_MODE)
+ *
+ * The view keeps the edges valid in [ts, te] (see edge_time_t::valid) w/o
+ * their timestamps, so the patterns of queries FROM SNAPSHOT read them as
+ * a non-temporal graph instead of filtering the history of every key.
+ * Like SegmentRDFGraph, the edges of a segment (i.e., [index|pid|dir]) are
+ * contiguous, and the keys w/o valid edges are dropped (i.e., not found).
+ *
+ * The view is built on a loaded gstore (see DGraph::create_snapshot_view),
+ * and dropped if the gstore is changed (e.g., dynamic loading).
+ */
+class SnapshotView {
+public:
+    int64_t ts;
+    int64_t te;
+
+    SnapshotView(int64_t ts, int64_t te) : ts(ts), te(te) {}
+
+    /**
+     * @brief Materialize the (local) normal and index value lists of gstore
+     *
+     * @param index the time-interval index of gstore
+     * @param times_of the timestamps of the value list at given offset of the key
+     *                 (nullptr: w/o timestamps, i.e., all edges are valid)
+     */
+    template <class Store, class TimesOf>
+    void build(Store &gstore, const TimeIndex &index, TimesOf times_of) {
+        struct entry_t {
+            segid_t segid;
+            ikey_t key;
+            iptr_t ptr;     // the value list in gstore
+            uint64_t nvalid;
+        };
+
+        // collect the keys w/ valid edges
+        std::vector<entry_t> entries;
+        std::vector<uint64_t> pos;
+        uint64_t total_buckets = gstore.num_buckets + gstore.num_buckets_ext;
+        for (uint64_t bucket_id = 0; bucket_id < total_buckets; bucket_id++) {
+            uint64_t slot_id = bucket_id * Store::ASSOCIATIVITY;
+            for (int i = 0; i < Store::ASSOCIATIVITY - 1; i++, slot_id++) {
+                auto &slot = gstore.slots[slot_id];
+                if (slot.key.is_empty() || slot.ptr.type != SID_t)
+                    continue;
+
+                index.valid_edges(slot.key, times_of(slot.key, slot.ptr.off), slot.ptr.size, ts, te, pos);
+                if (pos.size() > 0)
+                    entries.push_back({segid_t(slot.key), slot.key, slot.ptr, pos.size()});
+            }
+        }
+
+        // place the edges segment by segment
+        std::stable_sort(entries.begin(), entries.end(), [](const entry_t &a, const entry_t &b) {
+            return a.segid < b.segid;
+        });
+        uint64_t nedges = 0;
+        for (auto const &e : entries)
+            nedges += e.nvalid;
+
+        clear();
+        edges.reserve(nedges);
+        keys.reserve(entries.size());
+        for (auto const &e : entries) {
+            rdf_seg_meta_t &seg = segs[e.segid];
+            if (seg.num_keys == 0)
+                seg.edge_start = edges.size();
+            seg.num_keys++;
+            seg.num_edges += e.nvalid;
+
+            const edge_t *vals = &gstore.values[e.ptr.off];
+            index.valid_edges(e.key, times_of(e.key, e.ptr.off), e.ptr.size, ts, te, pos);
+            keys[e.key] = iptr_t(pos.size(), edges.size());
+            for (uint64_t k : pos)
+                edges.push_back(vals[k]);
+        }
+    }
+
+    // the value lists w/o segments share the time region of gstore (see KVStore::reserve_times)
+    template <class Store>
+    void build(Store &gstore, const TimeIndex &index) {
+        build(gstore, index, [&gstore](ikey_t key, uint64_t off) { return gstore.get_times(off); });
+    }
+
+    /**
+     * @brief Get the edges of given key valid in the snapshot
+     *
+     * @param key given key
+     * @param sz value size(return value)
+     * @return edge_t* value address (nullptr if not found)
+     */
+    edge_t *get_values(ikey_t key, uint64_t &sz) {
+        auto it = keys.find(key);
+        if (it == keys.end()) {
+            sz = 0;
+            return nullptr;  // not found
+        }
+        sz = it->second.size;
+        return &edges[it->second.off];
+    }
+
+    void clear() {
+        edges.clear();
+        keys.clear();
+        segs.clear();
+    }
+
+    uint64_t num_keys() const { return keys.size(); }
+
+    uint64_t num_edges() const { return edges.size(); }
+
+    // the memory usage of the view (bytes), estimating the buckets of keys by a pointer
+    uint64_t mem_usage() const {
+        return edges.size() * sizeof(edge_t)
+               + keys.size() * (sizeof(ikey_t) + sizeof(iptr_t) + sizeof(void *));
+    }
+
+    inline const std::map<segid_t, rdf_seg_meta_t> &get_seg_metas() const { return segs; }
+
+private:
+    struct key_hash {
+        size_t operator()(const ikey_t &key) const { return key.hash(); }
+    };
+
+    std::vector<edge_t> edges;
+    boost::unordered_map<ikey_t, iptr_t, key_hash> keys;  // the value lists in edges
+    std::map<segid_t, rdf_seg_meta_t> segs;               // the edges of each segment
+};
+
+/**
+ * The snapshot views of a server, which are evicted in LRU order to keep
+ * their memory usage under the budget (see Global::snapshot_view_size_mb).
+ * The views are shared w/ the engines, so an evicted view is freed after
+ * the patterns reading it are done.
+ */
+class SnapshotViews {
+public:
+    SnapshotViews() { pthread_spin_init(&lock, 0); }
+
+    /// the view of [ts, te] (nullptr if not materialized)
+    std::shared_ptr<SnapshotView> get(int64_t ts, int64_t te) {
+        pthread_spin_lock(&lock);
+        for (auto it = views.begin(); it != views.end(); it++) {
+            if ((*it)->ts == ts && (*it)->te == te) {
+                views.splice(views.begin(), views, it);  // most recently used
+                std::shared_ptr<SnapshotView> view = views.front();
+                pthread_spin_unlock(&lock);
+                return view;
+            }
+        }
+        pthread_spin_unlock(&lock);
+        return nullptr;
+    }
+
+    /**
+     * @brief Add (or replace) a view, and evict the least recently used ones
+     *        beyond the budget
+     *
+     * @param budget the max memory usage of views (bytes)
+     * @return false if the view alone exceeds the budget (not added)
+     */
+    bool add(std::shared_ptr<SnapshotView> view, uint64_t budget) {
+        if (view->mem_usage() > budget)
+            return false;
+
+        std::list<std::shared_ptr<SnapshotView>> evicted;  // freed w/o the lock
+        pthread_spin_lock(&lock);
+        remove(view->ts, view->te, evicted);
+        views.push_front(view);
+        usage += view->mem_usage();
+        while (usage > budget) {
+            usage -= views.back()->mem_usage();
+            evicted.splice(evicted.begin(), views, std::prev(views.end()));
+        }
+        pthread_spin_unlock(&lock);
+        return true;
+    }
+
+    /// drop the view of [ts, te] (false if not materialized)
+    bool drop(int64_t ts, int64_t te) {
+        std::list<std::shared_ptr<SnapshotView>> evicted;  // freed w/o the lock
+        pthread_spin_lock(&lock);
+        bool found = remove(ts, te, evicted);
+        pthread_spin_unlock(&lock);
+        return found;
+    }
+
+    void clear() {
+        std::list<std::shared_ptr<SnapshotView>> evicted;  // freed w/o the lock
+        pthread_spin_lock(&lock);
+        evicted.swap(views);
+        usage = 0;
+        pthread_spin_unlock(&lock);
+    }
+
+    /// the views from the most recently used one
+    std::vector<std::shared_ptr<SnapshotView>> list() {
+        pthread_spin_lock(&lock);
+        std::vector<std::shared_ptr<SnapshotView>> r(views.begin(), views.end());
+        pthread_spin_unlock(&lock);
+        return r;
+    }
+
+    // the memory usage of views (bytes)
+    uint64_t mem_usage() {
+        pthread_spin_lock(&lock);
+        uint64_t r = usage;
+        pthread_spin_unlock(&lock);
+        return r;
+    }
+
+private:
+    pthread_spinlock_t lock;
+    std::list<std::shared_ptr<SnapshotView>> views;  // in LRU order (the front is most recent)
+    uint64_t usage = 0;
+
+    // move the view of [ts, te] to evicted, which is freed by the caller w/o the lock
+    // NOTICE! This function is not thread-safe.
+    bool remove(int64_t ts, int64_t te, std::list<std::shared_ptr<SnapshotView>> &evicted) {
+        for (auto it = views.begin(); it != views.end(); it++) {
+            if ((*it)->ts == ts && (*it)->te == te) {
+                usage -= (*it)->mem_usage();
+                evicted.splice(evicted.begin(), views, it);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace wukong
+
+#endif  // TRDF_MODE
@@ -41,6 +41,8 @@ namespace wukong {
  */
 template <class KeyType, class PtrType, class ValueType>
 class StaticKVStore : public KVStore<KeyType, PtrType, ValueType> {
+    friend class SegmentRDFGraph;
+
 protected:
     // allocation offset of value entry
     uint64_t last_entry;
@@ -48,6 +50,7 @@ protected:
     pthread_spinlock_t entry_lock;
 
     using slot_t = typename KVStore<KeyType, PtrType, ValueType>::slot_t;
+    using InsertValueType = typename KVStore<KeyType, PtrType, ValueType>::InsertValueType;
 
     uint64_t alloc_entries(uint64_t num_values, int tid = 0) override {
         uint64_t orig;
@@ -77,7 +80,7 @@ public:
 
     ~StaticKVStore() {}
 
-    bool insert_key_value(KeyType key, ValueType value, bool& dedup_or_isdup, int tid) override {
+    bool insert_key_value(KeyType key, InsertValueType value, bool& dedup_or_isdup, int tid) override {
         // static kvstore doesn't support inserting kv-pair dynamically
         ASSERT(false);
     }
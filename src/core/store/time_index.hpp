@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#ifdef TRDF_MODE
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "core/common/type.hpp"
+
+#include "core/store/vertex.hpp"
+
+namespace wukong {
+
+/**
+ * The time-interval index of temporal value lists (TRDF_MODE)
+ *
+ * The value lists are sorted by vertex IDs (see sort_normal_triples), so
+ * finding the edges valid in [ts, te] (see edge_time_t::valid) scans the
+ * timestamps of the whole history of a key. For the local keys w/ at least
+ * #threshold edges, the index groups the positions of edges by the classes
+ * of their durations (i.e., [2^(c-1), 2^c)), and sorts them by start
+ * timestamps in each class.
+ * The edges valid in [ts, te] of a class start in [ts - max_len, te], which
+ * is found by binary search, and at most half of them ended before ts.
+ * So a probe tracks the number of valid edges instead of the history.
+ *
+ * The index is built after loading (see DGraph::build_time_index), and
+ * a probe falls back to scanning if the value list has been moved or
+ * resized since then (e.g., dynamic loading).
+ */
+class TimeIndex {
+public:
+    struct interval_list_t {
+        const edge_time_t *times = nullptr;  // the timestamps of the indexed value list
+        uint64_t sz = 0;
+
+        // the edges (positions) sorted by (class, start)
+        std::vector<int64_t> starts;
+        std::vector<uint32_t> order;
+
+        std::vector<uint64_t> class_offs;  // the first edge of each class (and the end)
+        std::vector<uint64_t> max_lens;    // the max duration of each class
+    };
+
+    static void build_list(const edge_time_t *times, uint64_t sz, interval_list_t &list) {
+        // the duration class of an edge (malformed edges are never valid but for all time)
+        auto duration = [times](uint32_t k) -> uint64_t {
+            return (uint64_t)times[k].te - (uint64_t)times[k].ts;
+        };
+        auto class_of = [&duration](uint32_t k) -> int {
+            uint64_t len = duration(k);
+            return (len == 0) ? 0 : (64 - __builtin_clzll(len));
+        };
+
+        list.times = times;
+        list.sz = sz;
+        list.order.clear();
+        for (uint32_t k = 0; k < sz; k++)
+            if (times[k].ts <= times[k].te)
+                list.order.push_back(k);
+        std::vector<int> classes(sz, 0);
+        for (uint32_t k : list.order)
+            classes[k] = class_of(k);
+        std::stable_sort(list.order.begin(), list.order.end(), [&](uint32_t a, uint32_t b) {
+            if (classes[a] != classes[b]) return classes[a] < classes[b];
+            return times[a].ts < times[b].ts;
+        });
+
+        list.starts.resize(list.order.size());
+        list.class_offs.clear();
+        list.max_lens.clear();
+        for (uint64_t j = 0; j < list.order.size(); j++) {
+            uint32_t k = list.order[j];
+            list.starts[j] = times[k].ts;
+            if (j == 0 || classes[k] != classes[list.order[j - 1]]) {
+                list.class_offs.push_back(j);
+                list.max_lens.push_back(0);
+            }
+            list.max_lens.back() = std::max(list.max_lens.back(), duration(k));
+        }
+        list.class_offs.push_back(list.order.size());
+    }
+
+    /**
+     * @brief the positions of edges valid in [ts, te] (ascending), which
+     *        are the same as scanning the value list w/ edge_time_t::valid
+     */
+    static void probe_list(const interval_list_t &list, int64_t ts, int64_t te,
+                           std::vector<uint64_t> &pos) {
+        pos.clear();
+        if (ts == TIMESTAMP_MIN && te == TIMESTAMP_MAX) {  // all
+            pos.resize(list.sz);
+            std::iota(pos.begin(), pos.end(), 0);
+            return;
+        }
+        if (ts > te) return;
+
+        for (uint64_t c = 0; c < list.max_lens.size(); c++) {
+            // the edges of the class starting in [ts - max_len, te]
+            int64_t min_start = ((uint64_t)ts - (uint64_t)TIMESTAMP_MIN <= list.max_lens[c])
+                                ? TIMESTAMP_MIN : (int64_t)((uint64_t)ts - list.max_lens[c]);
+            auto first = list.starts.begin() + list.class_offs[c];
+            auto last = list.starts.begin() + list.class_offs[c + 1];
+            first = std::lower_bound(first, last, min_start);
+            last = std::upper_bound(first, last, te);
+
+            for (uint64_t j = first - list.starts.begin(); j < last - list.starts.begin(); j++)
+                if (list.times[list.order[j]].te >= ts)
+                    pos.push_back(list.order[j]);
+        }
+        std::sort(pos.begin(), pos.end());  // in the order of the value list
+    }
+
+    static void scan_list(const edge_time_t *times, uint64_t sz, int64_t ts, int64_t te,
+                          std::vector<uint64_t> &pos) {
+        pos.clear();
+        for (uint64_t k = 0; k < sz; k++)
+            if (times[k].valid(ts, te))
+                pos.push_back(k);
+    }
+
+    /**
+     * @brief Build the index for the value lists of the local keys in gstore
+     *
+     * @param threshold the min number of edges of an indexed key (0: disabled)
+     * @param times_of the timestamps of the value list at given offset of the key
+     *                 (nullptr: w/o timestamps, e.g., non-temporal segments)
+     */
+    template <class Store, class TimesOf>
+    void build(Store &gstore, uint64_t threshold, TimesOf times_of) {
+        clear();
+        this->threshold = threshold;
+        if (threshold == 0) return;
+
+        uint64_t total_buckets = gstore.num_buckets + gstore.num_buckets_ext;
+        for (uint64_t bucket_id = 0; bucket_id < total_buckets; bucket_id++) {
+            uint64_t slot_id = bucket_id * Store::ASSOCIATIVITY;
+            for (int i = 0; i < Store::ASSOCIATIVITY - 1; i++, slot_id++) {
+                auto &slot = gstore.slots[slot_id];
+                if (slot.key.is_empty() || slot.ptr.type != SID_t || slot.ptr.size < threshold)
+                    continue;
+
+                const edge_time_t *times = times_of(slot.key, slot.ptr.off);
+                if (times == nullptr)
+                    continue;
+
+                build_list(times, slot.ptr.size, lists[slot.key]);
+                nedges += slot.ptr.size;
+            }
+        }
+    }
+
+    // the value lists w/o segments share the time region of gstore (see KVStore::reserve_times)
+    template <class Store>
+    void build(Store &gstore, uint64_t threshold) {
+        build(gstore, threshold, [&gstore](ikey_t key, uint64_t off) { return gstore.get_times(off); });
+    }
+
+    void clear() {
+        lists.clear();
+        nedges = 0;
+        threshold = 0;
+    }
+
+    uint64_t num_keys() const { return lists.size(); }
+
+    uint64_t num_edges() const { return nedges; }
+
+    // the memory usage of the index (bytes), ignoring the classes of durations
+    uint64_t mem_usage() const {
+        return nedges * (sizeof(int64_t) + sizeof(uint32_t))
+               + lists.size() * sizeof(interval_list_t);
+    }
+
+    /**
+     * @brief the positions of edges valid in [ts, te] in the value list of
+     *        the key (ascending), w/ the index of the key if any
+     *
+     * @param key the key of the value list
+     * @param times the timestamps of the value list (e.g., got by DGraph::get_timed_triples),
+     *              or nullptr if not fetched or stored (i.e., all edges are valid)
+     * @param sz the size of the value list
+     * @param pos the positions of valid edges (return value)
+     */
+    void valid_edges(ikey_t key, const edge_time_t *times, uint64_t sz, int64_t ts, int64_t te,
+                     std::vector<uint64_t> &pos) const {
+        if (times == nullptr) {
+            pos.resize(sz);
+            std::iota(pos.begin(), pos.end(), 0);
+            return;
+        }
+        if (threshold > 0 && sz >= threshold) {
+            auto it = lists.find(key);
+            // the list may be remote (e.g., RDMA) or changed since building
+            if (it != lists.end() && it->second.times == times && it->second.sz == sz) {
+                probe_list(it->second, ts, te, pos);
+                return;
+            }
+        }
+        scan_list(times, sz, ts, te, pos);
+    }
+
+private:
+    struct key_hash {
+        size_t operator()(const ikey_t &key) const { return key.hash(); }
+    };
+
+    boost::unordered_map<ikey_t, interval_list_t, key_hash> lists;
+    uint64_t nedges = 0;     // the number of indexed edges
+    uint64_t threshold = 0;  // the min number of edges of an indexed key (0: disabled)
+};
+
+} // namespace wukong
+
+#endif  // TRDF_MODE
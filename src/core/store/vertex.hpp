@@ -182,23 +182,6 @@ struct vertex_t {
 struct edge_t {
     int val;  // vertex ID
 
-#ifdef TRDF_MODE
-    int64_t ts;  // start timestamp
-    int64_t te;  // end timestamp
-
-    bool valid(int64_t _ts, int64_t _te) const {
-        bool rev = ((_ts <= _te) && (ts <= te) && (_ts <= te && _te >= ts)) || (_ts == TIMESTAMP_MIN && _te == TIMESTAMP_MAX);
-        return rev;
-    }
-
-    // clang-format off
-#if USE_GPU
-    __host__ __device__
-#endif
-    edge_t(sid_t id, int64_t ts, int64_t te): val(id), ts(ts), te(te) {}
-    // clang-format on
-#endif
-
     edge_t() {}
 
     // clang-format off
@@ -208,19 +191,9 @@ struct edge_t {
     explicit edge_t(sid_t id) : val(id) {}
     // clang-format on
 
-    edge_t(const edge_t& edge) : val(edge.val) {
-    #ifdef TRDF_MODE
-        ts = edge.ts;
-        te = edge.te;
-    #endif
-    }
+    edge_t(const edge_t& edge) : val(edge.val) {}
 
-    edge_t(edge_t&& edge) : val(edge.val) {
-    #ifdef TRDF_MODE
-        ts = edge.ts;
-        te = edge.te;
-    #endif
-    }
+    edge_t(edge_t&& edge) : val(edge.val) {}
 
     edge_t& operator=(sid_t id) {
         this->val = id;
@@ -228,83 +201,91 @@ struct edge_t {
     }
 
     edge_t& operator=(const edge_t& e) {
-        if (this != &e) {
+        if (this != &e)
             val = e.val;
-        #ifdef TRDF_MODE
-            ts = e.ts;
-            te = e.te;
-        #endif
-        }
         return *this;
     }
 
     edge_t& operator=(const edge_t&& e) {
-        if (this != &e) {
+        if (this != &e)
             val = e.val;
-        #ifdef TRDF_MODE
-            ts = e.ts;
-            te = e.te;
-        #endif
-        }
         return *this;
     }
 
     bool operator==(const edge_t& e) {
-    #ifdef TRDF_MODE
-        return this->val == e.val && this->ts == e.ts && this->te == e.te;
-    #else
         return this->val == e.val;
-    #endif
     }
 
     bool operator==(const sid_t& id) {
         return this->val == id;
     }
+
+    // the order of edges in a value list (see sort_normal_triples)
+    bool operator<(const edge_t& e) const {
+        return this->val < e.val;
+    }
 };
 
 #ifdef TRDF_MODE
-struct time_edge_t {
-    int val;  // vertex ID
+/**
+ * 128-bit timestamps of an edge (TRDF_MODE)
+ *
+ * The timestamps are not stored in edge_t but in a side region of KVStore
+ * (see KVStore::times), which is parallel to the entry region and addressed
+ * by the same offsets (iptr_t). So the patterns w/o time constraints only
+ * read the compact (32-bit) edges.
+ */
+struct edge_time_t {
     int64_t ts;  // start timestamp
     int64_t te;  // end timestamp
 
-    // clang-format off
-#ifdef USE_GPU
-    __host__ __device__
-#endif
-    time_edge_t(sid_t id, int64_t ts, int64_t te): val(id), ts(ts), te(te) {}
-    // clang-format on
+    edge_time_t() : ts(TIMESTAMP_MIN), te(TIMESTAMP_MAX) {}
+
+    edge_time_t(int64_t ts, int64_t te) : ts(ts), te(te) {}
 
     bool valid(int64_t _ts, int64_t _te) const {
         bool rev = ((_ts <= _te) && (ts <= te) && (_ts <= te && _te >= ts)) || (_ts == TIMESTAMP_MIN && _te == TIMESTAMP_MAX);
         return rev;
     }
 
-    time_edge_t(const time_edge_t& edge) : val(edge.val), ts(edge.ts), te(edge.te) {}
-
-    time_edge_t(time_edge_t&& edge) : val(edge.val), ts(edge.ts), te(edge.te) {}
+    bool operator==(const edge_time_t& t) const {
+        return this->ts == t.ts && this->te == t.te;
+    }
 
-    time_edge_t& operator=(time_edge_t& e) {
-        if (this != &e) {
-            val = e.val;
-            ts = e.ts;
-            te = e.te;
-        }
-        return *this;
+    bool operator<(const edge_time_t& t) const {
+        if (this->ts != t.ts) return this->ts < t.ts;
+        return this->te < t.te;
     }
+};
 
-    time_edge_t& operator=(time_edge_t&& e) {
-        if (this != &e) {
-            val = e.val;
-            ts = e.ts;
-            te = e.te;
-        }
-        return *this;
+// an edge w/ its timestamps, used to build value lists (TRDF_MODE)
+struct time_edge_t {
+    int val;  // vertex ID
+    int64_t ts;  // start timestamp
+    int64_t te;  // end timestamp
+
+    time_edge_t() {}
+
+    time_edge_t(sid_t id, int64_t ts, int64_t te): val(id), ts(ts), te(te) {}
+
+    bool valid(int64_t _ts, int64_t _te) const {
+        return time().valid(_ts, _te);
     }
 
-    bool operator==(const time_edge_t& e) {
+    edge_t edge() const { return edge_t(val); }
+
+    edge_time_t time() const { return edge_time_t(ts, te); }
+
+    bool operator==(const time_edge_t& e) const {
         return this->val == e.val && this->ts == e.ts && this->te == e.te;
     }
+
+    // the order of edges in a value list (see sort_normal_triples)
+    bool operator<(const time_edge_t& e) const {
+        if (this->val != e.val) return this->val < e.val;
+        if (this->ts != e.ts) return this->ts < e.ts;
+        return this->te < e.te;
+    }
 };
 #endif
 
@@ -44,12 +44,16 @@
 
 // loader
 #include "loader_interface.hpp"
+#include "triple_parser.hpp"
+#include "triple_runs.hpp"
 
 // utils
 #include "utils/assertion.hpp"
 #include "utils/math.hpp"
 #include "utils/timer.hpp"
+#include "utils/triple_sort.hpp"
 #include "utils/atomic.hpp"
+#include "utils/unit.hpp"
 
 // display progress
 #include "progresscpp/ProgressBar.hpp"
@@ -87,21 +91,6 @@ protected:
         return original - original % n + n;
     }
 
-    void dedup_triples(std::vector<triple_t>& triples) {
-        if (triples.size() <= 1)
-            return;
-
-        uint64_t n = 1;
-        for (uint64_t i = 1; i < triples.size(); i++) {
-            if (triples[i] == triples[i - 1]) {
-                continue;
-            }
-
-            triples[n++] = triples[i];
-        }
-        triples.resize(n);
-    }
-
     void flush_triples(int tid, int dst_sid) {
         uint64_t lbuf_partition_sz = floor(loader_mem.local_buf_sz / Global::num_servers - sizeof(uint64_t), sizeof(triple_t));
         uint64_t* pn = reinterpret_cast<uint64_t*>((loader_mem.local_buf + loader_mem.local_buf_sz * tid) + (lbuf_partition_sz + sizeof(uint64_t)) * dst_sid);
@@ -172,41 +161,127 @@ protected:
         *pn = (n + 1);
     }
 
-    int read_partial_exchange(std::vector<std::string>& fnames) {
-        // ensure the file name list has the same order on all servers
-        std::sort(fnames.begin(), fnames.end());
-
-        auto lambda = [&](std::istream& file, int localtid) {
-            triple_t triple;
-        #ifdef TRDF_MODE
-            while (file >> triple.s >> triple.p >> triple.o >> triple.ts >> triple.te) {
-        #else
-            while (file >> triple.s >> triple.p >> triple.o) {
-        #endif
-                int s_sid = PARTITION(triple.s);
-                int o_sid = PARTITION(triple.o);
-                if (s_sid == o_sid) {
-                    send_triple(localtid, s_sid, triple);
-                } else {
-                    send_triple(localtid, s_sid, triple);
-                    send_triple(localtid, o_sid, triple);
-                }
-            }
-        };
+    /* A piece of an input file parsed by a thread ([0, 0) for reading the whole file by stream) */
+    struct InputSplit {
+        int fid;
+        uint64_t begin;
+        uint64_t end;
+    };
 
-        // load input data and assign to different severs in parallel
+    /**
+     * @brief Parse triples from selected files in parallel, and call func(localtid, fid, triple)
+     *
+     * Memory-mapped files are split into pieces at line (or record) boundaries,
+     * so that a large file can be parsed by multiple threads. Other files
+     * (e.g., on HDFS) are read by chunks through the input stream.
+     *
+     * @param splittable whether the triples of a file can be handled by different threads
+     */
+    template <typename F>
+    void parse_triple_files(const std::vector<std::string>& fnames,
+                            const std::vector<bool>& selected, bool splittable, F func) {
+        uint64_t start = timer::get_usec();
         int num_files = fnames.size();
-        #pragma omp parallel for num_threads(Global::num_engines)
+        std::vector<const char*> bufs(num_files, nullptr);
+        std::vector<uint64_t> szs(num_files, 0);
+        std::vector<InputSplit> splits;
         for (int i = 0; i < num_files; i++) {
+            if (!selected[i]) continue;
+
+            bool binary = is_triple_bin_file(fnames[i]);
+            bufs[i] = map_file(fnames[i], szs[i]);
+            if (bufs[i] == nullptr) {
+                splits.push_back(InputSplit{i, 0, 0});
+                continue;
+            }
+
+            triple_bin_header_t h;
+            if (binary && (szs[i] < sizeof(h)
+                           || !reinterpret_cast<const triple_bin_header_t*>(bufs[i])->valid(szs[i]))) {
+                logstream(LOG_ERROR) << "[Loader] invalid binary triple file: " << fnames[i] << LOG_endl;
+                unmap_file(bufs[i], szs[i]);
+                bufs[i] = nullptr;
+                continue;
+            }
+            uint64_t split_sz = splittable ? LOADER_SPLIT_SZ : UINT64_MAX;
+            for (auto& piece : split_triple_file(bufs[i], szs[i], binary, split_sz))
+                splits.push_back(InputSplit{i, piece.first, piece.second});
+        }
+
+        std::vector<uint64_t> nbytes(Global::num_engines, 0);
+        std::vector<uint64_t> ntriples(Global::num_engines, 0);
+        int num_splits = splits.size();
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(Global::num_engines)
+        for (int i = 0; i < num_splits; i++) {
             int localtid = omp_get_thread_num();
+            const InputSplit& split = splits[i];
+            const char* buf = bufs[split.fid];
+            bool binary = is_triple_bin_file(fnames[split.fid]);
+
+            uint64_t n = 0, sz = 0;
+            auto emit = [&](const triple_t& triple) {
+                func(localtid, split.fid, triple);
+                n++;
+            };
+
+            bool ok = true;
+            if (buf != nullptr) {
+                if (binary) {
+                    const triple_bin_header_t* h = reinterpret_cast<const triple_bin_header_t*>(buf);
+                    parse_bin_triples(buf + split.begin, (split.end - split.begin) / h->record_sz(), *h, emit);
+                } else {
+                    const char* p = buf + split.begin;
+                    ok = parse_text_triples(p, buf + split.end, true, emit);
+                }
+                sz = split.end - split.begin;
+            } else {
+                std::istream* file = init_istream(fnames[split.fid]);
+                ok = parse_triple_stream(*file, binary, emit, sz);
+                close_istream(file);
+            }
+            if (!ok)
+                logstream(LOG_WARNING) << "[Loader] malformed triples in " << fnames[split.fid]
+                                       << ", skip the rest of its data" << LOG_endl;
+            nbytes[localtid] += sz;
+            ntriples[localtid] += n;
+        }
 
-            // each server only load a part of files
-            if (i % Global::num_servers != sid) continue;
+        for (int i = 0; i < num_files; i++)
+            if (bufs[i] != nullptr)
+                unmap_file(bufs[i], szs[i]);
 
-            std::istream* file = init_istream(fnames[i]);
-            lambda(*file, localtid);
-            close_istream(file);
+        uint64_t usec = std::max<uint64_t>(timer::get_usec() - start, 1);
+        uint64_t total_bytes = 0, total_triples = 0;
+        for (int t = 0; t < Global::num_engines; t++) {
+            total_bytes += nbytes[t];
+            total_triples += ntriples[t];
         }
+        logstream(LOG_INFO) << "[Loader] #" << sid << ": parsed " << total_triples << " triples ("
+                            << B2MiB(total_bytes) << " MB) from " << splits.size() << " pieces of files, "
+                            << B2MiB(total_bytes) * 1000000 / usec << " MB/s and "
+                            << total_triples * 1000000 / usec << " triples/s" << LOG_endl;
+    }
+
+    int read_partial_exchange(std::vector<std::string>& fnames) {
+        // ensure the file name list has the same order on all servers
+        std::sort(fnames.begin(), fnames.end());
+
+        // each server only load a part of files
+        std::vector<bool> selected(fnames.size());
+        for (int i = 0; i < fnames.size(); i++)
+            selected[i] = (i % Global::num_servers == sid);
+
+        // load input data and assign to different severs in parallel
+        parse_triple_files(fnames, selected, true, [&](int localtid, int fid, const triple_t& triple) {
+            int s_sid = PARTITION(triple.s);
+            int o_sid = PARTITION(triple.o);
+            if (s_sid == o_sid) {
+                send_triple(localtid, s_sid, triple);
+            } else {
+                send_triple(localtid, s_sid, triple);
+                send_triple(localtid, o_sid, triple);
+            }
+        });
 
         // flush the rest triples within each RDMA buffer
         for (int s = 0; s < Global::num_servers; s++)
@@ -236,45 +311,26 @@ protected:
     int read_all_files(std::vector<std::string>& fnames) {
         std::sort(fnames.begin(), fnames.end());
 
-        auto lambda = [&](std::istream& file, uint64_t& n, 
-                          uint64_t gbuf_partition_sz, triple_t* gbuf_partition) {
-            triple_t triple;
-        #ifdef TRDF_MODE
-            while (file >> triple.s >> triple.p >> triple.o >> triple.ts >> triple.te) {
-        #else
-            while (file >> triple.s >> triple.p >> triple.o) {
-        #endif
-                int s_sid = PARTITION(triple.s);
-                int o_sid = PARTITION(triple.o);
-                if ((s_sid == sid) || (o_sid == sid)) {
-                    ASSERT((n + 1) * sizeof(triple_t) <= gbuf_partition_sz);
-                    // buffer the triple and update the counter
-                    gbuf_partition[n] = triple;
-                    n++;
-                }
-            }
-        };
-
-
-        int num_files = fnames.size();
-        #pragma omp parallel for num_threads(Global::num_engines)
-        for (int i = 0; i < num_files; i++) {
-            int localtid = omp_get_thread_num();
-            uint64_t gbuf_partition_sz = floor(loader_mem.global_buf_sz / Global::num_engines - sizeof(uint64_t),
-                                    sizeof(triple_t));
-            uint64_t* pn = reinterpret_cast<uint64_t*>(loader_mem.global_buf + 
-                                (gbuf_partition_sz + sizeof(uint64_t)) * localtid);
-            triple_t* gbuf_partition = reinterpret_cast<triple_t*>(pn + 1);
-
-            // the uint64_t before gbuf_partition records #triples
-            uint64_t n = *pn;
-
-            std::istream* file = init_istream(fnames[i]);
-            lambda(*file, n, gbuf_partition_sz, gbuf_partition);
-            close_istream(file);
+        // each thread buffers triples in its own partition of the global buffer
+        uint64_t gbuf_partition_sz = floor(loader_mem.global_buf_sz / Global::num_engines - sizeof(uint64_t),
+                                           sizeof(triple_t));
+        parse_triple_files(fnames, std::vector<bool>(fnames.size(), true), true,
+                           [&](int localtid, int fid, const triple_t& triple) {
+            int s_sid = PARTITION(triple.s);
+            int o_sid = PARTITION(triple.o);
+            if ((s_sid == sid) || (o_sid == sid)) {
+                uint64_t* pn = reinterpret_cast<uint64_t*>(loader_mem.global_buf +
+                                    (gbuf_partition_sz + sizeof(uint64_t)) * localtid);
+                triple_t* gbuf_partition = reinterpret_cast<triple_t*>(pn + 1);
 
-            *pn = n;
-        }
+                // the uint64_t before gbuf_partition records #triples
+                uint64_t n = *pn;
+                ASSERT((n + 1) * sizeof(triple_t) <= gbuf_partition_sz);
+                // buffer the triple and update the counter
+                gbuf_partition[n] = triple;
+                *pn = n + 1;
+            }
+        });
 
         return Global::num_engines;
     }
@@ -339,9 +395,11 @@ protected:
             std::sort(triple_sav[tid].begin(), triple_sav[tid].end(), triple_sort_by_asv());
     }
 
+    // Sink: std::vector<triple_t> (in memory) or TripleRuns (spilled to disk)
+    template <typename Sink>
     void aggregate_data(int num_partitions,
-                        std::vector<std::vector<triple_t>>& triple_pso,
-                        std::vector<std::vector<triple_t>>& triple_pos) {
+                        std::vector<Sink>& triple_pso,
+                        std::vector<Sink>& triple_pos) {
         // calculate #triples in the global buffer from all servers
         uint64_t total = 0;
         uint64_t gbuf_partition_sz = floor(loader_mem.global_buf_sz / num_partitions - sizeof(uint64_t), sizeof(triple_t));
@@ -397,9 +455,10 @@ protected:
     }
 
     // Load normal triples from all files, using read_partial_exchange or read_all_files.
+    template <typename Sink>
     void load_triples_from_all(std::vector<std::string>& dfiles,
-                               std::vector<std::vector<triple_t>>& triple_pso,
-                               std::vector<std::vector<triple_t>>& triple_pos) {
+                               std::vector<Sink>& triple_pso,
+                               std::vector<Sink>& triple_pos) {
         // read_partial_exchange: load partial input files by each server and exchanges triples
         //            according to graph partitioning
         // read_all_files: load all files by each server and select triples
@@ -432,9 +491,10 @@ protected:
     }
 
     // Load preprocessed data from selected files.
+    template <typename Sink>
     void load_triples_from_selected(const std::string& src, std::vector<std::string>& fnames,
-                                    std::vector<std::vector<triple_t>>& triple_pso,
-                                    std::vector<std::vector<triple_t>>& triple_pos) {
+                                    std::vector<Sink>& triple_pso,
+                                    std::vector<Sink>& triple_pos) {
         uint64_t start = timer::get_usec();
 
         size_t triple_cnt = get_triple_cnt(src);
@@ -443,36 +503,23 @@ protected:
             triple_pos[i].reserve(triple_cnt / Global::num_servers / Global::num_engines);
         }
 
-        auto load_one_file = [&](bool by_s, std::istream& file,
-                                 std::vector<triple_t>& triple_pso, std::vector<triple_t>& triple_pos) {
-            triple_t triple;
-        #ifdef TRDF_MODE
-            while (file >> triple.s >> triple.p >> triple.o >> triple.ts >> triple.te) {
-        #else
-            while (file >> triple.s >> triple.p >> triple.o) {
-        #endif
-                if (by_s)    // out-edges
-                    triple_pso.push_back(triple);
-                else        // in-edges
-                    triple_pos.push_back(triple);
-            }
-        };
-
         int num_files = fnames.size();
-        #pragma omp parallel for num_threads(Global::num_engines)
+        std::vector<bool> selected(num_files), by_s(num_files);
         for (int i = 0; i < num_files; i++) {
-            int localtid = omp_get_thread_num();
-
             size_t spos = fnames[i].find_last_of('_') + 1;
             size_t len = fnames[i].find('.') - spos;
             int pid = stoi(fnames[i].substr(spos, len));
-            if (PARTITION(pid) == sid) {
-                std::istream* file = init_istream(fnames[i]);
-                bool by_s = (fnames[i].find("spo") != std::string::npos);
-                load_one_file(by_s, *file, triple_pso[localtid], triple_pos[localtid]);
-                close_istream(file);
-            }
+            selected[i] = (PARTITION(pid) == sid);
+            by_s[i] = (fnames[i].find("spo") != std::string::npos);
         }
+
+        // the triples of a vertex should be held by the same thread (i.e., not split files)
+        parse_triple_files(fnames, selected, false, [&](int localtid, int fid, const triple_t& triple) {
+            if (by_s[fid])    // out-edges
+                triple_pso[localtid].push_back(triple);
+            else              // in-edges
+                triple_pos[localtid].push_back(triple);
+        });
         uint64_t end = timer::get_usec();
         logstream(LOG_INFO) << "[Loader] #" << sid << ": " << (end - start) / 1000 << " ms "
                             << "for loading triples" << LOG_endl;
@@ -480,21 +527,25 @@ protected:
 
     void sort_normal_triples(std::vector<std::vector<triple_t>>& triple_pso,
                              std::vector<std::vector<triple_t>>& triple_pos) {
+        uint64_t start = timer::get_usec();
         #pragma omp parallel for num_threads(Global::num_engines)
         for (int tid = 0; tid < Global::num_engines; tid++) {
+            // radix sort w/ dedup (the buffer is shared by both orders)
+            std::vector<triple_t> tmp;
 #ifdef VERSATILE
-            std::sort(triple_pso[tid].begin(), triple_pso[tid].end(), triple_sort_by_spo());
-            std::sort(triple_pos[tid].begin(), triple_pos[tid].end(), triple_sort_by_ops());
+            sort_triples_by_spo(triple_pso[tid], tmp);
+            sort_triples_by_ops(triple_pos[tid], tmp);
 #else
-            std::sort(triple_pso[tid].begin(), triple_pso[tid].end(), triple_sort_by_pso());
-            std::sort(triple_pos[tid].begin(), triple_pos[tid].end(), triple_sort_by_pos());
+            sort_triples_by_pso(triple_pso[tid], tmp);
+            sort_triples_by_pos(triple_pos[tid], tmp);
 #endif
-            dedup_triples(triple_pos[tid]);
-            dedup_triples(triple_pso[tid]);
 
             triple_pos[tid].shrink_to_fit();
             triple_pso[tid].shrink_to_fit();
         }
+        uint64_t end = timer::get_usec();
+        logstream(LOG_INFO) << "[Loader] #" << sid << ": " << (end - start) / 1000 << " ms "
+                            << "for sorting triples" << LOG_endl;
     }
 
     bool is_preprocessed(const std::string& src) {
@@ -531,23 +582,87 @@ public:
 
     virtual std::istream* init_istream(const std::string& src) = 0;
     virtual void close_istream(std::istream* stream) = 0;
+    // map a file into memory, return nullptr if unsupported (read by stream instead)
+    virtual const char* map_file(const std::string& fname, uint64_t& sz) { return nullptr; }
+    virtual void unmap_file(const char* buf, uint64_t sz) {}
     virtual std::vector<std::string> list_files(const std::string& src, std::string prefix) = 0;
 
     void load(const std::string& src,
               std::vector<std::vector<triple_t>>& triple_pso,
               std::vector<std::vector<triple_t>>& triple_pos,
               std::vector<std::vector<triple_attr_t>>& triple_sav) {
-        uint64_t start, end;
-
-        num_triples.resize(Global::num_servers);
         triple_pso.resize(Global::num_engines);
         triple_pos.resize(Global::num_engines);
-        triple_sav.resize(Global::num_engines);
+
+        std::vector<std::string> afiles;
+        load_normal(src, afiles, triple_pso, triple_pos);
+
+        // Wukong sorts and dedups all triples before finally inserting them to gstore (kvstore)
+        sort_normal_triples(triple_pso, triple_pos);
+
+        load_attr(afiles, triple_sav);
+    }
+
+    /**
+     * Load normal triples into sorted runs on disk (bounded-memory loading),
+     * which buffer at most budget_mb of triples (pso and pos) per server.
+     * The caller should clear the runs (remove run files) after use.
+     *
+     * @return false if the runs fail to be spilled (e.g., the spill folder is full),
+     *         and the run files are removed
+     */
+    bool load(const std::string& src, uint64_t budget_mb,
+              std::vector<TripleRuns>& runs_pso,
+              std::vector<TripleRuns>& runs_pos,
+              std::vector<std::vector<triple_attr_t>>& triple_sav) {
+        uint64_t cap = MiB2B(budget_mb) / (2 * Global::num_engines * sizeof(triple_t));
+        runs_pso.clear();
+        runs_pos.clear();
+        for (int tid = 0; tid < Global::num_engines; tid++) {
+            std::string prefix = Global::load_spill_folder + "run." + std::to_string(sid) + "." + std::to_string(tid);
+            runs_pso.emplace_back(prefix + ".pso", true, cap);
+            runs_pos.emplace_back(prefix + ".pos", false, cap);
+        }
+
+        std::vector<std::string> afiles;
+        load_normal(src, afiles, runs_pso, runs_pos);
+
+        // spill the rest of triples
+        uint64_t start = timer::get_usec();
+        uint64_t nruns = 0, nfailed = 0;
+        #pragma omp parallel for num_threads(Global::num_engines) reduction(+ : nruns, nfailed)
+        for (int tid = 0; tid < Global::num_engines; tid++) {
+            nfailed += !runs_pso[tid].finish();
+            nfailed += !runs_pos[tid].finish();
+            nruns += runs_pso[tid].files().size() + runs_pos[tid].files().size();
+        }
+        if (nfailed > 0) {
+            logstream(LOG_ERROR) << "[Loader] #" << sid << ": failed to spill triples to "
+                                 << Global::load_spill_folder << LOG_endl;
+            for (int tid = 0; tid < Global::num_engines; tid++) {
+                runs_pso[tid].clear();
+                runs_pos[tid].clear();
+            }
+            return false;
+        }
+        uint64_t end = timer::get_usec();
+        logstream(LOG_INFO) << "[Loader] #" << sid << ": " << (end - start) / 1000 << " ms "
+                            << "for spilling triples (" << nruns << " sorted runs)" << LOG_endl;
+
+        load_attr(afiles, triple_sav);
+        return true;
+    }
+
+private:
+    template <typename Sink>
+    void load_normal(const std::string& src, std::vector<std::string>& afiles,
+                     std::vector<Sink>& triple_pso, std::vector<Sink>& triple_pos) {
+        num_triples.resize(Global::num_servers);
 
         // ID-format data files
         std::vector<std::string> dfiles(list_files(src, "id_"));
         // ID-format attribute files
-        std::vector<std::string> afiles(list_files(src, "attr_"));
+        afiles = list_files(src, "attr_");
 
         if (dfiles.size() == 0) {
             logstream(LOG_WARNING) << "[Loader] no data files found in directory (" << src
@@ -570,15 +685,16 @@ public:
             load_triples_from_selected(src, dfiles, triple_pso, triple_pos);
         else
             load_triples_from_all(dfiles, triple_pso, triple_pos);
+    }
 
-        // Wukong sorts and dedups all triples before finally inserting them to gstore (kvstore)
-        sort_normal_triples(triple_pso, triple_pos);
+    void load_attr(std::vector<std::string>& afiles, std::vector<std::vector<triple_attr_t>>& triple_sav) {
+        triple_sav.resize(Global::num_engines);
 
         // load attribute files
-        start = timer::get_usec();
+        uint64_t start = timer::get_usec();
         load_attr_from_allfiles(afiles, triple_sav);
         sort_attr(triple_sav);
-        end = timer::get_usec();
+        uint64_t end = timer::get_usec();
         logstream(LOG_INFO) << "[Loader] #" << sid << ": " << (end - start) / 1000 << " ms "
                             << "for loading attribute files" << LOG_endl;
     }
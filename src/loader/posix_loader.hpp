@@ -22,6 +22,11 @@
 
 #pragma once
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <string>
 #include <vector>
 
@@ -46,6 +51,32 @@ public:
         delete stream;
     }
 
+    const char* map_file(const std::string& fname, uint64_t& sz) {
+        int fd = open(fname.c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return nullptr;
+        }
+
+        void* buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (buf == MAP_FAILED)
+            return nullptr;
+
+        // pieces of a file are mostly scanned sequentially
+        madvise(buf, st.st_size, MADV_SEQUENTIAL);
+        sz = st.st_size;
+        return static_cast<const char*>(buf);
+    }
+
+    void unmap_file(const char* buf, uint64_t sz) {
+        munmap(const_cast<char*>(buf), sz);
+    }
+
     std::vector<std::string> list_files(const std::string& src, std::string prefix) {
         DIR* dir = opendir(src.c_str());
         if (dir == NULL) {
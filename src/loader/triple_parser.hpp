@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include "core/common/type.hpp"
+
+namespace wukong {
+
+/**
+ * Parsers of ID-triple files
+ *
+ * text (id_*): one triple per line, e.g., "132323 1 16" (w/ "ts te" in TRDF_MODE)
+ *
+ * binary (id_*.bin):
+ *  | header | record | record | ... |
+ *  record: s p o (id_sz bytes each) [ts te (8 bytes each)], little-endian and packed
+ */
+
+#define TRIPLE_BIN_MAGIC "WKTRIPLE"
+#define TRIPLE_BIN_VERSION 1
+#define TRIPLE_BIN_SUFFIX ".bin"
+
+#define LOADER_SPLIT_SZ (16UL << 20)  // a large file is split into 16MB pieces
+#define LOADER_CHUNK_SZ (16UL << 20)  // a stream is read by 16MB chunks
+
+struct triple_bin_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t id_sz;    // 4 or 8
+    uint32_t nfields;  // 3 (s p o) or 5 (s p o ts te)
+    uint32_t reserved;
+    uint64_t ntriples;
+
+    triple_bin_header_t() : version(TRIPLE_BIN_VERSION), id_sz(sizeof(sid_t)),
+                            nfields(TRIPLE_NFIELDS), reserved(0), ntriples(0) {
+        memcpy(magic, TRIPLE_BIN_MAGIC, sizeof(magic));
+    }
+
+    uint64_t record_sz() const { return 3 * id_sz + (nfields - 3) * sizeof(int64_t); }
+
+    // the file should match the layout of triple_t in this build
+    bool valid(uint64_t file_sz) const {
+        return memcmp(magic, TRIPLE_BIN_MAGIC, sizeof(magic)) == 0
+               && version == TRIPLE_BIN_VERSION
+               && (id_sz == sizeof(uint32_t) || id_sz == sizeof(uint64_t))
+               && nfields == TRIPLE_NFIELDS
+               && file_sz >= sizeof(triple_bin_header_t)
+               && (file_sz - sizeof(triple_bin_header_t)) / record_sz() >= ntriples;
+    }
+};
+
+static inline bool is_triple_bin_file(const std::string &fname) {
+    return boost::ends_with(fname, TRIPLE_BIN_SUFFIX);
+}
+
+/**
+ * @brief Parse text triples in [p, end) and call emit(triple) for each of them
+ *
+ * @param p the first unconsumed byte (return value), which is the start of
+ *          an incomplete triple if the buffer is not the last one
+ * @param last no more data follows the buffer
+ * @return false if malformed data is met (like std::istream, stop parsing)
+ */
+template <typename F>
+static inline bool parse_text_triples(const char *&p, const char *end, bool last, F emit) {
+    int64_t v[TRIPLE_NFIELDS];
+    while (true) {
+        const char *start = p;
+        for (int f = 0; f < TRIPLE_NFIELDS; f++) {
+            // skip blanks (incl. '\n')
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                p++;
+            if (p == end) {  // done or incomplete triple
+                if (!last) p = start;
+                return true;
+            }
+
+            bool neg = (*p == '-');
+            if (neg) p++;
+            const char *digits = p;
+            uint64_t x = 0;
+            while (p < end && static_cast<unsigned>(*p - '0') < 10)
+                x = x * 10 + (*p++ - '0');
+            if (p == end && !last) {  // the number may continue in the next buffer
+                p = start;
+                return true;
+            }
+            if (p == digits)
+                return false;
+            v[f] = neg ? -static_cast<int64_t>(x) : static_cast<int64_t>(x);
+        }
+    #ifdef TRDF_MODE
+        emit(triple_t(v[0], v[1], v[2], v[3], v[4]));
+    #else
+        emit(triple_t(v[0], v[1], v[2]));
+    #endif
+    }
+}
+
+static inline uint64_t load_bin_field(const char *p, uint32_t sz) {
+    if (sz == sizeof(uint32_t)) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Parse n binary records at p and call emit(triple) for each of them
+ */
+template <typename F>
+static inline void parse_bin_triples(const char *p, uint64_t n, const triple_bin_header_t &h, F emit) {
+    uint64_t rsz = h.record_sz();
+    for (uint64_t i = 0; i < n; i++, p += rsz) {
+        sid_t s = load_bin_field(p, h.id_sz);
+        sid_t pid = load_bin_field(p + h.id_sz, h.id_sz);
+        sid_t o = load_bin_field(p + 2 * h.id_sz, h.id_sz);
+    #ifdef TRDF_MODE
+        int64_t ts = load_bin_field(p + 3 * h.id_sz, sizeof(int64_t));
+        int64_t te = load_bin_field(p + 3 * h.id_sz + sizeof(int64_t), sizeof(int64_t));
+        emit(triple_t(s, pid, o, ts, te));
+    #else
+        emit(triple_t(s, pid, o));
+    #endif
+    }
+}
+
+// move off to the start of the next line (unless it is already)
+static inline uint64_t align_to_line(const char *buf, uint64_t sz, uint64_t off) {
+    if (off == 0 || off >= sz)
+        return std::min(off, sz);
+    const char *nl = static_cast<const char *>(memchr(buf + off - 1, '\n', sz - off + 1));
+    return (nl == nullptr) ? sz : (nl - buf + 1);
+}
+
+/**
+ * @brief Split an in-memory (mmapped) file into pieces of about split_sz bytes
+ *
+ * Text pieces start and end at line boundaries, and binary pieces
+ * start and end at record boundaries.
+ *
+ * @return [begin, end) offsets of pieces
+ */
+static inline std::vector<std::pair<uint64_t, uint64_t>>
+split_triple_file(const char *buf, uint64_t sz, bool binary, uint64_t split_sz = LOADER_SPLIT_SZ) {
+    std::vector<std::pair<uint64_t, uint64_t>> pieces;
+    if (binary) {
+        triple_bin_header_t h;
+        memcpy(&h, buf, sizeof(h));
+        uint64_t rsz = h.record_sz();
+        uint64_t step = std::max(split_sz / rsz, 1UL);
+        for (uint64_t i = 0; i < h.ntriples; i += std::min(step, h.ntriples - i))
+            pieces.push_back(std::make_pair(sizeof(h) + i * rsz,
+                                            sizeof(h) + (i + std::min(step, h.ntriples - i)) * rsz));
+        return pieces;
+    }
+
+    uint64_t begin = 0;
+    while (begin < sz) {
+        uint64_t end = (sz - begin <= split_sz) ? sz : align_to_line(buf, sz, begin + split_sz);
+        pieces.push_back(std::make_pair(begin, end));
+        begin = end;
+    }
+    return pieces;
+}
+
+/**
+ * @brief Parse triples from a text or binary stream (read by chunks)
+ *
+ * @param nbytes #bytes read from the stream (return value)
+ * @return false if the data is malformed
+ */
+template <typename F>
+static inline bool parse_triple_stream(std::istream &file, bool binary, F emit, uint64_t &nbytes,
+                                       uint64_t chunk_sz = LOADER_CHUNK_SZ) {
+    std::vector<char> buf(chunk_sz);
+    nbytes = 0;
+
+    if (binary) {
+        triple_bin_header_t h;
+        file.read(reinterpret_cast<char *>(&h), sizeof(h));
+        nbytes += file.gcount();
+        if (file.gcount() != sizeof(h) || !h.valid(sizeof(h) + h.ntriples * h.record_sz()))
+            return false;
+
+        uint64_t rsz = h.record_sz();
+        uint64_t step = std::max(chunk_sz / rsz, 1UL);
+        buf.resize(step * rsz);
+        for (uint64_t i = 0; i < h.ntriples; i += step) {
+            uint64_t n = std::min(step, h.ntriples - i);
+            file.read(buf.data(), n * rsz);
+            nbytes += file.gcount();
+            if (static_cast<uint64_t>(file.gcount()) != n * rsz)
+                return false;
+            parse_bin_triples(buf.data(), n, h, emit);
+        }
+        return true;
+    }
+
+    uint64_t rest = 0;  // incomplete triple from the previous chunk
+    while (true) {
+        if (rest == buf.size())  // a triple longer than a chunk?
+            buf.resize(buf.size() * 2);
+        file.read(buf.data() + rest, buf.size() - rest);
+        uint64_t sz = rest + file.gcount();
+        nbytes += file.gcount();
+        bool last = (file.gcount() == 0) || file.eof();
+
+        const char *p = buf.data();
+        if (!parse_text_triples(p, buf.data() + sz, last, emit))
+            return false;
+        if (last)
+            return true;
+
+        rest = buf.data() + sz - p;
+        memmove(buf.data(), p, rest);
+    }
+}
+
+}  // namespace wukong
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/common/type.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+#include "utils/logger2.hpp"
+#include "utils/triple_sort.hpp"
+
+namespace wukong {
+
+/**
+ * Sorted runs of triples spilled to disk (bounded-memory loading)
+ *
+ * Each engine buffers at most #cap triples of its vertices in one order
+ * (pso/pos, or spo/ops w/ VERSATILE), and spills them to a sorted and
+ * deduplicated run file once the buffer is full. TripleRunMerger merges
+ * the runs back (w/ dedup across runs) by chunks of complete keys, so that
+ * the gstore can be built from the runs with a bounded memory footprint.
+ *
+ * run file: <prefix>.<#run>, packed triple_t
+ */
+
+// the maximum #runs merged at once (bounded by the limit of open files)
+#define RUNS_MAX_FANIN 128
+
+class TripleRuns {
+private:
+    std::string prefix;
+    bool by_s;     // pso/spo (true) or pos/ops (false)
+    uint64_t cap;  // #triples buffered before spilling
+
+    std::vector<triple_t> buf;
+    std::vector<triple_t> tmp;  // for radix sort
+    std::vector<std::string> fnames;
+    uint64_t next_run = 0;
+
+    // set once a run fails to be written (e.g., the spill folder is full),
+    // and the rest of triples are dropped
+    bool failed = false;
+
+    std::string new_run() { return prefix + "." + std::to_string(next_run++); }
+
+    // return NULL on failure
+    static FILE* open_run(const std::string& fname) {
+        FILE* file = fopen(fname.c_str(), "wb");
+        if (file == NULL)
+            logstream(LOG_ERROR) << "failed to create run file " << fname
+                                 << " (" << strerror(errno) << ")" << LOG_endl;
+        return file;
+    }
+
+    static bool write_run(FILE* file, const std::string& fname, const std::vector<triple_t>& triples) {
+        if (fwrite(triples.data(), sizeof(triple_t), triples.size(), file) != triples.size()) {
+            logstream(LOG_ERROR) << "failed to spill triples to " << fname
+                                 << " (" << strerror(errno) << ")" << LOG_endl;
+            return false;
+        }
+        return true;
+    }
+
+    // close a run file, and remove it on failure
+    static bool close_run(FILE* file, const std::string& fname, bool ok) {
+        if (fclose(file) != 0 && ok) {
+            logstream(LOG_ERROR) << "failed to close run file " << fname
+                                 << " (" << strerror(errno) << ")" << LOG_endl;
+            ok = false;
+        }
+        if (!ok)
+            unlink(fname.c_str());
+        return ok;
+    }
+
+    // merge the first #RUNS_MAX_FANIN runs into a new run
+    bool merge_runs();
+
+public:
+    TripleRuns(std::string prefix, bool by_s, uint64_t cap)
+        : prefix(prefix), by_s(by_s), cap(std::max(cap, 1UL)) {}
+
+    // sort triples in the order of runs
+    static void sort_triples(std::vector<triple_t>& triples, bool by_s, std::vector<triple_t>& tmp) {
+#ifdef VERSATILE
+        if (by_s) sort_triples_by_spo(triples, tmp);
+        else sort_triples_by_ops(triples, tmp);
+#else
+        if (by_s) sort_triples_by_pso(triples, tmp);
+        else sort_triples_by_pos(triples, tmp);
+#endif
+    }
+
+    // compare triples in the order of runs
+    static bool less(const triple_t& t1, const triple_t& t2, bool by_s) {
+#ifdef VERSATILE
+        return by_s ? triple_sort_by_spo()(t1, t2) : triple_sort_by_ops()(t1, t2);
+#else
+        return by_s ? triple_sort_by_pso()(t1, t2) : triple_sort_by_pos()(t1, t2);
+#endif
+    }
+
+    void reserve(uint64_t n) { buf.reserve(std::min(n, cap)); }
+
+    // triples are dropped after a failed spill (see good())
+    void push_back(const triple_t& triple) {
+        if (failed) return;
+        buf.push_back(triple);
+        if (buf.size() >= cap)
+            spill();
+    }
+
+    // return false if the buffered triples fail to be spilled
+    bool spill() {
+        if (failed) return false;
+        if (buf.empty()) return true;
+
+        sort_triples(buf, by_s, tmp);
+        std::string fname = new_run();
+        FILE* file = open_run(fname);
+        bool ok = (file != NULL) && close_run(file, fname, write_run(file, fname, buf));
+        if (ok)
+            fnames.push_back(fname);
+        else
+            failed = true;
+
+        buf.clear();
+        return ok;
+    }
+
+    /**
+     * @brief spill the rest and release buffers, and reduce #runs to at most #RUNS_MAX_FANIN
+     *
+     * @return false if any run fails to be written (some triples are lost)
+     */
+    bool finish() {
+        spill();
+        std::vector<triple_t>().swap(buf);
+        std::vector<triple_t>().swap(tmp);
+        while (!failed && fnames.size() > RUNS_MAX_FANIN)
+            failed = !merge_runs();
+        return !failed;
+    }
+
+    bool good() const { return !failed; }
+
+    // remove run files
+    void clear() {
+        for (auto& fname : fnames)
+            unlink(fname.c_str());
+        fnames.clear();
+    }
+
+    uint64_t capacity() const { return cap; }
+
+    bool order_by_s() const { return by_s; }
+    const std::vector<std::string>& files() const { return fnames; }
+};
+
+/**
+ * K-way merge of the runs of an engine, which returns triples by chunks.
+ * A chunk always ends at the boundary of keys, i.e., [vid|pid] (or vid
+ * w/ VERSATILE, since vid's predicates are inserted together).
+ */
+class TripleRunMerger {
+private:
+    struct Reader {
+        std::string fname;
+        FILE* file = NULL;
+        std::vector<triple_t> buf;
+        uint64_t pos = 0;
+
+        bool refill() {
+            buf.resize(buf.capacity());
+            uint64_t n = fread(buf.data(), sizeof(triple_t), buf.size(), file);
+            buf.resize(n);
+            pos = 0;
+            return n > 0;
+        }
+    };
+
+    bool by_s;
+    std::vector<Reader> readers;
+
+    // set once a run fails to be opened or read, and no more triples are returned
+    bool failed = false;
+
+    // read the next block of a run, and return false at the end of the run or on failure
+    bool refill(int r) {
+        Reader& rd = readers[r];
+        if (rd.refill())
+            return true;
+        if (ferror(rd.file)) {
+            logstream(LOG_ERROR) << "failed to read run file " << rd.fname << LOG_endl;
+            failed = true;
+        }
+        return false;
+    }
+
+    // (the head of a run, #run), the smallest on top
+    using head_t = std::pair<triple_t, int>;
+    struct greater {
+        bool by_s;
+        bool operator()(const head_t& h1, const head_t& h2) const {
+            return TripleRuns::less(h2.first, h1.first, by_s);
+        }
+    };
+    std::priority_queue<head_t, std::vector<head_t>, greater> heap;
+
+    bool has_last = false;
+    triple_t last;  // the last returned triple (dedup across runs)
+
+    bool same_key(const triple_t& t1, const triple_t& t2) const {
+        sid_t v1 = by_s ? t1.s : t1.o, v2 = by_s ? t2.s : t2.o;
+#ifdef VERSATILE
+        return v1 == v2;
+#else
+        return v1 == v2 && t1.p == t2.p;
+#endif
+    }
+
+    void advance(int r) {
+        Reader& rd = readers[r];
+        if (++rd.pos < rd.buf.size() || refill(r))
+            heap.push(head_t(rd.buf[rd.pos], r));
+    }
+
+    // pop the next triple (w/o duplicates)
+    bool pop(triple_t& triple) {
+        while (!heap.empty()) {
+            head_t h = heap.top();
+            heap.pop();
+            advance(h.second);
+            if (has_last && h.first == last)
+                continue;
+            triple = last = h.first;
+            has_last = true;
+            return true;
+        }
+        return false;
+    }
+
+    bool has_peek = false;
+    triple_t peeked;
+
+public:
+    TripleRunMerger(const TripleRuns& runs, uint64_t buf_sz)
+        : TripleRunMerger(runs.files(), runs.order_by_s(), buf_sz) {}
+
+    /**
+     * @param fnames run files
+     * @param by_s the order of runs (see TripleRuns)
+     * @param buf_sz the memory budget (bytes) of read buffers
+     */
+    TripleRunMerger(const std::vector<std::string>& fnames, bool by_s, uint64_t buf_sz)
+        : by_s(by_s), heap(greater{by_s}) {
+        readers.resize(fnames.size());
+        uint64_t n = std::max(buf_sz / std::max(fnames.size(), 1UL) / sizeof(triple_t), 1024UL);
+        for (int r = 0; r < fnames.size(); r++) {
+            readers[r].fname = fnames[r];
+            readers[r].file = fopen(fnames[r].c_str(), "rb");
+            if (readers[r].file == NULL) {
+                logstream(LOG_ERROR) << "failed to open run file " << fnames[r]
+                                     << " (" << strerror(errno) << ")" << LOG_endl;
+                failed = true;
+                return;
+            }
+            readers[r].buf.reserve(n);
+            if (refill(r))
+                heap.push(head_t(readers[r].buf[0], r));
+        }
+    }
+
+    ~TripleRunMerger() {
+        for (auto& rd : readers)
+            if (rd.file != NULL) fclose(rd.file);
+    }
+
+    TripleRunMerger(const TripleRunMerger&) = delete;
+    TripleRunMerger& operator=(const TripleRunMerger&) = delete;
+
+    // false if any run fails to be opened or read (some triples are lost)
+    bool good() const { return !failed; }
+
+    /**
+     * @brief Get the next chunk of about max_sz triples in the order of runs
+     *
+     * @return false if no more triples, or on failure (see good())
+     */
+    bool next_chunk(std::vector<triple_t>& chunk, uint64_t max_sz) {
+        chunk.clear();
+        triple_t triple;
+        while (!failed) {
+            if (has_peek) {
+                triple = peeked;
+                has_peek = false;
+            } else if (!pop(triple)) {
+                break;
+            }
+
+            // stop at the boundary of keys
+            if (chunk.size() >= max_sz && !same_key(chunk.back(), triple)) {
+                peeked = triple;
+                has_peek = true;
+                break;
+            }
+            chunk.push_back(triple);
+        }
+        return !failed && !chunk.empty();
+    }
+};
+
+inline bool TripleRuns::merge_runs() {
+    std::vector<std::string> inputs(fnames.begin(), fnames.begin() + RUNS_MAX_FANIN);
+    std::string fname = new_run();
+    FILE* file = open_run(fname);
+    if (file == NULL)
+        return false;
+
+    bool ok = true;
+    {
+        // use the buffer budget for reading (half) and writing (half)
+        TripleRunMerger merger(inputs, by_s, cap * sizeof(triple_t) / 2);
+        std::vector<triple_t> chunk;
+        while (ok && merger.next_chunk(chunk, std::max(cap / 2, 1UL)))
+            ok = write_run(file, fname, chunk);
+        ok = ok && merger.good();
+    }
+    if (!close_run(file, fname, ok))
+        return false;
+
+    for (auto& input : inputs)
+        unlink(input.c_str());
+    fnames.erase(fnames.begin(), fnames.begin() + RUNS_MAX_FANIN);
+    fnames.push_back(fname);
+    return true;
+}
+
+}  // namespace wukong
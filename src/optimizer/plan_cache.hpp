@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "core/common/type.hpp"
+
+#include "core/sparql/query.hpp"
+
+namespace wukong {
+
+/**
+ * A cache of query plans keyed by the shapes of queries
+ *
+ * The shape of a query is its patterns (incl. UNION groups) w/ the constant
+ * vertices abstracted, so all instances of a light-query template (see
+ * SPARQLQuery_Template) share a plan. The predicates, the types (i.e., the
+ * objects of rdf:type), the variables and the multi-threading factor are
+ * kept, since they steer the optimizer.
+ * A plan is the orders and directions of the raw patterns, which is the
+ * same as a user-defined plan (see Planner::set_plan), so it can be applied
+ * to any query of the same shape.
+ *
+ * The cache is private to a planner (i.e., a proxy thread), and cleared once
+ * the statistics are reloaded (see Stats::version).
+ */
+class PlanCache {
+public:
+    using key_t = std::vector<ssid_t>;
+
+    struct plan_t {
+        std::vector<int> orders;        // the raw patterns (from 1)
+        std::vector<std::string> dirs;  // the directions of patterns (>, <, >> or <<)
+        std::vector<plan_t> unions;
+    };
+
+    uint64_t version = 0;  // the version of statistics used by the cached plans
+
+    // the placeholder of constant vertices in keys
+    const static ssid_t CONST_PH = std::numeric_limits<ssid_t>::max();
+
+    static key_t get_key(const SPARQLQuery &r) {
+        key_t key;
+        key.push_back(r.mt_factor);
+        append_key(r.pattern_group, key);
+        return key;
+    }
+
+    /**
+     * @brief the plan of a pattern group, which reorders and redirects the
+     *        raw patterns to the planned ones (the inverse of Planner::set_direction)
+     *
+     * @return false if the planned patterns are not a permutation of the raw
+     *         patterns (e.g., rewritten by the planner)
+     */
+    static bool get_plan(const SPARQLQuery::PatternGroup &raw,
+                         const SPARQLQuery::PatternGroup &planned, plan_t &plan) {
+        if (raw.unions.size() != planned.unions.size()
+                || raw.patterns.size() != planned.patterns.size())
+            return false;
+
+        plan.orders.clear();
+        plan.dirs.clear();
+        // each raw pattern is mapped once (e.g., duplicated patterns)
+        std::vector<bool> used(raw.patterns.size(), false);
+        for (auto const &p : planned.patterns) {
+            int order = 0;
+            std::string dir;
+            for (size_t i = 0; i < raw.patterns.size() && dir.empty(); i++) {
+                if (used[i])
+                    continue;
+                dir = get_direction(raw.patterns[i], p);
+                order = i + 1;
+            }
+            if (dir.empty())
+                return false;
+            used[order - 1] = true;
+            plan.orders.push_back(order);
+            plan.dirs.push_back(dir);
+        }
+
+        plan.unions.resize(raw.unions.size());
+        for (size_t i = 0; i < raw.unions.size(); i++)
+            if (!get_plan(raw.unions[i], planned.unions[i], plan.unions[i]))
+                return false;
+        return true;
+    }
+
+    /// the cached plan of the key (nullptr if not found)
+    const plan_t *lookup(const key_t &key) {
+        auto it = plans.find(key);
+        if (it == plans.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        return &it->second;
+    }
+
+    /// cache at most #capacity plans, which are evicted all at once if full
+    void insert(const key_t &key, const plan_t &plan, uint64_t capacity) {
+        if (plans.size() >= capacity)
+            plans.clear();
+        plans[key] = plan;
+    }
+
+    void clear() { plans.clear(); }
+
+    uint64_t size() const { return plans.size(); }
+
+    uint64_t num_hits() const { return hits; }
+
+    uint64_t num_misses() const { return misses; }
+
+private:
+    boost::unordered_map<key_t, plan_t, boost::hash<key_t>> plans;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    static ssid_t abstract(ssid_t id) { return (id > 0) ? CONST_PH : id; }
+
+    static void append_key(const SPARQLQuery::PatternGroup &group, key_t &key) {
+        key.push_back(group.patterns.size());
+        for (auto const &p : group.patterns) {
+            key.push_back(abstract(p.subject));
+            key.push_back(p.predicate);
+            key.push_back(p.direction);
+            key.push_back((p.predicate == TYPE_ID) ? p.object : abstract(p.object));
+            key.push_back(p.pred_type);
+        #ifdef TRDF_MODE
+            key.push_back(p.time_interval.type);
+            if (p.time_interval.type != SPARQLQuery::UNDEFINED) {
+                key.push_back(p.time_interval.ts_var);
+                key.push_back(p.time_interval.te_var);
+            }
+        #endif
+        }
+
+        key.push_back(group.unions.size());
+        for (auto const &g : group.unions)
+            append_key(g, key);
+    }
+
+    // the direction turning the raw pattern to the planned one (empty if not)
+    static std::string get_direction(const SPARQLQuery::Pattern &raw,
+                                     const SPARQLQuery::Pattern &p) {
+        if (raw.direction != OUT || raw.pred_type != p.pred_type)
+            return "";
+    #ifdef TRDF_MODE
+        const SPARQLQuery::TimeIntervalPattern &ti = raw.time_interval, &pi = p.time_interval;
+        if (ti.type != pi.type
+                || (ti.type != SPARQLQuery::UNDEFINED
+                    && (ti.ts_value != pi.ts_value || ti.te_value != pi.te_value
+                        || ti.ts_var != pi.ts_var || ti.te_var != pi.te_var)))
+            return "";
+    #endif
+
+        if (p.predicate == raw.predicate) {
+            if (p.direction == OUT && p.subject == raw.subject && p.object == raw.object)
+                return ">";
+            if (p.direction == IN && p.subject == raw.object && p.object == raw.subject)
+                return "<";
+        }
+        // start from the predicate index
+        if (p.predicate == PREDICATE_ID && p.subject == raw.predicate) {
+            if (p.direction == IN && p.object == raw.subject)
+                return "<<";
+            if (p.direction == OUT && p.object == raw.object)
+                return ">>";
+        }
+        return "";
+    }
+};
+
+} // namespace wukong
@@ -12,6 +12,7 @@
 
 #include "optimizer/helper.hpp"
 #include "optimizer/cost_model.hpp"
+#include "optimizer/plan_cache.hpp"
 
 #include "utils/timer.hpp"
 
@@ -25,6 +26,7 @@ class Planner {
     const double BUDGET_TIME_RATIO = 0.1;
     Dgraph_helper helper;
     Stats *stats;
+    PlanCache plan_cache;
 
     std::vector<ssid_t> triples;
 #ifdef TRDF_MODE
@@ -619,12 +621,15 @@ class Planner {
     }
 
     // used by set direction
-    void set_ptypes_pos(std::vector<int> &ptypes_pos, const std::string &dir, int current_order, int raw_order) {
-        for (int i = 0; i < ptypes_pos.size(); i ++) {
+    // (raw_pos is the positions before reordering, since a moved position
+    //  may collide with the raw order of a later pattern)
+    void set_ptypes_pos(std::vector<int> &ptypes_pos, const std::vector<int> &raw_pos,
+                        const std::string &dir, int current_order, int raw_order) {
+        for (int i = 0; i < raw_pos.size(); i ++) {
             // check if any pos need to be changed
-            if (ptypes_pos[i] / 4 == raw_order) {
+            if (raw_pos[i] / 4 == raw_order) {
                 if (dir == "<") {
-                    switch (ptypes_pos[i] % 4) {
+                    switch (raw_pos[i] % 4) {
                     case 0:
                         ptypes_pos[i] = current_order * 4 + 3;
                         break;
@@ -635,12 +640,12 @@ class Planner {
                         ptypes_pos[i] = current_order * 4 + 0;
                         break;
                     default:
-                        ptypes_pos[i] = current_order * 4 + ptypes_pos[i] % 4;
+                        ptypes_pos[i] = current_order * 4 + raw_pos[i] % 4;
                     }
                 } else if (dir == ">") {
-                    ptypes_pos[i] = current_order * 4 + ptypes_pos[i] % 4;
+                    ptypes_pos[i] = current_order * 4 + raw_pos[i] % 4;
                 } else if (dir == "<<") {
-                    switch (ptypes_pos[i] % 4) {
+                    switch (raw_pos[i] % 4) {
                     case 0:
                         ptypes_pos[i] = current_order * 4 + 3;
                         break;
@@ -648,15 +653,15 @@ class Planner {
                         ptypes_pos[i] = current_order * 4 + 0;
                         break;
                     default:
-                        ptypes_pos[i] = current_order * 4 + ptypes_pos[i] % 4;
+                        ptypes_pos[i] = current_order * 4 + raw_pos[i] % 4;
                     }
                 } else if (dir == ">>") {
-                    switch (ptypes_pos[i] % 4) {
+                    switch (raw_pos[i] % 4) {
                     case 1:
                         ptypes_pos[i] = current_order * 4 + 0;
                         break;
                     default:
-                        ptypes_pos[i] = current_order * 4 + ptypes_pos[i] % 4;
+                        ptypes_pos[i] = current_order * 4 + raw_pos[i] % 4;
                     }
                 }
             }
@@ -669,6 +674,7 @@ class Planner {
                        const std::vector<std::string> &dirs,
                        std::vector<int> &ptypes_pos = empty_ptypes_pos) {
         std::vector<SPARQLQuery::Pattern> patterns;
+        const std::vector<int> raw_pos = ptypes_pos;
         for (int i = 0; i < orders.size(); i++) {
             // number of orders starts from 1
             SPARQLQuery::Pattern pattern = group.patterns[orders[i] - 1];
@@ -692,7 +698,7 @@ class Planner {
             }
 
             if (ptypes_pos.size() != 0)
-                set_ptypes_pos(ptypes_pos, dirs[i], patterns.size(), orders[i] - 1);
+                set_ptypes_pos(ptypes_pos, raw_pos, dirs[i], patterns.size(), orders[i] - 1);
             patterns.push_back(pattern);
         }
         group.patterns = patterns;
@@ -707,9 +713,33 @@ class Planner {
     CostModel cost_model;
     
     // generate optimal query plan by optimizer
+    // (reuse the plan of the queries in the same shape if cached)
     // @return
     bool generate_plan(SPARQLQuery &r) {
-        return do_plan(r, false);
+        if (Global::plan_cache_size == 0)
+            return do_plan(r, false);
+
+        // the cached plans are stale once the statistics are reloaded
+        if (plan_cache.version != stats->version) {
+            plan_cache.clear();
+            plan_cache.version = stats->version;
+        }
+
+        PlanCache::key_t key = PlanCache::get_key(r);
+        const PlanCache::plan_t *plan = plan_cache.lookup(key);
+        if (plan != nullptr) {
+            set_plan(r.pattern_group, *plan);
+            return true;
+        }
+
+        SPARQLQuery::PatternGroup raw = r.pattern_group;
+        if (!do_plan(r, false))
+            return false;
+
+        PlanCache::plan_t new_plan;
+        if (PlanCache::get_plan(raw, r.pattern_group, new_plan))
+            plan_cache.insert(key, new_plan, Global::plan_cache_size);
+        return true;
     }
 
     // test query optimizing (search an optimal plan)
@@ -768,6 +798,16 @@ class Planner {
         set_direction(group, orders, dirs, ptypes_pos);
         return true;
     }
+
+    // set cached query plan (see PlanCache::get_plan)
+    void set_plan(SPARQLQuery::PatternGroup &group, const PlanCache::plan_t &plan,
+                  std::vector<int> &ptypes_pos = empty_ptypes_pos) {
+        set_direction(group, plan.orders, plan.dirs, ptypes_pos);
+        for (int i = 0; i < plan.unions.size(); i++)
+            set_plan(group.unions[i], plan.unions[i]);
+    }
+
+    const PlanCache &get_plan_cache() const { return plan_cache; }
 };
 
 } // namespace wukong
\ No newline at end of file
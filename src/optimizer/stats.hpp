@@ -72,6 +72,7 @@ private:
                >> global_type2int
                >> global_single2complex;
         }
+        version++;  // stale the plans cached by planners (see PlanCache)
     }
 
     friend class boost::serialization::access;
@@ -105,6 +106,7 @@ public:
     std::unordered_set<ssid_t> global_useful_type;
 
     int sid;
+    uint64_t version = 0;  // bumped once the global statistics are (re)loaded
 
     Stats(int sid) : sid(sid) { }
 
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2021 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+
+#include <iostream>
+
+#include "stringserver/string_dict.hpp"
+
+static void usage(char* fn) {
+    std::cout << "usage: " << fn << " <data file directory> [output file]" << std::endl;
+    std::cout << "  build the string dictionary from str_index, str_attr_index and str_normal," << std::endl;
+    std::cout << "  which is <data file directory>/str_dict by default (used by string servers)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    // parse argv
+    std::string input_folder = std::string(argv[1]);
+    if (input_folder.back() != '/') input_folder += "/";
+    std::string output_file = (argc > 2) ? std::string(argv[2]) : input_folder + "str_dict";
+
+    if (!wukong::StringDict::build(input_folder, output_file))
+        exit(EXIT_FAILURE);
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "core/common/type.hpp"
+
+// utils
+#include "utils/logger2.hpp"
+
+namespace wukong {
+
+// statistics of a cache shard
+struct cache_stat_t {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    uint64_t size = 0;
+
+    cache_stat_t& operator+=(const cache_stat_t& s) {
+        hits += s.hits;
+        misses += s.misses;
+        inserts += s.inserts;
+        evictions += s.evictions;
+        size += s.size;
+        return *this;
+    }
+};
+
+/**
+ * A sharded cache w/ CLOCK eviction
+ *
+ * Keys are hashed to shards, each of which has its own lock, hash map,
+ * and clock. A hit only sets the reference bit of the entry (no list to
+ * reorder), so that the critical section is a hash lookup, and threads
+ * rarely contend for the same shard. A miss inserts the entry and evicts
+ * the first entry whose reference bit is unset (second chance).
+ *
+ * Values should be cheap to copy (e.g., IDs or refcounted handles).
+ */
+template <typename K, typename V, typename Hash = boost::hash<K>>
+class ShardedCache {
+private:
+    struct entry_t {
+        K key;
+        V val;
+        bool ref;
+    };
+
+    // aligned to avoid false sharing between the locks of shards
+    struct alignas(64) shard_t {
+        pthread_spinlock_t lock;
+        boost::unordered_map<K, uint64_t, Hash> index;  // key to the position in clock
+        std::vector<entry_t> clock;
+        uint64_t hand = 0;
+        uint64_t capacity = 0;
+        cache_stat_t stat;
+    };
+
+    std::vector<shard_t> shards;
+    Hash hasher;
+
+    shard_t& get_shard(const K& key) {
+        // mix the hash, since std/boost hash of integers is identity
+        uint64_t h = hasher(key) * 0x9E3779B97F4A7C15ULL;
+        return shards[(h >> 32) % shards.size()];
+    }
+
+public:
+    /**
+     * @param capacity the total number of entries
+     * @param nshards the number of shards
+     */
+    ShardedCache(uint64_t capacity, int nshards) : shards(std::max(nshards, 1)) {
+        for (int i = 0; i < shards.size(); i++) {
+            shard_t& shard = shards[i];
+            pthread_spin_init(&shard.lock, 0);
+            // distribute the capacity evenly (at least one entry per shard)
+            shard.capacity = std::max<uint64_t>(capacity / shards.size() + (i < capacity % shards.size()), 1);
+            shard.index.reserve(shard.capacity);
+            shard.clock.reserve(shard.capacity);
+        }
+    }
+
+    ~ShardedCache() {
+        for (auto& shard : shards)
+            pthread_spin_destroy(&shard.lock);
+    }
+
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+
+    // @return true and the value (in val) if the key is cached
+    bool lookup(const K& key, V& val) {
+        shard_t& shard = get_shard(key);
+        pthread_spin_lock(&shard.lock);
+        auto it = shard.index.find(key);
+        bool found = (it != shard.index.end());
+        if (found) {
+            entry_t& e = shard.clock[it->second];
+            e.ref = true;
+            val = e.val;
+            shard.stat.hits++;
+        } else {
+            shard.stat.misses++;
+        }
+        pthread_spin_unlock(&shard.lock);
+        return found;
+    }
+
+    // insert or update an entry
+    void insert(const K& key, const V& val) {
+        shard_t& shard = get_shard(key);
+        pthread_spin_lock(&shard.lock);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.clock[it->second].val = val;
+        } else if (shard.clock.size() < shard.capacity) {
+            shard.index.emplace(key, shard.clock.size());
+            shard.clock.push_back(entry_t{key, val, false});
+            shard.stat.inserts++;
+        } else {
+            // CLOCK: give a second chance to the referenced entries
+            while (shard.clock[shard.hand].ref) {
+                shard.clock[shard.hand].ref = false;
+                shard.hand = (shard.hand + 1) % shard.capacity;
+            }
+            entry_t& victim = shard.clock[shard.hand];
+            shard.index.erase(victim.key);
+            victim = entry_t{key, val, false};
+            shard.index.emplace(key, shard.hand);
+            shard.hand = (shard.hand + 1) % shard.capacity;
+            shard.stat.inserts++;
+            shard.stat.evictions++;
+        }
+        pthread_spin_unlock(&shard.lock);
+    }
+
+    int num_shards() const { return shards.size(); }
+
+    // the statistics of each shard
+    std::vector<cache_stat_t> get_stats() {
+        std::vector<cache_stat_t> stats(shards.size());
+        for (int i = 0; i < shards.size(); i++) {
+            pthread_spin_lock(&shards[i].lock);
+            stats[i] = shards[i].stat;
+            stats[i].size = shards[i].clock.size();
+            pthread_spin_unlock(&shards[i].lock);
+        }
+        return stats;
+    }
+
+    cache_stat_t get_total_stat() {
+        cache_stat_t total;
+        for (auto& s : get_stats())
+            total += s;
+        return total;
+    }
+};
+
+}  // namespace wukong
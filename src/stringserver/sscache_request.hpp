@@ -37,7 +37,12 @@ namespace wukong {
 
 enum class SSCacheReqType { TRANS_STR = 0,
                             TRANS_ID = 1,
-                            LOAD_MAPPING = 2 };
+                            LOAD_MAPPING = 2,
+                            TRANS_STR_BATCH = 3,
+                            TRANS_ID_BATCH = 4 };
+
+// the maximum #IDs (strings) translated by a batched request
+#define SSCACHE_BATCH_SZ 4096
 
 /**
  * String<->ID mapping request
@@ -52,6 +57,9 @@ private:
         ar& str;
         ar& vid;
         ar& success;
+        ar& vids;
+        ar& strs;
+        ar& found;
     }
 
 public:
@@ -60,6 +68,11 @@ public:
     sid_t vid;
     bool success = false;
 
+    // batched requests (found[i]: whether vids[i] or strs[i] is translated)
+    std::vector<sid_t> vids;
+    std::vector<std::string> strs;
+    std::vector<bool> found;
+
     SSCacheRequest() {}
 
     // used for sscache send TRANS_ID requests
@@ -69,6 +82,14 @@ public:
     // used for sscache send TRANS_STR requests
     explicit SSCacheRequest(std::string str)
         : req_type(SSCacheReqType::TRANS_STR), str(str) {}
+
+    // used for sscache send TRANS_ID_BATCH requests
+    explicit SSCacheRequest(const std::vector<sid_t>& vids)
+        : req_type(SSCacheReqType::TRANS_ID_BATCH), vids(vids) {}
+
+    // used for sscache send TRANS_STR_BATCH requests
+    explicit SSCacheRequest(const std::vector<std::string>& strs)
+        : req_type(SSCacheReqType::TRANS_STR_BATCH), strs(strs) {}
 };
 
 }  // namespace wukong
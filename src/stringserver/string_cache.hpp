@@ -27,7 +27,6 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -39,6 +38,7 @@
 
 #include "client/rpc_client.hpp"
 
+#include "stringserver/sharded_cache.hpp"
 #include "stringserver/sscache_request.hpp"
 #include "stringserver/string_mapping.hpp"
 
@@ -49,151 +49,6 @@
 
 namespace wukong {
 
-class Cache {
-private:
-    // cache statistics
-    uint64_t total_miss;
-    uint64_t total_hit;
-
-    // lock for multiple threads r/w cache
-    pthread_spinlock_t cache_lock;
-
-    // Cache
-    boost::unordered_map<std::string, sid_t> simap;  // STRING to ID
-    boost::unordered_map<sid_t, std::string> ismap;  // ID to STRING
-
-    // cache size to be determined
-    const uint32_t capacity;
-
-public:
-    explicit Cache(uint32_t max_cache_size) : capacity(max_cache_size) {
-        pthread_spin_init(&cache_lock, 0);
-
-        total_miss = 0;
-        total_hit = 0;
-
-        simap.reserve(capacity);
-        ismap.reserve(capacity);
-    }
-    ~Cache() {}
-
-    bool cached(std::string str) {
-        pthread_spin_lock(&cache_lock);
-        auto it = simap.find(str);
-        bool iscached = (it != simap.end());
-        if (iscached) {
-            touch(it->second);
-        }
-        pthread_spin_unlock(&cache_lock);
-        return iscached;
-    }
-
-    bool cached(sid_t vid) {
-        pthread_spin_lock(&cache_lock);
-        auto it = ismap.find(vid);
-        bool iscached = (it != ismap.end());
-        if (iscached) {
-            touch(vid);
-        }
-        pthread_spin_unlock(&cache_lock);
-        return iscached;
-    }
-
-    // @return true given vid is cached if cached, otherwise false.
-    std::pair<bool, std::string> get_if_cached(sid_t vid) {
-        std::string get_str;
-        pthread_spin_lock(&cache_lock);
-        auto it = ismap.find(vid);
-        bool iscached = (it != ismap.end());
-        if (iscached) {
-            get_str = it->second;
-            touch(vid);
-        }
-        pthread_spin_unlock(&cache_lock);
-        return std::make_pair(iscached, get_str);
-    }
-
-    std::pair<bool, sid_t> get_if_cached(std::string str) {
-        sid_t get_sid;
-        pthread_spin_lock(&cache_lock);
-        auto it = simap.find(str);
-        bool iscached = (it != simap.end());
-        if (iscached) {
-            get_sid = it->second;
-            touch(it->second);
-        }
-        pthread_spin_unlock(&cache_lock);
-        return std::make_pair(iscached, get_sid);
-    }
-
-    void update(sid_t vid, std::string str) {
-        pthread_spin_lock(&cache_lock);
-        // don't exsit in cache
-        if (ismap.find(vid) == ismap.end()) {
-            // cache is full
-            if (ismap.size() >= capacity) {
-                sid_t evict_vid = evict_old_item();
-                simap.erase(ismap[evict_vid]);
-                ismap.erase(evict_vid);
-                exit(evict_vid);
-            }
-            simap[str] = vid;
-            ismap[vid] = str;
-            enter(vid);
-        } else {
-            // already exsit in cache, so update previous cache item
-            simap[str] = vid;
-            ismap[vid] = str;
-        }
-        pthread_spin_unlock(&cache_lock);
-    }
-
-    virtual void touch(sid_t vid) = 0;
-    virtual void enter(sid_t vid) = 0;
-    virtual void exit(sid_t vid) = 0;
-    virtual sid_t evict_old_item() = 0;
-};
-
-class FIFOCache : public Cache {
-private:
-    std::list<sid_t> fifo_queue;
-
-public:
-    explicit FIFOCache(uint32_t max_cache_size) : Cache(max_cache_size) {}
-    ~FIFOCache() {}
-
-    // FIFO strategy cache do noting when item is touched
-    void touch(sid_t vid) override {}
-    void enter(sid_t vid) override { fifo_queue.emplace_front(vid); }
-    void exit(sid_t vid) override { fifo_queue.pop_back(); }
-    sid_t evict_old_item() override { return fifo_queue.back(); }
-};
-
-class LRUCache : public Cache {
-private:
-    std::list<sid_t> lru_queue;
-    std::unordered_map<sid_t, std::list<sid_t>::iterator> key_finder;
-
-public:
-    explicit LRUCache(uint32_t max_cache_size) : Cache(max_cache_size) {}
-    ~LRUCache() {}
-
-    void touch(sid_t vid) override {
-        // move the touched element at the beginning of the lru_queue
-        lru_queue.splice(lru_queue.begin(), lru_queue, key_finder[vid]);
-    }
-    void enter(sid_t vid) override {
-        lru_queue.emplace_front(vid);
-        key_finder[vid] = lru_queue.begin();
-    }
-    void exit(sid_t vid) override {
-        // remove the least recently used element
-        key_finder.erase(lru_queue.back());
-        lru_queue.pop_back();
-    }
-    sid_t evict_old_item() override { return lru_queue.back(); }
-};
-
 class StringRPCClient : public RPCClient {
 public:
     StringRPCClient() {}
@@ -235,7 +90,11 @@ private:
     std::unordered_map<std::string, sid_t> index_simap;
     std::unordered_map<sid_t, std::string> index_ismap;
 
-    std::shared_ptr<Cache> cache;
+    // ID to STRING and STRING to ID
+    // (the strings are refcounted, so that hits copy them outside the lock of shards)
+    using str_handle_t = std::shared_ptr<const std::string>;
+    ShardedCache<sid_t, str_handle_t> id_cache;
+    ShardedCache<std::string, sid_t> str_cache;
 
     const sid_t start_normal_id = 1 << NBITS_IDX;
 
@@ -330,10 +189,12 @@ private:
 
 public:
     static int cache_capacity;
+    static int cache_shards;
 
     explicit StringCache(std::string dname)
-        : rpc_clients(Global::num_threads) {
-        cache = std::make_shared<FIFOCache>(cache_capacity);
+        : rpc_clients(Global::num_threads),
+          id_cache(cache_capacity, cache_shards),
+          str_cache(cache_capacity, cache_shards) {
 
         // parse host and port from string server addr
         std::string addr = Global::standalone_str_server_addr;
@@ -364,59 +225,181 @@ public:
     }
 
     ~StringCache() {
+        print_cache_stat();
         for (auto& client : rpc_clients) {
             client.disconnect();
         }
     }
 
+    void print_cache_stat() {
+        auto print = [](const std::string& name, const std::vector<cache_stat_t>& stats) {
+            cache_stat_t total;
+            uint64_t max_hits = 0;
+            for (auto& s : stats) {
+                total += s;
+                max_hits = std::max(max_hits, s.hits);
+            }
+            logstream(LOG_INFO) << "[StringCache] " << name << ": #hits: " << total.hits
+                                << ", #misses: " << total.misses << ", #evictions: " << total.evictions
+                                << ", #entries: " << total.size << ", #hits of the hottest shard: "
+                                << max_hits << " (" << stats.size() << " shards)" << LOG_endl;
+        };
+        print("id2str", id_cache.get_stats());
+        print("str2id", str_cache.get_stats());
+    }
+
     std::pair<bool, std::string> id2str(int tid, sid_t vid) override {
         if (is_index_id(vid)) {
-            if (index_ismap.count(vid) != 0) {
-                return std::make_pair(true, index_ismap[vid]);
-            } else {
+            auto it = index_ismap.find(vid);
+            if (it == index_ismap.end())
                 return std::make_pair(false, "");
+            return std::make_pair(true, it->second);
+        }
+
+        str_handle_t str;
+        if (id_cache.lookup(vid, str))
+            return std::make_pair(true, *str);
+
+        SSCacheRequest request(vid);
+        rpc_clients[tid].execute_string_request(request);
+        if (!request.success)
+            return std::make_pair(false, "");
+
+        logstream(LOG_DEBUG) << "String translation success!!" << LOG_endl;
+        str = std::make_shared<const std::string>(std::move(request.str));
+        id_cache.insert(vid, str);
+        str_cache.insert(*str, vid);
+        return std::make_pair(true, *str);
+    }
+
+    std::pair<bool, sid_t> str2id(int tid, std::string str) override {
+        auto it = index_simap.find(str);
+        if (it != index_simap.end())
+            return std::make_pair(true, it->second);
+
+        sid_t vid;
+        if (str_cache.lookup(str, vid)) {
+            logstream(LOG_DEBUG) << "Found:" << str << " in cache." << LOG_endl;
+            return std::make_pair(true, vid);
+        }
+
+        logstream(LOG_DEBUG) << "Not found:" << str << " in cache." << LOG_endl;
+        SSCacheRequest request(str);
+        rpc_clients[tid].execute_string_request(request);
+        if (!request.success)
+            return std::make_pair(false, 0);
+
+        logstream(LOG_DEBUG) << "String translation success!!" << LOG_endl;
+        str_cache.insert(str, request.vid);
+        id_cache.insert(request.vid, std::make_shared<const std::string>(str));
+        return std::make_pair(true, request.vid);
+    }
+
+    /**
+     * @brief Translate a batch of IDs (e.g., a column of results)
+     *
+     * Index IDs and cached IDs are translated locally, and the rest are
+     * deduplicated and sent to the string server by batches of at most
+     * SSCACHE_BATCH_SZ IDs, instead of one RPC per ID.
+     */
+    std::vector<std::pair<bool, std::string>> id2str_batch(int tid, const std::vector<sid_t>& vids) override {
+        std::vector<std::pair<bool, std::string>> strs(vids.size(), std::make_pair(false, std::string()));
+
+        std::vector<sid_t> misses;                         // deduplicated
+        boost::unordered_map<sid_t, uint64_t> miss_idx;    // ID to the index of misses
+        std::vector<std::pair<uint64_t, uint64_t>> waits;  // (index of vids, index of misses)
+        for (uint64_t i = 0; i < vids.size(); i++) {
+            sid_t vid = vids[i];
+            if (is_index_id(vid)) {
+                auto it = index_ismap.find(vid);
+                if (it != index_ismap.end())
+                    strs[i] = std::make_pair(true, it->second);
+                continue;
             }
+
+            str_handle_t str;
+            if (id_cache.lookup(vid, str)) {
+                strs[i] = std::make_pair(true, *str);
+                continue;
+            }
+
+            auto ret = miss_idx.emplace(vid, misses.size());
+            if (ret.second) misses.push_back(vid);
+            waits.push_back(std::make_pair(i, ret.first->second));
         }
-        auto cache_result = cache->get_if_cached(vid);
-        if (cache_result.first) {
-            return std::make_pair(true, cache_result.second);
-        } else {
-            int dst_tid = rand() % Global::num_threads;
-            SSCacheRequest request(vid);
 
+        std::vector<str_handle_t> found(misses.size());
+        for (uint64_t off = 0; off < misses.size(); off += SSCACHE_BATCH_SZ) {
+            uint64_t end = std::min<uint64_t>(off + SSCACHE_BATCH_SZ, misses.size());
+            SSCacheRequest request(std::vector<sid_t>(misses.begin() + off, misses.begin() + end));
             rpc_clients[tid].execute_string_request(request);
-            if (request.success) {
-                logstream(LOG_INFO) << "String translation success!!" << LOG_endl;
-                cache->update(vid, request.str);
-                return std::make_pair(true, request.str);
-            } else {
-                return std::make_pair(false, "");
+            if (!request.success)
+                continue;
+
+            for (uint64_t j = 0; j < request.found.size(); j++) {
+                if (!request.found[j]) continue;
+                str_handle_t str = std::make_shared<const std::string>(std::move(request.strs[j]));
+                id_cache.insert(misses[off + j], str);
+                str_cache.insert(*str, misses[off + j]);
+                found[off + j] = str;
             }
         }
+        logstream(LOG_DEBUG) << "[StringCache] translate " << vids.size() << " IDs ("
+                             << misses.size() << " misses)" << LOG_endl;
+
+        for (auto& w : waits)
+            if (found[w.second] != nullptr)
+                strs[w.first] = std::make_pair(true, *found[w.second]);
+        return strs;
     }
 
-    std::pair<bool, sid_t> str2id(int tid, std::string str) override {
-        if (index_simap.count(str) != 0) {
-            return std::make_pair(true, index_simap[str]);
+    // translate a batch of strings (see id2str_batch)
+    std::vector<std::pair<bool, sid_t>> str2id_batch(int tid, const std::vector<std::string>& strs) override {
+        std::vector<std::pair<bool, sid_t>> vids(strs.size(), std::make_pair(false, 0));
+
+        std::vector<std::string> misses;
+        boost::unordered_map<std::string, uint64_t> miss_idx;
+        std::vector<std::pair<uint64_t, uint64_t>> waits;
+        for (uint64_t i = 0; i < strs.size(); i++) {
+            auto it = index_simap.find(strs[i]);
+            if (it != index_simap.end()) {
+                vids[i] = std::make_pair(true, it->second);
+                continue;
+            }
+
+            sid_t vid;
+            if (str_cache.lookup(strs[i], vid)) {
+                vids[i] = std::make_pair(true, vid);
+                continue;
+            }
+
+            auto ret = miss_idx.emplace(strs[i], misses.size());
+            if (ret.second) misses.push_back(strs[i]);
+            waits.push_back(std::make_pair(i, ret.first->second));
         }
-        auto cache_result = cache->get_if_cached(str);
-        if (cache_result.first) {
-            logstream(LOG_INFO) << "Found:" << str << " in cache." << LOG_endl;
-            return std::make_pair(true, cache_result.second);
-        } else {
-            logstream(LOG_INFO) << "Not found:" << str << " in cache." << LOG_endl;
-            int dst_tid = rand() % Global::num_threads;
-            SSCacheRequest request(str);
 
+        std::vector<std::pair<bool, sid_t>> found(misses.size(), std::make_pair(false, 0));
+        for (uint64_t off = 0; off < misses.size(); off += SSCACHE_BATCH_SZ) {
+            uint64_t end = std::min<uint64_t>(off + SSCACHE_BATCH_SZ, misses.size());
+            SSCacheRequest request(std::vector<std::string>(misses.begin() + off, misses.begin() + end));
             rpc_clients[tid].execute_string_request(request);
-            if (request.success) {
-                logstream(LOG_INFO) << "String translation success!!" << LOG_endl;
-                cache->update(request.vid, str);
-                return std::make_pair(true, request.vid);
-            } else {
-                return std::make_pair(false, 0);
+            if (!request.success)
+                continue;
+
+            for (uint64_t j = 0; j < request.found.size(); j++) {
+                if (!request.found[j]) continue;
+                sid_t vid = request.vids[j];
+                str_cache.insert(misses[off + j], vid);
+                id_cache.insert(vid, std::make_shared<const std::string>(misses[off + j]));
+                found[off + j] = std::make_pair(true, vid);
             }
         }
+        logstream(LOG_DEBUG) << "[StringCache] translate " << strs.size() << " strings ("
+                             << misses.size() << " misses)" << LOG_endl;
+
+        for (auto& w : waits)
+            vids[w.first] = found[w.second];
+        return vids;
     }
 
     bool add(std::string str, sid_t vid) override {
@@ -426,6 +409,7 @@ public:
     }
 };
 
-    int StringCache::cache_capacity = 10000;
+int StringCache::cache_capacity = 10000;
+int StringCache::cache_shards = 64;
 
 }  // namespace wukong
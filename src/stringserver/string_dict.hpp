@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2021 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/common/type.hpp"
+#include "core/store/vertex.hpp"
+
+#include "stringserver/term_kind.hpp"
+#include "stringserver/typed_literal.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+#include "utils/logger2.hpp"
+
+namespace wukong {
+
+/**
+ * A compact and mmap-able ID-STRING dictionary (read-only)
+ *
+ * It is built offline from the ID-mapping files (str_index, str_attr_index
+ * and str_normal) by build_string_dict, and opened by StringServer in O(1)
+ * w/o parsing, since all lookups work on the mapped file directly. The pages
+ * are loaded on demand and shared by all processes mapping the same file.
+ *
+ * Strings are sorted and front-coded by blocks of DICT_BLOCK_SZ strings:
+ * the first string of a block is stored in full, and each of the rest only
+ * stores the length of the prefix shared w/ its predecessor and the suffix.
+ * - str2id: binary search on the first strings of blocks, and a scan of the
+ *           block (w/ an array of IDs in the sorted order)
+ * - id2str: the position of the ID in the sorted order (dense arrays of
+ *           index and normal IDs), and a decode of its block up to it
+ * The typed values of literals (see typed_literal.hpp) and the kinds of terms
+ * (see term_kind.hpp) are also decoded at build time.
+ *
+ * file layout (sections are 8-byte aligned):
+ *   dict_header_t
+ *   uint64_t blocks[nblocks + 1]         offsets of blocks in the data
+ *   sid_t    ids[nstrs]                  IDs in the sorted order of strings
+ *   uint32_t index_pos[index_range]      positions of index IDs [0, index_range)
+ *   uint32_t normal_pos[normal_range]    positions of normal IDs [normal_base, ...)
+ *   char     types[index_range]          types of index IDs (data_type)
+ *   dict_typed_t typed[ntyped]           typed values of literals (sorted by IDs)
+ *   uint8_t  kinds[nstrs]                term kinds in the sorted order of strings
+ *   data                                 front-coded blocks (varint lengths)
+ */
+
+#define DICT_MAGIC "WKSTRDCT"
+#define DICT_VERSION 3
+#define DICT_BLOCK_SZ 16
+#define DICT_NO_POS UINT32_MAX
+
+struct dict_typed_t {
+    sid_t id;
+    uint32_t kind;
+    double val;
+};
+
+struct dict_header_t {
+    char magic[8];
+    uint64_t version;
+    uint64_t id_size;  // sizeof(sid_t)
+    uint64_t nstrs;
+    uint64_t nblocks;
+    uint64_t index_range;
+    uint64_t normal_base;
+    uint64_t normal_range;
+    uint64_t next_index_id;
+    uint64_t next_normal_id;
+    uint64_t ntyped;
+
+    // offsets of sections in the file
+    uint64_t blocks_off;
+    uint64_t ids_off;
+    uint64_t index_pos_off;
+    uint64_t normal_pos_off;
+    uint64_t types_off;
+    uint64_t typed_off;
+    uint64_t kinds_off;
+    uint64_t data_off;
+    uint64_t file_sz;
+};
+
+class StringDict {
+private:
+    char* addr = nullptr;
+    uint64_t sz = 0;
+
+    const dict_header_t* header = nullptr;
+    const uint64_t* blocks = nullptr;
+    const sid_t* ids = nullptr;
+    const uint32_t* index_pos = nullptr;
+    const uint32_t* normal_pos = nullptr;
+    const char* types = nullptr;
+    const dict_typed_t* typed = nullptr;
+    const uint8_t* kinds = nullptr;
+    const char* data = nullptr;
+
+    static uint64_t align8(uint64_t off) { return (off + 7) & ~7UL; }
+
+    static void put_varint(std::string& buf, uint64_t v) {
+        while (v >= 0x80) {
+            buf.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        buf.push_back(static_cast<char>(v));
+    }
+
+    static uint64_t get_varint(const char*& p) {
+        uint64_t v = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+    }
+
+    // compare w/ a string stored in place (the same order as std::string)
+    static int compare(const std::string& str, const char* p, uint64_t len) {
+        int cmp = memcmp(str.data(), p, std::min<uint64_t>(str.size(), len));
+        if (cmp != 0) return cmp;
+        return (str.size() < len) ? -1 : (str.size() > len);
+    }
+
+    uint32_t id2pos(sid_t id) const {
+        if (id < header->index_range)
+            return index_pos[id];
+        if (id >= header->normal_base && id - header->normal_base < header->normal_range)
+            return normal_pos[id - header->normal_base];
+        return DICT_NO_POS;
+    }
+
+    void close() {
+        if (addr != nullptr) munmap(addr, sz);
+        addr = nullptr;
+        header = nullptr;
+    }
+
+public:
+    // an entry of the dictionary (type: the data_type of an index ID)
+    struct entry_t {
+        std::string str;
+        sid_t id;
+        char type;
+    };
+
+    StringDict() {}
+
+    ~StringDict() { close(); }
+
+    StringDict(const StringDict&) = delete;
+    StringDict& operator=(const StringDict&) = delete;
+
+    /**
+     * @brief Map a dictionary file (read-only)
+     *
+     * @return false if the file is missing or invalid
+     */
+    bool open(const std::string& fname) {
+        close();
+        int fd = ::open(fname.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(dict_header_t)) {
+            ::close(fd);
+            logstream(LOG_ERROR) << "invalid string dictionary: " << fname << LOG_endl;
+            return false;
+        }
+
+        sz = st.st_size;
+        void* p = mmap(NULL, sz, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping keeps the file
+        if (p == MAP_FAILED) {
+            logstream(LOG_ERROR) << "failed to mmap string dictionary: " << fname << LOG_endl;
+            return false;
+        }
+        addr = static_cast<char*>(p);
+
+        header = reinterpret_cast<const dict_header_t*>(addr);
+        if (memcmp(header->magic, DICT_MAGIC, sizeof(header->magic)) != 0
+                || header->version != DICT_VERSION || header->id_size != sizeof(sid_t)
+                || header->file_sz != sz) {
+            logstream(LOG_ERROR) << "string dictionary " << fname << " is corrupted, "
+                                 << "or built by an incompatible version (sid_t)" << LOG_endl;
+            close();
+            return false;
+        }
+
+        blocks = reinterpret_cast<const uint64_t*>(addr + header->blocks_off);
+        ids = reinterpret_cast<const sid_t*>(addr + header->ids_off);
+        index_pos = reinterpret_cast<const uint32_t*>(addr + header->index_pos_off);
+        normal_pos = reinterpret_cast<const uint32_t*>(addr + header->normal_pos_off);
+        types = addr + header->types_off;
+        typed = reinterpret_cast<const dict_typed_t*>(addr + header->typed_off);
+        kinds = reinterpret_cast<const uint8_t*>(addr + header->kinds_off);
+        data = addr + header->data_off;
+        return true;
+    }
+
+    bool is_open() const { return header != nullptr; }
+
+    uint64_t size() const { return header->nstrs; }
+
+    uint64_t file_size() const { return sz; }
+
+    sid_t get_next_index_id() const { return header->next_index_id; }
+
+    sid_t get_next_normal_id() const { return header->next_normal_id; }
+
+    // visit the types of index IDs, i.e., func(id, type)
+    template <typename F>
+    void foreach_index_type(F func) const {
+        for (uint64_t id = 0; id < header->index_range; id++)
+            if (index_pos[id] != DICT_NO_POS) func(static_cast<sid_t>(id), types[id]);
+    }
+
+    std::pair<bool, std::string> id2str(sid_t id) const {
+        uint32_t pos = id2pos(id);
+        if (pos == DICT_NO_POS)
+            return std::make_pair(false, "");
+
+        // decode the block up to the position
+        const char* p = data + blocks[pos / DICT_BLOCK_SZ];
+        std::string str;
+        uint64_t len = get_varint(p);
+        str.assign(p, len);
+        p += len;
+        for (uint64_t k = pos % DICT_BLOCK_SZ; k > 0; k--) {
+            uint64_t lcp = get_varint(p);
+            len = get_varint(p);
+            str.resize(lcp);
+            str.append(p, len);
+            p += len;
+        }
+        return std::make_pair(true, str);
+    }
+
+    // @return false if the ID is not in the dictionary
+    bool term_kind(sid_t id, uint8_t& kind) const {
+        uint32_t pos = id2pos(id);
+        if (pos == DICT_NO_POS)
+            return false;
+        kind = kinds[pos];
+        return true;
+    }
+
+    // @return false if the ID is not a typed literal
+    bool typed_value(sid_t id, typed_value_t& v) const {
+        const dict_typed_t* end = typed + header->ntyped;
+        const dict_typed_t* it = std::lower_bound(typed, end, id,
+                                 [](const dict_typed_t& t, sid_t id) { return t.id < id; });
+        if (it == end || it->id != id)
+            return false;
+        v = typed_value_t(it->val, it->kind);
+        return true;
+    }
+
+    std::pair<bool, sid_t> str2id(const std::string& str) const {
+        if (header->nstrs == 0)
+            return std::make_pair(false, 0);
+
+        // the last block whose first string <= str
+        uint64_t lo = 0, hi = header->nblocks;
+        while (hi - lo > 1) {
+            uint64_t mid = (lo + hi) / 2;
+            const char* p = data + blocks[mid];
+            uint64_t len = get_varint(p);
+            if (compare(str, p, len) < 0) hi = mid;
+            else lo = mid;
+        }
+
+        // scan the block
+        const char* p = data + blocks[lo];
+        const char* end = data + blocks[lo + 1];
+        uint64_t pos = lo * DICT_BLOCK_SZ;
+        std::string cur;
+        uint64_t len = get_varint(p);
+        cur.assign(p, len);
+        p += len;
+        while (true) {
+            int cmp = str.compare(cur);
+            if (cmp == 0)
+                return std::make_pair(true, ids[pos]);
+            if (cmp < 0 || p >= end)  // sorted
+                return std::make_pair(false, 0);
+
+            uint64_t lcp = get_varint(p);
+            len = get_varint(p);
+            cur.resize(lcp);
+            cur.append(p, len);
+            p += len;
+            pos++;
+        }
+    }
+
+    /**
+     * @brief Build a dictionary file from entries (sorted in place)
+     *
+     * @return false if it fails (e.g., duplicate strings or IDs)
+     */
+    static bool build(std::vector<entry_t>& entries, sid_t next_index_id, sid_t next_normal_id,
+                      const std::string& fname) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const entry_t& e1, const entry_t& e2) { return e1.str < e2.str; });
+        for (uint64_t i = 1; i < entries.size(); i++) {
+            if (entries[i].str == entries[i - 1].str) {
+                logstream(LOG_ERROR) << "duplicate string in the dictionary: " << entries[i].str << LOG_endl;
+                return false;
+            }
+        }
+        if (entries.size() >= DICT_NO_POS) {
+            logstream(LOG_ERROR) << "too many strings for a dictionary: " << entries.size() << LOG_endl;
+            return false;
+        }
+
+        dict_header_t h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, DICT_MAGIC, sizeof(h.magic));
+        h.version = DICT_VERSION;
+        h.id_size = sizeof(sid_t);
+        h.nstrs = entries.size();
+        h.nblocks = (entries.size() + DICT_BLOCK_SZ - 1) / DICT_BLOCK_SZ;
+        h.normal_base = 1 << NBITS_IDX;
+        h.next_index_id = next_index_id;
+        h.next_normal_id = next_normal_id;
+
+        // the ranges of index and normal IDs
+        uint64_t max_normal = h.normal_base;
+        for (auto& e : entries) {
+            if (e.id < h.normal_base) h.index_range = std::max<uint64_t>(h.index_range, e.id + 1);
+            else max_normal = std::max<uint64_t>(max_normal, e.id + 1);
+        }
+        h.normal_range = max_normal - h.normal_base;
+
+        std::vector<sid_t> sorted_ids(entries.size());
+        std::vector<uint32_t> index_pos(h.index_range, DICT_NO_POS), normal_pos(h.normal_range, DICT_NO_POS);
+        std::vector<char> types(h.index_range, 0);
+        std::vector<dict_typed_t> typed;
+        std::vector<uint8_t> kinds(entries.size());
+        for (uint64_t i = 0; i < entries.size(); i++) {
+            sid_t id = entries[i].id;
+            sorted_ids[i] = id;
+            uint32_t& pos = (id < h.normal_base) ? index_pos[id] : normal_pos[id - h.normal_base];
+            if (pos != DICT_NO_POS) {
+                logstream(LOG_ERROR) << "duplicate ID in the dictionary: " << id << LOG_endl;
+                return false;
+            }
+            pos = i;
+            if (id < h.normal_base) types[id] = entries[i].type;
+            kinds[i] = TermKind::classify(entries[i].str);
+
+            typed_value_t v;
+            if (TypedLiteral::decode(entries[i].str, v)) {
+                dict_typed_t t;
+                memset(&t, 0, sizeof(t));
+                t.id = id;
+                t.kind = v.kind;
+                t.val = v.val;
+                typed.push_back(t);
+            }
+        }
+        std::sort(typed.begin(), typed.end(),
+                  [](const dict_typed_t& t1, const dict_typed_t& t2) { return t1.id < t2.id; });
+        h.ntyped = typed.size();
+
+        // front-coded blocks
+        std::vector<uint64_t> blocks;
+        std::string buf;
+        for (uint64_t i = 0; i < entries.size(); i++) {
+            const std::string& str = entries[i].str;
+            if (i % DICT_BLOCK_SZ == 0) {
+                blocks.push_back(buf.size());
+                put_varint(buf, str.size());
+                buf.append(str);
+            } else {
+                const std::string& prev = entries[i - 1].str;
+                uint64_t lcp = 0, n = std::min(prev.size(), str.size());
+                while (lcp < n && prev[lcp] == str[lcp]) lcp++;
+                put_varint(buf, lcp);
+                put_varint(buf, str.size() - lcp);
+                buf.append(str, lcp, std::string::npos);
+            }
+        }
+        blocks.push_back(buf.size());
+
+        h.blocks_off = align8(sizeof(h));
+        h.ids_off = align8(h.blocks_off + blocks.size() * sizeof(uint64_t));
+        h.index_pos_off = align8(h.ids_off + sorted_ids.size() * sizeof(sid_t));
+        h.normal_pos_off = align8(h.index_pos_off + index_pos.size() * sizeof(uint32_t));
+        h.types_off = align8(h.normal_pos_off + normal_pos.size() * sizeof(uint32_t));
+        h.typed_off = align8(h.types_off + types.size());
+        h.kinds_off = align8(h.typed_off + typed.size() * sizeof(dict_typed_t));
+        h.data_off = align8(h.kinds_off + kinds.size());
+        h.file_sz = h.data_off + buf.size();
+
+        // write to a temporary file, and rename it at last (never a partial dictionary)
+        std::string tmp_fname = fname + ".tmp";
+        std::ofstream ofs(tmp_fname, std::ios::binary | std::ios::trunc);
+        auto write_at = [&ofs](uint64_t off, const void* p, uint64_t n) {
+            static const char zeros[8] = {0};
+            ofs.write(zeros, off - ofs.tellp());  // padding
+            ofs.write(static_cast<const char*>(p), n);
+        };
+        write_at(0, &h, sizeof(h));
+        write_at(h.blocks_off, blocks.data(), blocks.size() * sizeof(uint64_t));
+        write_at(h.ids_off, sorted_ids.data(), sorted_ids.size() * sizeof(sid_t));
+        write_at(h.index_pos_off, index_pos.data(), index_pos.size() * sizeof(uint32_t));
+        write_at(h.normal_pos_off, normal_pos.data(), normal_pos.size() * sizeof(uint32_t));
+        write_at(h.types_off, types.data(), types.size());
+        write_at(h.typed_off, typed.data(), typed.size() * sizeof(dict_typed_t));
+        write_at(h.kinds_off, kinds.data(), kinds.size());
+        write_at(h.data_off, buf.data(), buf.size());
+        ofs.close();
+        if (!ofs.good() || rename(tmp_fname.c_str(), fname.c_str()) != 0) {
+            logstream(LOG_ERROR) << "failed to write string dictionary: " << fname << LOG_endl;
+            unlink(tmp_fname.c_str());
+            return false;
+        }
+
+        logstream(LOG_INFO) << "build string dictionary " << fname << ": " << h.nstrs
+                            << " strings (" << h.ntyped << " typed literals), " << (h.file_sz >> 20) << " MB ("
+                            << (buf.size() >> 20) << " MB front-coded strings)" << LOG_endl;
+        return true;
+    }
+
+    /**
+     * @brief Build a dictionary file from the ID-mapping files in a directory
+     *        (str_index, str_attr_index and str_normal)
+     */
+    static bool build(const std::string& dname, const std::string& fname) {
+        std::vector<entry_t> entries;
+        sid_t next_index_id = 0, next_normal_id = 0;
+        entry_t e;
+
+        // the same as StringServer: the next ID follows the last one of the file
+        std::ifstream index(dname + "str_index");
+        while (index >> e.str >> e.id) {
+            e.type = static_cast<char>(SID_t);
+            next_index_id = e.id + 1;
+            entries.push_back(e);
+        }
+
+        std::ifstream attr_index(dname + "str_attr_index");
+        while (attr_index >> e.str >> e.id >> e.type)
+            entries.push_back(e);
+
+        std::ifstream normal(dname + "str_normal");
+        if (!normal.good()) {
+            logstream(LOG_ERROR) << "failed to open " << dname << "str_normal" << LOG_endl;
+            return false;
+        }
+        while (normal >> e.str >> e.id) {
+            e.type = static_cast<char>(SID_t);
+            next_normal_id = e.id + 1;
+            entries.push_back(e);
+        }
+
+        return build(entries, next_index_id, next_normal_id, fname);
+    }
+};
+
+}  // namespace wukong
@@ -28,6 +28,9 @@
 
 #include "core/common/type.hpp"
 
+#include "stringserver/term_kind.hpp"
+#include "stringserver/typed_literal.hpp"
+
 namespace wukong {
 
 class StringMapping {
@@ -39,6 +42,47 @@ public:
     virtual std::pair<bool, sid_t> str2id(int tid, std::string str) = 0;
     virtual bool add(std::string str, sid_t sid) = 0;
 
+    // translate a batch of IDs (e.g., a column of results), in the same order as given
+    virtual std::vector<std::pair<bool, std::string>> id2str_batch(int tid, const std::vector<sid_t>& sids) {
+        std::vector<std::pair<bool, std::string>> strs;
+        strs.reserve(sids.size());
+        for (sid_t sid : sids)
+            strs.push_back(id2str(tid, sid));
+        return strs;
+    }
+
+    /**
+     * @brief Get the typed values (see typed_literal.hpp) of a batch of IDs,
+     *        whose kinds are LIT_NONE if they are not typed literals
+     */
+    virtual std::vector<typed_value_t> typed_value_batch(int tid, const std::vector<sid_t>& sids) {
+        std::vector<typed_value_t> vals(sids.size());
+        auto strs = id2str_batch(tid, sids);
+        for (int i = 0; i < strs.size(); i++)
+            if (strs[i].first)
+                TypedLiteral::decode(strs[i].second, vals[i]);
+        return vals;
+    }
+
+    // the term kinds (see term_kind.hpp) of a batch of IDs, TERM_NONE if unknown
+    virtual std::vector<uint8_t> term_kind_batch(int tid, const std::vector<sid_t>& sids) {
+        std::vector<uint8_t> kinds(sids.size(), TERM_NONE);
+        auto strs = id2str_batch(tid, sids);
+        for (int i = 0; i < strs.size(); i++)
+            if (strs[i].first)
+                kinds[i] = TermKind::classify(strs[i].second);
+        return kinds;
+    }
+
+    // translate a batch of strings, in the same order as given
+    virtual std::vector<std::pair<bool, sid_t>> str2id_batch(int tid, const std::vector<std::string>& strs) {
+        std::vector<std::pair<bool, sid_t>> sids;
+        sids.reserve(strs.size());
+        for (auto& str : strs)
+            sids.push_back(str2id(tid, str));
+        return sids;
+    }
+
     virtual ~StringMapping() {}
 };
 
@@ -103,6 +103,30 @@ private:
                                     << "->" << req.vid
                                     << " fail" << LOG_endl;
             }
+        } else if (req.req_type == SSCacheReqType::TRANS_ID_BATCH) {
+            auto trans_result = this->str_server->id2str_batch(tid, req.vids);
+            req.strs.resize(trans_result.size());
+            req.found.resize(trans_result.size());
+            for (int i = 0; i < trans_result.size(); i++) {
+                req.found[i] = trans_result[i].first;
+                req.strs[i] = std::move(trans_result[i].second);
+            }
+            req.success = true;
+            logstream(LOG_DEBUG) << "Translate " << req.vids.size() << " IDs in a batch" << LOG_endl;
+            // no need to send IDs back
+            req.vids.clear();
+        } else if (req.req_type == SSCacheReqType::TRANS_STR_BATCH) {
+            auto trans_result = this->str_server->str2id_batch(tid, req.strs);
+            req.vids.resize(trans_result.size());
+            req.found.resize(trans_result.size());
+            for (int i = 0; i < trans_result.size(); i++) {
+                req.found[i] = trans_result[i].first;
+                req.vids[i] = trans_result[i].second;
+            }
+            // no need to send strings back
+            req.strs.clear();
+            req.success = true;
+            logstream(LOG_DEBUG) << "Translate " << req.vids.size() << " strings in a batch" << LOG_endl;
         }
 
         // reply
@@ -40,6 +40,7 @@
 #include "core/common/type.hpp"
 
 #include "stringserver/sscache_request.hpp"
+#include "stringserver/string_dict.hpp"
 #include "stringserver/string_mapping.hpp"
 
 // utils
@@ -63,6 +64,17 @@ private:
     boost::unordered_map<sid_t, std::string> ismap;  // ID to STRING
 #endif
 
+    StringDict dict;  // the mapped dictionary (see string_dict.hpp)
+
+    // typed values of literals (decoded at load time), w/o the dictionary
+    boost::unordered_map<sid_t, typed_value_t> typed_values;
+
+    void add_typed_value(const std::string& str, sid_t vid) {
+        typed_value_t v;
+        if (TypedLiteral::decode(str, v))
+            typed_values[vid] = v;
+    }
+
 public:
     sid_t next_index_id;
     sid_t next_normal_id;
@@ -91,7 +103,7 @@ public:
     }
 
 #ifdef USE_BITRIE
-    std::pair<bool, std::string> id2str(int tid, sid_t vid) override {
+    std::pair<bool, std::string> map_id2str(sid_t vid) {
         if (bimap.exist(vid)) {
             return std::make_pair(true, bimap[vid]);
         } else {
@@ -99,7 +111,7 @@ public:
         }
     }
 
-    std::pair<bool, sid_t> str2id(int tid, std::string str) override {
+    std::pair<bool, sid_t> map_str2id(const std::string& str) {
         if (bimap.exist(str)) {
             return std::make_pair(true, bimap[str]);
         } else {
@@ -108,31 +120,33 @@ public:
     }
 
     bool add(std::string str, sid_t vid) override {
+        add_typed_value(str, vid);
         bimap.insert_kv(str, vid);
         return true;
     }
 
     void shrink() { bimap.storage_resize(); }
 #else
-    std::pair<bool, std::string> id2str(int tid, sid_t vid) override {
+    std::pair<bool, std::string> map_id2str(sid_t vid) {
         auto ptr = ismap.find(vid);
         if (ptr != ismap.end()) {
-            return std::make_pair(true, ismap[vid]);
+            return std::make_pair(true, ptr->second);
         } else {
             return std::make_pair(false, "");
         }
     }
 
-    std::pair<bool, sid_t> str2id(int tid, std::string str) override {
+    std::pair<bool, sid_t> map_str2id(const std::string& str) {
         auto ptr = simap.find(str);
         if (ptr != simap.end()) {
-            return std::make_pair(true, simap[str]);
+            return std::make_pair(true, ptr->second);
         } else {
             return std::make_pair(false, 0);
         }
     }
 
     bool add(std::string str, sid_t vid) override {
+        add_typed_value(str, vid);
         simap[str] = vid;
         ismap[vid] = str;
         return true;
@@ -141,9 +155,60 @@ public:
     void shrink() {}
 #endif
 
+    // the mapped dictionary (if any) first, then the strings added at runtime
+    std::pair<bool, std::string> id2str(int tid, sid_t vid) override {
+        if (dict.is_open()) {
+            auto result = dict.id2str(vid);
+            if (result.first) return result;
+        }
+        return map_id2str(vid);
+    }
+
+    std::pair<bool, sid_t> str2id(int tid, std::string str) override {
+        if (dict.is_open()) {
+            auto result = dict.str2id(str);
+            if (result.first) return result;
+        }
+        return map_str2id(str);
+    }
+
+    std::vector<typed_value_t> typed_value_batch(int tid, const std::vector<sid_t>& vids) override {
+        std::vector<typed_value_t> vals(vids.size());
+        for (int i = 0; i < vids.size(); i++) {
+            if (dict.is_open() && dict.typed_value(vids[i], vals[i]))
+                continue;
+            auto it = typed_values.find(vids[i]);
+            if (it != typed_values.end())
+                vals[i] = it->second;
+        }
+        return vals;
+    }
+
+    std::vector<uint8_t> term_kind_batch(int tid, const std::vector<sid_t>& vids) override {
+        std::vector<uint8_t> kinds(vids.size(), TERM_NONE);
+        for (int i = 0; i < vids.size(); i++) {
+            if (dict.is_open() && dict.term_kind(vids[i], kinds[i]))
+                continue;
+            auto result = map_id2str(vids[i]);
+            if (result.first)
+                kinds[i] = TermKind::classify(result.second);
+        }
+        return kinds;
+    }
+
 private:
     /* load ID mapping files from a shared filesystem (e.g., NFS) */
     void load_from_posixfs(std::string dname) {
+        // use the dictionary (built by build_string_dict) instead of the text files
+        if (dict.open(dname + "str_dict")) {
+            logstream(LOG_INFO) << "[StringServer] map string dictionary: " << dname << "str_dict ("
+                                << dict.size() << " strings, " << (dict.file_size() >> 20) << " MB)" << LOG_endl;
+            dict.foreach_index_type([this](sid_t id, char type) { pid2type[id] = type; });
+            next_index_id = dict.get_next_index_id();
+            next_normal_id = dict.get_next_normal_id();
+            return;
+        }
+
         DIR* dir = opendir(dname.c_str());
         if (dir == NULL) {
             logstream(LOG_ERROR) << "failed to open the directory of ID-mapping files ("
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2021 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+namespace wukong {
+
+/**
+ * The kinds of RDF terms (bits), precomputed for IDs by the string
+ * dictionary, so that isIRI/isLiteral/isBlank FILTERs are bit tests.
+ * - IRI: <...> (w/o the characters excluded by IRI_REF), or a prefixed name
+ * - literal: a quoted string w/ an optional language tag or datatype
+ * - blank node: _:xxx
+ */
+enum term_kind_t : uint8_t { TERM_NONE = 0, TERM_IRI = 1, TERM_LITERAL = 2, TERM_BLANK = 4 };
+
+class TermKind {
+public:
+    static uint8_t classify(const char* s, uint64_t len) {
+        if (len == 0) return TERM_NONE;
+
+        if (len >= 2 && s[0] == '_' && s[1] == ':')
+            return TERM_BLANK;
+
+        if (s[0] == '"' || s[0] == '\'') {
+            // the closing quote, followed by nothing, a language tag or a datatype
+            const char* close = static_cast<const char*>(memrchr(s + 1, s[0], len - 1));
+            if (close == nullptr) return TERM_NONE;
+            uint64_t rest = s + len - (close + 1);
+            if (rest == 0 || close[1] == '@' || (rest > 2 && close[1] == '^' && close[2] == '^'))
+                return TERM_LITERAL;
+            return TERM_NONE;
+        }
+
+        if (s[0] == '<') {
+            if (s[len - 1] != '>') return TERM_NONE;
+            for (uint64_t i = 1; i < len - 1; i++)
+                if (strchr("<>\\\"{}|^`", s[i]) != nullptr)
+                    return TERM_NONE;
+            return TERM_IRI;
+        }
+
+        // prefixed name (e.g., ub:Course)
+        if (memchr(s, ':', len) != nullptr)
+            return TERM_IRI;
+        return TERM_NONE;
+    }
+
+    static uint8_t classify(const std::string& str) { return classify(str.data(), str.size()); }
+};
+
+}  // namespace wukong
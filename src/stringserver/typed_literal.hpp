@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2021 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <string>
+
+namespace wukong {
+
+/**
+ * Typed values of literals, decoded once (at load or dictionary time) so that
+ * FILTERs compare them by value instead of by their strings, e.g.,
+ *   "12"^^<http://www.w3.org/2001/XMLSchema#integer>         (numeric)
+ *   "1.5E2"^^xsd:double                                       (numeric)
+ *   "2002-10-10T12:00:00+08:00"^^xsd:dateTime                 (dateTime)
+ *
+ * Numeric values are doubles, and dateTime (date) values are seconds since
+ * the epoch (UTC, w/o a timezone as UTC).
+ */
+
+enum literal_kind_t : uint8_t { LIT_NONE = 0, LIT_NUMERIC = 1, LIT_DATETIME = 2 };
+
+struct typed_value_t {
+    double val = 0;
+    uint8_t kind = LIT_NONE;
+
+    typed_value_t() {}
+    typed_value_t(double val, uint8_t kind) : val(val), kind(kind) {}
+};
+
+#define XSD_PREFIX "http://www.w3.org/2001/XMLSchema#"
+
+class TypedLiteral {
+private:
+    // days from 1970-01-01 to y-m-d (proleptic Gregorian calendar)
+    static int64_t days_from_civil(int64_t y, int64_t m, int64_t d) {
+        y -= (m <= 2);
+        int64_t era = (y >= 0 ? y : y - 399) / 400;
+        int64_t yoe = y - era * 400;
+        int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    // parse #n digits at p
+    static bool digits(const char*& p, const char* end, int n, int64_t& v) {
+        v = 0;
+        for (int i = 0; i < n; i++, p++) {
+            if (p >= end || *p < '0' || *p > '9') return false;
+            v = v * 10 + (*p - '0');
+        }
+        return true;
+    }
+
+    static bool expect(const char*& p, const char* end, char c) {
+        if (p >= end || *p != c) return false;
+        p++;
+        return true;
+    }
+
+public:
+    static bool is_numeric_type(const std::string& type) {
+        static const char* types[] = {
+            "integer", "decimal", "double", "float", "int", "long", "short", "byte",
+            "nonNegativeInteger", "nonPositiveInteger", "negativeInteger", "positiveInteger",
+            "unsignedLong", "unsignedInt", "unsignedShort", "unsignedByte"};
+        for (const char* t : types)
+            if (type == t) return true;
+        return false;
+    }
+
+    static bool is_integer_type(const std::string& type) {
+        return is_numeric_type(type) && type != "decimal" && type != "double" && type != "float";
+    }
+
+    static bool is_datetime_type(const std::string& type) {
+        return type == "dateTime" || type == "date" || type == "dateTimeStamp";
+    }
+
+    // the xsd type (e.g., integer) of a datatype IRI (<xsd#type>, xsd#type or xsd:type), empty if not xsd
+    static std::string xsd_type(std::string iri) {
+        if (iri.size() > 2 && iri.front() == '<' && iri.back() == '>')
+            iri = iri.substr(1, iri.size() - 2);
+        if (iri.compare(0, sizeof(XSD_PREFIX) - 1, XSD_PREFIX) == 0)
+            return iri.substr(sizeof(XSD_PREFIX) - 1);
+        if (iri.compare(0, 4, "xsd:") == 0)
+            return iri.substr(4);
+        return "";
+    }
+
+    // decode a numeric lexical form (the whole string) of the xsd type
+    static bool decode_numeric(const std::string& lex, const std::string& type, double& val) {
+        if (lex.empty() || isspace(lex[0])) return false;
+        char* end = nullptr;
+        if (is_integer_type(type)) {
+            errno = 0;
+            long long i = strtoll(lex.c_str(), &end, 10);
+            if (errno == ERANGE || end != lex.c_str() + lex.size()) return false;
+            val = static_cast<double>(i);
+            return true;
+        }
+
+        // w/o the hexadecimal, infinity and NaN forms of strtod
+        if (lex.find_first_not_of("0123456789+-.eE") != std::string::npos) return false;
+        val = strtod(lex.c_str(), &end);
+        return end == lex.c_str() + lex.size();
+    }
+
+    // decode the lexical form of the xsd type
+    static bool decode_typed(const std::string& lex, const std::string& type, typed_value_t& v) {
+        if (is_numeric_type(type) && decode_numeric(lex, type, v.val)) {
+            v.kind = LIT_NUMERIC;
+            return true;
+        }
+        if (is_datetime_type(type) && decode_datetime(lex, v.val)) {
+            v.kind = LIT_DATETIME;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Decode a dateTime (YYYY-MM-DDThh:mm:ss[.s+][Z|(+|-)hh:mm]) or
+     *        a date (YYYY-MM-DD[Z|(+|-)hh:mm]) to seconds since the epoch
+     */
+    static bool decode_datetime(const std::string& lex, double& val) {
+        const char* p = lex.c_str();
+        const char* end = p + lex.size();
+        int64_t y, mo, d, h = 0, mi = 0, s = 0;
+        if (!digits(p, end, 4, y) || !expect(p, end, '-') || !digits(p, end, 2, mo)
+                || !expect(p, end, '-') || !digits(p, end, 2, d))
+            return false;
+        if (mo < 1 || mo > 12 || d < 1 || d > 31) return false;
+
+        double frac = 0;
+        if (p < end && *p == 'T') {
+            p++;
+            if (!digits(p, end, 2, h) || !expect(p, end, ':') || !digits(p, end, 2, mi)
+                    || !expect(p, end, ':') || !digits(p, end, 2, s))
+                return false;
+            if (h > 24 || mi > 59 || s > 60) return false;
+            if (p < end && *p == '.') {
+                const char* start = p;
+                p++;
+                while (p < end && *p >= '0' && *p <= '9') p++;
+                if (p == start + 1) return false;
+                frac = strtod(std::string(start, p).c_str(), nullptr);
+            }
+        }
+
+        // timezone (w/o a timezone as UTC)
+        int64_t tz = 0;
+        if (p < end && *p == 'Z') {
+            p++;
+        } else if (p < end && (*p == '+' || *p == '-')) {
+            int sign = (*p == '+') ? 1 : -1;
+            int64_t tzh, tzm;
+            p++;
+            if (!digits(p, end, 2, tzh) || !expect(p, end, ':') || !digits(p, end, 2, tzm))
+                return false;
+            tz = sign * (tzh * 3600 + tzm * 60);
+        }
+        if (p != end) return false;
+
+        val = static_cast<double>(days_from_civil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s - tz) + frac;
+        return true;
+    }
+
+    /**
+     * @brief Decode a typed literal in the dataset, i.e., "lex"^^<xsd#type>
+     *        or "lex"^^xsd:type
+     *
+     * @return false for other strings (e.g., IRIs, plain and other literals)
+     */
+    static bool decode(const std::string& str, typed_value_t& v) {
+        if (str.size() < 4 || str[0] != '"') return false;
+        size_t pos = str.rfind("\"^^");
+        if (pos == std::string::npos || pos == 0) return false;
+
+        return decode_typed(str.substr(1, pos - 1), xsd_type(str.substr(pos + 3)), v);
+    }
+
+    /**
+     * @brief Decode a constant of FILTERs, i.e., the lexical form w/o quotes
+     *        and its datatype IRI (e.g., 12 and 1.5 are typed by the parser,
+     *        and "2002-10-10T12:00:00Z"^^xsd:dateTime)
+     *
+     * @return false for untyped constants (e.g., "12" is a plain literal)
+     */
+    static bool decode_constant(const std::string& lex, const std::string& type, typed_value_t& v) {
+        return decode_typed(lex, xsd_type(type), v);
+    }
+};
+
+}  // namespace wukong
@@ -77,6 +77,20 @@ public:
         return (int64_t)mktime(&tm);
     }
 
+    // the time interval of a snapshot, i.e., a day (yyyy-MM-dd) or an instant (yyyy-MM-ddTHH:mm:ss)
+    static bool snapshot2interval(std::string &s, int64_t &ts, int64_t &te) {
+        if (is_date(s)) {
+            ts = str2int(s);
+            te = ts + 24 * 60 * 60;
+        } else if (is_time(s)) {
+            ts = str2int(s);
+            te = ts;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
     static std::string int2str(int64_t num) {
         struct tm *ptm = gmtime(&num);
         return std::to_string(1900 + ptm->tm_year) + "-" + (ptm->tm_mon >= 9 ? std::to_string(1 + ptm->tm_mon) : "0" + std::to_string(1 + ptm->tm_mon)) + "-" +
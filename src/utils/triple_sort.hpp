@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2016 Shanghai Jiao Tong University.
+ *     All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing,
+ *  software distributed under the License is distributed on an "AS
+ *  IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ *  express or implied.  See the License for the specific language
+ *  governing permissions and limitations under the License.
+ *
+ * For more about this software visit:
+ *
+ *      http://ipads.se.sjtu.edu.cn/projects/wukong
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "core/common/type.hpp"
+
+// utils
+#include "utils/assertion.hpp"
+
+namespace wukong {
+
+/**
+ * LSD radix sort of triples
+ *
+ * Each field is rebased to its minimum, and its significant bits are
+ * split into digits of at most 12 bits, so that IDs of a dataset usually
+ * take two passes and predicates take one. The passes of trivial digits
+ * are skipped. Each pass is stable, so that the triples sorted by spo (ops)
+ * can be re-sorted by pso (pos) with the passes of p only. Duplicates are
+ * adjacent in their bucket during the last pass, which drops them.
+ *
+ * The results are the same as std::sort w/ triple_sort_by_xxx and dedup.
+ */
+
+#define RADIX_MAX_BITS 12
+
+enum triple_field_t { FIELD_S, FIELD_P, FIELD_O, FIELD_TS, FIELD_TE };
+
+template <int F>
+static inline uint64_t triple_field(const triple_t &t) {
+    switch (F) {
+    case FIELD_S: return t.s;
+    case FIELD_P: return t.p;
+    case FIELD_O: return t.o;
+#ifdef TRDF_MODE
+    // flip the sign bit to order signed timestamps as unsigned
+    case FIELD_TS: return static_cast<uint64_t>(t.ts) ^ (1ULL << 63);
+    case FIELD_TE: return static_cast<uint64_t>(t.te) ^ (1ULL << 63);
+#endif
+    default: return 0;
+    }
+}
+
+struct radix_pass_t {
+    int field;
+    uint64_t base;  // the minimum of the field
+    int shift;
+    uint64_t mask;
+    std::vector<uint64_t> cnt;
+};
+
+// plan the passes of a field (from the least significant digit)
+template <int F>
+static inline void radix_plan(const triple_t *t, uint64_t n, std::vector<radix_pass_t> &passes) {
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t v = triple_field<F>(t[i]);
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+    if (lo == hi) return;
+
+    int bits = 64 - __builtin_clzll(hi - lo);
+    int npasses = (bits + RADIX_MAX_BITS - 1) / RADIX_MAX_BITS;
+    int dbits = (bits + npasses - 1) / npasses;
+    int first = passes.size();
+    for (int shift = 0; shift < bits; shift += dbits)
+        passes.push_back(radix_pass_t{F, lo, shift, (1ULL << dbits) - 1,
+                                      std::vector<uint64_t>(1ULL << dbits, 0)});
+
+    // histograms of all digits of the field
+    int ndigits = passes.size() - first;
+    uint64_t *cnts[64 / RADIX_MAX_BITS + 1];
+    for (int d = 0; d < ndigits; d++)
+        cnts[d] = passes[first + d].cnt.data();
+    uint64_t mask = (1ULL << dbits) - 1;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t v = triple_field<F>(t[i]) - lo;
+        for (int d = 0; d < ndigits; d++, v >>= dbits)
+            cnts[d][v & mask]++;
+    }
+
+    // skip the digit if all triples fall in one bucket
+    for (int p = passes.size() - 1; p >= first; p--)
+        if (*std::max_element(passes[p].cnt.begin(), passes[p].cnt.end()) == n)
+            passes.erase(passes.begin() + p);
+}
+
+// scatter triples to the buckets of a digit (pos: the next free slot of each bucket)
+template <int F, bool DEDUP>
+static inline void radix_scatter(const triple_t *src, triple_t *dst, uint64_t n, const radix_pass_t &pass,
+                                 uint64_t *pos, const uint64_t *start) {
+    for (uint64_t i = 0; i < n; i++) {
+        const triple_t &t = src[i];
+        uint64_t d = ((triple_field<F>(t) - pass.base) >> pass.shift) & pass.mask;
+        if (DEDUP && pos[d] > start[d] && dst[pos[d] - 1] == t)
+            continue;
+        dst[pos[d]++] = t;
+    }
+}
+
+template <int F>
+static inline void radix_pass(const triple_t *src, triple_t *dst, uint64_t n, const radix_pass_t &pass,
+                              uint64_t *pos, const uint64_t *start, bool dedup) {
+    if (dedup)
+        radix_scatter<F, true>(src, dst, n, pass, pos, start);
+    else
+        radix_scatter<F, false>(src, dst, n, pass, pos, start);
+}
+
+/**
+ * @brief Sort triples by the key fields (from the most significant one)
+ *
+ * @param dedup remove duplicates (the key should contain all fields)
+ * @param tmp a buffer reused across calls (its content is discarded)
+ */
+static inline void radix_sort_triples(std::vector<triple_t> &triples, const std::vector<int> &key,
+                                      bool dedup, std::vector<triple_t> &tmp) {
+    uint64_t n = triples.size();
+    if (n <= 1)
+        return;
+    ASSERT(!dedup || key.size() == TRIPLE_NFIELDS);
+
+    std::vector<radix_pass_t> passes;
+    for (int k = key.size() - 1; k >= 0; k--) {
+        switch (key[k]) {
+        case FIELD_S: radix_plan<FIELD_S>(triples.data(), n, passes); break;
+        case FIELD_P: radix_plan<FIELD_P>(triples.data(), n, passes); break;
+        case FIELD_O: radix_plan<FIELD_O>(triples.data(), n, passes); break;
+        case FIELD_TS: radix_plan<FIELD_TS>(triples.data(), n, passes); break;
+        case FIELD_TE: radix_plan<FIELD_TE>(triples.data(), n, passes); break;
+        }
+    }
+
+    if (passes.empty()) {  // all keys are equal
+        if (dedup) triples.resize(1);
+        return;
+    }
+
+    tmp.resize(n);
+    triple_t *src = triples.data(), *dst = tmp.data();
+    std::vector<uint64_t> start, pos;
+    for (size_t i = 0; i < passes.size(); i++) {
+        const radix_pass_t &pass = passes[i];
+        bool last = dedup && (i == passes.size() - 1);
+        start.resize(pass.cnt.size());
+        uint64_t off = 0;
+        for (uint64_t d = 0; d < pass.cnt.size(); d++) {
+            start[d] = off;
+            off += pass.cnt[d];
+        }
+        pos = start;
+
+        switch (pass.field) {
+        case FIELD_S: radix_pass<FIELD_S>(src, dst, n, pass, pos.data(), start.data(), last); break;
+        case FIELD_P: radix_pass<FIELD_P>(src, dst, n, pass, pos.data(), start.data(), last); break;
+        case FIELD_O: radix_pass<FIELD_O>(src, dst, n, pass, pos.data(), start.data(), last); break;
+        case FIELD_TS: radix_pass<FIELD_TS>(src, dst, n, pass, pos.data(), start.data(), last); break;
+        case FIELD_TE: radix_pass<FIELD_TE>(src, dst, n, pass, pos.data(), start.data(), last); break;
+        }
+
+        if (last) {  // close the gaps left by duplicates
+            n = 0;
+            for (uint64_t d = 0; d < start.size(); d++) {
+                if (n != start[d])
+                    std::copy(dst + start[d], dst + pos[d], dst + n);
+                n += pos[d] - start[d];
+            }
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != triples.data())
+        triples.swap(tmp);
+    triples.resize(n);
+}
+
+#ifdef TRDF_MODE
+#define TRIPLE_KEY(_f1, _f2, _f3) {_f1, _f2, _f3, FIELD_TS, FIELD_TE}
+#else
+#define TRIPLE_KEY(_f1, _f2, _f3) {_f1, _f2, _f3}
+#endif
+
+// sort and dedup triples, the same as std::sort w/ triple_sort_by_xxx and dedup
+static inline void sort_triples_by_spo(std::vector<triple_t> &triples, std::vector<triple_t> &tmp) {
+    radix_sort_triples(triples, TRIPLE_KEY(FIELD_S, FIELD_P, FIELD_O), true, tmp);
+}
+
+static inline void sort_triples_by_ops(std::vector<triple_t> &triples, std::vector<triple_t> &tmp) {
+    radix_sort_triples(triples, TRIPLE_KEY(FIELD_O, FIELD_P, FIELD_S), true, tmp);
+}
+
+static inline void sort_triples_by_pso(std::vector<triple_t> &triples, std::vector<triple_t> &tmp) {
+    radix_sort_triples(triples, TRIPLE_KEY(FIELD_P, FIELD_S, FIELD_O), true, tmp);
+}
+
+static inline void sort_triples_by_pos(std::vector<triple_t> &triples, std::vector<triple_t> &tmp) {
+    radix_sort_triples(triples, TRIPLE_KEY(FIELD_P, FIELD_O, FIELD_S), true, tmp);
+}
+
+// re-sort triples from spo (ops) to pso (pos) by a stable sort on p
+static inline void resort_triples_by_p(std::vector<triple_t> &triples, std::vector<triple_t> &tmp) {
+    radix_sort_triples(triples, {FIELD_P}, false, tmp);
+}
+
+}  // namespace wukong
@@ -227,12 +227,46 @@ main(int argc, char *argv[])
 #else 
     wukong::DGraph * dgraph = new wukong::SegmentRDFGraph(sid, kv_mem);
 #endif
-    dgraph->load(wukong::Global::input_folder);
+    // restore RDF graph from binary snapshots if possible (see 'gstore snapshot'),
+    // otherwise load triples from input files.
+    // all servers restore only if the snapshots of all servers are valid
+    bool restored = false;
+    if (!wukong::Global::snapshot_folder.empty()) {
+        restored = dgraph->read_snapshot(wukong::Global::snapshot_folder);
+        restored = boost::mpi::all_reduce(world, restored, std::logical_and<bool>());
+        if (restored)
+            dgraph->commit_snapshot();
+        else
+            dgraph->abort_snapshot();
+    }
+    if (!restored) {
+        bool loaded = dgraph->load(wukong::Global::input_folder);
+        loaded = boost::mpi::all_reduce(world, loaded, std::logical_and<bool>());
+        if (!loaded) {
+            logstream(LOG_ERROR) << "#" << sid << ": failed to load RDF graph from "
+                                 << wukong::Global::input_folder << LOG_endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+#ifdef TRDF_MODE
+    dgraph->build_time_index();
+#endif
+
+    // reuse statistics stored with snapshots only if all servers are restored
+    std::string snapshot_stat_fname = wukong::Global::snapshot_folder + "statfile";
+    if (sid == 0)
+        restored = restored && std::ifstream(snapshot_stat_fname).good();
+    restored = boost::mpi::all_reduce(world, restored, std::logical_and<bool>());
 
     // prepare statistics for SPARQL optimizer
     wukong::Stats stats(sid);
     uint64_t t0, t1;
-    if (wukong::Global::generate_statistics) {
+    if (restored) {
+        t0 = wukong::timer::get_usec();
+        stats.load_stat_from_file(snapshot_stat_fname, wukong::con_adaptor);
+        t1 = wukong::timer::get_usec();
+        logstream(LOG_EMPH)  << "[Stats] load statistics using time: " << t1 - t0 << "usec" << LOG_endl;
+    } else if (wukong::Global::generate_statistics) {
         t0 = wukong::timer::get_usec();
         stats.generate_statistics(dgraph);
         t1 = wukong::timer::get_usec();
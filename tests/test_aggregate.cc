@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "core/common/bundle.hpp"
+#include "core/engine/aggregator.hpp"
+#include "core/engine/rmap.hpp"
+#include "utils/timer.hpp"
+
+#define VAL_BASE (1 << 20)  // IDs of integers (i.e., "n"^^xsd:integer)
+#define DEPT_BASE 100       // IDs of departments
+
+namespace test {
+using namespace wukong;
+
+class MockStrings : public StringMapping {
+public:
+    std::pair<bool, std::string> id2str(int tid, sid_t sid) override {
+        if (sid >= VAL_BASE)
+            return {true, "\"" + std::to_string(sid - VAL_BASE) + "\"^^xsd:integer"};
+        return {true, "<http://www.Department" + std::to_string(sid) + ".edu>"};
+    }
+    std::pair<bool, sid_t> str2id(int tid, std::string str) override { return {false, 0}; }
+    bool add(std::string str, sid_t sid) override { return false; }
+};
+
+/*
+ * SELECT ?d (COUNT(*) AS ?c) (SUM(?v) AS ?s) (MAX(?v) AS ?mx) (AVG(?v) AS ?a)
+ * WHERE { ?x ub:worksFor ?d . ?x ub:age ?v } GROUP BY ?d ORDER BY DESC(?c)
+ */
+static SPARQLQuery make_query(int start, int end, int ndepts) {
+    SPARQLQuery q;
+    q.qid = 1 << 8;  // an engine
+    q.aggregates.push_back(SPARQLQuery::Aggregate(AGG_COUNT, 0, -4, false));
+    q.aggregates.push_back(SPARQLQuery::Aggregate(AGG_SUM, -3, -5, false));
+    q.aggregates.push_back(SPARQLQuery::Aggregate(AGG_MAX, -3, -6, false));
+    q.aggregates.push_back(SPARQLQuery::Aggregate(AGG_AVG, -3, -7, false));
+    q.group_by = {-2};
+    q.orders.push_back(SPARQLQuery::Order(-4, true));
+
+    SPARQLQuery::Result &r = q.result;
+    r.nvars = 7;
+    r.required_vars = {-2, -4, -5, -6, -7};
+    r.add_var2col(-1, 0);
+    r.add_var2col(-2, 1);
+    r.add_var2col(-3, 2);
+    r.set_col_num(3);
+    for (int i = start; i < end; i++) {
+        int d = (i % 7 == 0) ? 0 : (i % ndepts);  // skewed groups
+        r.result_table.push_back(i);
+        r.result_table.push_back(DEPT_BASE + d);
+        r.result_table.push_back(VAL_BASE + (i % 97));
+    }
+    r.update_nrows();
+    return q;
+}
+
+static SPARQLQuery round_trip(const SPARQLQuery &q) {
+    Bundle out(q);
+    Bundle in(out.take_str());
+    return in.get_sparql_query();
+}
+
+static void expect_same(SPARQLQuery::Result &a, SPARQLQuery::Result &b) {
+    ASSERT_EQ(a.row_num, b.row_num);
+    EXPECT_EQ(a.get_col_num(), b.get_col_num());
+    EXPECT_EQ(a.get_attr_col_num(), b.get_attr_col_num());
+    EXPECT_EQ(a.result_table, b.result_table);
+    ASSERT_EQ(a.attr_res_table.size(), b.attr_res_table.size());
+    for (int i = 0; i < a.attr_res_table.size(); i++)
+        EXPECT_NEAR(boost::apply_visitor([](auto v) { return (double)v; }, a.attr_res_table[i]),
+                    boost::apply_visitor([](auto v) { return (double)v; }, b.attr_res_table[i]), 1e-6);
+}
+
+TEST(AggTable, UpdateMerge) {
+    AggTable whole, part1, part2;
+    std::vector<int32_t> funcs = {AGG_COUNT, AGG_SUM, AGG_AVG, AGG_MIN, AGG_MAX};
+    whole.init(1, funcs);
+    part1.init(1, funcs);
+    part2.init(1, funcs);
+
+    for (sid_t i = 0; i < 1000; i++) {
+        sid_t key = i % 7;
+        typed_value_t v((i % 2) ? i : -(double)i, LIT_NUMERIC);
+        AggTable &part = (i < 300) ? part1 : part2;
+        uint32_t g = whole.group(&key), pg = part.group(&key);
+        for (int a = 0; a < funcs.size(); a++) {
+            whole.update(g, a, i, v);
+            part.update(pg, a, i, v);
+        }
+    }
+    // unbound and untyped values
+    sid_t key = 0;
+    whole.update(whole.group(&key), 0, BLANK_ID, typed_value_t());
+    whole.update(whole.group(&key), 1, 5, typed_value_t());
+
+    AggTable merged;
+    merged.merge(part1);
+    merged.merge(part2);
+    ASSERT_EQ(merged.size(), 7);
+    for (sid_t k = 0; k < 7; k++) {
+        uint32_t g = whole.group(&k), mg = merged.group(&k);
+        for (int a = 0; a < funcs.size(); a++) {
+            EXPECT_EQ(whole.count(g, a), merged.count(mg, a));
+            EXPECT_DOUBLE_EQ(whole.value(g, a), merged.value(mg, a));
+        }
+    }
+
+    uint32_t g = whole.group(&key);  // 0, 7, ..., 994
+    EXPECT_EQ(whole.value(g, 0), 143);
+    EXPECT_EQ(whole.value(g, 3), -994);
+    EXPECT_EQ(whole.id(g, 3), 994);
+    EXPECT_EQ(whole.value(g, 4), 987);
+    EXPECT_EQ(whole.id(g, 4), 987);
+}
+
+// MIN/MAX over IRIs (by strings) and over a mix of typed values and IRIs
+TEST(AggTable, MinMaxTerms) {
+    MockStrings strs;
+    std::vector<int32_t> funcs = {AGG_MIN, AGG_MAX};
+    AggTable whole, part1, part2;
+    whole.init(0, funcs);
+    part1.init(0, funcs);
+    part2.init(0, funcs);
+
+    // "<http://www.Department300.edu>" < "...40.edu>" < "...5.edu>"
+    std::vector<sid_t> ids = {40, 5, 300, 40};
+    for (int i = 0; i < ids.size(); i++) {
+        std::string str = strs.id2str(0, ids[i]).second;
+        AggTable &part = (i < 2) ? part1 : part2;
+        for (int a = 0; a < funcs.size(); a++) {
+            whole.update(whole.group(nullptr), a, ids[i], typed_value_t(), str);
+            part.update(part.group(nullptr), a, ids[i], typed_value_t(), str);
+        }
+    }
+    EXPECT_EQ(whole.count(0, 0), 4);
+    EXPECT_EQ(whole.id(0, 0), 300);
+    EXPECT_EQ(whole.id(0, 1), 5);
+
+    AggTable merged;
+    merged.merge(part1);
+    merged.merge(part2);
+    EXPECT_EQ(merged.id(0, 0), 300);
+    EXPECT_EQ(merged.id(0, 1), 5);
+
+    // typed values go before the other terms
+    whole.update(0, 0, VAL_BASE + 7, typed_value_t(7, LIT_NUMERIC));
+    whole.update(0, 1, VAL_BASE + 7, typed_value_t(7, LIT_NUMERIC));
+    EXPECT_EQ(whole.id(0, 0), VAL_BASE + 7);
+    EXPECT_EQ(whole.id(0, 1), 5);
+}
+
+// partial aggregation by sub-queries (merged by RMap) vs. aggregation at once
+TEST(Aggregator, Partial) {
+    MockStrings strs;
+    const int nrows = 10000, ndepts = 13, nsubs = 4;
+
+    SPARQLQuery whole = make_query(0, nrows, ndepts);
+    Aggregator::finalize(whole, &strs, 0);
+    ASSERT_EQ(whole.result.row_num, ndepts);
+    EXPECT_EQ(whole.result.get_col_num(), 2);       // ?d and ?mx
+    EXPECT_EQ(whole.result.get_attr_col_num(), 3);  // ?c, ?s and ?a
+    EXPECT_EQ(whole.result.var2col(-6), 1);
+    EXPECT_EQ(whole.result.var_type(-4), INT_t);
+
+    // sorted by ?c (desc)
+    for (int i = 1; i < ndepts; i++)
+        EXPECT_GE(boost::get<int>(whole.result.attr_res_table[(i - 1) * 3]),
+                  boost::get<int>(whole.result.attr_res_table[i * 3]));
+
+    RMap rmap;
+    SPARQLQuery parent = make_query(0, 0, ndepts);
+    rmap.put_parent_request(parent, nsubs);
+    for (int s = 0; s < nsubs; s++) {
+        SPARQLQuery sub = make_query(s * nrows / nsubs, (s + 1) * nrows / nsubs, ndepts);
+        sub.pqid = parent.qid;
+        ASSERT_TRUE(sub.can_aggregate_partially());
+        Aggregator::aggregate(sub, &strs, 0);
+        EXPECT_EQ(sub.result.row_num, 0);
+        sub.shrink();
+        SPARQLQuery reply = round_trip(sub);
+        rmap.put_reply(reply);
+    }
+    ASSERT_TRUE(rmap.is_ready(parent.qid));
+    SPARQLQuery r = rmap.get_reply(parent.qid);
+    Aggregator::finalize(r, &strs, 0);
+    expect_same(whole.result, r.result);
+
+    // LIMIT and OFFSET on groups
+    SPARQLQuery top = make_query(0, nrows, ndepts);
+    top.offset = 1;
+    top.limit = 2;
+    Aggregator::finalize(top, &strs, 0);
+    ASSERT_EQ(top.result.row_num, 2);
+    EXPECT_EQ(top.result.result_table[0], whole.result.result_table[2]);
+}
+
+TEST(Aggregator, Special) {
+    MockStrings strs;
+
+    // COUNT(*) w/o GROUP BY and rows is 0
+    SPARQLQuery q = make_query(0, 0, 1);
+    q.aggregates.resize(1);
+    q.group_by.clear();
+    q.orders.clear();
+    q.result.required_vars = {-4};
+    Aggregator::finalize(q, &strs, 0);
+    ASSERT_EQ(q.result.row_num, 1);
+    EXPECT_EQ(q.result.get_col_num(), 0);
+    EXPECT_EQ(boost::get<int>(q.result.attr_res_table[0]), 0);
+
+    // COUNT(DISTINCT ?v) is not mergeable
+    q = make_query(0, 1000, 3);
+    q.aggregates = {SPARQLQuery::Aggregate(AGG_COUNT, -3, -4, true)};
+    q.result.required_vars = {-2, -4};
+    q.pqid = 0;
+    EXPECT_FALSE(q.can_aggregate_partially());
+    Aggregator::finalize(q, &strs, 0);
+    ASSERT_EQ(q.result.row_num, 3);
+    for (int i = 0; i < 3; i++)
+        EXPECT_EQ(boost::get<int>(q.result.attr_res_table[i]), 97);
+}
+
+// SELECT ?v (MIN(?d) AS ?mn) (MAX(?d) AS ?mx) ... GROUP BY ?v ORDER BY ?mx
+TEST(Aggregator, MinMaxIRIs) {
+    MockStrings strs;
+    SPARQLQuery q = make_query(0, 1000, 13);
+    q.aggregates = {SPARQLQuery::Aggregate(AGG_MIN, -2, -4, false),
+                    SPARQLQuery::Aggregate(AGG_MAX, -2, -5, false)};
+    q.group_by = {-3};
+    q.orders = {SPARQLQuery::Order(-5, false)};
+    q.result.required_vars = {-3, -4, -5};
+    Aggregator::finalize(q, &strs, 0);
+    ASSERT_EQ(q.result.row_num, 97);
+    ASSERT_EQ(q.result.get_col_num(), 3);  // ?v, ?mn and ?mx
+    ASSERT_EQ(q.result.get_attr_col_num(), 0);
+
+    // departments 100, ..., 112 by strings, and every group has department 100
+    std::string prev;
+    for (int i = 0; i < q.result.row_num; i++) {
+        EXPECT_EQ(q.result.result_table[i * 3 + 1], DEPT_BASE);
+        std::string mx = strs.id2str(0, q.result.result_table[i * 3 + 2]).second;
+        EXPECT_LE(prev, mx);  // sorted by ?mx
+        prev = mx;
+    }
+    EXPECT_EQ(prev, "<http://www.Department112.edu>");
+}
+
+// the bytes replied by sub-queries: rows vs. groups
+TEST(Aggregator, Benchmark) {
+    MockStrings strs;
+    const int nrows = 1 << 20, ndepts = 100, nsubs = 4;
+
+    uint64_t row_bytes = 0, group_bytes = 0, usec = 0;
+    for (int s = 0; s < nsubs; s++) {
+        SPARQLQuery sub = make_query(s * nrows / nsubs, (s + 1) * nrows / nsubs, ndepts);
+        row_bytes += Bundle(sub).take_str().size();
+
+        uint64_t start = timer::get_usec();
+        Aggregator::aggregate(sub, &strs, 0);
+        usec += timer::get_usec() - start;
+        sub.shrink();
+        group_bytes += Bundle(sub).take_str().size();
+    }
+    EXPECT_LT(group_bytes * 100, row_bytes);
+    printf("replies of %d sub-queries (%d rows, %d groups): rows %lu bytes, groups %lu bytes "
+           "(aggregated in %lu ms)\n", nsubs, nrows, ndepts, row_bytes, group_bytes, usec / 1000);
+}
+
+}  // namespace test
@@ -1,6 +1,19 @@
 #include <gtest/gtest.h>
 
+#include <pthread.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/bundle.hpp"
 #include "core/store/rdma_cache.hpp"
+#include "stringserver/sharded_cache.hpp"
+#include "stringserver/string_server.hpp"
+#include "utils/timer.hpp"
 
 namespace test {
 
@@ -54,4 +67,171 @@ TEST(Store, Cache) {
   EXPECT_EQ(success, false);
 }
 
+using str_handle_t = std::shared_ptr<const std::string>;
+
+TEST(StringCache, LookupAndInsert) {
+  ShardedCache<sid_t, str_handle_t> cache(100, 4);
+  str_handle_t str;
+  EXPECT_FALSE(cache.lookup(1, str));
+
+  cache.insert(1, std::make_shared<const std::string>("<a>"));
+  ASSERT_TRUE(cache.lookup(1, str));
+  EXPECT_EQ(*str, "<a>");
+
+  // update, and the handle of the old value is still valid
+  cache.insert(1, std::make_shared<const std::string>("<b>"));
+  str_handle_t str2;
+  ASSERT_TRUE(cache.lookup(1, str2));
+  EXPECT_EQ(*str2, "<b>");
+  EXPECT_EQ(*str, "<a>");
+
+  ShardedCache<std::string, sid_t> scache(100, 4);
+  sid_t id;
+  scache.insert("<a>", 1);
+  ASSERT_TRUE(scache.lookup("<a>", id));
+  EXPECT_EQ(id, 1);
+  EXPECT_FALSE(scache.lookup("<b>", id));
+
+  cache_stat_t stat = cache.get_total_stat();
+  EXPECT_EQ(stat.hits, 2);
+  EXPECT_EQ(stat.misses, 1);
+  EXPECT_EQ(stat.inserts, 1);
+  EXPECT_EQ(stat.size, 1);
+  EXPECT_EQ(cache.get_stats().size(), 4);
 }
+
+TEST(StringCache, ClockEviction) {
+  ShardedCache<sid_t, sid_t> cache(3, 1);
+  for (sid_t i = 1; i <= 3; i++)
+    cache.insert(i, i * 10);
+
+  // 1 and 3 are referenced, so 2 is evicted (second chance)
+  sid_t v;
+  EXPECT_TRUE(cache.lookup(1, v));
+  EXPECT_TRUE(cache.lookup(3, v));
+  cache.insert(4, 40);
+  EXPECT_FALSE(cache.lookup(2, v));
+  EXPECT_TRUE(cache.lookup(1, v));
+  EXPECT_TRUE(cache.lookup(3, v));
+  EXPECT_TRUE(cache.lookup(4, v));
+  EXPECT_EQ(v, 40);
+
+  cache_stat_t stat = cache.get_total_stat();
+  EXPECT_EQ(stat.evictions, 1);
+  EXPECT_EQ(stat.size, 3);
+
+  // the capacity is never exceeded
+  ShardedCache<sid_t, sid_t> cache2(1000, 16);
+  for (sid_t i = 0; i < 100000; i++)
+    cache2.insert(i, i);
+  EXPECT_LE(cache2.get_total_stat().size, 1000);
+}
+
+// the single-lock cache replaced by ShardedCache (copy strings on hits)
+class SingleLockCache {
+  pthread_spinlock_t lock;
+  boost::unordered_map<sid_t, std::string> ismap;
+
+public:
+  SingleLockCache() { pthread_spin_init(&lock, 0); }
+
+  void insert(sid_t id, const std::string &str) { ismap[id] = str; }
+
+  std::pair<bool, std::string> get_if_cached(sid_t id) {
+    std::string str;
+    pthread_spin_lock(&lock);
+    auto it = ismap.find(id);
+    bool found = (it != ismap.end());
+    if (found) str = it->second;
+    pthread_spin_unlock(&lock);
+    return std::make_pair(found, str);
+  }
+};
+
+// hit-path throughput w/ threads
+TEST(StringCache, Benchmark) {
+  const uint64_t nkeys = 10000, nlookups = 1 << 21;
+  const std::string prefix = "<http://www.Department0.University0.edu/GraduateStudent";
+
+  SingleLockCache single;
+  ShardedCache<sid_t, str_handle_t> sharded(2 * nkeys, 64);  // no eviction
+  for (sid_t i = 0; i < nkeys; i++) {
+    std::string str = prefix + std::to_string(i) + ">";
+    single.insert(i, str);
+    sharded.insert(i, std::make_shared<const std::string>(str));
+  }
+
+  auto run = [&](int nthreads, const std::function<uint64_t(sid_t)> &lookup) {
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> sums(nthreads);
+    uint64_t start = timer::get_usec();
+    for (int t = 0; t < nthreads; t++) {
+      threads.emplace_back([&, t]() {
+        unsigned int seed = t;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < nlookups / nthreads; i++)
+          sum += lookup(rand_r(&seed) % nkeys);
+        sums[t] = sum;
+      });
+    }
+    for (auto &th : threads) th.join();
+    uint64_t usec = std::max<uint64_t>(timer::get_usec() - start, 1);
+    for (auto sum : sums) EXPECT_GT(sum, 0);
+    return nlookups * 1000000 / usec;
+  };
+
+  for (int nthreads = 1; nthreads <= 8; nthreads *= 2) {
+    uint64_t single_tput = run(nthreads, [&](sid_t id) {
+      return single.get_if_cached(id).second.size();
+    });
+    uint64_t sharded_tput = run(nthreads, [&](sid_t id) {
+      str_handle_t str;
+      return sharded.lookup(id, str) ? str->size() : 0;
+    });
+    printf("%d thread(s): single lock %10lu lookups/s, sharded %10lu lookups/s\n",
+           nthreads, single_tput, sharded_tput);
+  }
+}
+
+// batched translation (w/ duplicates and unknown IDs) and its request
+TEST(StringServer, Batch) {
+  const std::string dname = "/tmp/wukong_test_strs/";
+  ASSERT_EQ(system(("mkdir -p " + dname).c_str()), 0);
+  {
+    std::ofstream str_index(dname + "str_index");
+    str_index << "<type> 1\n<p> 2\n";
+    std::ofstream str_normal(dname + "str_normal");
+    for (sid_t i = 0; i < 100; i++)
+      str_normal << "<v" << i << "> " << (1 << NBITS_IDX) + i << "\n";
+  }
+  StringServer server(dname);
+
+  std::vector<sid_t> vids = {1, 2, 3, (1 << NBITS_IDX) + 5, (1 << NBITS_IDX) + 5, (1 << NBITS_IDX) + 1000};
+  auto strs = server.id2str_batch(0, vids);
+  ASSERT_EQ(strs.size(), vids.size());
+  for (int i = 0; i < vids.size(); i++)
+    EXPECT_EQ(strs[i], server.id2str(0, vids[i]));
+  EXPECT_EQ(strs[3], std::make_pair(true, std::string("<v5>")));
+  EXPECT_FALSE(strs[5].first);
+
+  std::vector<std::string> names = {"<v7>", "<p>", "<none>"};
+  auto ids = server.str2id_batch(0, names);
+  EXPECT_EQ(ids[0], std::make_pair(true, (sid_t)(1 << NBITS_IDX) + 7));
+  EXPECT_EQ(ids[1], std::make_pair(true, (sid_t)2));
+  EXPECT_FALSE(ids[2].first);
+
+  // a batched request survives serialization
+  SSCacheRequest req(vids);
+  req.strs = {"a", "", "c"};
+  req.found = {true, false, true};
+  Bundle bundle(req);
+  SSCacheRequest copy = Bundle(bundle.to_str()).get_sscache_req();
+  EXPECT_TRUE(copy.req_type == SSCacheReqType::TRANS_ID_BATCH);
+  EXPECT_EQ(copy.vids, vids);
+  EXPECT_EQ(copy.strs, req.strs);
+  EXPECT_EQ(copy.found, req.found);
+
+  EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+}  // namespace test
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "core/sparql/query.hpp"
+#include "utils/timer.hpp"
+
+#define NROWS (1 << 16)
+#define NCOLS 4
+#define FANOUT 8
+
+namespace test {
+using namespace wukong;
+
+static void init_result(SPARQLQuery::Result &res) {
+    res.set_col_num(NCOLS);
+    res.result_table.resize(NROWS * NCOLS);
+    for (int i = 0; i < NROWS * NCOLS; i++)
+        res.result_table[i] = i;
+    res.update_nrows();
+}
+
+// a fake neighbor list: FANOUT neighbors for each vertex
+static inline sid_t ngbr(sid_t v, int k) { return v * FANOUT + k; }
+
+// a fake filter: keep a half of rows
+static inline bool keep(sid_t v) { return (v % 2) == 0; }
+
+// expand -> filter -> expand by copying rows (i.e., append_row_to)
+static void run_row_copy(SPARQLQuery::Result &res) {
+    for (int step = 0; step < 3; step++) {
+        std::vector<sid_t> updated_result_table;
+        int col = res.get_col_num() - 1;
+        int nrows = res.get_row_num();
+        for (int i = 0; i < nrows; i++) {
+            sid_t cur = res.get_row_col(i, col);
+            if (step == 1) {
+                if (keep(cur))
+                    res.append_row_to(i, updated_result_table);
+                continue;
+            }
+
+            for (int k = 0; k < FANOUT; k++) {
+                res.append_row_to(i, updated_result_table);
+                updated_result_table.push_back(ngbr(cur, k));
+            }
+        }
+
+        res.result_table.swap(updated_result_table);
+        if (step != 1) res.set_col_num(res.get_col_num() + 1);
+        res.update_nrows();
+    }
+}
+
+// expand -> filter -> expand on columnar table (late materialization)
+static void run_columnar(SPARQLQuery::Result &res) {
+    res.begin_columnar();
+    for (int step = 0; step < 3; step++) {
+        std::vector<sid_t> cur;
+        res.col_table.gather(res.get_col_num() - 1, cur);
+
+        if (step == 1) {
+            std::vector<uint32_t> rows;
+            for (uint32_t i = 0; i < cur.size(); i++)
+                if (keep(cur[i])) rows.push_back(i);
+            res.col_table.select(rows);
+            res.update_nrows();
+            continue;
+        }
+
+        std::vector<uint32_t> parents;
+        std::vector<sid_t> vals;
+        for (uint32_t i = 0; i < cur.size(); i++) {
+            for (int k = 0; k < FANOUT; k++) {
+                parents.push_back(i);
+                vals.push_back(ngbr(cur[i], k));
+            }
+        }
+        res.col_table.expand(parents, vals, res.get_col_num());
+        res.set_col_num(res.get_col_num() + 1);
+        res.update_nrows();
+    }
+    res.materialize();
+}
+
+TEST(ColumnTable, Basic) {
+    std::vector<sid_t> table = {1, 2, 3, 4, 5, 6};  // 3 rows x 2 cols
+    ColumnTable ct;
+    ct.init(table, 2);
+    EXPECT_EQ(ct.size(), 3);
+    EXPECT_EQ(ct.get(2, 1), 6);
+
+    // expand row 0 twice and row 2 once
+    std::vector<uint32_t> parents = {0, 0, 2};
+    std::vector<sid_t> vals = {10, 11, 12};
+    ct.expand(parents, vals, 2);
+    EXPECT_EQ(ct.size(), 3);
+
+    // keep the 2nd and 3rd rows
+    ct.select({1, 2});
+    EXPECT_EQ(ct.size(), 2);
+    EXPECT_EQ(ct.get(0, 0), 1);
+    EXPECT_EQ(ct.get(0, 2), 11);
+    EXPECT_EQ(ct.get(1, 1), 6);
+
+    std::vector<sid_t> col;
+    ct.gather(2, col);
+    EXPECT_EQ(col, std::vector<sid_t>({11, 12}));
+
+    std::vector<sid_t> out;
+    ct.flush(out, 3);
+    EXPECT_EQ(out, std::vector<sid_t>({1, 2, 11, 5, 6, 12}));
+    EXPECT_FALSE(ct.enabled());
+}
+
+// microbenchmark: row copy vs. columnar table
+TEST(ColumnTable, RowCopyVsColumnar) {
+    SPARQLQuery::Result r1, r2;
+    init_result(r1);
+    init_result(r2);
+
+    uint64_t t0 = timer::get_usec();
+    run_row_copy(r1);
+    uint64_t t1 = timer::get_usec();
+    run_columnar(r2);
+    uint64_t t2 = timer::get_usec();
+
+    printf("rows = %d, cols = %d: row copy = %lu usec, columnar = %lu usec\n",
+           r1.get_row_num(), r1.get_col_num(), t1 - t0, t2 - t1);
+
+    EXPECT_EQ(r1.get_col_num(), r2.get_col_num());
+    EXPECT_EQ(r1.get_row_num(), r2.get_row_num());
+    EXPECT_EQ(r1.result_table, r2.result_table);
+}
+
+}  // namespace test
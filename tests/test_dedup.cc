@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "core/engine/dedup.hpp"
+#include "core/store/dgraph.hpp"
+
+#define VID_MIN (1 << 17)
+#define PID_MIN (1 << 10)
+
+namespace test {
+using namespace wukong;
+
+// remote reads return the same buffer, like the per-thread RDMA buffer (see KVStore::rdma_get_values)
+class RemoteGraph : public DGraph {
+public:
+    std::vector<edge_t> rrbuf;
+    int nreads = 0;
+
+    RemoteGraph(int sid) : DGraph(sid, KVMem{nullptr, 0, nullptr, 0}), rrbuf(16) {}
+
+    void init_gstore(std::vector<std::vector<triple_t>>& triple_pso,
+                     std::vector<std::vector<triple_t>>& triple_pos,
+                     std::vector<std::vector<triple_attr_t>>& triple_sav) override {}
+
+    // #vid % 4 neighbors (vid * 10 + i)
+    edge_t* get_triples(int tid, sid_t vid, sid_t pid, dir_t d, uint64_t& sz) override {
+        nreads++;
+        sz = vid % 4;
+        for (uint64_t i = 0; i < sz; i++)
+            rrbuf[i] = edge_t(vid * 10 + i);
+        return rrbuf.data();
+    }
+};
+
+// #nrows rows of #ndistinct vertices, which are interleaved (fan-in-heavy) or consecutive
+static std::vector<sid_t> make_knowns(uint64_t nrows, uint64_t ndistinct, bool interleaved) {
+    std::vector<sid_t> knowns(nrows);
+    for (uint64_t i = 0; i < nrows; i++)
+        knowns[i] = 2 * (interleaved ? (i % ndistinct) : (i * ndistinct / nrows)) + VID_MIN + 1;
+    return knowns;
+}
+
+TEST(KnownDedup, NeedGlobal) {
+    int threshold = Global::dedup_threshold;
+    Global::dedup_threshold = 20;
+
+    EXPECT_TRUE(KnownDedup::need_global(make_knowns(10000, 8, true)));
+    EXPECT_FALSE(KnownDedup::need_global(make_knowns(10000, 8, false)));    // consecutive
+    EXPECT_FALSE(KnownDedup::need_global(make_knowns(10000, 10000, true)));  // distinct
+    EXPECT_FALSE(KnownDedup::need_global(make_knowns(KnownDedup::MIN_ROWS - 1, 8, true)));
+
+    Global::dedup_threshold = 0;  // disabled
+    EXPECT_FALSE(KnownDedup::need_global(make_knowns(10000, 8, true)));
+    Global::dedup_threshold = threshold;
+}
+
+// the neighbors of remote vertices are expanded back to every row (incl. duplicates)
+TEST(KnownDedup, ExpandRows) {
+    int num_servers = Global::num_servers, threshold = Global::dedup_threshold;
+    Global::num_servers = 2;
+    Global::dedup_threshold = 20;
+    RemoteGraph graph(0);  // odd vertices are remote
+
+    for (bool interleaved : {true, false}) {
+        std::vector<sid_t> knowns = make_knowns(4096, 16, interleaved);
+        knowns[7] = BLANK_ID;
+        ASSERT_EQ(KnownDedup::need_global(knowns), interleaved);
+
+        std::vector<sid_t> vids;
+        std::vector<int64_t> idxs;
+        KnownDedup::dedup(knowns, vids, idxs);
+        EXPECT_EQ(vids.size(), 16);
+
+        std::vector<edge_t*> vid_edges, edges;
+        std::vector<uint64_t> vid_szs, szs;
+        std::vector<edge_t> remote_edges;
+        graph.nreads = 0;
+        graph.get_triples_batch(0, vids, PID_MIN, OUT, vid_edges, vid_szs, remote_edges);
+        EXPECT_EQ(graph.nreads, vids.size());
+        KnownDedup::expand(idxs, vid_edges, vid_szs, edges, szs);
+
+        ASSERT_EQ(edges.size(), knowns.size());
+        ASSERT_EQ(szs.size(), knowns.size());
+        for (uint64_t i = 0; i < knowns.size(); i++) {
+            if (knowns[i] == BLANK_ID) {
+                EXPECT_EQ(edges[i], nullptr);
+                EXPECT_EQ(szs[i], 0);
+                continue;
+            }
+            EXPECT_EQ(szs[i], knowns[i] % 4);
+            for (uint64_t k = 0; k < szs[i]; k++)
+                EXPECT_EQ(edges[i][k].val, knowns[i] * 10 + k);
+        }
+    }
+    Global::num_servers = num_servers;
+    Global::dedup_threshold = threshold;
+}
+
+}  // namespace test
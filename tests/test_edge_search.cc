@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "core/store/edge_search.hpp"
+#include "utils/timer.hpp"
+
+#define NEDGES (1 << 16)
+#define NSEARCHES (1 << 20)
+
+namespace test {
+using namespace wukong;
+
+// a sorted value list of even IDs
+static std::vector<edge_t> make_edges(uint64_t n) {
+    std::vector<edge_t> edges;
+    for (uint64_t i = 0; i < n; i++)
+        edges.push_back(edge_t(2 * i + 2));
+    return edges;
+}
+
+TEST(EdgeSearch, Contains) {
+    for (uint64_t n : {0, 1, 7, 16, 17, 1000}) {
+        std::vector<edge_t> edges = make_edges(n);
+        for (sid_t v = 0; v < 2 * n + 4; v++)
+            EXPECT_EQ(edge_contains(edges.data(), n, v), (v > 0) && (v % 2 == 0) && (v <= 2 * n));
+    }
+}
+
+TEST(EdgeSearch, Gallop) {
+    std::vector<edge_t> edges = make_edges(1000);
+    uint64_t lo = 0;
+    for (sid_t v = 0; v < 2100; v += 3) {
+        uint64_t k = edge_gallop(edges.data(), lo, edges.size(), v);
+        EXPECT_EQ(k, edge_lower_bound(edges.data(), 0, edges.size(), v));
+        lo = k;
+    }
+}
+
+TEST(EdgeSearch, Intersect) {
+    unsigned int seed = 0;
+    for (uint64_t n : {3, 40, 1000, 5000}) {
+        std::vector<edge_t> edges = make_edges(2000);
+
+        // sorted values w/ duplicates
+        std::vector<sid_t> vals;
+        for (uint64_t i = 0; i < n; i++)
+            vals.push_back(rand_r(&seed) % 4100);
+        std::sort(vals.begin(), vals.end());
+
+        std::vector<uint64_t> expected, matched;
+        for (uint64_t i = 0; i < n; i++)
+            if (edge_contains(edges.data(), edges.size(), vals[i]))
+                expected.push_back(i);
+        edge_intersect(vals.data(), n, edges.data(), edges.size(), matched);
+        EXPECT_EQ(matched, expected);
+    }
+}
+
+// membership test on a high-degree vertex: linear scan vs. binary search
+TEST(EdgeSearch, Throughput) {
+    std::vector<edge_t> edges = make_edges(NEDGES);
+    std::vector<sid_t> vals(NSEARCHES / 64);
+    unsigned int seed = 0;
+    for (auto &v : vals)
+        v = rand_r(&seed) % (2 * NEDGES);
+
+    uint64_t n0 = 0, n1 = 0, n2 = 0;
+    uint64_t t0 = timer::get_usec();
+    for (auto v : vals) {
+        for (uint64_t k = 0; k < NEDGES; k++) {
+            if ((sid_t)edges[k].val == v) {
+                n0++;
+                break;
+            }
+        }
+    }
+    uint64_t t1 = timer::get_usec();
+    for (int r = 0; r < 64; r++)
+        for (auto v : vals)
+            n1 += edge_contains(edges.data(), NEDGES, v);
+    uint64_t t2 = timer::get_usec();
+
+    std::sort(vals.begin(), vals.end());
+    std::vector<uint64_t> matched;
+    for (int r = 0; r < 64; r++) {
+        matched.clear();
+        edge_intersect(vals.data(), vals.size(), edges.data(), NEDGES, matched);
+        n2 += matched.size();
+    }
+    uint64_t t3 = timer::get_usec();
+
+    EXPECT_EQ(n0 * 64, n1);
+    EXPECT_EQ(n1, n2);
+    printf("degree %d: linear scan %.3f Mops/s, binary search %.2f Mops/s, intersect %.2f Mops/s\n",
+           NEDGES, (double)vals.size() / (t1 - t0), (double)NSEARCHES / (t2 - t1),
+           (double)NSEARCHES / (t3 - t2));
+}
+
+}  // namespace test
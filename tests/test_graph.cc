@@ -285,4 +285,45 @@ TEST(Dgraph, TestRDFGraph) {
     delete rbuf;
 }
 
+// remote reads return the same buffer, like the per-thread RDMA buffer (see KVStore::rdma_get_values)
+class RemoteGraph : public DGraph {
+public:
+    std::vector<edge_t> rrbuf;
+
+    RemoteGraph(int sid) : DGraph(sid, KVMem{nullptr, 0, nullptr, 0}), rrbuf(16) {}
+
+    void init_gstore(std::vector<std::vector<triple_t>>& triple_pso,
+                     std::vector<std::vector<triple_t>>& triple_pos,
+                     std::vector<std::vector<triple_attr_t>>& triple_sav) override {}
+
+    // #vid % 4 neighbors (vid * 10 + i)
+    edge_t* get_triples(int tid, sid_t vid, sid_t pid, dir_t d, uint64_t& sz) override {
+        sz = vid % 4;
+        for (uint64_t i = 0; i < sz; i++)
+            rrbuf[i] = edge_t(vid * 10 + i);
+        return rrbuf.data();
+    }
+};
+
+TEST(Dgraph, RemoteTriplesBatch) {
+    int num_servers = Global::num_servers;
+    Global::num_servers = 2;
+    RemoteGraph graph(0);
+
+    std::vector<sid_t> vids = {VID_MIN + 1, VID_MIN + 3, VID_MIN + 5, VID_MIN + 7};  // all remote
+    std::vector<edge_t*> edges;
+    std::vector<uint64_t> szs;
+    std::vector<edge_t> remote_edges;
+    graph.get_triples_batch(TID, vids, PID_MIN, OUT, edges, szs, remote_edges);
+    Global::num_servers = num_servers;
+
+    ASSERT_EQ(edges.size(), vids.size());
+    ASSERT_EQ(szs.size(), vids.size());
+    for (int i = 0; i < vids.size(); i++) {
+        EXPECT_EQ(szs[i], vids[i] % 4);
+        for (uint64_t k = 0; k < szs[i]; k++)
+            EXPECT_EQ(edges[i][k].val, vids[i] * 10 + k);  // not overwritten by later reads
+    }
+}
+
 }  // namespace test
@@ -0,0 +1,308 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/store/static_kvstore.hpp"
+#include "utils/timer.hpp"
+
+#define KV_SZ (sizeof(edge_t) << 25)  // 128MB w/o timestamps
+#define RBUF_SZ (1 << 15)
+#define SID 0
+#define PID 20
+#define NWRITERS 2
+#define NREADERS 2
+#define NKEYS_PER_WRITER (1 << 14)
+#define NVALS_PER_KEY 3
+#define NKEYS_BENCH (1 << 20)
+#define NLOOKUPS (1 << 22)
+#define NBUCKETS_PROBE (1 << 16)
+
+namespace test {
+using namespace wukong;
+
+// TestKVStore for testing KVStore's protected functions
+// NOTE: DynamicKVStore is not used since BuddyMalloc requires at least 4GB entry region
+template <class KeyType, class PtrType, class ValueType>
+class TestKVStore : public StaticKVStore<KeyType, PtrType, ValueType> {
+    using slot_t = typename KVStore<KeyType, PtrType, ValueType>::slot_t;
+
+public:
+    TestKVStore(int sid, KVMem kv_mem) : StaticKVStore<KeyType, PtrType, ValueType>(sid, kv_mem) {}
+    ~TestKVStore() {}
+
+    // append a value to the key by moving values to a new block
+    // (the same as DynamicKVStore::insert_key_value)
+    void append_value(KeyType key, ValueType value) {
+        uint64_t bucket_id = this->bucket_local(key);
+        uint64_t lock_id = bucket_id % this->NUM_LOCKS;
+        slot_t slot;
+        uint64_t slot_id = this->lookup_slot(key, bucket_id, slot);
+        if (slot.key != key) {
+            uint64_t off = this->alloc_entries(1);
+            this->values[off] = value;
+            this->insert_key(key, PtrType(1, off));
+            return;
+        }
+
+        this->lock_bucket(lock_id);
+        PtrType old_ptr = this->slots[slot_id].ptr;
+        uint64_t off = this->alloc_entries(old_ptr.size + 1);
+        memcpy(&this->values[off], &this->values[old_ptr.off], old_ptr.size * sizeof(ValueType));
+        this->values[off + old_ptr.size] = value;
+        this->slots[slot_id].ptr = PtrType(old_ptr.size + 1, off);
+        this->unlock_bucket(lock_id);
+    }
+
+    uint64_t get_num_buckets() { return this->num_buckets; }
+
+    // lookup with the bucket lock (the behavior before optimistic reads)
+    bool check_key_exist_locked(KeyType key) {
+        uint64_t bucket_id = this->bucket_local(key);
+        uint64_t lock_id = bucket_id % this->NUM_LOCKS;
+        slot_t slot;
+        pthread_spin_lock(&this->bucket_locks[lock_id]);
+        this->probe_chain(key, bucket_id, slot);
+        pthread_spin_unlock(&this->bucket_locks[lock_id]);
+        return (slot.key == key);
+    }
+};
+
+using TestStore = TestKVStore<ikey_t, iptr_t, edge_t>;
+
+static TestStore *new_store(char *&kvs, char *&rbuf) {
+    kvs = new char[KV_SZ];
+    rbuf = new char[RBUF_SZ];
+    KVMem kv_mem = {kvs, KV_SZ, rbuf, RBUF_SZ};
+    return new TestStore(SID, kv_mem);
+}
+
+// concurrent inserts/updates and lock-free reads
+TEST(KVStore, ConcurrentInsertAndRead) {
+    char *kvs, *rbuf;
+    TestStore *gstore = new_store(kvs, rbuf);
+
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> nerrors(0), nfound(0);
+    std::vector<std::thread> threads;
+
+    for (int w = 0; w < NWRITERS; w++) {
+        threads.push_back(std::thread([&, w]() {
+            for (int n = 0; n < NVALS_PER_KEY; n++) {
+                for (uint64_t i = 0; i < NKEYS_PER_WRITER; i++) {
+                    uint64_t vid = 1 + w * NKEYS_PER_WRITER + i;
+                    gstore->append_value(ikey_t(vid, PID, OUT), edge_t(vid + n));
+                }
+            }
+        }));
+    }
+
+    for (int r = 0; r < NREADERS; r++) {
+        threads.push_back(std::thread([&, r]() {
+            unsigned int seed = r;
+            while (!done) {
+                uint64_t vid = 1 + rand_r(&seed) % (NWRITERS * NKEYS_PER_WRITER);
+                uint64_t sz = 0;
+                edge_t *vals = gstore->get_values(NWRITERS + r, SID, ikey_t(vid, PID, OUT), sz);
+                if (vals == nullptr)
+                    continue;  // not inserted yet
+
+                nfound++;
+                if (sz < 1 || sz > NVALS_PER_KEY || vals[0].val != vid)
+                    nerrors++;
+            }
+        }));
+    }
+
+    for (int w = 0; w < NWRITERS; w++)
+        threads[w].join();
+    done = true;
+    for (int r = 0; r < NREADERS; r++)
+        threads[NWRITERS + r].join();
+
+    EXPECT_EQ(nerrors, 0);
+    printf("%lu successful reads during insertion\n", nfound.load());
+
+    for (uint64_t vid = 1; vid <= NWRITERS * NKEYS_PER_WRITER; vid++) {
+        uint64_t sz = 0;
+        edge_t *vals = gstore->get_values(0, SID, ikey_t(vid, PID, OUT), sz);
+        EXPECT_TRUE(gstore->check_key_exist(ikey_t(vid, PID, OUT)));
+        EXPECT_FALSE(gstore->check_key_exist(ikey_t(vid, PID, IN)));
+        ASSERT_NE(vals, nullptr);
+        EXPECT_EQ(sz, NVALS_PER_KEY);
+        for (int n = 0; n < NVALS_PER_KEY; n++)
+            EXPECT_EQ(vals[n].val, vid + n);
+    }
+
+    delete gstore;
+    delete[] kvs;
+    delete[] rbuf;
+}
+
+// read throughput: optimistic reads vs. bucket spinlocks
+TEST(KVStore, ReadThroughput) {
+    char *kvs, *rbuf;
+    TestStore *gstore = new_store(kvs, rbuf);
+
+    for (uint64_t vid = 1; vid <= NKEYS_BENCH; vid++) {
+        gstore->append_value(ikey_t(vid, PID, OUT), edge_t(vid));
+    }
+
+    int max_threads = std::max(1U, std::thread::hardware_concurrency());
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        for (int locked = 0; locked < 2; locked++) {
+            std::atomic<uint64_t> nhits(0);
+            std::vector<std::thread> threads;
+            uint64_t start = timer::get_usec();
+            for (int t = 0; t < nthreads; t++) {
+                threads.push_back(std::thread([&, t]() {
+                    unsigned int seed = t;
+                    uint64_t hits = 0;
+                    for (int i = 0; i < NLOOKUPS / nthreads; i++) {
+                        ikey_t key(1 + rand_r(&seed) % NKEYS_BENCH, PID, OUT);
+                        hits += locked ? gstore->check_key_exist_locked(key)
+                                       : gstore->check_key_exist(key);
+                    }
+                    nhits += hits;
+                }));
+            }
+            for (auto &th : threads)
+                th.join();
+            uint64_t end = timer::get_usec();
+
+            EXPECT_EQ(nhits, (NLOOKUPS / nthreads) * nthreads);
+            printf("%d threads, %s: %.2f Mops/s\n", nthreads,
+                   locked ? "spinlock" : "optimistic",
+                   (double)NLOOKUPS / (end - start));
+        }
+    }
+
+    delete gstore;
+    delete[] kvs;
+    delete[] rbuf;
+}
+
+// SIMD (if enabled) vs. scalar bucket probing
+TEST(KVStore, ProbeBucket) {
+    struct slot_t {
+        ikey_t key;
+        iptr_t ptr;
+    };
+
+    std::vector<slot_t> buckets(NBUCKETS_PROBE * 8);
+    unsigned int seed = 0;
+    for (auto &s : buckets) {
+        // about a quarter of slots are empty
+        if (rand_r(&seed) % 4)
+            s.key = ikey_t(1 + rand_r(&seed) % 64, PID, rand_r(&seed) % 2);
+        s.ptr = iptr_t(rand_r(&seed) % 64, rand_r(&seed));
+    }
+
+    for (uint64_t b = 0; b < NBUCKETS_PROBE; b++) {
+        for (int n = 0; n < 8; n++) {
+            ikey_t key(1 + rand_r(&seed) % 64, PID, rand_r(&seed) % 2);
+            // scalar reference
+            int expected = 7;
+            for (int i = 0; i < 7; i++) {
+                if (buckets[b * 8 + i].key == key || buckets[b * 8 + i].key.is_empty()) {
+                    expected = i;
+                    break;
+                }
+            }
+
+            uint64_t k;
+            memcpy(&k, &key, sizeof(uint64_t));
+            EXPECT_EQ(probe_bucket(&buckets[b * 8], k), expected);
+        }
+    }
+}
+
+// lookup throughput across load factors of the main-header region
+TEST(KVStore, LookupThroughput) {
+    for (int lf = 25; lf <= 100; lf += 25) {
+        char *kvs, *rbuf;
+        TestStore *gstore = new_store(kvs, rbuf);
+
+        uint64_t nkeys = gstore->get_num_buckets() * (KVStore<ikey_t, iptr_t, edge_t>::ASSOCIATIVITY - 1) * lf / 100;
+        for (uint64_t vid = 1; vid <= nkeys; vid++)
+            gstore->append_value(ikey_t(vid, PID, OUT), edge_t(vid));
+
+        unsigned int seed = lf;
+        uint64_t hits = 0, start = timer::get_usec();
+        for (int i = 0; i < NLOOKUPS; i++) {
+            // a half of lookups miss
+            ikey_t key(1 + rand_r(&seed) % nkeys, PID, rand_r(&seed) % 2);
+            uint64_t sz = 0;
+            hits += (gstore->get_values(0, SID, key, sz) != nullptr);
+        }
+        uint64_t end = timer::get_usec();
+
+        EXPECT_GT(hits, 0);
+        EXPECT_LT(hits, NLOOKUPS);
+        printf("load factor %d%%: %.2f Mops/s (%s)\n", lf, (double)NLOOKUPS / (end - start),
+#if defined(USE_AVX512)
+               "AVX-512"
+#elif defined(USE_AVX2)
+               "AVX2"
+#else
+               "scalar"
+#endif
+              );
+
+        delete gstore;
+        delete[] kvs;
+        delete[] rbuf;
+    }
+}
+
+// batched lookups vs. one-by-one lookups
+TEST(KVStore, BatchLookup) {
+    char *kvs, *rbuf;
+    TestStore *gstore = new_store(kvs, rbuf);
+
+    for (uint64_t vid = 1; vid <= NKEYS_BENCH; vid++) {
+        gstore->append_value(ikey_t(vid, PID, OUT), edge_t(vid));
+        if (vid % 2) gstore->append_value(ikey_t(vid, PID, OUT), edge_t(vid + 1));
+    }
+
+    // random keys, a quarter of them miss
+    std::vector<ikey_t> keys(NLOOKUPS);
+    unsigned int seed = 0;
+    for (auto &key : keys)
+        key = ikey_t(1 + rand_r(&seed) % (NKEYS_BENCH + NKEYS_BENCH / 3), PID, OUT);
+
+    std::vector<edge_t *> vals(NLOOKUPS);
+    std::vector<uint64_t> szs(NLOOKUPS);
+    // both read the last value of each key
+    uint64_t sum0 = 0, sum1 = 0;
+    uint64_t t0 = timer::get_usec();
+    gstore->get_values_batch(0, keys.data(), keys.size(), vals.data(), szs.data());
+    for (uint64_t i = 0; i < keys.size(); i++)
+        if (szs[i] > 0) sum0 += vals[i][szs[i] - 1].val;
+    uint64_t t1 = timer::get_usec();
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        uint64_t sz = 0;
+        edge_t *v = gstore->get_values(0, SID, keys[i], sz);
+        if (sz > 0) sum1 += v[sz - 1].val;
+    }
+    uint64_t t2 = timer::get_usec();
+    EXPECT_EQ(sum0, sum1);
+
+    uint64_t nerrors = 0;
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        uint64_t sz = 0;
+        edge_t *v = gstore->get_values(0, SID, keys[i], sz);
+        if (v != vals[i] || sz != szs[i])
+            nerrors++;
+    }
+    EXPECT_EQ(nerrors, 0);
+    printf("batch: %.2f Mops/s, one by one: %.2f Mops/s\n",
+           (double)NLOOKUPS / (t1 - t0), (double)NLOOKUPS / (t2 - t1));
+
+    delete gstore;
+    delete[] kvs;
+    delete[] rbuf;
+}
+
+}  // namespace test
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <omp.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "loader/posix_loader.hpp"
+#include "utils/timer.hpp"
+
+#define NTRIPLES (1 << 22)
+#define MAX_THREADS 4
+
+namespace test {
+using namespace wukong;
+
+// expose the parser of BaseLoader
+class TestLoader : public PosixLoader {
+public:
+    TestLoader() : PosixLoader(0, LoaderMem()) {}
+
+    std::vector<triple_t> parse(const std::string& fname, bool splittable = true) {
+        std::vector<std::vector<triple_t>> triples(Global::num_engines);
+        parse_triple_files(std::vector<std::string>(1, fname), std::vector<bool>(1, true), splittable,
+                           [&](int localtid, int fid, const triple_t& triple) {
+            triples[localtid].push_back(triple);
+        });
+
+        std::vector<triple_t> all;
+        for (auto& t : triples)
+            all.insert(all.end(), t.begin(), t.end());
+        std::sort(all.begin(), all.end(), triple_sort_by_spo());
+        return all;
+    }
+
+    uint64_t count(const std::string& fname) {
+        std::vector<uint64_t> cnts(Global::num_engines, 0);
+        parse_triple_files(std::vector<std::string>(1, fname), std::vector<bool>(1, true), true,
+                           [&](int localtid, int fid, const triple_t& triple) {
+            cnts[localtid] += (triple.p != 0);
+        });
+
+        uint64_t n = 0;
+        for (auto c : cnts)
+            n += c;
+        return n;
+    }
+};
+
+static std::vector<triple_t> gen_triples(uint64_t n) {
+    std::vector<triple_t> triples;
+    unsigned int seed = 0;
+    for (uint64_t i = 0; i < n; i++)
+        triples.push_back(triple_t((1 << 17) + rand_r(&seed) % (1 << 24), 1 + rand_r(&seed) % 20,
+                                   (1 << 17) + rand_r(&seed) % (1 << 24)));
+    return triples;
+}
+
+static void write_text(const std::string& fname, const std::vector<triple_t>& triples) {
+    std::ofstream ofs(fname);
+    for (auto& t : triples)
+        ofs << t.s << "\t" << t.p << "\t" << t.o << "\n";
+}
+
+static void write_bin(const std::string& fname, const std::vector<triple_t>& triples) {
+    std::ofstream ofs(fname, std::ios::binary);
+    triple_bin_header_t h;
+    h.ntriples = triples.size();
+    ofs.write(reinterpret_cast<char*>(&h), sizeof(h));
+    for (auto& t : triples) {
+        sid_t ids[3] = {t.s, t.p, t.o};
+        ofs.write(reinterpret_cast<char*>(ids), sizeof(ids));
+    }
+}
+
+static uint64_t file_sz(const std::string& fname) {
+    std::ifstream ifs(fname, std::ios::binary | std::ios::ate);
+    return ifs.tellg();
+}
+
+static void expect_same(std::vector<triple_t> t0, const std::vector<triple_t>& t1) {
+    std::sort(t0.begin(), t0.end(), triple_sort_by_spo());
+    ASSERT_EQ(t0.size(), t1.size());
+    uint64_t nerrors = 0;
+    for (uint64_t i = 0; i < t0.size(); i++)
+        nerrors += !(t0[i] == t1[i]);
+    EXPECT_EQ(nerrors, 0);
+}
+
+TEST(Loader, ParseText) {
+    std::vector<triple_t> parsed;
+    auto emit = [&](const triple_t& t) { parsed.push_back(t); };
+
+    std::string text = "1 2 3\n4\t5\t6\r\n\n  7 8 9";
+    const char* p = text.data();
+    EXPECT_TRUE(parse_text_triples(p, text.data() + text.size(), true, emit));
+    ASSERT_EQ(parsed.size(), 3);
+    EXPECT_TRUE(parsed[1] == triple_t(4, 5, 6));
+    EXPECT_TRUE(parsed[2] == triple_t(7, 8, 9));
+
+    // an incomplete triple is left for the next buffer
+    parsed.clear();
+    p = text.data();
+    EXPECT_TRUE(parse_text_triples(p, text.data() + text.size(), false, emit));
+    EXPECT_EQ(parsed.size(), 2);
+    EXPECT_EQ(p - text.data(), text.find("6") + 1);
+
+    // stop at malformed data like std::istream
+    parsed.clear();
+    text = "1 2 3\n4 x 6\n7 8 9\n";
+    p = text.data();
+    EXPECT_FALSE(parse_text_triples(p, text.data() + text.size(), true, emit));
+    EXPECT_EQ(parsed.size(), 1);
+
+    // small chunks
+    parsed.clear();
+    text = "11 22 33\n444 555 666\n7 8 9\n";
+    std::istringstream iss(text);
+    uint64_t nbytes = 0;
+    EXPECT_TRUE(parse_triple_stream(iss, false, emit, nbytes, 4));
+    EXPECT_EQ(nbytes, text.size());
+    ASSERT_EQ(parsed.size(), 3);
+    EXPECT_TRUE(parsed[1] == triple_t(444, 555, 666));
+}
+
+TEST(Loader, SplitText) {
+    std::string text;
+    for (int i = 0; i < 1000; i++)
+        text += std::to_string(i) + " " + std::to_string(i * 7) + " " + std::to_string(i * 13) + "\n";
+
+    for (uint64_t split_sz : {1UL, 10UL, 333UL, 1UL << 20}) {
+        auto pieces = split_triple_file(text.data(), text.size(), false, split_sz);
+        uint64_t n = 0, last = 0;
+        for (auto& piece : pieces) {
+            EXPECT_EQ(piece.first, last);
+            EXPECT_TRUE(piece.first == 0 || text[piece.first - 1] == '\n');
+            last = piece.second;
+
+            const char* p = text.data() + piece.first;
+            parse_text_triples(p, text.data() + piece.second, true, [&](const triple_t& t) {
+                EXPECT_EQ(t.s, n);
+                EXPECT_EQ(t.o, n * 13);
+                n++;
+            });
+        }
+        EXPECT_EQ(last, text.size());
+        EXPECT_EQ(n, 1000);
+    }
+}
+
+TEST(Loader, TextAndBinaryFiles) {
+    std::vector<triple_t> triples = gen_triples(100000);
+    std::string tname = "/tmp/wukong_test_loader.nt", bname = "/tmp/wukong_test_loader.bin";
+    write_text(tname, triples);
+    write_bin(bname, triples);
+
+    TestLoader loader;
+    for (int nthreads : {1, 3}) {
+        Global::num_engines = nthreads;
+        expect_same(triples, loader.parse(tname));
+        expect_same(triples, loader.parse(bname));
+        expect_same(triples, loader.parse(tname, false));
+    }
+
+    // stream (e.g., HDFS)
+    for (std::string fname : {tname, bname}) {
+        std::vector<triple_t> parsed;
+        std::ifstream ifs(fname, std::ios::binary);
+        uint64_t nbytes = 0;
+        EXPECT_TRUE(parse_triple_stream(ifs, is_triple_bin_file(fname),
+                                        [&](const triple_t& t) { parsed.push_back(t); }, nbytes, 1000));
+        EXPECT_EQ(nbytes, file_sz(fname));
+        std::sort(parsed.begin(), parsed.end(), triple_sort_by_spo());
+        expect_same(triples, parsed);
+    }
+
+    // corrupted binary file
+    {
+        std::fstream fs(bname, std::ios::in | std::ios::out | std::ios::binary);
+        fs.write("WKBROKEN", 8);
+    }
+    EXPECT_EQ(loader.parse(bname).size(), 0);
+
+    unlink(tname.c_str());
+    unlink(bname.c_str());
+}
+
+// loading throughput: std::istream vs. hand-written tokenizer (text) vs. binary
+TEST(Loader, Benchmark) {
+    std::vector<triple_t> triples = gen_triples(NTRIPLES);
+    std::string tname = "/tmp/wukong_bench_loader.nt", bname = "/tmp/wukong_bench_loader.bin";
+    write_text(tname, triples);
+    write_bin(bname, triples);
+
+    auto report = [](const char* name, int nthreads, uint64_t sz, uint64_t n, uint64_t usec) {
+        usec = std::max<uint64_t>(usec, 1);
+        printf("%-8s %d thread(s): %8.1f MB/s %12lu triples/s (per thread: %8.1f MB/s %12lu triples/s)\n",
+               name, nthreads, B2MiB(sz) * 1000000 / usec, n * 1000000 / usec,
+               B2MiB(sz) * 1000000 / usec / nthreads, n * 1000000 / usec / nthreads);
+    };
+
+    uint64_t start = timer::get_usec();
+    {
+        std::ifstream ifs(tname);
+        triple_t t;
+        uint64_t n = 0;
+        while (ifs >> t.s >> t.p >> t.o)
+            n++;
+        EXPECT_EQ(n, triples.size());
+    }
+    report("istream", 1, file_sz(tname), triples.size(), timer::get_usec() - start);
+
+    TestLoader loader;
+    for (int nthreads = 1; nthreads <= MAX_THREADS; nthreads *= 2) {
+        Global::num_engines = nthreads;
+        for (std::string fname : {tname, bname}) {
+            start = timer::get_usec();
+            EXPECT_EQ(loader.count(fname), triples.size());
+            report(is_triple_bin_file(fname) ? "binary" : "text", nthreads,
+                   file_sz(fname), triples.size(), timer::get_usec() - start);
+        }
+    }
+    Global::num_engines = 1;
+
+    unlink(tname.c_str());
+    unlink(bname.c_str());
+}
+
+}  // namespace test
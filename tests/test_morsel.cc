@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/engine/morsel.hpp"
+
+#define NTASKS 64
+#define NMORSELS 16
+#define NHELPERS 3
+
+namespace test {
+using namespace wukong;
+
+// every morsel is run exactly once by the owners or helpers
+TEST(Morsel, ClaimOnce) {
+    std::vector<std::shared_ptr<MorselTask>> tasks;
+    std::vector<std::atomic<int>> runs(NTASKS * NMORSELS);
+    for (auto &r : runs) r = 0;
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> helpers;
+    for (int h = 0; h < NHELPERS; h++) {
+        helpers.push_back(std::thread([&]() {
+            while (!stop) {
+                int m;
+                std::shared_ptr<MorselTask> task = morsel_pool.pick(m);
+                if (task == nullptr) continue;
+                runs[task->morsels[m].qid * NMORSELS + m]++;
+                task->ndone++;
+            }
+        }));
+    }
+
+    // the owner publishes tasks and runs morsels by itself as well
+    for (int t = 0; t < NTASKS; t++) {
+        std::shared_ptr<MorselTask> task = std::make_shared<MorselTask>();
+        task->morsels.resize(NMORSELS);
+        for (auto &q : task->morsels) q.qid = t;
+        morsel_pool.publish(task);
+
+        int m;
+        while ((m = task->claim()) >= 0) {
+            runs[t * NMORSELS + m]++;
+            task->ndone++;
+        }
+        while (!task->done()) continue;
+        EXPECT_EQ(task->status, SUCCESS);
+    }
+
+    stop = true;
+    for (auto &th : helpers)
+        th.join();
+
+    for (auto &r : runs)
+        EXPECT_EQ(r, 1);
+
+    int m;
+    EXPECT_EQ(morsel_pool.pick(m), nullptr);
+}
+
+}  // namespace test
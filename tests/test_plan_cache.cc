@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "optimizer/plan_cache.hpp"
+#include "optimizer/planner.hpp"
+
+namespace test {
+using namespace wukong;
+
+// ?X ub:takesCourse <course>, ?X rdf:type ub:GraduateStudent, ?Y ub:memberOf ?X (UNION ?Y ub:worksFor ?X)
+static SPARQLQuery make_query(ssid_t course, ssid_t type) {
+    SPARQLQuery r;
+    r.pattern_group.patterns.push_back(SPARQLQuery::Pattern(-1, 10, OUT, course));
+    r.pattern_group.patterns.push_back(SPARQLQuery::Pattern(-1, TYPE_ID, OUT, type));
+    SPARQLQuery::PatternGroup g0, g1;
+    g0.patterns.push_back(SPARQLQuery::Pattern(-2, 11, OUT, -1));
+    g1.patterns.push_back(SPARQLQuery::Pattern(-2, 12, OUT, -1));
+    r.pattern_group.unions.push_back(g0);
+    r.pattern_group.unions.push_back(g1);
+    return r;
+}
+
+static void expect_pattern(const SPARQLQuery::Pattern &p, ssid_t s, ssid_t pred, dir_t d, ssid_t o) {
+    EXPECT_EQ(p.subject, s);
+    EXPECT_EQ(p.predicate, pred);
+    EXPECT_EQ(p.direction, d);
+    EXPECT_EQ(p.object, o);
+}
+
+TEST(PlanCache, Key) {
+    PlanCache::key_t key = PlanCache::get_key(make_query(1 << 17, 100));
+    EXPECT_EQ(PlanCache::get_key(make_query((1 << 17) + 1, 100)), key);  // another instance
+    EXPECT_NE(PlanCache::get_key(make_query(1 << 17, 101)), key);        // another type
+
+    SPARQLQuery r = make_query(1 << 17, 100);
+    r.pattern_group.unions[1].patterns[0].predicate = 13;
+    EXPECT_NE(PlanCache::get_key(r), key);
+    r = make_query(1 << 17, 100);
+    r.pattern_group.patterns[0].object = -3;  // a variable instead of a constant
+    EXPECT_NE(PlanCache::get_key(r), key);
+    r = make_query(1 << 17, 100);
+    r.mt_factor = 4;
+    EXPECT_NE(PlanCache::get_key(r), key);
+}
+
+TEST(PlanCache, SameAsPlanner) {
+    // start from <course> (i.e., the 1st pattern in reverse) and the index of types
+    PlanCache::plan_t plan;
+    plan.orders = {1, 2};
+    plan.dirs = {"<", ">"};
+    plan.unions.resize(2);
+    plan.unions[0].orders = {1};
+    plan.unions[0].dirs = {"<<"};
+    plan.unions[1].orders = {1};
+    plan.unions[1].dirs = {">>"};
+
+    Planner planner;
+    SPARQLQuery raw = make_query(1 << 17, 100), r = raw;
+    planner.set_plan(r.pattern_group, plan);
+    expect_pattern(r.pattern_group.patterns[0], 1 << 17, 10, IN, -1);
+    expect_pattern(r.pattern_group.patterns[1], -1, TYPE_ID, OUT, 100);
+    expect_pattern(r.pattern_group.unions[0].patterns[0], 11, PREDICATE_ID, IN, -2);
+    expect_pattern(r.pattern_group.unions[1].patterns[0], 12, PREDICATE_ID, OUT, -1);
+
+    // the plan of the planned query is the same as above
+    PlanCache::plan_t cached;
+    ASSERT_TRUE(PlanCache::get_plan(raw.pattern_group, r.pattern_group, cached));
+    EXPECT_EQ(cached.orders, plan.orders);
+    EXPECT_EQ(cached.dirs, plan.dirs);
+    ASSERT_EQ(cached.unions.size(), 2);
+    EXPECT_EQ(cached.unions[0].dirs, plan.unions[0].dirs);
+    EXPECT_EQ(cached.unions[1].dirs, plan.unions[1].dirs);
+
+    // reordered
+    std::swap(r.pattern_group.patterns[0], r.pattern_group.patterns[1]);
+    ASSERT_TRUE(PlanCache::get_plan(raw.pattern_group, r.pattern_group, cached));
+    EXPECT_EQ(cached.orders, std::vector<int>({2, 1}));
+    EXPECT_EQ(cached.dirs, std::vector<std::string>({">", "<"}));
+
+    // the cached plan of another instance
+    SPARQLQuery r2 = make_query((1 << 17) + 1, 100);
+    planner.set_plan(r2.pattern_group, plan);
+    expect_pattern(r2.pattern_group.patterns[0], (1 << 17) + 1, 10, IN, -1);
+
+    // not a plan of the raw query (e.g., rewritten by the planner)
+    r.pattern_group.patterns[0].object = -5;
+    EXPECT_FALSE(PlanCache::get_plan(raw.pattern_group, r.pattern_group, cached));
+}
+
+TEST(PlanCache, DuplicatedPatterns) {
+    // ?X ub:takesCourse <course> . ?X ub:takesCourse <course>
+    SPARQLQuery::PatternGroup raw;
+    raw.patterns.push_back(SPARQLQuery::Pattern(-1, 10, OUT, 1 << 17));
+    raw.patterns.push_back(SPARQLQuery::Pattern(-1, 10, OUT, 1 << 17));
+
+    SPARQLQuery::PatternGroup planned = raw;
+    planned.patterns[0] = SPARQLQuery::Pattern(1 << 17, 10, IN, -1);
+    PlanCache::plan_t cached;
+    ASSERT_TRUE(PlanCache::get_plan(raw, planned, cached));
+    EXPECT_EQ(cached.orders, std::vector<int>({1, 2}));
+    EXPECT_EQ(cached.dirs, std::vector<std::string>({"<", ">"}));
+
+    // a raw pattern is dropped (e.g., deduplicated by the planner)
+    planned.patterns.pop_back();
+    EXPECT_FALSE(PlanCache::get_plan(raw, planned, cached));
+}
+
+// a prepared query keeps the plan of its first bindings (see RPCProxy::execute_prepared_task)
+TEST(PlanCache, PreparedTemplate) {
+    SPARQLQuery_Template tpl;
+    tpl.nvars = 1;
+    tpl.required_vars = {-1};
+    tpl.pattern_group = make_query(0, 100).pattern_group;
+    tpl.pattern_group.unions.clear();
+    tpl.ptypes_pos = {3};  // the object of the 1st pattern
+
+    SPARQLQuery raw = tpl.instantiate(std::vector<sid_t>({1 << 17})), r = raw;
+    PlanCache::plan_t plan;
+    plan.orders = {1, 2};
+    plan.dirs = {"<", ">"};
+    Planner planner;
+    planner.set_plan(r.pattern_group, plan);
+
+    PlanCache::plan_t cached;
+    ASSERT_TRUE(PlanCache::get_plan(raw.pattern_group, r.pattern_group, cached));
+    planner.set_plan(tpl.pattern_group, cached, tpl.ptypes_pos);
+    EXPECT_EQ(tpl.ptypes_pos, std::vector<int>({0}));  // the subject of the planned pattern
+
+    SPARQLQuery r2 = tpl.instantiate(std::vector<sid_t>({(1 << 17) + 1}));
+    expect_pattern(r2.pattern_group.patterns[0], (1 << 17) + 1, 10, IN, -1);
+    expect_pattern(r2.pattern_group.patterns[1], -1, TYPE_ID, OUT, 100);
+
+    // ?X ub:memberOf ?Y . <dept> ub:subOrganizationOf ?X (reordered)
+    tpl.pattern_group.patterns.clear();
+    tpl.pattern_group.patterns.push_back(SPARQLQuery::Pattern(-1, 11, OUT, -2));
+    tpl.pattern_group.patterns.push_back(SPARQLQuery::Pattern(0, 12, OUT, -1));
+    tpl.ptypes_pos = {4};  // the subject of the 2nd pattern
+
+    raw = tpl.instantiate(std::vector<sid_t>({1 << 17}));
+    r = raw;
+    plan.orders = {2, 1};
+    plan.dirs = {">", ">"};
+    planner.set_plan(r.pattern_group, plan);
+    ASSERT_TRUE(PlanCache::get_plan(raw.pattern_group, r.pattern_group, cached));
+    planner.set_plan(tpl.pattern_group, cached, tpl.ptypes_pos);
+    EXPECT_EQ(tpl.ptypes_pos, std::vector<int>({0}));  // not moved again by the 2nd pattern
+
+    r2 = tpl.instantiate(std::vector<sid_t>({(1 << 17) + 1}));
+    expect_pattern(r2.pattern_group.patterns[0], (1 << 17) + 1, 12, OUT, -1);
+    expect_pattern(r2.pattern_group.patterns[1], -1, 11, OUT, -2);
+}
+
+TEST(PlanCache, Lookup) {
+    PlanCache cache;
+    PlanCache::plan_t plan;
+    plan.orders = {1};
+    plan.dirs = {">"};
+
+    PlanCache::key_t k0 = PlanCache::get_key(make_query(1 << 17, 100));
+    PlanCache::key_t k1 = PlanCache::get_key(make_query(1 << 17, 101));
+    EXPECT_EQ(cache.lookup(k0), nullptr);
+    cache.insert(k0, plan, 1);
+    ASSERT_NE(cache.lookup(k0), nullptr);
+    EXPECT_EQ(cache.lookup(k0)->orders, plan.orders);
+
+    cache.insert(k1, plan, 1);  // full
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.lookup(k0), nullptr);
+    EXPECT_NE(cache.lookup(k1), nullptr);
+    EXPECT_EQ(cache.num_hits(), 3);
+    EXPECT_EQ(cache.num_misses(), 2);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+}
+
+}  // namespace test
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "core/sparql/regex_matcher.hpp"
+#include "stringserver/term_kind.hpp"
+#include "utils/timer.hpp"
+
+namespace test {
+using namespace wukong;
+
+// the same results as std::regex_match (w/ and w/o the "i" flag)
+TEST(RegexMatcher, SameAsStdRegex) {
+    std::vector<std::string> patterns = {
+        "Course1", "Course1.*", ".*Course1", ".*Course1.*", ".*", "", "^Course1$", "^.*ourse.*$",
+        "course1", "Course[0-9]+", "C.urse1", "(Course|Student)1.*", ".*\\..*", "a.*.*", ".*.*"};
+    std::vector<std::string> strs = {
+        "Course1", "Course10", "GraduateCourse1", "AnCourse12", "course1", "COURSE1x", "",
+        "Course", "Course1\nx", "x\nCourse1", "Student1", "a.b", "ab", "a\n"};
+
+    for (bool icase : {false, true}) {
+        for (auto &p : patterns) {
+            RegexMatcher matcher(p, icase);
+            std::regex re = icase ? std::regex(p, std::regex::icase) : std::regex(p);
+            for (auto &s : strs)
+                EXPECT_EQ(matcher.match(s), std::regex_match(s, re))
+                        << "pattern: " << p << ", string: " << s << ", icase: " << icase;
+        }
+    }
+
+    EXPECT_FALSE(RegexMatcher(".*Course1.*", false).is_regex());
+    EXPECT_TRUE(RegexMatcher("Course[0-9]+", false).is_regex());
+    EXPECT_THROW(RegexMatcher("Course[0-9", false), std::regex_error);
+}
+
+TEST(RegexMatcher, Cache) {
+    RegexCache cache(2);
+    auto m1 = cache.get("abc.*", false);
+    EXPECT_EQ(cache.get("abc.*", false), m1);
+    EXPECT_NE(cache.get("abc.*", true), m1);
+    EXPECT_EQ(cache.size(), 2);
+    cache.get("xyz", false);  // full
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_THROW(cache.get("(", false), std::regex_error);
+}
+
+TEST(TermKind, Classify) {
+    EXPECT_EQ(TermKind::classify("<http://www.University0.edu>"), TERM_IRI);
+    EXPECT_EQ(TermKind::classify("ub:Course"), TERM_IRI);
+    EXPECT_EQ(TermKind::classify("<http://a b{c}>"), TERM_NONE);
+    EXPECT_EQ(TermKind::classify("\"Course1\""), TERM_LITERAL);
+    EXPECT_EQ(TermKind::classify("\"12:30\""), TERM_LITERAL);  // not a prefixed name
+    EXPECT_EQ(TermKind::classify("\"chat\"@fr-BE"), TERM_LITERAL);
+    EXPECT_EQ(TermKind::classify("\"12\"^^<http://www.w3.org/2001/XMLSchema#integer>"), TERM_LITERAL);
+    EXPECT_EQ(TermKind::classify("'x'"), TERM_LITERAL);
+    EXPECT_EQ(TermKind::classify("\"x\"junk"), TERM_NONE);
+    EXPECT_EQ(TermKind::classify("_:b0"), TERM_BLANK);
+    EXPECT_EQ(TermKind::classify("Course1"), TERM_NONE);
+    EXPECT_EQ(TermKind::classify(""), TERM_NONE);
+}
+
+// REGEX filters on a column: compiled per call (as before) vs. cached and memoized
+TEST(RegexMatcher, Benchmark) {
+    const int nrows = 200000, ndistinct = 2000;
+    std::vector<std::string> strs;
+    for (int i = 0; i < ndistinct; i++)
+        strs.push_back("GraduateCourse" + std::to_string(i));
+    std::vector<int> col(nrows);
+    unsigned int seed = 0;
+    for (auto &c : col) c = rand_r(&seed) % ndistinct;
+
+    for (std::string pattern : {".*Course1.*", "Graduate(Course|Student)1[0-9]*"}) {
+        uint64_t start = timer::get_usec();
+        std::regex re(pattern);  // compiled once per filter call
+        uint64_t n0 = 0;
+        for (int row = 0; row < nrows; row++)
+            n0 += std::regex_match(strs[col[row]], re);
+        uint64_t usec0 = timer::get_usec() - start;
+
+        start = timer::get_usec();
+        RegexCache cache;
+        auto matcher = cache.get(pattern, false);
+        std::vector<int8_t> memo(ndistinct, -1);  // per distinct ID
+        uint64_t n1 = 0;
+        for (int row = 0; row < nrows; row++) {
+            int8_t &m = memo[col[row]];
+            if (m < 0) m = matcher->match(strs[col[row]]);
+            n1 += m;
+        }
+        uint64_t usec1 = timer::get_usec() - start;
+
+        EXPECT_EQ(n0, n1);
+        printf("regex %s on %d rows (%d distinct): std::regex %lu ms, matcher %lu ms\n",
+               pattern.c_str(), nrows, ndistinct, usec0 / 1000, usec1 / 1000);
+    }
+}
+
+}  // namespace test
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "core/engine/result_sorter.hpp"
+#include "utils/timer.hpp"
+
+namespace test {
+using namespace wukong;
+
+// the strings of IDs are in the reverse order of IDs
+class MockStrings : public StringMapping {
+public:
+    std::pair<bool, std::string> id2str(int tid, sid_t sid) override {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "<http://www.ex.org/%010u>", 1000000000u - sid);
+        return {true, buf};
+    }
+    std::pair<bool, sid_t> str2id(int tid, std::string str) override { return {false, 0}; }
+    bool add(std::string str, sid_t sid) override { return false; }
+};
+
+// ?x ?y ?z (w/ an attribute ?a), and ?x and ?y are requested
+static SPARQLQuery make_query(int nrows, int ndistinct) {
+    SPARQLQuery q;
+    SPARQLQuery::Result &r = q.result;
+    r.nvars = 4;
+    r.required_vars = {-1, -2, -4};
+    r.add_var2col(-1, 0);
+    r.add_var2col(-2, 1);
+    r.add_var2col(-3, 2);
+    r.add_var2col(-4, 0, INT_t);
+    r.set_col_num(3);
+    r.set_attr_col_num(1);
+
+    unsigned int seed = 0;
+    for (int i = 0; i < nrows; i++) {
+        r.result_table.push_back(1 << 17 | (rand_r(&seed) % ndistinct));
+        r.result_table.push_back(1 << 17 | (rand_r(&seed) % 3));
+        r.result_table.push_back(i);
+        r.attr_res_table.push_back(attr_t(i % 5));
+    }
+    r.update_nrows();
+    return q;
+}
+
+// the rows (?z) of the naive DISTINCT, ORDER BY, OFFSET and LIMIT
+static std::vector<sid_t> expected(SPARQLQuery &q, StringMapping *strs) {
+    SPARQLQuery::Result &r = q.result;
+    std::vector<int> rows;
+    std::set<std::pair<sid_t, sid_t>> seen;
+    for (int i = 0; i < r.get_row_num(); i++)
+        if (!q.distinct || seen.emplace(r.get_row_col(i, 0), r.get_row_col(i, 1)).second)
+            rows.push_back(i);
+
+    std::stable_sort(rows.begin(), rows.end(), [&](int a, int b) {
+        for (auto const &o : q.orders) {
+            int cmp;
+            if (o.id == -4) {
+                int va = boost::get<int>(r.get_attr_row_col(a, 0));
+                int vb = boost::get<int>(r.get_attr_row_col(b, 0));
+                cmp = (va < vb) ? -1 : (va > vb);
+            } else {
+                int col = r.var2col(o.id);
+                cmp = strs->id2str(0, r.get_row_col(a, col)).second.compare(
+                          strs->id2str(0, r.get_row_col(b, col)).second);
+            }
+            if (cmp != 0) return o.descending ? cmp > 0 : cmp < 0;
+        }
+        return false;
+    });
+
+    std::vector<sid_t> zs;
+    for (int i = q.offset; i < rows.size() && (q.limit < 0 || i < q.offset + q.limit); i++)
+        zs.push_back(r.get_row_col(rows[i], 2));
+    return zs;
+}
+
+static void expect_sorted(SPARQLQuery q, StringMapping *strs) {
+    std::vector<sid_t> zs = expected(q, strs);
+    std::vector<sid_t> table = q.result.result_table;
+    ResultSorter::process(q, strs, 0);
+
+    ASSERT_EQ(q.result.get_row_num(), zs.size());
+    ASSERT_EQ(q.result.get_attr_row_num(), zs.size());
+    for (int i = 0; i < zs.size(); i++) {
+        sid_t z = q.result.get_row_col(i, 2);
+        if (!q.distinct) EXPECT_EQ(z, zs[i]);  // the first row of duplicates may differ
+        EXPECT_EQ(q.result.get_row_col(i, 0), table[z * 3]);
+        EXPECT_EQ(boost::get<int>(q.result.get_attr_row_col(i, 0)), z % 5);
+    }
+}
+
+TEST(ResultSorter, SameAsNaive) {
+    MockStrings strs;
+    for (bool distinct : {false, true}) {
+        for (int limit : {-1, 0, 1, 7, 100000}) {
+            for (unsigned offset : {0, 3}) {
+                SPARQLQuery q = make_query(1000, 50);
+                q.distinct = distinct;
+                q.limit = limit;
+                q.offset = offset;
+                expect_sorted(q, &strs);  // w/o ORDER BY
+
+                q.orders = {SPARQLQuery::Order(-1, true)};
+                expect_sorted(q, &strs);
+
+                q.orders = {SPARQLQuery::Order(-2, false), SPARQLQuery::Order(-1, false)};
+                expect_sorted(q, &strs);
+
+                if (!distinct) {
+                    q.orders = {SPARQLQuery::Order(-4, true), SPARQLQuery::Order(-1, false)};
+                    expect_sorted(q, &strs);
+                }
+            }
+        }
+    }
+}
+
+// ORDER BY ?x LIMIT 10: the full sort (as before) vs. top-K
+TEST(ResultSorter, Benchmark) {
+    MockStrings strs;
+    const int nrows = 1 << 20, ndistinct = 10000;
+    SPARQLQuery q = make_query(nrows, ndistinct);
+    q.orders = {SPARQLQuery::Order(-1, false)};
+    q.limit = 10;
+
+    // copy rows by per-row allocations, and sort them by strings
+    uint64_t start = timer::get_usec();
+    SPARQLQuery::Result &r = q.result;
+    int col_num = r.get_col_num();
+    int **table = new int*[nrows];
+    for (int i = 0; i < nrows; i++) {
+        table[i] = new int[col_num];
+        for (int j = 0; j < col_num; j++)
+            table[i][j] = r.get_row_col(i, j);
+    }
+    boost::unordered_map<sid_t, std::string> strings;
+    for (int i = 0; i < nrows; i++)
+        if (strings.find(table[i][0]) == strings.end())
+            strings[table[i][0]] = strs.id2str(0, table[i][0]).second;
+    std::sort(table, table + nrows, [&strings](const int *a, const int *b) {
+        return strings.at(a[0]).compare(strings.at(b[0])) < 0;
+    });
+    std::vector<sid_t> top;
+    for (int i = 0; i < q.limit; i++)
+        top.push_back(table[i][0]);
+    for (int i = 0; i < nrows; i++)
+        delete[] table[i];
+    delete[] table;
+    uint64_t usec0 = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    ResultSorter::process(q, &strs, 0);
+    uint64_t usec1 = timer::get_usec() - start;
+
+    ASSERT_EQ(q.result.get_row_num(), q.limit);
+    for (int i = 0; i < q.limit; i++)
+        EXPECT_EQ(q.result.get_row_col(i, 0), top[i]);
+    printf("ORDER BY LIMIT %d on %d rows (%d distinct): full sort %lu ms, top-K %lu ms\n",
+           q.limit, nrows, ndistinct, usec0 / 1000, usec1 / 1000);
+}
+
+}  // namespace test
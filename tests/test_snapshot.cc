@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <tbb/concurrent_unordered_map.h>
+
+#include "core/network/tcp_adaptor.hpp"
+#include "core/store/segment_rdf_dgraph.hpp"
+
+#define KV_SZ (1UL << 26)
+#define RBUF_SZ (1 << 15)
+#define SID 0
+#define TID 0
+#define NVERTICES 1000
+#define VID_MIN (1 << 17)
+#define PID_MIN 11
+#define NPREDS 10
+#define NTYPES 9
+
+namespace wukong {
+// used to synchronize segment metadata (no peer for a single server)
+TCP_Adaptor *con_adaptor = nullptr;
+}  // namespace wukong
+
+namespace test {
+using namespace wukong;
+
+// TestGraph for setting predicates w/o loading str_index
+class TestGraph : public SegmentRDFGraph {
+public:
+    TestGraph(int sid, KVMem kv_mem) : SegmentRDFGraph(sid, kv_mem) {}
+
+    // #NVERTICES vertices w/ 3 edges and a type
+    // (w/ timed: the edges of PID_MIN are valid in [s, s + i], see expect_times)
+    void init(bool timed = false) {
+        std::vector<std::vector<triple_t>> triple_pso(Global::num_engines);
+        std::vector<std::vector<triple_t>> triple_pos(Global::num_engines);
+        for (sid_t s = VID_MIN; s < VID_MIN + NVERTICES; s++) {
+            for (sid_t i = 1; i < 4; i++) {
+                triple_t t(s, PID_MIN + s % NPREDS, VID_MIN + (s * i) % NVERTICES);
+#ifdef TRDF_MODE
+                if (timed && t.p == PID_MIN) {
+                    t.ts = s;
+                    t.te = s + i;
+                }
+#endif
+                triple_pso[0].push_back(t);
+            }
+            triple_pso[0].push_back(triple_t(s, TYPE_ID, 2 + s % NTYPES));
+        }
+#ifdef VERSATILE
+        std::sort(triple_pso[0].begin(), triple_pso[0].end(), triple_sort_by_spo());
+        triple_pos[0] = triple_pso[0];
+        std::sort(triple_pos[0].begin(), triple_pos[0].end(), triple_sort_by_ops());
+#else
+        std::sort(triple_pso[0].begin(), triple_pso[0].end(), triple_sort_by_pso());
+        triple_pos[0] = triple_pso[0];
+        std::sort(triple_pos[0].begin(), triple_pos[0].end(), triple_sort_by_pos());
+#endif
+
+        for (sid_t p = 0; p < PID_MIN + NPREDS; p++)
+            this->predicates.push_back(p);  // PREDICATE_ID, TYPE_ID, types, and predicates
+        std::vector<std::vector<triple_attr_t>> triple_sav(triple_pso.size());
+        init_gstore(triple_pso, triple_pos, triple_sav);
+    }
+};
+
+static KVMem new_mem(uint64_t kvs_sz) {
+    KVMem kv_mem = {new char[kvs_sz], kvs_sz, new char[RBUF_SZ], RBUF_SZ};
+    return kv_mem;
+}
+
+static void free_mem(KVMem &kv_mem) {
+    delete[] kv_mem.kvs;
+    delete[] kv_mem.rrbuf;
+}
+
+static void expect_same_graph(DGraph *g0, DGraph *g1) {
+    uint64_t sz0, sz1, nerrors = 0;
+    for (sid_t s = VID_MIN; s < VID_MIN + NVERTICES; s++) {
+        for (sid_t p = TYPE_ID; p < PID_MIN + NPREDS; p++) {
+            for (int d = IN; d <= OUT; d++) {
+                edge_t *e0 = g0->get_triples(TID, s, p, (dir_t)d, sz0);
+                edge_t *e1 = g1->get_triples(TID, s, p, (dir_t)d, sz1);
+                if (sz0 != sz1 || (sz0 > 0 && !std::equal(e0, e0 + sz0, e1)))
+                    nerrors++;
+            }
+        }
+    }
+    for (sid_t p = TYPE_ID; p < PID_MIN + NPREDS; p++) {
+        for (int d = IN; d <= OUT; d++) {
+            g0->get_index(TID, p, (dir_t)d, sz0);
+            g1->get_index(TID, p, (dir_t)d, sz1);
+            if (sz0 != sz1)
+                nerrors++;
+        }
+    }
+    EXPECT_EQ(nerrors, 0);
+    EXPECT_EQ(g0->get_edge_predicates(), g1->get_edge_predicates());
+    EXPECT_EQ(g0->get_type_predicates(), g1->get_type_predicates());
+}
+
+TEST(Snapshot, Checksum) {
+    std::vector<char> buf(3 * SNAPSHOT_CHUNK / 2 + 13);
+    for (uint64_t i = 0; i < buf.size(); i++)
+        buf[i] = i * 7 + (i >> 11);
+
+    uint64_t c0 = snapshot_checksum(buf.data(), buf.size());
+    EXPECT_EQ(c0, snapshot_checksum(buf.data(), buf.size()));
+    EXPECT_NE(c0, snapshot_checksum(buf.data(), buf.size() - 1));
+    for (uint64_t pos : {0UL, 31UL, SNAPSHOT_CHUNK + 5, buf.size() - 1}) {
+        buf[pos] ^= 1;
+        EXPECT_NE(c0, snapshot_checksum(buf.data(), buf.size()));
+        buf[pos] ^= 1;
+    }
+}
+
+TEST(Snapshot, DumpAndRestore) {
+    KVMem mem0 = new_mem(KV_SZ);
+    TestGraph *g0 = new TestGraph(SID, mem0);
+    g0->init();
+
+    std::string dname = "/tmp/wukong_test_snapshot/";
+    ASSERT_EQ(system(("mkdir -p " + dname).c_str()), 0);
+    ASSERT_TRUE(g0->dump_snapshot(dname));
+
+    // restore into another KV region
+    KVMem mem1 = new_mem(KV_SZ);
+    TestGraph *g1 = new TestGraph(SID, mem1);
+    ASSERT_TRUE(g1->read_snapshot(dname));
+    g1->commit_snapshot();
+    expect_same_graph(g0, g1);
+    uint64_t sz = 0;
+    g1->get_triples(TID, VID_MIN, PID_MIN + VID_MIN % NPREDS, OUT, sz);
+    EXPECT_EQ(sz, 3);
+
+    // the snapshot of another server is invalid, so all servers load triples
+    ASSERT_TRUE(g1->read_snapshot(dname));
+    g1->abort_snapshot();
+    EXPECT_TRUE(g1->get_edge_predicates().empty());
+    g1->init();
+    expect_same_graph(g0, g1);
+
+    // mismatched memstore size
+    KVMem mem2 = new_mem(KV_SZ / 2);
+    SegmentRDFGraph *g2 = new SegmentRDFGraph(SID, mem2);
+    EXPECT_FALSE(g2->read_snapshot(dname));
+
+    // corrupted values
+    std::string fname = snapshot_fname(dname, SID);
+    {
+        std::fstream fs(fname, std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekp(-1, std::ios::end);
+        char c = ~fs.peek();
+        fs.write(&c, 1);
+    }
+    SegmentRDFGraph *g3 = new SegmentRDFGraph(SID, mem1);
+    EXPECT_FALSE(g3->read_snapshot(dname));
+
+    // missing
+    unlink(fname.c_str());
+    EXPECT_FALSE(g3->read_snapshot(dname));
+
+    delete g0;
+    delete g1;
+    delete g2;
+    delete g3;
+    free_mem(mem0);
+    free_mem(mem1);
+    free_mem(mem2);
+}
+
+#ifdef TRDF_MODE
+// the timestamps of the edges of s, which are all in [s, s + 3] if timed
+static void expect_times(DGraph *g, sid_t s, bool timed) {
+    uint64_t sz = 0;
+    edge_time_t *times = nullptr;
+    g->get_timed_triples(TID, s, PID_MIN + s % NPREDS, OUT, sz, times);
+    EXPECT_EQ(sz, 3);
+    if (!timed) {
+        EXPECT_TRUE(times == nullptr);  // nothing reserved
+        return;
+    }
+    ASSERT_TRUE(times != nullptr);
+    for (uint64_t k = 0; k < sz; k++) {
+        EXPECT_EQ(times[k].ts, s);
+        EXPECT_GT(times[k].te, s);
+        EXPECT_LE(times[k].te, s + 3);
+    }
+}
+
+TEST(Snapshot, TemporalSegments) {
+    KVMem mem0 = new_mem(KV_SZ);
+    TestGraph *g0 = new TestGraph(SID, mem0);
+    g0->init(true);
+
+    // only the segments of the temporal predicate reserve timestamps
+    const std::map<segid_t, rdf_seg_meta_t> &metas = g0->get_rdf_seg_metas();
+    EXPECT_TRUE(metas.at(segid_t(0, PID_MIN, OUT)).temporal);
+    EXPECT_TRUE(metas.at(segid_t(0, PID_MIN, IN)).temporal);
+    EXPECT_FALSE(metas.at(segid_t(0, PID_MIN + 1, OUT)).temporal);
+    EXPECT_FALSE(metas.at(segid_t(0, TYPE_ID, OUT)).temporal);
+    EXPECT_FALSE(metas.at(segid_t(1, PREDICATE_ID, OUT)).temporal);
+    EXPECT_FALSE(metas.at(segid_t(1, PREDICATE_ID, IN)).temporal);
+    const rdf_seg_meta_t &seg = metas.at(segid_t(0, PID_MIN, OUT));
+    EXPECT_GE(seg.time_start, seg.edge_start + seg.num_edges);
+
+    for (sid_t s = VID_MIN; s < VID_MIN + NPREDS; s++)
+        expect_times(g0, s, s % NPREDS == 0);
+
+    // the timestamps are restored w/ the values
+    std::string dname = "/tmp/wukong_test_snapshot/";
+    ASSERT_EQ(system(("mkdir -p " + dname).c_str()), 0);
+    ASSERT_TRUE(g0->dump_snapshot(dname));
+    KVMem mem1 = new_mem(KV_SZ);
+    TestGraph *g1 = new TestGraph(SID, mem1);
+    ASSERT_TRUE(g1->read_snapshot(dname));
+    g1->commit_snapshot();
+    expect_same_graph(g0, g1);
+    for (sid_t s = VID_MIN; s < VID_MIN + NPREDS; s++)
+        expect_times(g1, s, s % NPREDS == 0);
+    unlink(snapshot_fname(dname, SID).c_str());
+
+    delete g0;
+    delete g1;
+    free_mem(mem0);
+    free_mem(mem1);
+}
+#endif
+
+}  // namespace test
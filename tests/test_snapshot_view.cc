@@ -0,0 +1,194 @@
+// NOTE: build w/ -DTRDF_MODE
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "core/store/snapshot_view.hpp"
+#include "core/store/static_kvstore.hpp"
+#include "utils/timer.hpp"
+
+namespace test {
+using namespace wukong;
+
+// a static store w/ the values of keys written by the loader (see insert_normal)
+class TimedStore : public StaticKVStore<ikey_t, iptr_t, edge_t> {
+public:
+    TimedStore(KVMem kv_mem) : StaticKVStore<ikey_t, iptr_t, edge_t>(0, kv_mem) {
+        this->reserve_times();  // like RDFGraph
+    }
+
+    void insert(ikey_t key, const std::vector<time_edge_t> &edges) {
+        uint64_t off = this->alloc_entries(edges.size());
+        this->insert_key(key, iptr_t(edges.size(), off));
+        for (auto const &e : edges) {
+            this->times[off] = e.time();
+            this->values[off++] = e.edge();
+        }
+    }
+};
+
+// the history of a key: #n edges (sorted by val), each valid for a while
+static std::vector<time_edge_t> make_edges(int n, int64_t horizon, int64_t max_len, unsigned int seed) {
+    std::vector<time_edge_t> edges;
+    for (int i = 0; i < n; i++) {
+        int64_t ts = rand_r(&seed) % horizon;
+        int64_t te = ts + rand_r(&seed) % max_len;
+        if (i % 97 == 0) te = horizon;  // long-lived
+        edges.push_back(time_edge_t(rand_r(&seed) % 100000, ts, te));
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+// the keys of #nvids vertices w/ #npids predicates (and the predicate index)
+static std::vector<ikey_t> fill(TimedStore &store, int nvids, int npids, int n, int64_t horizon) {
+    std::vector<ikey_t> keys;
+    for (int p = 0; p < npids; p++) {
+        for (int v = 0; v < nvids; v++) {
+            keys.push_back(ikey_t(v + (1 << 17), p + 2, v % 2 ? IN : OUT));
+            store.insert(keys.back(), make_edges(n, horizon, horizon / 10, v * npids + p));
+        }
+        keys.push_back(ikey_t(0, p + 2, IN));
+        store.insert(keys.back(), make_edges(nvids, horizon, horizon / 10, p));
+    }
+    return keys;
+}
+
+TEST(SnapshotView, SameAsFilter) {
+    const uint64_t kvs_sz = 1UL << 26;
+    char *kvs = new char[kvs_sz];
+    KVMem kv_mem = {kvs, kvs_sz, nullptr, 0};
+    TimedStore store(kv_mem);
+    const int64_t horizon = 100000;
+    std::vector<ikey_t> keys = fill(store, 100, 4, 200, horizon);
+
+    TimeIndex index;
+    index.build(store, 64);
+    for (int64_t t : {(int64_t)0, horizon / 2, horizon, horizon * 2}) {
+        SnapshotView view(t, t);
+        view.build(store, index);
+
+        uint64_t nedges = 0;
+        std::vector<uint64_t> pos;
+        for (auto const &key : keys) {
+            uint64_t sz = 0, vsz = 0;
+            edge_time_t *times = nullptr;
+            edge_t *vals = store.get_timed_values(0, 0, key, sz, times);
+            TimeIndex::scan_list(times, sz, t, t, pos);
+            edge_t *vvals = view.get_values(key, vsz);
+            ASSERT_EQ(vsz, pos.size());
+            EXPECT_EQ(vvals == nullptr, pos.size() == 0);  // the keys w/o valid edges are dropped
+            for (uint64_t k = 0; k < pos.size(); k++)
+                EXPECT_EQ(vvals[k].val, vals[pos[k]].val);
+            nedges += vsz;
+        }
+        EXPECT_EQ(view.num_edges(), nedges);
+
+        // the edges of a segment are contiguous
+        uint64_t next = 0;
+        for (auto const &e : view.get_seg_metas()) {
+            EXPECT_EQ(e.second.edge_start, next);
+            next += e.second.num_edges;
+        }
+        EXPECT_EQ(next, nedges);
+    }
+    delete[] kvs;
+}
+
+TEST(SnapshotView, LRU) {
+    const uint64_t kvs_sz = 1UL << 24;
+    char *kvs = new char[kvs_sz];
+    KVMem kv_mem = {kvs, kvs_sz, nullptr, 0};
+    TimedStore store(kv_mem);
+    fill(store, 10, 1, 10, 100);
+
+    // the views of the same size (i.e., all edges)
+    TimeIndex index;
+    std::vector<std::shared_ptr<SnapshotView>> vs;
+    for (int i = 0; i < 3; i++) {
+        vs.push_back(std::make_shared<SnapshotView>(0, 100 + i));
+        vs.back()->build(store, index);
+    }
+    ASSERT_GT(vs[0]->mem_usage(), 0);
+    ASSERT_EQ(vs[0]->mem_usage(), vs[2]->mem_usage());
+    uint64_t budget = vs[0]->mem_usage() * 2;
+
+    SnapshotViews views;
+    EXPECT_FALSE(views.add(vs[0], vs[0]->mem_usage() - 1));  // beyond the budget
+    EXPECT_EQ(views.get(0, 100), nullptr);
+
+    EXPECT_TRUE(views.add(vs[0], budget));
+    EXPECT_TRUE(views.add(vs[1], budget));
+    EXPECT_EQ(views.get(0, 100), vs[0]);  // vs[1] is the least recently used
+    EXPECT_TRUE(views.add(vs[2], budget));
+    EXPECT_EQ(views.get(0, 101), nullptr);
+    EXPECT_EQ(views.get(0, 100), vs[0]);
+    EXPECT_EQ(views.get(0, 102), vs[2]);
+    EXPECT_EQ(views.mem_usage(), budget);
+
+    EXPECT_TRUE(views.add(vs[2], budget));  // replaced
+    EXPECT_EQ(views.list().size(), 2);
+    EXPECT_TRUE(views.drop(0, 100));
+    EXPECT_FALSE(views.drop(0, 100));
+    EXPECT_EQ(views.list().size(), 1);
+    views.clear();
+    EXPECT_EQ(views.mem_usage(), 0);
+    delete[] kvs;
+}
+
+// repeated FROM SNAPSHOT reads: filtering the histories (as before) vs. the view
+TEST(SnapshotView, Benchmark) {
+    const uint64_t kvs_sz = 1UL << 30;
+    char *kvs = new char[kvs_sz];
+    KVMem kv_mem = {kvs, kvs_sz, nullptr, 0};
+    TimedStore store(kv_mem);
+    const int64_t horizon = 1 << 30;
+    const int nqueries = 20;
+    std::vector<ikey_t> keys = fill(store, 10000, 4, 100, horizon);
+
+    TimeIndex index;
+    index.build(store, 64);
+    uint64_t start = timer::get_usec();
+    SnapshotView view(horizon / 2, horizon / 2);
+    view.build(store, index);
+    uint64_t build_usec = timer::get_usec() - start;
+
+    std::vector<uint64_t> pos;
+    uint64_t sum0 = 0, sum1 = 0;
+    start = timer::get_usec();
+    for (int i = 0; i < nqueries; i++) {
+        for (auto const &key : keys) {
+            uint64_t sz = 0;
+            edge_time_t *times = nullptr;
+            edge_t *vals = store.get_timed_values(0, 0, key, sz, times);
+            index.valid_edges(key, times, sz, horizon / 2, horizon / 2, pos);
+            for (uint64_t k : pos)
+                sum0 += vals[k].val;
+        }
+    }
+    uint64_t usec0 = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    for (int i = 0; i < nqueries; i++) {
+        for (auto const &key : keys) {
+            uint64_t sz = 0;
+            edge_t *vals = view.get_values(key, sz);
+            for (uint64_t k = 0; k < sz; k++)
+                sum1 += vals[k].val;
+        }
+    }
+    uint64_t usec1 = timer::get_usec() - start;
+
+    EXPECT_EQ(sum0, sum1);
+    printf("%d snapshot reads of %lu keys: filter %lu ms, view %lu ms "
+           "(%lu of %lu edges, built in %lu ms)\n", nqueries, keys.size(), usec0 / 1000,
+           usec1 / 1000, view.num_edges(), keys.size() * 100, build_usec / 1000);
+    delete[] kvs;
+}
+
+}  // namespace test
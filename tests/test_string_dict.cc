@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "stringserver/string_dict.hpp"
+#include "stringserver/string_server.hpp"
+#include "utils/timer.hpp"
+
+#define NORMAL_BASE (1 << NBITS_IDX)
+
+namespace test {
+using namespace wukong;
+
+static std::string vertex_str(uint64_t i) {
+    // LUBM-like IRIs w/ long common prefixes
+    return "<http://www.Department" + std::to_string(i % 15) + ".University" + std::to_string(i / 1000)
+           + ".edu/GraduateStudent" + std::to_string(i) + ">";
+}
+
+static void write_dataset(const std::string &dname, uint64_t nvertices) {
+    ASSERT_EQ(system(("mkdir -p " + dname + " && rm -f " + dname + "str_dict").c_str()), 0);
+    std::ofstream str_index(dname + "str_index");
+    str_index << "__PREDICATE__ 0\n<rdf:type> 1\n<ub:advisor> 2\n<ub:name> 3\n";
+    std::ofstream str_attr_index(dname + "str_attr_index");
+    str_attr_index << "<ub:age> 4 1\n";
+    std::ofstream str_normal(dname + "str_normal");
+    for (uint64_t i = 0; i < nvertices; i++)
+        str_normal << vertex_str(i) << "\t" << NORMAL_BASE + i << "\n";
+}
+
+static uint64_t get_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.compare(0, 6, "VmRSS:") == 0)
+            return std::stoull(line.substr(6));
+    return 0;
+}
+
+TEST(StringDict, Lookup) {
+    std::string dname = "/tmp/wukong_test_dict/";
+    uint64_t nvertices = 1000;
+    write_dataset(dname, nvertices);
+    ASSERT_TRUE(StringDict::build(dname, dname + "str_dict"));
+
+    StringDict dict;
+    ASSERT_TRUE(dict.open(dname + "str_dict"));
+    EXPECT_EQ(dict.size(), nvertices + 5);
+    EXPECT_EQ(dict.get_next_index_id(), 4);
+    EXPECT_EQ(dict.get_next_normal_id(), NORMAL_BASE + nvertices);
+
+    for (uint64_t i = 0; i < nvertices; i++) {
+        EXPECT_EQ(dict.id2str(NORMAL_BASE + i), std::make_pair(true, vertex_str(i)));
+        EXPECT_EQ(dict.str2id(vertex_str(i)), std::make_pair(true, (sid_t)(NORMAL_BASE + i)));
+    }
+    EXPECT_EQ(dict.str2id("<rdf:type>"), std::make_pair(true, (sid_t)1));
+    EXPECT_EQ(dict.id2str(4), std::make_pair(true, std::string("<ub:age>")));
+
+    // missing IDs and strings (before, between and after the sorted strings)
+    EXPECT_FALSE(dict.id2str(5).first);
+    EXPECT_FALSE(dict.id2str(NORMAL_BASE + nvertices).first);
+    EXPECT_FALSE(dict.id2str(NORMAL_BASE - 1).first);
+    std::vector<std::string> missing = {"", "<", "<a", "<http://www.Department0", vertex_str(nvertices), "~~"};
+    for (auto &str : missing)
+        EXPECT_FALSE(dict.str2id(str).first) << str;
+
+    uint8_t kind = TERM_NONE;
+    EXPECT_TRUE(dict.term_kind(NORMAL_BASE + 1, kind));
+    EXPECT_EQ(kind, TERM_IRI);
+    EXPECT_FALSE(dict.term_kind(NORMAL_BASE + nvertices, kind));
+
+    std::map<sid_t, char> types;
+    dict.foreach_index_type([&](sid_t id, char type) { types[id] = type; });
+    EXPECT_EQ(types.size(), 5);
+    EXPECT_EQ(types[2], static_cast<char>(SID_t));
+    EXPECT_EQ(types[4], '1');
+
+    // StringServer maps the dictionary instead of the text files
+    StringServer server(dname);
+    EXPECT_EQ(server.id2str(0, NORMAL_BASE + 7), std::make_pair(true, vertex_str(7)));
+    EXPECT_EQ(server.str2id(0, "<ub:name>"), std::make_pair(true, (sid_t)3));
+    EXPECT_EQ(server.pid2type[4], '1');
+    EXPECT_EQ(server.next_normal_id, NORMAL_BASE + nvertices);
+    EXPECT_EQ(server.term_kind_batch(0, {1, NORMAL_BASE + 1, NORMAL_BASE + nvertices}),
+              std::vector<uint8_t>({TERM_IRI, TERM_IRI, TERM_NONE}));
+    // strings added at runtime (e.g., dynamic loading)
+    server.add("<new>", NORMAL_BASE + nvertices);
+    EXPECT_EQ(server.str2id(0, "<new>"), std::make_pair(true, (sid_t)(NORMAL_BASE + nvertices)));
+
+    // duplicate strings
+    std::vector<StringDict::entry_t> entries = {{"<a>", 1, 0}, {"<a>", 2, 0}};
+    EXPECT_FALSE(StringDict::build(entries, 3, 0, dname + "str_dup"));
+
+    // a corrupted (truncated) file
+    ASSERT_EQ(system(("head -c 1000 " + dname + "str_dict > " + dname + "str_bad").c_str()), 0);
+    EXPECT_FALSE(dict.open(dname + "str_bad"));
+    EXPECT_FALSE(dict.is_open());
+
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+// startup time and RSS: text files vs. the dictionary
+TEST(StringDict, Benchmark) {
+    std::string dname = "/tmp/wukong_bench_dict/";
+    uint64_t nvertices = 2000000, nlookups = 1000000;
+    write_dataset(dname, nvertices);
+
+    uint64_t start = timer::get_usec();
+    ASSERT_TRUE(StringDict::build(dname, "/tmp/wukong_bench_str_dict"));
+    printf("build the dictionary of %lu strings (offline): %lu ms\n",
+           nvertices, (timer::get_usec() - start) / 1000);
+
+    auto lookup = [&](StringServer &server) {
+        unsigned int seed = 0;
+        uint64_t found = 0;
+        for (uint64_t i = 0; i < nlookups; i++) {
+            sid_t id = NORMAL_BASE + rand_r(&seed) % nvertices;
+            found += server.str2id(0, server.id2str(0, id).second).first;
+        }
+        EXPECT_EQ(found, nlookups);
+    };
+
+    // the dictionary first (freed heap is not returned to the OS)
+    for (bool use_dict : {true, false}) {
+        if (use_dict)
+            ASSERT_EQ(system(("mv /tmp/wukong_bench_str_dict " + dname + "str_dict").c_str()), 0);
+        else
+            ASSERT_EQ(system(("rm -f " + dname + "str_dict").c_str()), 0);
+
+        uint64_t base = get_rss_kb();
+        start = timer::get_usec();
+        std::unique_ptr<StringServer> server(new StringServer(dname));
+        uint64_t usec = timer::get_usec() - start;
+        uint64_t rss = get_rss_kb() - base;
+
+        start = timer::get_usec();
+        lookup(*server);
+        uint64_t lookup_usec = timer::get_usec() - start;
+        printf("%s: startup %lu ms, RSS +%lu MB; %lu id2str+str2id: %lu ms, RSS +%lu MB\n",
+               use_dict ? "dictionary" : "text files", usec / 1000, rss / 1024,
+               nlookups, lookup_usec / 1000, (get_rss_kb() - base) / 1024);
+    }
+
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+}  // namespace test
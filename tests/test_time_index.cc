@@ -0,0 +1,182 @@
+// NOTE: build w/ -DTRDF_MODE
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "core/store/static_kvstore.hpp"
+#include "core/store/time_index.hpp"
+#include "utils/timer.hpp"
+
+namespace test {
+using namespace wukong;
+
+// the history of a key: #n edges (sorted by val), each valid for a while
+static std::vector<time_edge_t> make_edges(int n, int64_t horizon, int64_t max_len, unsigned int seed) {
+    std::vector<time_edge_t> edges;
+    for (int i = 0; i < n; i++) {
+        int64_t ts = rand_r(&seed) % horizon;
+        int64_t te = ts + rand_r(&seed) % max_len;
+        if (i % 97 == 0) te = horizon;           // long-lived
+        if (i % 101 == 0) std::swap(ts, te);     // malformed (ts > te)
+        edges.push_back(time_edge_t(rand_r(&seed) % 1000, ts, te));
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+// the timestamps of the history (see edge_time_t)
+static std::vector<edge_time_t> make_history(int n, int64_t horizon, int64_t max_len, unsigned int seed) {
+    std::vector<edge_time_t> times;
+    for (auto const &e : make_edges(n, horizon, max_len, seed))
+        times.push_back(e.time());
+    return times;
+}
+
+TEST(TimeIndex, SameAsScan) {
+    const int64_t horizon = 100000;
+    for (int n : {1, 31, 32, 33, 1000, 5000}) {
+        std::vector<edge_time_t> edges = make_history(n, horizon, 500, n);
+        TimeIndex::interval_list_t list;
+        TimeIndex::build_list(edges.data(), edges.size(), list);
+
+        unsigned int seed = 7;
+        std::vector<std::pair<int64_t, int64_t>> intervals = {
+            {TIMESTAMP_MIN, TIMESTAMP_MAX}, {0, 0}, {horizon, horizon}, {10, 5},
+            {TIMESTAMP_MIN, 100}, {50000, TIMESTAMP_MAX}};
+        for (int i = 0; i < 200; i++) {
+            int64_t ts = rand_r(&seed) % horizon;
+            intervals.push_back({ts, ts + (i % 2 ? 0 : rand_r(&seed) % 1000)});
+        }
+
+        std::vector<uint64_t> expected, probed;
+        for (auto &in : intervals) {
+            TimeIndex::scan_list(edges.data(), edges.size(), in.first, in.second, expected);
+            TimeIndex::probe_list(list, in.first, in.second, probed);
+            EXPECT_EQ(expected, probed) << "n: " << n << ", [" << in.first << ", " << in.second << "]";
+        }
+    }
+
+    // not indexed (e.g., remote lists)
+    TimeIndex index;
+    std::vector<edge_time_t> edges = make_history(100, horizon, 500, 1);
+    std::vector<uint64_t> expected, pos;
+    TimeIndex::scan_list(edges.data(), edges.size(), 10, 20000, expected);
+    index.valid_edges(ikey_t(1, 2, OUT), edges.data(), edges.size(), 10, 20000, pos);
+    EXPECT_EQ(expected, pos);
+}
+
+// snapshot queries on a long history: scan (as before) vs. probe
+TEST(TimeIndex, Benchmark) {
+    const int n = 1 << 20, nqueries = 1000;
+    const int64_t horizon = 1 << 30;
+    std::vector<edge_time_t> edges = make_history(n, horizon, 10000, 0);
+    TimeIndex::interval_list_t list;
+    uint64_t start = timer::get_usec();
+    TimeIndex::build_list(edges.data(), edges.size(), list);
+    uint64_t build_usec = timer::get_usec() - start;
+
+    std::vector<int64_t> snapshots;
+    unsigned int seed = 1;
+    for (int i = 0; i < nqueries; i++)
+        snapshots.push_back(rand_r(&seed) % horizon);
+
+    std::vector<uint64_t> pos;
+    uint64_t nvalid0 = 0, nvalid1 = 0;
+    start = timer::get_usec();
+    for (int64_t t : snapshots) {
+        TimeIndex::scan_list(edges.data(), edges.size(), t, t, pos);
+        nvalid0 += pos.size();
+    }
+    uint64_t usec0 = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    for (int64_t t : snapshots) {
+        TimeIndex::probe_list(list, t, t, pos);
+        nvalid1 += pos.size();
+    }
+    uint64_t usec1 = timer::get_usec() - start;
+
+    EXPECT_EQ(nvalid0, nvalid1);
+    printf("%d snapshot probes on %d edges (%lu valid on avg.): scan %lu ms, index %lu ms "
+           "(built in %lu ms)\n", nqueries, n, nvalid0 / nqueries, usec0 / 1000, usec1 / 1000,
+           build_usec / 1000);
+}
+
+// a static store w/ the values of a key written by the loader (see insert_normal)
+class TimedStore : public StaticKVStore<ikey_t, iptr_t, edge_t> {
+public:
+    TimedStore(KVMem kv_mem) : StaticKVStore<ikey_t, iptr_t, edge_t>(0, kv_mem) {
+        this->reserve_times();  // like RDFGraph
+    }
+
+    void insert(ikey_t key, const std::vector<time_edge_t> &edges) {
+        uint64_t off = this->alloc_entries(edges.size());
+        this->insert_key(key, iptr_t(edges.size(), off));
+        for (auto const &e : edges) {
+            this->times[off] = e.time();
+            this->values[off++] = e.edge();
+        }
+    }
+};
+
+TEST(TimeIndex, TimedValues) {
+    EXPECT_EQ(sizeof(edge_t), 4);  // the timestamps are not inflating edges
+
+    const uint64_t kvs_sz = 1UL << 26;
+    char *kvs = new char[kvs_sz];
+    KVMem kv_mem = {kvs, kvs_sz, nullptr, 0};
+    TimedStore store(kv_mem);
+    ASSERT_EQ(reinterpret_cast<uint64_t>(store.get_time_addr()) % sizeof(int64_t), 0);
+
+    std::vector<std::vector<time_edge_t>> lists;
+    for (int v = 0; v < 100; v++) {
+        lists.push_back(make_edges(v + 1, 100000, 500, v));
+        store.insert(ikey_t(v + (1 << 17), 2, OUT), lists.back());
+    }
+
+    for (int v = 0; v < 100; v++) {
+        uint64_t sz = 0, tsz = 0;
+        edge_time_t *times = nullptr;
+        edge_t *vals = store.get_values(0, 0, ikey_t(v + (1 << 17), 2, OUT), sz);
+        edge_t *tvals = store.get_timed_values(0, 0, ikey_t(v + (1 << 17), 2, OUT), tsz, times);
+        ASSERT_EQ(sz, lists[v].size());
+        ASSERT_EQ(tsz, sz);
+        ASSERT_EQ(vals, tvals);
+        for (uint64_t k = 0; k < sz; k++) {
+            EXPECT_EQ(vals[k].val, lists[v][k].val);
+            EXPECT_TRUE(times[k] == lists[v][k].time());
+        }
+    }
+    delete[] kvs;
+}
+
+// the edges of a non-temporal pattern: w/ timestamps inlined (as before) vs. side region
+TEST(TimeIndex, BenchmarkLayout) {
+    const int n = 1 << 22, nscans = 20;
+    std::vector<time_edge_t> inlined = make_edges(n, 1 << 30, 10000, 0);
+    std::vector<edge_t> edges;
+    for (auto const &e : inlined)
+        edges.push_back(e.edge());
+
+    uint64_t sum0 = 0, sum1 = 0;
+    uint64_t start = timer::get_usec();
+    for (int i = 0; i < nscans; i++)
+        for (int k = 0; k < n; k++)
+            sum0 += inlined[k].val + i;
+    uint64_t usec0 = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    for (int i = 0; i < nscans; i++)
+        for (int k = 0; k < n; k++)
+            sum1 += edges[k].val + i;
+    uint64_t usec1 = timer::get_usec() - start;
+
+    EXPECT_EQ(sum0, sum1);
+    printf("%d scans on %d edges: inlined timestamps (%lu bytes) %lu ms, side region (%lu bytes) %lu ms\n",
+           nscans, n, sizeof(time_edge_t), usec0 / 1000, sizeof(edge_t), usec1 / 1000);
+}
+
+}  // namespace test
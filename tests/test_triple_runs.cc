@@ -0,0 +1,284 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "core/network/tcp_adaptor.hpp"
+#include "core/store/rdf_dgraph.hpp"
+#include "core/store/segment_rdf_dgraph.hpp"
+#include "utils/timer.hpp"
+
+#define SID 0
+#define TID 0
+#define RBUF_SZ (1 << 15)
+#define VID_MIN (1 << 17)
+#define PID_MIN 11
+#define NPREDS 10
+#define NTYPES 9
+
+namespace wukong {
+// used to synchronize segment metadata (no peer for a single server)
+TCP_Adaptor *con_adaptor = nullptr;
+}  // namespace wukong
+
+namespace test {
+using namespace wukong;
+
+static std::vector<triple_t> gen_triples(uint64_t n, uint64_t nvertices) {
+    std::vector<triple_t> triples;
+    unsigned int seed = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        triple_t t(VID_MIN + rand_r(&seed) % nvertices, PID_MIN + rand_r(&seed) % NPREDS,
+                   VID_MIN + rand_r(&seed) % nvertices);
+        triples.push_back(t);
+        if (i % 5 == 0)  // duplicates
+            triples.push_back(t);
+    }
+    return triples;
+}
+
+static std::vector<triple_t> merge_all(const TripleRuns &runs, uint64_t chunk_sz, bool by_s) {
+    std::vector<triple_t> all, chunk;
+    TripleRunMerger merger(runs, 4096);
+    while (merger.next_chunk(chunk, chunk_sz)) {
+        // a key is never split across chunks
+        if (!all.empty()) {
+            sid_t v0 = by_s ? all.back().s : all.back().o, v1 = by_s ? chunk[0].s : chunk[0].o;
+#ifdef VERSATILE
+            EXPECT_NE(v0, v1);
+#else
+            EXPECT_FALSE(v0 == v1 && all.back().p == chunk[0].p);
+#endif
+        }
+        all.insert(all.end(), chunk.begin(), chunk.end());
+    }
+    return all;
+}
+
+static void expect_same(const std::vector<triple_t> &t0, const std::vector<triple_t> &t1) {
+    ASSERT_EQ(t0.size(), t1.size());
+    uint64_t nerrors = 0;
+    for (uint64_t i = 0; i < t0.size(); i++)
+        nerrors += !(t0[i] == t1[i]);
+    EXPECT_EQ(nerrors, 0);
+}
+
+TEST(TripleRuns, SpillAndMerge) {
+    std::vector<triple_t> triples = gen_triples(100000, 1000), tmp;
+    for (bool by_s : {true, false}) {
+        std::vector<triple_t> sorted = triples;
+        TripleRuns::sort_triples(sorted, by_s, tmp);
+
+        for (uint64_t cap : {3UL, 777UL, 1UL << 20}) {
+            TripleRuns runs("/tmp/wukong_test_runs", by_s, cap);
+            for (auto &t : triples)
+                runs.push_back(t);
+            runs.finish();
+            uint64_t nruns = (triples.size() + cap - 1) / cap;
+            if (nruns <= RUNS_MAX_FANIN)
+                EXPECT_EQ(runs.files().size(), nruns);
+            else  // merged by passes
+                EXPECT_LE(runs.files().size(), RUNS_MAX_FANIN);
+
+            expect_same(sorted, merge_all(runs, UINT64_MAX, by_s));
+            expect_same(sorted, merge_all(runs, 100, by_s));
+            runs.clear();
+            EXPECT_EQ(runs.files().size(), 0);
+        }
+    }
+
+    // no triples
+    TripleRuns runs("/tmp/wukong_test_runs", true, 10);
+    runs.finish();
+    std::vector<triple_t> chunk;
+    EXPECT_FALSE(TripleRunMerger(runs, 4096).next_chunk(chunk, 100));
+}
+
+/* load a dataset (id_*, str_index) w/ and w/o the memory budget */
+
+static void write_dataset(const std::string &dname, uint64_t n, uint64_t nvertices) {
+    ASSERT_EQ(system(("mkdir -p " + dname).c_str()), 0);
+    std::ofstream str_index(dname + "str_index");
+    for (sid_t p = 0; p < PID_MIN + NPREDS; p++)
+        str_index << "<p" << p << "> " << p << "\n";
+
+    std::ofstream ofs(dname + "id_uni0.nt");
+    unsigned int seed = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        sid_t s = VID_MIN + rand_r(&seed) % nvertices;
+        if (i % 10 == 0)  // type triples
+            ofs << s << "\t" << TYPE_ID << "\t" << 2 + rand_r(&seed) % NTYPES;
+        else
+            ofs << s << "\t" << PID_MIN + rand_r(&seed) % NPREDS << "\t"
+                << VID_MIN + rand_r(&seed) % nvertices;
+#ifdef TRDF_MODE
+        ofs << "\t" << 0 << "\t" << 0;  // ts and te
+#endif
+        ofs << "\n";
+    }
+}
+
+static DGraph *new_graph(KVMem kv_mem, bool segment) {
+    if (segment)
+        return new SegmentRDFGraph(SID, kv_mem);
+    // a static store, since the buddy allocator of a dynamic one needs a larger KV region
+    return new RDFGraph(SID, kv_mem, false);
+}
+
+static DGraph *load_graph(const std::string &dname, KVMem &kv_mem, uint64_t kvs_sz, int budget_mb,
+                          bool segment = true) {
+    Global::use_rdma = false;
+    Global::load_budget_mb = budget_mb;
+    // zero-filled lazily, so that only the pages in use are resident
+    kv_mem = {static_cast<char *>(calloc(kvs_sz, 1)), kvs_sz,
+              static_cast<char *>(calloc(RBUF_SZ, 1)), RBUF_SZ};
+    DGraph *g = new_graph(kv_mem, segment);
+    EXPECT_TRUE(g->load(dname));
+    return g;
+}
+
+static void free_graph(DGraph *g, KVMem &kv_mem) {
+    delete g;
+    free(kv_mem.kvs);
+    free(kv_mem.rrbuf);
+}
+
+static void expect_same_graph(DGraph *g0, DGraph *g1, uint64_t nvertices) {
+    uint64_t sz0, sz1, nerrors = 0, nedges = 0;
+    for (sid_t s = VID_MIN; s < VID_MIN + nvertices; s++) {
+        for (sid_t p = TYPE_ID; p < PID_MIN + NPREDS; p++) {
+            for (int d = IN; d <= OUT; d++) {
+                edge_t *e0 = g0->get_triples(TID, s, p, (dir_t)d, sz0);
+                edge_t *e1 = g1->get_triples(TID, s, p, (dir_t)d, sz1);
+                if (sz0 != sz1 || (sz0 > 0 && !std::equal(e0, e0 + sz0, e1)))
+                    nerrors++;
+                nedges += sz0;
+            }
+        }
+    }
+    for (sid_t p = TYPE_ID; p < PID_MIN + NPREDS; p++) {
+        for (int d = IN; d <= OUT; d++) {
+            g0->get_index(TID, p, (dir_t)d, sz0);
+            g1->get_index(TID, p, (dir_t)d, sz1);
+            if (sz0 != sz1)
+                nerrors++;
+        }
+    }
+    EXPECT_GT(nedges, 0);
+    EXPECT_EQ(nerrors, 0);
+    EXPECT_EQ(g0->get_edge_predicates(), g1->get_edge_predicates());
+    EXPECT_EQ(g0->get_type_predicates(), g1->get_type_predicates());
+}
+
+TEST(TripleRuns, LoadGraph) {
+    std::string dname = "/tmp/wukong_test_runs/";
+    uint64_t nvertices = 5000;
+    write_dataset(dname, 300000, nvertices);
+
+    for (bool segment : {true, false}) {
+        for (int nengines : {1, 3}) {
+            Global::num_engines = nengines;
+            KVMem mem0, mem1;
+            DGraph *g0 = load_graph(dname, mem0, 1UL << 27, 0, segment);
+            DGraph *g1 = load_graph(dname, mem1, 1UL << 27, 1, segment);  // spill runs of ~20K triples
+            expect_same_graph(g0, g1, nvertices);
+            free_graph(g0, mem0);
+            free_graph(g1, mem1);
+        }
+    }
+    Global::num_engines = 1;
+    Global::load_budget_mb = 0;
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+TEST(TripleRuns, SpillFailure) {
+    std::vector<triple_t> triples = gen_triples(1000, 100);
+
+    // the spill folder does not exist
+    TripleRuns runs("/tmp/wukong_test_runs_missing/run", true, 100);
+    for (auto &t : triples)
+        runs.push_back(t);
+    EXPECT_FALSE(runs.good());
+    EXPECT_FALSE(runs.finish());
+    EXPECT_EQ(runs.files().size(), 0);
+
+    std::string dname = "/tmp/wukong_test_runs/";
+    write_dataset(dname, 1000, 100);
+    std::string folder = Global::load_spill_folder;
+    Global::load_spill_folder = "/tmp/wukong_test_runs_missing/";
+    Global::use_rdma = false;
+    Global::load_budget_mb = 1;
+    KVMem kv_mem = {static_cast<char *>(calloc(1UL << 27, 1)), 1UL << 27,
+                    static_cast<char *>(calloc(RBUF_SZ, 1)), RBUF_SZ};
+    DGraph *g = new_graph(kv_mem, true);
+    EXPECT_FALSE(g->load(dname));
+    free_graph(g, kv_mem);
+    Global::load_spill_folder = folder;
+    Global::load_budget_mb = 0;
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+TEST(TripleRuns, ReadFailure) {
+    std::vector<triple_t> triples = gen_triples(20000, 1000);
+    std::vector<triple_t> chunk;
+
+    // a run file is removed before merged
+    TripleRuns runs("/tmp/wukong_test_runs_read", true, 100);
+    for (int i = 0; i < 1000; i++)
+        runs.push_back(triples[i]);
+    ASSERT_TRUE(runs.spill());
+    ASSERT_GT(runs.files().size(), 1);
+    unlink(runs.files()[1].c_str());
+    {
+        TripleRunMerger merger(runs, 4096);
+        EXPECT_FALSE(merger.good());
+        EXPECT_FALSE(merger.next_chunk(chunk, 100));
+        EXPECT_TRUE(chunk.empty());
+    }
+
+    // ... or before reduced to RUNS_MAX_FANIN runs by finish()
+    for (int i = 1000; i < triples.size(); i++)
+        runs.push_back(triples[i]);
+    ASSERT_TRUE(runs.spill());
+    ASSERT_GT(runs.files().size(), RUNS_MAX_FANIN);
+    EXPECT_FALSE(runs.finish());
+    EXPECT_FALSE(runs.good());
+    runs.clear();
+}
+
+// peak RSS of loading: in memory vs. w/ a budget
+TEST(TripleRuns, Benchmark) {
+    std::string dname = "/tmp/wukong_bench_runs/";
+#if defined(VERSATILE) || defined(TRDF_MODE)
+    uint64_t kvs_sz = 1UL << 30;  // the predicates of vertices, or the timestamps of edges
+#else
+    uint64_t kvs_sz = 1UL << 29;
+#endif
+    write_dataset(dname, 1 << 22, 1 << 20);
+
+    for (int budget_mb : {0, 16}) {
+        // reset the peak RSS, and exclude the KV region
+        std::ofstream("/proc/self/clear_refs") << "5";
+        uint64_t base = DGraph::get_peak_rss_kb() + B2KiB(kvs_sz);
+
+        uint64_t start = timer::get_usec();
+        KVMem kv_mem;
+        DGraph *g = load_graph(dname, kv_mem, kvs_sz, budget_mb);
+        uint64_t usec = timer::get_usec() - start;
+        uint64_t rss = DGraph::get_peak_rss_kb() - base;
+        free_graph(g, kv_mem);
+
+        printf("load %d triples (budget: %d MB): %lu ms, peak RSS (excl. %lu MB KV) +%lu MB\n",
+               1 << 22, budget_mb, usec / 1000, kvs_sz >> 20, rss / 1024);
+    }
+    Global::load_budget_mb = 0;
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+}  // namespace test
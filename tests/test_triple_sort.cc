@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "utils/timer.hpp"
+#include "utils/triple_sort.hpp"
+
+#define NTRIPLES (1 << 22)
+
+namespace test {
+using namespace wukong;
+
+static std::vector<triple_t> gen_triples(uint64_t n, uint64_t nvertices) {
+    std::vector<triple_t> triples;
+    unsigned int seed = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        triple_t t((1 << 17) + rand_r(&seed) % nvertices, 1 + rand_r(&seed) % 20,
+                   (1 << 17) + rand_r(&seed) % nvertices);
+        triples.push_back(t);
+        if (i % 5 == 0)  // duplicates
+            triples.push_back(t);
+    }
+    return triples;
+}
+
+template <typename Compare>
+static void std_sort_dedup(std::vector<triple_t>& triples, Compare cmp) {
+    std::sort(triples.begin(), triples.end(), cmp);
+    triples.erase(std::unique(triples.begin(), triples.end()), triples.end());
+}
+
+static void expect_same(const std::vector<triple_t>& t0, const std::vector<triple_t>& t1) {
+    ASSERT_EQ(t0.size(), t1.size());
+    uint64_t nerrors = 0;
+    for (uint64_t i = 0; i < t0.size(); i++)
+        nerrors += !(t0[i] == t1[i]);
+    EXPECT_EQ(nerrors, 0);
+}
+
+TEST(TripleSort, SameAsStdSort) {
+    std::vector<triple_t> tmp;
+    for (uint64_t nvertices : {1UL, 100UL, 1UL << 20}) {
+        std::vector<triple_t> triples = gen_triples(100000, nvertices);
+
+        std::vector<triple_t> t0 = triples, t1 = triples;
+        std_sort_dedup(t0, triple_sort_by_pso());
+        sort_triples_by_pso(t1, tmp);
+        expect_same(t0, t1);
+
+        t0 = triples, t1 = triples;
+        std_sort_dedup(t0, triple_sort_by_pos());
+        sort_triples_by_pos(t1, tmp);
+        expect_same(t0, t1);
+
+        // spo -> pso and ops -> pos
+        t0 = triples, t1 = triples;
+        std_sort_dedup(t0, triple_sort_by_pso());
+        sort_triples_by_spo(t1, tmp);
+        resort_triples_by_p(t1, tmp);
+        expect_same(t0, t1);
+
+        t0 = triples, t1 = triples;
+        std_sort_dedup(t0, triple_sort_by_pos());
+        sort_triples_by_ops(t1, tmp);
+        resort_triples_by_p(t1, tmp);
+        expect_same(t0, t1);
+    }
+
+    std::vector<triple_t> empty;
+    sort_triples_by_pso(empty, tmp);
+    EXPECT_EQ(empty.size(), 0);
+}
+
+TEST(TripleSort, Benchmark) {
+    std::vector<triple_t> triples = gen_triples(NTRIPLES, 1 << 24);
+    std::vector<triple_t> t0 = triples, t1 = triples, tmp;
+
+    uint64_t start = timer::get_usec();
+    std_sort_dedup(t0, triple_sort_by_pso());
+    uint64_t std_usec = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    sort_triples_by_pso(t1, tmp);
+    uint64_t radix_usec = timer::get_usec() - start;
+    expect_same(t0, t1);
+
+    // re-sort (VERSATILE): std::sort vs. stable sort on p
+    std_sort_dedup(t0, triple_sort_by_spo());
+    t1 = t0;
+    start = timer::get_usec();
+    std::sort(t0.begin(), t0.end(), triple_sort_by_pso());
+    uint64_t std_resort_usec = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    resort_triples_by_p(t1, tmp);
+    uint64_t radix_resort_usec = timer::get_usec() - start;
+    expect_same(t0, t1);
+
+    printf("sort+dedup %lu triples: std::sort %lu ms, radix %lu ms\n",
+           triples.size(), std_usec / 1000, radix_usec / 1000);
+    printf("re-sort spo->pso: std::sort %lu ms, radix %lu ms\n",
+           std_resort_usec / 1000, radix_resort_usec / 1000);
+}
+
+}  // namespace test
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "stringserver/string_dict.hpp"
+#include "stringserver/string_server.hpp"
+#include "stringserver/typed_literal.hpp"
+#include "utils/timer.hpp"
+
+#define NORMAL_BASE (1 << NBITS_IDX)
+#define XSD(_t) "^^<http://www.w3.org/2001/XMLSchema#" _t ">"
+
+namespace test {
+using namespace wukong;
+
+TEST(TypedLiteral, Decode) {
+    typed_value_t v;
+    ASSERT_TRUE(TypedLiteral::decode("\"12\"" XSD("integer"), v));
+    EXPECT_EQ(v.kind, LIT_NUMERIC);
+    EXPECT_EQ(v.val, 12);
+    ASSERT_TRUE(TypedLiteral::decode("\"-1.5E2\"^^xsd:double", v));
+    EXPECT_EQ(v.val, -150);
+    ASSERT_TRUE(TypedLiteral::decode("\"0.25\"" XSD("decimal"), v));
+    EXPECT_EQ(v.val, 0.25);
+
+    ASSERT_TRUE(TypedLiteral::decode("\"1970-01-02T00:00:01Z\"" XSD("dateTime"), v));
+    EXPECT_EQ(v.kind, LIT_DATETIME);
+    EXPECT_EQ(v.val, 86401);
+    ASSERT_TRUE(TypedLiteral::decode("\"2002-10-10T12:00:00+08:00\"" XSD("dateTime"), v));
+    EXPECT_EQ(v.val, 1034222400);  // 2002-10-10T04:00:00Z
+    ASSERT_TRUE(TypedLiteral::decode("\"2000-03-01\"^^xsd:date", v));
+    EXPECT_EQ(v.val, 951868800);
+    ASSERT_TRUE(TypedLiteral::decode("\"2000-03-01T00:00:00.5\"^^xsd:dateTime", v));
+    EXPECT_EQ(v.val, 951868800.5);
+
+    // not typed (numeric or dateTime) literals
+    for (std::string str : std::vector<std::string>{
+             "\"12\"", "<http://a/12>", "\"abc\"" XSD("integer"), "\"12\"" XSD("string"),
+             "\"12\"^^<http://example.org/integer>", "\"12 \"" XSD("int"), "\"\"" XSD("int"),
+             "\"2002-13-10\"" XSD("date"), "\"2002-10-10T12:00\"" XSD("dateTime"), "\"12\"@en"})
+        EXPECT_FALSE(TypedLiteral::decode(str, v)) << str;
+
+    // hexadecimal, infinity and NaN forms are not numbers
+    for (std::string str : std::vector<std::string>{
+             "\"0x1A\"" XSD("integer"), "\"inf\"" XSD("integer"), "\"nan\"" XSD("int"),
+             "\"1.5\"" XSD("integer"), "\"99999999999999999999\"" XSD("long"),
+             "\"0x1A\"" XSD("double"), "\"infinity\"" XSD("double")})
+        EXPECT_FALSE(TypedLiteral::decode(str, v)) << str;
+
+    // constants of FILTERs (numbers are typed by the parser)
+    ASSERT_TRUE(TypedLiteral::decode_constant("7", XSD_PREFIX "integer", v));
+    EXPECT_EQ(v.kind, LIT_NUMERIC);
+    EXPECT_EQ(v.val, 7);
+    ASSERT_TRUE(TypedLiteral::decode_constant("2002-10-10T12:00:00Z", "<" XSD_PREFIX "dateTime>", v));
+    EXPECT_EQ(v.kind, LIT_DATETIME);
+    ASSERT_TRUE(TypedLiteral::decode_constant("1.5", "xsd:decimal", v));
+    EXPECT_EQ(v.val, 1.5);
+    EXPECT_FALSE(TypedLiteral::decode_constant("12", "", v));  // "12" is a plain literal
+    EXPECT_FALSE(TypedLiteral::decode_constant("0x1A", XSD_PREFIX "integer", v));
+    EXPECT_FALSE(TypedLiteral::decode_constant("Course7", "", v));
+}
+
+static void write_dataset(const std::string &dname, uint64_t nvertices) {
+    ASSERT_EQ(system(("mkdir -p " + dname + " && rm -f " + dname + "str_dict").c_str()), 0);
+    std::ofstream str_index(dname + "str_index");
+    str_index << "__PREDICATE__ 0\n<rdf:type> 1\n<ub:age> 2\n";
+    std::ofstream str_normal(dname + "str_normal");
+    for (uint64_t i = 0; i < nvertices; i++) {
+        // integers, plain literals and IRIs
+        if (i % 3 == 0)
+            str_normal << "\"" << i << "\"" << XSD("integer") << "\t" << NORMAL_BASE + i << "\n";
+        else if (i % 3 == 1)
+            str_normal << "\"" << i << "\"\t" << NORMAL_BASE + i << "\n";
+        else
+            str_normal << "<http://www.University0.edu/Student" << i << ">\t" << NORMAL_BASE + i << "\n";
+    }
+}
+
+TEST(TypedLiteral, StringServer) {
+    std::string dname = "/tmp/wukong_test_typed/";
+    write_dataset(dname, 300);
+
+    // decoded at load time (text files) or at dictionary time
+    for (bool use_dict : {false, true}) {
+        if (use_dict)
+            ASSERT_TRUE(StringDict::build(dname, dname + "str_dict"));
+        StringServer server(dname);
+        std::vector<sid_t> ids;
+        for (sid_t i = 0; i < 300; i++)
+            ids.push_back(NORMAL_BASE + i);
+        ids.push_back(1);
+        ids.push_back(NORMAL_BASE + 1000);  // unknown
+
+        std::vector<typed_value_t> vals = server.typed_value_batch(0, ids);
+        ASSERT_EQ(vals.size(), ids.size());
+        for (sid_t i = 0; i < 300; i++) {
+            EXPECT_EQ(vals[i].kind, (i % 3 == 0) ? LIT_NUMERIC : LIT_NONE);
+            if (i % 3 == 0) EXPECT_EQ(vals[i].val, i);
+        }
+        EXPECT_EQ(vals[300].kind, LIT_NONE);
+        EXPECT_EQ(vals[301].kind, LIT_NONE);
+
+        // strings added at runtime
+        server.add("\"3.5\"^^xsd:float", NORMAL_BASE + 1000);
+        EXPECT_EQ(server.typed_value_batch(0, {NORMAL_BASE + 1000})[0].val, 3.5);
+    }
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+// FILTER (?x < c) on a column: per-row id2str and string comparison vs. typed values
+TEST(TypedLiteral, Benchmark) {
+    std::string dname = "/tmp/wukong_bench_typed/";
+    uint64_t nvertices = 300000, nrows = 1000000;
+    write_dataset(dname, nvertices);
+    StringServer server(dname);
+
+    std::vector<sid_t> col(nrows);
+    unsigned int seed = 0;
+    for (auto &id : col)
+        id = NORMAL_BASE + 3 * (rand_r(&seed) % (nvertices / 3));  // integers
+    std::string c = "1000";
+
+    // the string comparison (as before), which is also wrong for numbers
+    uint64_t start = timer::get_usec();
+    std::vector<bool> by_str(nrows, true);
+    std::string lit = "\"" + c + "\"";
+    for (uint64_t row = 0; row < nrows; row++)
+        if (server.id2str(0, col[row]).second >= lit)
+            by_str[row] = false;
+    uint64_t str_usec = timer::get_usec() - start;
+
+    start = timer::get_usec();
+    std::vector<typed_value_t> vals = server.typed_value_batch(0, col);
+    std::vector<uint8_t> by_val(nrows);
+    double cv = std::stod(c);
+    for (uint64_t row = 0; row < nrows; row++)
+        by_val[row] = vals[row].kind == LIT_NUMERIC && vals[row].val < cv;
+    uint64_t val_usec = timer::get_usec() - start;
+
+    uint64_t nstr = 0, nval = 0, nexpected = 0;
+    for (uint64_t row = 0; row < nrows; row++) {
+        nstr += by_str[row];
+        nval += by_val[row];
+        nexpected += (col[row] - NORMAL_BASE < 1000);
+    }
+    EXPECT_EQ(nval, nexpected);
+    printf("FILTER (?x < %s) on %lu rows: strings %lu ms (%lu rows), typed values %lu ms (%lu rows)\n",
+           c.c_str(), nrows, str_usec / 1000, nstr, val_usec / 1000, nval);
+    EXPECT_EQ(system(("rm -rf " + dname).c_str()), 0);
+}
+
+}  // namespace test
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "core/common/bundle.hpp"
+#include "utils/timer.hpp"
+
+#define NROWS (1 << 20)
+#define NCOLS 4
+#define NLOOPS 10
+
+namespace test {
+using namespace wukong;
+
+static SPARQLQuery make_query(int nrows) {
+    SPARQLQuery q;
+    q.qid = 7;
+    q.pqid = 3;
+    q.state = SPARQLQuery::SQState::SQ_REPLY;
+    q.pattern_step = 2;
+    q.local_var = -1;
+    q.limit = 10;
+    q.distinct = true;
+
+    q.pattern_group.patterns.push_back(SPARQLQuery::Pattern(1 << 17, 5, OUT, -1));
+    q.pattern_group.patterns.push_back(SPARQLQuery::Pattern(-1, 6, IN, -2));
+
+    SPARQLQuery::Filter f;
+    f.type = SPARQLQuery::Filter::Type::Builtin_regex;
+    f.arg1 = new SPARQLQuery::Filter();
+    f.arg1->type = SPARQLQuery::Filter::Type::Variable;
+    f.arg1->valueArg = -2;
+    f.arg2 = new SPARQLQuery::Filter();
+    f.arg2->type = SPARQLQuery::Filter::Type::Literal;
+    f.arg2->value = "\"^ab\"";
+    q.pattern_group.filters.push_back(f);
+
+    SPARQLQuery::PatternGroup opt;
+    opt.patterns.push_back(SPARQLQuery::Pattern(-2, 8, OUT, -3));
+    opt.optional_new_vars.insert(-3);
+    q.pattern_group.optional.push_back(opt);
+    q.orders.push_back(SPARQLQuery::Order(-1, true));
+    q.aggregates.push_back(SPARQLQuery::Aggregate(AGG_MAX, -2, -4, true));
+    q.group_by = {-1};
+
+    SPARQLQuery::Result &r = q.result;
+    r.nvars = 3;
+    r.required_vars = {-1, -2};
+    r.v2c_map = {0, 1, NO_RESULT};
+    r.optional_matched_rows = {true, false, true};
+    r.set_col_num(NCOLS);
+    r.result_table.resize(nrows * NCOLS);
+    for (int i = 0; i < nrows * NCOLS; i++)
+        r.result_table[i] = i;
+    r.attr_res_table = {attr_t(1), attr_t(2.5), attr_t(3.5f)};
+    r.update_nrows();
+
+    sid_t key = 1 << 17;
+    r.agg_table.init(1, {AGG_MAX});
+    r.agg_table.update(r.agg_table.group(&key), 0, 42, typed_value_t(2.5, LIT_NUMERIC));
+    key = 1 << 18;
+    r.agg_table.update(r.agg_table.group(&key), 0, 43, typed_value_t(), "<http://www.Department0.edu>");
+    return q;
+}
+
+static void expect_same(const SPARQLQuery &a, const SPARQLQuery &b) {
+    EXPECT_EQ(a.qid, b.qid);
+    EXPECT_EQ(a.pqid, b.pqid);
+    EXPECT_EQ(a.state, b.state);
+    EXPECT_EQ(a.pattern_step, b.pattern_step);
+    EXPECT_EQ(a.local_var, b.local_var);
+    EXPECT_EQ(a.limit, b.limit);
+    EXPECT_EQ(a.distinct, b.distinct);
+
+    EXPECT_EQ(a.pattern_group.patterns.size(), b.pattern_group.patterns.size());
+    for (int i = 0; i < a.pattern_group.patterns.size(); i++) {
+        EXPECT_EQ(a.pattern_group.patterns[i].subject, b.pattern_group.patterns[i].subject);
+        EXPECT_EQ(a.pattern_group.patterns[i].direction, b.pattern_group.patterns[i].direction);
+    }
+    EXPECT_EQ(a.pattern_group.filters.size(), b.pattern_group.filters.size());
+    EXPECT_EQ(b.pattern_group.filters[0].arg2->value, "\"^ab\"");
+    EXPECT_EQ(b.pattern_group.filters[0].arg3, nullptr);
+    EXPECT_EQ(a.pattern_group.optional[0].optional_new_vars,
+              b.pattern_group.optional[0].optional_new_vars);
+    EXPECT_EQ(b.orders[0].descending, true);
+    ASSERT_EQ(b.aggregates.size(), 1);
+    EXPECT_EQ(b.aggregates[0].func, AGG_MAX);
+    EXPECT_EQ(b.aggregates[0].alias, -4);
+    EXPECT_EQ(b.aggregates[0].distinct, true);
+    EXPECT_EQ(a.group_by, b.group_by);
+
+    EXPECT_EQ(a.result.required_vars, b.result.required_vars);
+    EXPECT_EQ(a.result.v2c_map, b.result.v2c_map);
+    EXPECT_EQ(a.result.optional_matched_rows, b.result.optional_matched_rows);
+    EXPECT_EQ(a.result.get_row_num(), b.result.get_row_num());
+    EXPECT_EQ(a.result.result_table, b.result.result_table);
+    EXPECT_EQ(a.result.attr_res_table, b.result.attr_res_table);
+    EXPECT_EQ(a.result.agg_table.keys, b.result.agg_table.keys);
+    EXPECT_EQ(a.result.agg_table.vals, b.result.agg_table.vals);
+    EXPECT_EQ(a.result.agg_table.ids, b.result.agg_table.ids);
+    EXPECT_EQ(a.result.agg_table.strs, b.result.agg_table.strs);
+}
+
+// send and receive a query through Bundle
+static SPARQLQuery round_trip(const SPARQLQuery &q) {
+    Bundle out(q);
+    Bundle in(out.take_str());
+    return in.get_sparql_query();
+}
+
+TEST(Wire, RoundTrip) {
+    SPARQLQuery q = make_query(16);
+
+    Global::enable_flat_wire = true;
+    expect_same(q, round_trip(q));
+
+    Global::enable_flat_wire = false;
+    expect_same(q, round_trip(q));
+
+    Global::enable_flat_wire = true;
+}
+
+// throughput: flat wire format vs. boost serialization
+TEST(Wire, Throughput) {
+    SPARQLQuery q = make_query(NROWS);
+    bool flags[2] = {true, false};
+
+    for (bool flat : flags) {
+        Global::enable_flat_wire = flat;
+        uint64_t bytes = 0, enc = 0, dec = 0;
+        for (int i = 0; i < NLOOPS; i++) {
+            uint64_t t0 = timer::get_usec();
+            Bundle out(q);
+            std::string msg = out.take_str();
+            uint64_t t1 = timer::get_usec();
+            Bundle in(std::move(msg));
+            SPARQLQuery r = in.get_sparql_query();
+            uint64_t t2 = timer::get_usec();
+
+            EXPECT_EQ(r.result.get_row_num(), NROWS);
+            bytes += in.data.size();
+            enc += t1 - t0;
+            dec += t2 - t1;
+        }
+        printf("%s: %lu bytes/msg, encode %.1f MB/s, decode %.1f MB/s\n",
+               flat ? "flat wire" : "boost", bytes / NLOOPS,
+               (double)bytes / enc, (double)bytes / dec);
+    }
+    Global::enable_flat_wire = true;
+}
+
+}  // namespace test
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/engine/work_deque.hpp"
+#include "utils/timer.hpp"
+
+#define NITEMS (1 << 20)
+#define NTHIEVES 3
+#define NTASKS (1 << 12)
+#define NWORKERS 4
+
+namespace test {
+using namespace wukong;
+
+TEST(WorkDeque, OwnerLIFOThiefFIFO) {
+    WorkDeque<int> dq;
+    int item;
+    EXPECT_FALSE(dq.try_pop(item));
+    EXPECT_FALSE(dq.steal(item));
+
+    // grow beyond the initial capacity
+    for (int i = 0; i < 1000; i++)
+        dq.push(i);
+    EXPECT_EQ(dq.size(), 1000);
+
+    ASSERT_TRUE(dq.steal(item));
+    EXPECT_EQ(item, 0);
+    ASSERT_TRUE(dq.try_pop(item));
+    EXPECT_EQ(item, 999);
+    for (int i = 1; i < 999; i++) {
+        ASSERT_TRUE(dq.steal(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_TRUE(dq.empty());
+    EXPECT_FALSE(dq.try_pop(item));
+}
+
+// every item is taken exactly once by the owner or thieves
+TEST(WorkDeque, ConcurrentSteal) {
+    WorkDeque<std::vector<int>> dq;  // non-trivial items
+    std::vector<std::atomic<int>> taken(NITEMS);
+    for (auto &t : taken) t = 0;
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < NTHIEVES; i++) {
+        thieves.push_back(std::thread([&]() {
+            std::vector<int> item;
+            while (!stop || !dq.empty()) {
+                if (dq.steal(item))
+                    taken[item[0]]++;
+            }
+        }));
+    }
+
+    std::vector<int> item;
+    for (int i = 0; i < NITEMS; i++) {
+        dq.push(std::vector<int>(1, i));
+        // the owner pops a half of items by itself
+        if (i % 2 && dq.try_pop(item))
+            taken[item[0]]++;
+    }
+    while (dq.try_pop(item))
+        taken[item[0]]++;
+
+    stop = true;
+    for (auto &th : thieves)
+        th.join();
+
+    uint64_t nerrors = 0;
+    for (auto &t : taken)
+        nerrors += (t != 1);
+    EXPECT_EQ(nerrors, 0);
+}
+
+// latency of light tasks mixed w/ heavy tasks, which are all submitted to
+// the first worker: w/o stealing vs. stealing from random victims
+TEST(WorkDeque, MixedLatency) {
+    for (int stealing = 0; stealing < 2; stealing++) {
+        std::vector<WorkDeque<int>> queues(NWORKERS);
+        std::vector<uint64_t> latency(NTASKS);
+        std::atomic<int> ndone(0);
+
+        uint64_t start = timer::get_usec();
+        for (int i = 0; i < NTASKS; i++)
+            queues[0].push(i);
+
+        std::vector<std::thread> workers;
+        for (int w = 0; w < NWORKERS; w++) {
+            workers.push_back(std::thread([&, w]() {
+                unsigned int seed = w;
+                int task;
+                while (ndone < NTASKS) {
+                    bool got = queues[w].steal(task);
+                    if (!got && stealing)
+                        got = queues[rand_r(&seed) % NWORKERS].steal(task);
+                    if (!got) continue;
+
+                    // one of 64 tasks is heavy (100x)
+                    uint64_t cost = (task % 64 == 0) ? 1000 : 10;
+                    uint64_t t = timer::get_usec();
+                    while (timer::get_usec() - t < cost) continue;
+                    latency[task] = timer::get_usec() - start;
+                    ndone++;
+                }
+            }));
+        }
+        for (auto &th : workers)
+            th.join();
+
+        std::sort(latency.begin(), latency.end());
+        printf("%s: 50th %lu usec, 99th %lu usec\n", stealing ? "stealing" : "no stealing",
+               latency[NTASKS / 2], latency[NTASKS * 99 / 100]);
+    }
+}
+
+}  // namespace test